@@ -273,10 +273,19 @@ enum elf_dynamic_tag {
 	DT_TEXTREL  = 22,
 	DT_JMPREL   = 23,
 	DT_BIND_NOW = 24,
+	DT_FLAGS    = 30,
+	DT_GNU_HASH = 0x6ffffef5,
 	DT_LOPROC   = 0x70000000,
 	DT_HIPROC   = 0x7fffffff,
 };
 
+/**
+ * Flags in the DT_FLAGS dynamic array entry
+ */
+enum {
+	DF_BIND_NOW = 0x8,
+};
+
 /**
  * Special section indexes
  */
@@ -45,6 +45,8 @@ enum {
 	AS_AREA_CACHEABLE    = 0x08,
 	AS_AREA_GUARD        = 0x10,
 	AS_AREA_LATE_RESERVE = 0x20,
+	/** Hint to place the area so that it can be mapped by large pages. */
+	AS_AREA_LARGE_PAGES  = 0x40,
 };
 
 static void *const AS_AREA_ANY = (void *) -1;
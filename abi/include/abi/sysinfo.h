@@ -48,6 +48,7 @@ enum {
 	/** Maximum name sizes */
 	TASK_NAME_BUFLEN = 64,
 	EXC_NAME_BUFLEN  = 20,
+	LOCK_NAME_BUFLEN = 32,
 };
 
 /** Item value type
@@ -70,6 +71,12 @@ typedef struct {
 	uint16_t frequency_mhz;  /**< Frequency in MHz */
 	uint64_t idle_cycles;    /**< Number of idle cycles */
 	uint64_t busy_cycles;    /**< Number of busy cycles */
+	uint64_t tlb_shootdowns;           /**< TLB shootdowns initiated */
+	uint64_t tlb_shootdowns_received;  /**< TLB shootdowns received */
+	uint64_t tlb_ipis_sent;            /**< TLB shootdown IPIs sent */
+	uint64_t tlb_ipis_avoided;         /**< TLB shootdown IPIs avoided */
+	uint64_t page_faults;              /**< Page faults serviced */
+	uint64_t large_pages_mapped;       /**< Large pages mapped on faults */
 } stats_cpu_t;
 
 /** Physical memory statistics
@@ -96,6 +103,15 @@ typedef struct {
 	uint64_t forwarded;           /**< IPC messages forwarded */
 } stats_ipc_t;
 
+/** Page fault statistics
+ *
+ */
+typedef struct {
+	uint64_t page_faults;         /**< Page faults serviced */
+	uint64_t faulted_around;      /**< Pages mapped ahead of faults */
+	uint64_t prezeroed;           /**< Pre-zeroed frames used */
+} stats_fault_t;
+
 /** Statistics about a single task
  *
  */
@@ -108,6 +124,7 @@ typedef struct {
 	uint64_t ucycles;             /**< Number of CPU cycles in user space */
 	uint64_t kcycles;             /**< Number of CPU cycles in kernel */
 	stats_ipc_t ipc_info;         /**< IPC statistics */
+	stats_fault_t fault_info;     /**< Page fault statistics */
 } stats_task_t;
 
 /** Statistics about a single thread
@@ -143,6 +160,27 @@ typedef struct {
 	uint64_t count;              /**< Number of handled exceptions */
 } stats_exc_t;
 
+/** Contention statistics of spinlocks with the same name
+ *
+ */
+typedef struct {
+	char name[LOCK_NAME_BUFLEN];  /**< Lock name */
+	uint64_t acquisitions;        /**< Number of acquisitions */
+	uint64_t contended;           /**< Acquisitions which had to wait */
+	uint64_t spin_cycles;         /**< CPU cycles spent waiting */
+	uint64_t hold_cycles;         /**< CPU cycles the lock was held */
+	uint64_t max_hold_cycles;     /**< Longest hold time in cycles */
+} stats_lock_t;
+
+/** Contention statistics of adaptive kernel mutexes
+ *
+ */
+typedef struct {
+	uint64_t contended;      /**< Acquisitions which found the mutex locked */
+	uint64_t spin_acquired;  /**< Contended acquisitions satisfied by spinning */
+	uint64_t slept;          /**< Contended acquisitions which had to sleep */
+} stats_mutex_t;
+
 /** Load fixed-point value */
 typedef uint32_t load_t;
 
@@ -40,6 +40,10 @@ void ipi_broadcast_arch(int ipi)
 {
 }
 
+void ipi_multicast_arch(int ipi, struct cpu_mask *mask)
+{
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
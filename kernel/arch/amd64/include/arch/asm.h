@@ -49,6 +49,14 @@ _NO_TRACE static inline void cpu_sleep(void)
 	);
 }
 
+/** Hint the CPU that we are in a busy-wait loop. */
+_NO_TRACE static inline void cpu_spin_hint(void)
+{
+	asm volatile (
+	    "pause\n"
+	);
+}
+
 _NO_TRACE static inline void __attribute__((noreturn)) cpu_halt(void)
 {
 	while (true) {
@@ -160,6 +160,13 @@
 #define PTE_EXECUTABLE_ARCH(p) \
 	((p)->no_execute == 0)
 
+/* Large pages mapped directly by PTL2 entries. */
+#define LARGE_PAGE_WIDTH_ARCH  21
+#define GET_PTL3_LARGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].page_size != 0)
+#define SET_PTL3_LARGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].page_size = 1)
+
 #ifndef __ASSEMBLER__
 
 #include <arch/interrupt.h>
@@ -197,7 +204,7 @@ typedef struct {
 	unsigned int page_cache_disable : 1;
 	unsigned int accessed : 1;
 	unsigned int dirty : 1;
-	unsigned int unused : 1;
+	unsigned int page_size : 1;  /**< Large page in PTL1/PTL2, PAT in PTL3. */
 	unsigned int global : 1;
 	unsigned int soft_valid : 1;  /**< Valid content even if present bit is cleared. */
 	unsigned int avl : 2;
@@ -64,6 +64,14 @@ _NO_TRACE static inline void cpu_sleep(void)
 #endif
 }
 
+/** Hint the CPU that we are in a busy-wait loop. */
+_NO_TRACE static inline void cpu_spin_hint(void)
+{
+#ifdef PROCESSOR_ARCH_armv7_a
+	asm volatile ("yield");
+#endif
+}
+
 _NO_TRACE static inline void pio_write_8(ioport8_t *port, uint8_t v)
 {
 	*port = v;
@@ -53,6 +53,12 @@ _NO_TRACE static inline void cpu_sleep(void)
 	asm volatile ("wfe");
 }
 
+/** Hint the CPU that we are in a busy-wait loop. */
+_NO_TRACE static inline void cpu_spin_hint(void)
+{
+	asm volatile ("yield");
+}
+
 /** Halts CPU. */
 _NO_TRACE static inline __attribute__((noreturn)) void cpu_halt(void)
 {
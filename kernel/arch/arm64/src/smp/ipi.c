@@ -46,6 +46,11 @@ void ipi_broadcast_arch(int ipi)
 	panic("broadcast IPI not implemented.");
 }
 
+void ipi_multicast_arch(int ipi, struct cpu_mask *mask)
+{
+	panic("multicast IPI not implemented.");
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
@@ -63,6 +63,18 @@ _NO_TRACE static inline void cpu_sleep(void)
 	);
 }
 
+/** Hint the CPU that we are in a busy-wait loop.
+ *
+ * The pause instruction is encoded as rep nop, so it is harmless on
+ * processors which predate it.
+ */
+_NO_TRACE static inline void cpu_spin_hint(void)
+{
+	asm volatile (
+	    "pause\n"
+	);
+}
+
 #define GEN_READ_REG(reg) _NO_TRACE static inline sysarg_t read_ ##reg (void) \
 	{ \
 		sysarg_t res; \
@@ -36,12 +36,23 @@
 
 #include <smp/ipi.h>
 #include <arch/smp/apic.h>
+#include <cpu.h>
+#include <cpu/cpu_mask.h>
+#include <arch.h>
 
 void ipi_broadcast_arch(int ipi)
 {
 	(void) l_apic_broadcast_custom_ipi((uint8_t) ipi);
 }
 
+void ipi_multicast_arch(int ipi, cpu_mask_t *mask)
+{
+	cpu_mask_for_each(*mask, i) {
+		if (i != CPU->id)
+			(void) l_apic_send_custom_ipi(cpus[i].arch.id, (uint8_t) ipi);
+	}
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
@@ -463,6 +463,11 @@ _NO_TRACE static inline void pk_disable(void)
 
 extern void cpu_halt(void) __attribute__((noreturn));
 extern void cpu_sleep(void);
+
+_NO_TRACE static inline void cpu_spin_hint(void)
+{
+}
+
 extern void asm_delay_loop(uint32_t t);
 
 extern void switch_to_userspace(uintptr_t, uintptr_t, uintptr_t, uintptr_t,
@@ -41,6 +41,10 @@ void ipi_broadcast_arch(int ipi)
 {
 }
 
+void ipi_multicast_arch(int ipi, struct cpu_mask *mask)
+{
+}
+
 void smp_init(void)
 {
 }
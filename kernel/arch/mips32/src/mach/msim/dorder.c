@@ -36,6 +36,9 @@
 #include <arch/mach/msim/msim.h>
 #include <stdint.h>
 #include <smp/ipi.h>
+#include <cpu.h>
+#include <cpu/cpu_mask.h>
+#include <arch.h>
 #include <interrupt.h>
 #include <arch/asm.h>
 #include <typedefs.h>
@@ -49,6 +52,19 @@ void ipi_broadcast_arch(int ipi)
 	pio_write_32(((ioport32_t *) MSIM_DORDER_ADDRESS), 0x7fffffff);
 }
 
+void ipi_multicast_arch(int ipi, cpu_mask_t *mask)
+{
+	uint32_t dorder_mask = 0;
+
+	cpu_mask_for_each(*mask, i) {
+		if (i != CPU->id)
+			dorder_mask |= 1 << i;
+	}
+
+	if (dorder_mask != 0)
+		pio_write_32(((ioport32_t *) MSIM_DORDER_ADDRESS), dorder_mask);
+}
+
 #endif
 
 static irq_ownership_t dorder_claim(irq_t *irq)
@@ -524,6 +524,11 @@ _NO_TRACE static inline void nucleus_leave(void)
 
 extern void cpu_halt(void) __attribute__((noreturn));
 extern void cpu_sleep(void);
+
+_NO_TRACE static inline void cpu_spin_hint(void)
+{
+}
+
 extern void asm_delay_loop(const uint32_t usec);
 
 extern uint64_t read_from_ag_g6(void);
@@ -36,6 +36,7 @@
 #include <arch/barrier.h>
 #include <assert.h>
 #include <cpu.h>
+#include <cpu/cpu_mask.h>
 #include <arch.h>
 #include <arch/cpu.h>
 #include <arch/asm.h>
@@ -172,5 +173,34 @@ void ipi_broadcast_arch(int ipi)
 	}
 }
 
+/*
+ * Deliver IPI to the processors in a mask except the current one.
+ *
+ * We assume that interrupts are disabled.
+ *
+ * @param ipi  IPI number.
+ * @param mask Destination processors.
+ */
+void ipi_multicast_arch(int ipi, cpu_mask_t *mask)
+{
+	void (*func)(void);
+
+	switch (ipi) {
+	case IPI_TLB_SHOOTDOWN:
+		func = tlb_shootdown_ipi_recv;
+		break;
+	default:
+		panic("Unknown IPI (%d).\n", ipi);
+		break;
+	}
+
+	cpu_mask_for_each(*mask, i) {
+		if (&cpus[i] == CPU)
+			continue;		/* skip the current CPU */
+
+		cross_call(cpus[i].arch.mid, func);
+	}
+}
+
 /** @}
  */
@@ -139,6 +139,19 @@
 #define PTE_WRITABLE(p)    PTE_WRITABLE_ARCH((p))
 #define PTE_EXECUTABLE(p)  PTE_EXECUTABLE_ARCH((p))
 
+/*
+ * Macros for large pages mapped by PTL2 entries instead of a PTL3, if the
+ * architecture supports them.
+ *
+ */
+#ifdef LARGE_PAGE_WIDTH_ARCH
+#define LARGE_PAGE_WIDTH  LARGE_PAGE_WIDTH_ARCH
+#define LARGE_PAGE_SIZE   (1 << LARGE_PAGE_WIDTH)
+
+#define GET_PTL3_LARGE(ptl2, i)  GET_PTL3_LARGE_ARCH(ptl2, i)
+#define SET_PTL3_LARGE(ptl2, i)  SET_PTL3_LARGE_ARCH(ptl2, i)
+#endif
+
 extern as_operations_t as_pt_operations;
 extern page_mapping_operations_t pt_mapping_operations;
 
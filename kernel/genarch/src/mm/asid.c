@@ -64,6 +64,7 @@
 #include <synch/spinlock.h>
 #include <synch/mutex.h>
 #include <adt/list.h>
+#include <cpu/cpu_mask.h>
 
 static size_t asids_allocated = 0;
 
@@ -123,11 +124,19 @@ asid_t asid_get(void)
 		as_invalidate_translation_cache(as, 0, (size_t) -1);
 
 		/*
-		 * Get the system rid of the stolen ASID.
+		 * Get the system rid of the stolen ASID. Only the processors
+		 * on which the victim address space has run can cache it.
 		 */
-		ipl_t ipl = tlb_shootdown_start(TLB_INVL_ASID, asid, 0, 0);
+		ipl_t ipl = tlb_shootdown_start_targeted(as->cpu_mask,
+		    TLB_INVL_ASID, asid, 0, 0);
 		tlb_invalidate_asid(asid);
 		tlb_shootdown_finalize(ipl);
+
+		/*
+		 * The address space will be recorded again on the processors
+		 * it runs on once it is assigned a new ASID.
+		 */
+		cpu_mask_none(as->cpu_mask);
 	} else {
 
 		/*
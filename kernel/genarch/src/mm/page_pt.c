@@ -56,32 +56,77 @@ static void pt_mapping_remove(as_t *, uintptr_t);
 static bool pt_mapping_find(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_update(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_make_global(uintptr_t, size_t);
+#ifdef LARGE_PAGE_SIZE
+static void pt_mapping_insert_large(as_t *, uintptr_t, uintptr_t, unsigned int);
+#endif
 
 page_mapping_operations_t pt_mapping_operations = {
 	.mapping_insert = pt_mapping_insert,
 	.mapping_remove = pt_mapping_remove,
 	.mapping_find = pt_mapping_find,
 	.mapping_update = pt_mapping_update,
-	.mapping_make_global = pt_mapping_make_global
+	.mapping_make_global = pt_mapping_make_global,
+#ifdef LARGE_PAGE_SIZE
+	.mapping_insert_large = pt_mapping_insert_large,
+	.large_page_size = LARGE_PAGE_SIZE
+#endif
 };
 
-/** Map page to frame using hierarchical page tables.
+#ifdef LARGE_PAGE_SIZE
+
+/** Replace large page mapping by a PTL3 mapping the same frames.
  *
- * Map virtual address page to physical address frame
- * using flags.
+ * The PTL3 inherits the flags of the large page. The translation of the
+ * affected addresses does not change, so TLB entries cached for the large
+ * page remain valid until they are invalidated as part of the operation
+ * which required the split.
  *
- * @param as    Address space to wich page belongs.
- * @param page  Virtual address of the page to be mapped.
- * @param frame Physical address of memory frame to which the mapping is done.
- * @param flags Flags to be used for mapping.
+ * @param ptl2 PTL2 containing the large page mapping.
+ * @param i    Index of the large page mapping in PTL2.
  *
  */
-void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
-    unsigned int flags)
+static void pt_large_split(pte_t *ptl2, size_t i)
 {
-	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
+	uintptr_t frame = (uintptr_t) GET_PTL3_ADDRESS(ptl2, i);
+	unsigned int flags = GET_PTL3_FLAGS(ptl2, i);
 
-	assert(page_table_locked(as));
+	pte_t *newpt = (pte_t *)
+	    PA2KA(frame_alloc(PTL3_FRAMES, FRAME_LOWMEM, PTL3_SIZE - 1));
+	memsetb(newpt, PTL3_SIZE, 0);
+
+	for (size_t j = 0; j < PTL3_ENTRIES; j++) {
+		SET_FRAME_ADDRESS(newpt, j, frame + P2SZ(j));
+		SET_FRAME_FLAGS(newpt, j, flags);
+	}
+
+	/*
+	 * Prepare the new PTL2 entry aside and replace the large page mapping
+	 * by a single store so that a concurrent hardware page table walk
+	 * sees either the old or the new entry.
+	 */
+	pte_t entry;
+	memsetb(&entry, sizeof(entry), 0);
+	SET_PTL3_ADDRESS(&entry, 0, KA2PA(newpt));
+	SET_PTL3_FLAGS(&entry, 0, PAGE_PRESENT | PAGE_USER | PAGE_EXEC |
+	    PAGE_CACHEABLE | PAGE_WRITE);
+
+	write_barrier();
+	ptl2[i] = entry;
+}
+
+#endif /* LARGE_PAGE_SIZE */
+
+/** Get PTL2 for page, allocating any missing page tables on the way.
+ *
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the page.
+ *
+ * @return PTL2 covering page.
+ *
+ */
+static pte_t *pt_ptl2_get(as_t *as, uintptr_t page)
+{
+	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
 
 	if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
@@ -117,7 +162,31 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 		SET_PTL2_PRESENT(ptl1, PTL1_INDEX(page));
 	}
 
-	pte_t *ptl2 = (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+	return (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+}
+
+/** Map page to frame using hierarchical page tables.
+ *
+ * Map virtual address page to physical address frame
+ * using flags.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the page to be mapped.
+ * @param frame Physical address of memory frame to which the mapping is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+
+#ifdef LARGE_PAGE_SIZE
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page)))
+		pt_large_split(ptl2, PTL2_INDEX(page));
+#endif
 
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
@@ -145,6 +214,53 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 	SET_FRAME_PRESENT(ptl3, PTL3_INDEX(page));
 }
 
+#ifdef LARGE_PAGE_SIZE
+
+/** Map large page to a block of frames using hierarchical page tables.
+ *
+ * The large page is mapped directly by a PTL2 entry. A PTL3 previously
+ * covering the large page must not contain any valid mappings and is freed.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the block of frames to which the mapping
+ *              is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void pt_mapping_insert_large(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(page_table_locked(as));
+	assert(IS_ALIGNED(page, LARGE_PAGE_SIZE));
+	assert(IS_ALIGNED(frame, LARGE_PAGE_SIZE));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+	size_t i = PTL2_INDEX(page);
+
+	if (!(GET_PTL3_FLAGS(ptl2, i) & PAGE_NOT_PRESENT) &&
+	    !GET_PTL3_LARGE(ptl2, i)) {
+		pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, i));
+
+		for (size_t j = 0; j < PTL3_ENTRIES; j++)
+			assert(!PTE_VALID(&ptl3[j]));
+
+		memsetb(&ptl2[i], sizeof(pte_t), 0);
+		frame_free(KA2PA((uintptr_t) ptl3), PTL3_FRAMES);
+	}
+
+	SET_PTL3_ADDRESS(ptl2, i, frame);
+	SET_PTL3_FLAGS(ptl2, i, flags | PAGE_NOT_PRESENT);
+	SET_PTL3_LARGE(ptl2, i);
+	/*
+	 * Make the new mapping visible only after it is fully initialized.
+	 */
+	write_barrier();
+	SET_PTL3_PRESENT(ptl2, i);
+}
+
+#endif /* LARGE_PAGE_SIZE */
+
 /** Remove mapping of page from hierarchical page tables.
  *
  * Remove any mapping of page within address space as.
@@ -177,6 +293,12 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return;
 
+#ifdef LARGE_PAGE_SIZE
+	/* Only the requested page is demapped, keep the rest mapped. */
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page)))
+		pt_large_split(ptl2, PTL2_INDEX(page));
+#endif
+
 	pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
 
 	/*
@@ -291,7 +413,8 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 #endif /* PTL1_ENTRIES != 0 */
 }
 
-static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
+static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock,
+    bool *large)
 {
 	assert(nolock || page_table_locked(as));
 
@@ -316,6 +439,13 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return NULL;
 
+#ifdef LARGE_PAGE_SIZE
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page))) {
+		*large = true;
+		return &ptl2[PTL2_INDEX(page)];
+	}
+#endif
+
 #if (PTL2_ENTRIES != 0)
 	/*
 	 * Always read ptl3 only after we are sure it is present.
@@ -339,9 +469,19 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
  */
 bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
-	if (t)
+	bool large = false;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
+	if (t) {
 		*pte = *t;
+
+#ifdef LARGE_PAGE_SIZE
+		/* Present the large page as a mapping of the single page. */
+		if (large) {
+			SET_FRAME_ADDRESS(pte, 0, PTE_GET_FRAME(t) +
+			    (page & (LARGE_PAGE_SIZE - 1)));
+		}
+#endif
+	}
 	return t != NULL;
 }
 
@@ -354,17 +494,26 @@ bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
  */
 void pt_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
+	bool large = false;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
 	if (!t)
 		panic("Updating non-existent PTE");
 
-	assert(PTE_VALID(t) == PTE_VALID(pte));
-	assert(PTE_PRESENT(t) == PTE_PRESENT(pte));
-	assert(PTE_GET_FRAME(t) == PTE_GET_FRAME(pte));
-	assert(PTE_WRITABLE(t) == PTE_WRITABLE(pte));
-	assert(PTE_EXECUTABLE(t) == PTE_EXECUTABLE(pte));
+	pte_t new = *pte;
+
+#ifdef LARGE_PAGE_SIZE
+	/* The large page PTE was presented as a mapping of the single page. */
+	if (large)
+		SET_FRAME_ADDRESS(&new, 0, PTE_GET_FRAME(t));
+#endif
+
+	assert(PTE_VALID(t) == PTE_VALID(&new));
+	assert(PTE_PRESENT(t) == PTE_PRESENT(&new));
+	assert(PTE_GET_FRAME(t) == PTE_GET_FRAME(&new));
+	assert(PTE_WRITABLE(t) == PTE_WRITABLE(&new));
+	assert(PTE_EXECUTABLE(t) == PTE_EXECUTABLE(&new));
 
-	*t = *pte;
+	*t = new;
 }
 
 /** Return the size of the region mapped by a single PTL0 entry.
@@ -38,9 +38,8 @@
 #include <abi/cap.h>
 #include <typedefs.h>
 #include <adt/list.h>
-#include <adt/hash.h>
-#include <adt/hash_table.h>
 #include <lib/ra.h>
+#include <mm/slab.h>
 #include <synch/mutex.h>
 #include <atomic.h>
 
@@ -73,6 +72,24 @@ extern kobject_ops_t *kobject_ops[];
 
 #define KOBJECT_OP(k)	kobject_ops[(k)->type]
 
+/** Number of capability slots in one leaf of the capability table. */
+#define CAPS_LEAF_SIZE	512
+/** Number of leaves in the capability table. */
+#define CAPS_DIR_SIZE	512
+
+/** Object retired from the lock-free capability lookup
+ *
+ * Capabilities and kernel objects may still be referenced by a concurrent
+ * kobject_get(), so they are only returned to their slab cache once all
+ * CPUs have left the lookup (see cap.c).
+ */
+typedef struct cap_retired {
+	link_t link;
+	unsigned int epoch;
+	slab_cache_t *cache;
+	void *obj;
+} cap_retired_t;
+
 /*
  * Everything in kobject_t except for the atomic reference count, the capability
  * list and its lock is imutable.
@@ -93,10 +110,13 @@ typedef struct kobject {
 		struct phone *phone;
 		struct waitq *waitq;
 	};
+
+	cap_retired_t retired;
 } kobject_t;
 
 /*
- * A cap_t may only be accessed under the protection of the cap_info_t lock.
+ * A cap_t may only be modified under the protection of the cap_info_t lock.
+ * kobject_get() reads the kobject member without holding the lock.
  */
 typedef struct cap {
 	cap_state_t state;
@@ -110,22 +130,30 @@ typedef struct cap {
 	/* Link to the task's capabilities of the same kobject type. */
 	link_t type_link;
 
-	ht_link_t caps_link;
+	/* The underlying kernel object, NULL unless published. */
+	_Atomic(kobject_t *) kobject;
 
-	/* The underlying kernel object. */
-	kobject_t *kobject;
+	cap_retired_t retired;
 } cap_t;
 
+/** Leaf of the capability table. */
+typedef struct cap_leaf {
+	_Atomic(cap_t *) caps[CAPS_LEAF_SIZE];
+} cap_leaf_t;
+
 typedef struct cap_info {
 	mutex_t lock;
 
 	list_t type_list[KOBJECT_TYPE_MAX];
 
-	hash_table_t caps;
+	/** Capabilities indexed by handle. Modified under lock. */
+	_Atomic(cap_leaf_t *) caps[CAPS_DIR_SIZE];
 	ra_arena_t *handles;
 } cap_info_t;
 
 extern void caps_init(void);
+extern void caps_reclaim_kick(void);
+extern void kcapreclaim(void *);
 extern errno_t caps_task_alloc(struct task *);
 extern void caps_task_free(struct task *);
 extern void caps_task_init(struct task *);
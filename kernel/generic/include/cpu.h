@@ -37,6 +37,7 @@
 
 #include <mm/tlb.h>
 #include <synch/spinlock.h>
+#include <synch/waitq.h>
 #include <proc/scheduler.h>
 #include <arch/cpu.h>
 #include <arch/context.h>
@@ -89,6 +90,45 @@ typedef struct cpu {
 	bool active;
 	volatile bool tlb_active;
 
+	/**
+	 * TLB shootdown accounting. Updated by the
+	 * owning CPU with interrupts disabled.
+	 */
+	uint64_t tlb_shootdowns;
+	uint64_t tlb_shootdowns_received;
+	uint64_t tlb_ipis_sent;
+	uint64_t tlb_ipis_avoided;
+
+	/**
+	 * Page fault accounting. Updated by threads running on
+	 * the CPU with preemption disabled.
+	 */
+	uint64_t page_faults;
+	uint64_t large_pages_mapped;
+
+	/**
+	 * Capability lookup epoch this CPU is in, zero if none.
+	 * See kobject_get().
+	 */
+	atomic_uint cap_epoch;
+
+	/**
+	 * Capabilities and kernel objects retired on this CPU
+	 * and waiting to be freed. Accessed with interrupts
+	 * disabled.
+	 */
+	list_t cap_retired;
+	size_t cap_retired_count;
+
+	/**
+	 * Wait queue of the kcapreclaim thread of this CPU and
+	 * a flag telling that it has been woken up and has not
+	 * finished yet. The flag is accessed with interrupts
+	 * disabled.
+	 */
+	waitq_t cap_reclaim_wq;
+	bool cap_reclaim_pending;
+
 	uint16_t frequency_mhz;
 	uint32_t delay_loop_const;
 
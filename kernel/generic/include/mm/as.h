@@ -107,6 +107,15 @@ typedef struct as {
 	 */
 	size_t cpu_refcount;
 
+	/**
+	 * Processors which may hold TLB entries of this
+	 * address space. Processors are added by as_switch()
+	 * and the mask is only cleared when the address space
+	 * loses its ASID. NULL for the kernel address space.
+	 * Modified under asidlock.
+	 */
+	struct cpu_mask *cpu_mask;
+
 	/** Address space identifier.
 	 *
 	 * Constant on architectures that do not
@@ -273,6 +282,9 @@ typedef struct {
 	/** Map of used space. */
 	used_space_t used_space;
 
+	/** Page of the last page fault, used to detect sequential access. */
+	uintptr_t fault_last;
+
 	/**
 	 * If the address space area is shared. this is
 	 * a reference to the share info structure.
@@ -336,6 +348,7 @@ extern void as_pagemap_remove(as_page_mapping_t *);
 
 extern unsigned int as_area_get_flags(as_area_t *);
 extern bool as_area_check_access(as_area_t *, pf_access_t);
+extern bool as_area_large_page_get(as_area_t *, uintptr_t, uintptr_t *);
 extern size_t as_area_get_size(uintptr_t);
 extern used_space_ival_t *used_space_first(used_space_t *);
 extern used_space_ival_t *used_space_next(used_space_ival_t *);
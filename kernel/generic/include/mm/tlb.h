@@ -64,16 +64,23 @@ typedef struct {
 	size_t count;			/**< Number of pages to invalidate. */
 } tlb_shootdown_msg_t;
 
+struct cpu_mask;
+
 extern void tlb_init(void);
 
 #ifdef CONFIG_SMP
 extern ipl_t tlb_shootdown_start(tlb_invalidate_type_t, asid_t, uintptr_t,
     size_t);
+extern ipl_t tlb_shootdown_start_targeted(struct cpu_mask *,
+    tlb_invalidate_type_t, asid_t, uintptr_t, size_t);
 extern void tlb_shootdown_finalize(ipl_t);
+extern void tlb_shootdown_sync(asid_t);
 extern void tlb_shootdown_ipi_recv(void);
 #else
 #define tlb_shootdown_start(w, x, y, z)	interrupts_disable()
+#define tlb_shootdown_start_targeted(v, w, x, y, z)	interrupts_disable()
 #define tlb_shootdown_finalize(i)	(interrupts_restore(i));
+#define tlb_shootdown_sync(a)	((void) (a))
 #define tlb_shootdown_ipi_recv()
 #endif /* CONFIG_SMP */
 
@@ -35,6 +35,7 @@
 #ifndef KERN_TASK_H_
 #define KERN_TASK_H_
 
+#include <atomic.h>
 #include <cpu.h>
 #include <ipc/ipc.h>
 #include <ipc/event.h>
@@ -115,6 +116,16 @@ typedef struct task {
 	/** IPC statistics */
 	stats_ipc_t ipc_info;
 
+	/**
+	 * Page fault statistics. Updated by the fault path without
+	 * holding the task lock.
+	 */
+	struct {
+		atomic_size_t page_faults;
+		atomic_size_t faulted_around;
+		atomic_size_t prezeroed;
+	} fault_info;
+
 #ifdef CONFIG_UDEBUG
 	/** Debugging stuff. */
 	udebug_task_t udebug;
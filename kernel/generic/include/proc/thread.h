@@ -149,6 +149,9 @@ typedef struct thread {
 	/** Link used in the joiner_head list. */
 	link_t joiner_link;
 
+	/** Adaptive and recursive mutexes held by the thread. */
+	list_t mutexes;
+
 	fpu_context_t *saved_fpu_context;
 	bool fpu_context_exists;
 
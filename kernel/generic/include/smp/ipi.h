@@ -37,12 +37,17 @@
 
 #ifdef CONFIG_SMP
 
+struct cpu_mask;
+
 extern void ipi_broadcast(int);
 extern void ipi_broadcast_arch(int);
+extern void ipi_multicast(int, struct cpu_mask *);
+extern void ipi_multicast_arch(int, struct cpu_mask *);
 
 #else
 
 #define ipi_broadcast(ipi)
+#define ipi_multicast(ipi, mask)
 
 #endif /* CONFIG_SMP */
 
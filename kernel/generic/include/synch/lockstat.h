@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_LOCKSTAT_H_
+#define KERN_LOCKSTAT_H_
+
+#ifdef CONFIG_LOCKSTAT
+
+#include <typedefs.h>
+#include <abi/sysinfo.h>
+#include <arch/cycle.h>
+
+/** Number of distinct lock names which can be tracked. */
+#define LOCKSTAT_ENTRIES  512
+
+struct spinlock;
+
+#define lockstat_now()  get_cycle()
+
+extern void lockstat_acquire(struct spinlock *, bool, uint64_t);
+extern void lockstat_release(struct spinlock *);
+
+extern size_t lockstat_count(void);
+extern size_t lockstat_snapshot(stats_lock_t *, size_t);
+extern void lockstat_reset(void);
+extern void lockstat_print(bool);
+
+#else /* CONFIG_LOCKSTAT */
+
+#define lockstat_now()  0
+
+#define lockstat_acquire(lock, contended, spin) \
+	((void) (lock), (void) (contended), (void) (spin))
+#define lockstat_release(lock)  ((void) (lock))
+
+#endif /* CONFIG_LOCKSTAT */
+
+#endif
+
+/** @}
+ */
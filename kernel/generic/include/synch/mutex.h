@@ -35,15 +35,26 @@
 #ifndef KERN_MUTEX_H_
 #define KERN_MUTEX_H_
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <adt/list.h>
 #include <synch/semaphore.h>
 #include <abi/synch.h>
+#include <abi/sysinfo.h>
 
 typedef enum {
+	/** Sleep when the mutex is locked. */
 	MUTEX_PASSIVE,
+	/** Like MUTEX_ADAPTIVE, but may be locked repeatedly by its owner. */
 	MUTEX_RECURSIVE,
-	MUTEX_ACTIVE
+	/** Spin when the mutex is locked. */
+	MUTEX_ACTIVE,
+	/**
+	 * Spin while the owner is running on another CPU,
+	 * sleep otherwise.
+	 */
+	MUTEX_ADAPTIVE
 } mutex_type_t;
 
 struct thread;
@@ -51,7 +62,12 @@ struct thread;
 typedef struct {
 	mutex_type_t type;
 	semaphore_t sem;
-	struct thread *owner;
+	/** Owner of an adaptive or recursive mutex. */
+	_Atomic(struct thread *) owner;
+	/** Owner of an adaptive or recursive mutex is on a CPU. */
+	atomic_bool running;
+	/** Link in the owner's list of held mutexes. */
+	link_t owner_link;
 	unsigned nesting;
 } mutex_t;
 
@@ -68,6 +84,8 @@ extern void mutex_initialize(mutex_t *, mutex_type_t);
 extern bool mutex_locked(mutex_t *);
 extern errno_t _mutex_lock_timeout(mutex_t *, uint32_t, unsigned int);
 extern void mutex_unlock(mutex_t *);
+extern void mutex_stats_get(stats_mutex_t *);
+extern void mutex_owner_switch(struct thread *, bool);
 
 #endif
 
@@ -38,17 +38,38 @@
 #include <assert.h>
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <preemption.h>
 #include <arch/asm.h>
 
 #ifdef CONFIG_SMP
 
+/** Ticket spinlock
+ *
+ * Each locker takes a ticket and spins until the lock serves it. This
+ * makes the lock fair (FIFO) and the waiters only read the shared cache
+ * line until it is their turn.
+ */
 typedef struct spinlock {
-	atomic_flag flag;
+	/** Next ticket to be handed out. */
+	atomic_uint ticket;
+	/** Ticket of the current lock holder. */
+	atomic_uint serving;
 
 #ifdef CONFIG_DEBUG_SPINLOCK
 	const char *name;
 #endif /* CONFIG_DEBUG_SPINLOCK */
+
+#ifdef CONFIG_LOCKSTAT
+	/** Statistics of locks with the same name. */
+	struct lockstat *stat;
+	/** Cycle count when the lock was acquired. */
+	uint64_t acquired;
+	/** Cycles spent waiting for the lock by its current holder. */
+	uint64_t spin;
+	/** Whether the current holder had to wait for the lock. */
+	bool contended;
+#endif /* CONFIG_LOCKSTAT */
 } spinlock_t;
 
 /*
@@ -68,13 +89,15 @@ typedef struct spinlock {
 #define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	spinlock_t lock_name = { \
 		.name = desc_name, \
-		.flag = ATOMIC_FLAG_INIT \
+		.ticket = 0, \
+		.serving = 0 \
 	}
 
 #define SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static spinlock_t lock_name = { \
 		.name = desc_name, \
-		.flag = ATOMIC_FLAG_INIT \
+		.ticket = 0, \
+		.serving = 0 \
 	}
 
 #define ASSERT_SPINLOCK(expr, lock) \
@@ -87,12 +110,14 @@ typedef struct spinlock {
 
 #define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	spinlock_t lock_name = { \
-		.flag = ATOMIC_FLAG_INIT \
+		.ticket = 0, \
+		.serving = 0 \
 	}
 
 #define SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static spinlock_t lock_name = { \
-		.flag = ATOMIC_FLAG_INIT \
+		.ticket = 0, \
+		.serving = 0 \
 	}
 
 #define ASSERT_SPINLOCK(expr, lock) \
@@ -105,8 +130,11 @@ typedef struct spinlock {
 _NO_TRACE static inline void spinlock_lock(spinlock_t *lock)
 {
 	preemption_disable();
-	while (atomic_flag_test_and_set_explicit(&lock->flag,
-	    memory_order_acquire))
+
+	unsigned int ticket = atomic_fetch_add_explicit(&lock->ticket, 1,
+	    memory_order_relaxed);
+	while (atomic_load_explicit(&lock->serving, memory_order_acquire) !=
+	    ticket)
 		;
 }
 
@@ -116,7 +144,9 @@ _NO_TRACE static inline void spinlock_lock(spinlock_t *lock)
  */
 _NO_TRACE static inline void spinlock_unlock(spinlock_t *lock)
 {
-	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+	unsigned int serving = atomic_load_explicit(&lock->serving,
+	    memory_order_relaxed);
+	atomic_store_explicit(&lock->serving, serving + 1, memory_order_release);
 	preemption_enable();
 }
 
@@ -214,7 +244,8 @@ typedef struct {
 	irq_spinlock_t lock_name = { \
 		.lock = { \
 			.name = desc_name, \
-			.flag = ATOMIC_FLAG_INIT \
+			.ticket = 0, \
+			.serving = 0 \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
@@ -224,7 +255,8 @@ typedef struct {
 	static irq_spinlock_t lock_name = { \
 		.lock = { \
 			.name = desc_name, \
-			.flag = ATOMIC_FLAG_INIT \
+			.ticket = 0, \
+			.serving = 0 \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
@@ -235,7 +267,8 @@ typedef struct {
 #define IRQ_SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	irq_spinlock_t lock_name = { \
 		.lock = { \
-			.flag = ATOMIC_FLAG_INIT \
+			.ticket = 0, \
+			.serving = 0 \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
@@ -244,7 +277,8 @@ typedef struct {
 #define IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static irq_spinlock_t lock_name = { \
 		.lock = { \
-			.flag = ATOMIC_FLAG_INIT \
+			.ticket = 0, \
+			.serving = 0 \
 		}, \
 		.guard = false, \
 		.ipl = 0 \
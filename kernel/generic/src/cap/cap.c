@@ -73,12 +73,25 @@
  * kobject_get() or kobject_add_ref(). When the kernel object is removed from
  * the container, the reference count should go down via a call to
  * kobject_put().
+ *
+ * Capabilities are stored in a per-task two-level table indexed by handle.
+ * The table is modified under the task's cap_info_t lock, but kobject_get(),
+ * which is on the fast path of every IPC operation, looks capabilities up
+ * without taking any lock. Capabilities and kernel objects which such a
+ * lookup may still be examining are therefore freed using epoch-based
+ * reclamation: the lookup announces the global epoch in its cpu_t, freed
+ * objects are tagged with the epoch in which they were retired and are only
+ * returned to their slab cache after the global epoch has advanced twice,
+ * which requires every CPU inside a lookup to have observed a newer epoch.
  */
 
+#include <assert.h>
 #include <cap/cap.h>
 #include <abi/cap.h>
 #include <proc/task.h>
+#include <proc/thread.h>
 #include <synch/mutex.h>
+#include <synch/waitq.h>
 #include <abi/errno.h>
 #include <mm/slab.h>
 #include <adt/list.h>
@@ -86,14 +99,21 @@
 #include <ipc/ipcrsc.h>
 #include <ipc/ipc.h>
 #include <ipc/irq.h>
+#include <arch.h>
+#include <cpu.h>
+#include <config.h>
+#include <mem.h>
 
 #include <limits.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 #define CAPS_START	((intptr_t) CAP_NIL + 1)
-#define CAPS_SIZE	(INT_MAX - (int) CAPS_START)
-#define CAPS_LAST	(CAPS_SIZE - 1)
+#define CAPS_SIZE	(CAPS_DIR_SIZE * CAPS_LEAF_SIZE - (int) CAPS_START)
+#define CAPS_LAST	(CAPS_START + CAPS_SIZE - 1)
+
+/** Number of retired objects after which a CPU tries to free them. */
+#define CAPS_RETIRED_BATCH	32
 
 static slab_cache_t *cap_cache;
 static slab_cache_t *kobject_cache;
@@ -105,30 +125,276 @@ kobject_ops_t *kobject_ops[KOBJECT_TYPE_MAX] = {
 	[KOBJECT_TYPE_WAITQ] = &waitq_kobject_ops
 };
 
-static size_t caps_hash(const ht_link_t *item)
+/** Global capability lookup epoch, never zero. */
+static atomic_uint caps_epoch = 1;
+
+/** Enter lock-free capability lookup.
+ *
+ * @return Token to be passed to caps_lookup_end().
+ */
+static unsigned int caps_lookup_begin(void)
 {
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return hash_mix(cap_handle_raw(cap->handle));
+	preemption_disable();
+
+	/*
+	 * An interrupt handler may nest inside a lookup. Keeping the older
+	 * announcement in that case is conservative.
+	 */
+	unsigned int prev = atomic_load_explicit(&CPU->cap_epoch,
+	    memory_order_relaxed);
+	if (prev == 0) {
+		atomic_store_explicit(&CPU->cap_epoch,
+		    atomic_load_explicit(&caps_epoch, memory_order_relaxed),
+		    memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+	}
+
+	return prev;
 }
 
-static size_t caps_key_hash(const void *key)
+/** Leave lock-free capability lookup.
+ *
+ * @param prev Token returned by caps_lookup_begin().
+ */
+static void caps_lookup_end(unsigned int prev)
 {
-	const cap_handle_t *handle = key;
-	return hash_mix(cap_handle_raw(*handle));
+	atomic_store_explicit(&CPU->cap_epoch, prev, memory_order_release);
+	preemption_enable();
 }
 
-static bool caps_key_equal(const void *key, const ht_link_t *item)
+/** Advance the global epoch if all CPUs in a lookup have observed it. */
+static void caps_epoch_try_advance(void)
 {
-	const cap_handle_t *handle = key;
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return *handle == cap->handle;
+	atomic_thread_fence(memory_order_seq_cst);
+
+	unsigned int epoch = atomic_load_explicit(&caps_epoch,
+	    memory_order_relaxed);
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		unsigned int cur = atomic_load_explicit(&cpus[i].cap_epoch,
+		    memory_order_acquire);
+		if ((cur != 0) && (cur != epoch))
+			return;
+	}
+
+	unsigned int next = epoch + 1;
+	if (next == 0)
+		next = 1;
+
+	(void) atomic_compare_exchange_strong(&caps_epoch, &epoch, next);
 }
 
-static hash_table_ops_t caps_ops = {
-	.hash = caps_hash,
-	.key_hash = caps_key_hash,
-	.key_equal = caps_key_equal
-};
+/** Collect retired objects of this CPU which can be freed.
+ *
+ * Must be called with interrupts disabled.
+ *
+ * @param reclaim List to which the reclaimable records are moved.
+ * @param advance Try to advance the global epoch first.
+ */
+static void caps_reclaim_collect(list_t *reclaim, bool advance)
+{
+	if (advance)
+		caps_epoch_try_advance();
+
+	unsigned int epoch = atomic_load_explicit(&caps_epoch,
+	    memory_order_relaxed);
+
+	list_foreach_safe(CPU->cap_retired, cur, next) {
+		cap_retired_t *r = list_get_instance(cur, cap_retired_t, link);
+
+		/* Objects are retired in epoch order. */
+		if (epoch - r->epoch < 2)
+			break;
+
+		list_remove(&r->link);
+		list_append(&r->link, reclaim);
+		CPU->cap_retired_count--;
+	}
+}
+
+/** Return collected retired objects to their slab caches.
+ *
+ * @param reclaim List filled by caps_reclaim_collect().
+ */
+static void caps_reclaim_free(list_t *reclaim)
+{
+	list_foreach_safe(*reclaim, cur, next) {
+		cap_retired_t *r = list_get_instance(cur, cap_retired_t, link);
+		list_remove(&r->link);
+		slab_free(r->cache, r->obj);
+	}
+}
+
+/** Free an object once no lock-free lookup can reference it anymore.
+ *
+ * Objects retired earlier whose grace period has meanwhile passed are
+ * freed as well. The global epoch is pushed forward only once a batch
+ * of objects has accumulated.
+ *
+ * @param retired Retirement record embedded in the object.
+ * @param cache   Slab cache of the object.
+ * @param obj     Object to free.
+ */
+static void caps_retire(cap_retired_t *retired, slab_cache_t *cache,
+    void *obj)
+{
+	list_t reclaim;
+	list_initialize(&reclaim);
+
+	retired->cache = cache;
+	retired->obj = obj;
+	link_initialize(&retired->link);
+
+	ipl_t ipl = interrupts_disable();
+
+	/* Order the unlinking of the object before reading the epoch. */
+	atomic_thread_fence(memory_order_seq_cst);
+	retired->epoch = atomic_load_explicit(&caps_epoch,
+	    memory_order_relaxed);
+
+	list_append(&retired->link, &CPU->cap_retired);
+
+	caps_reclaim_collect(&reclaim,
+	    ++CPU->cap_retired_count >= CAPS_RETIRED_BATCH);
+
+	interrupts_restore(ipl);
+
+	caps_reclaim_free(&reclaim);
+}
+
+/** Free objects retired on this CPU whose grace period has passed. */
+static void caps_reclaim(void)
+{
+	list_t reclaim;
+	list_initialize(&reclaim);
+
+	ipl_t ipl = interrupts_disable();
+
+	if (CPU->cap_retired_count == 0) {
+		interrupts_restore(ipl);
+		return;
+	}
+
+	caps_reclaim_collect(&reclaim, true);
+
+	interrupts_restore(ipl);
+
+	caps_reclaim_free(&reclaim);
+}
+
+/** Wake up the reclaimer of this CPU if there is something to free.
+ *
+ * Called by the scheduler before the CPU goes idle, so that objects
+ * retired on a CPU which subsequently stops retiring more of them are
+ * eventually freed. The objects are freed by kcapreclaim rather than
+ * here, as the idle path must not call into the slab allocator.
+ *
+ * Must be called with interrupts disabled.
+ */
+void caps_reclaim_kick(void)
+{
+	assert(interrupts_disabled());
+
+	if ((CPU->cap_retired_count == 0) || CPU->cap_reclaim_pending)
+		return;
+
+	caps_epoch_try_advance();
+
+	unsigned int epoch = atomic_load_explicit(&caps_epoch,
+	    memory_order_relaxed);
+	cap_retired_t *r = list_get_instance(list_first(&CPU->cap_retired),
+	    cap_retired_t, link);
+
+	/* Do not keep the CPU busy until the grace period passes. */
+	if (epoch - r->epoch < 2)
+		return;
+
+	CPU->cap_reclaim_pending = true;
+	waitq_wakeup(&CPU->cap_reclaim_wq, WAKEUP_FIRST);
+}
+
+/** Kernel thread freeing capabilities retired on its CPU.
+ *
+ * One instance is wired to every CPU and woken up by caps_reclaim_kick().
+ *
+ * @param arg Generic thread argument (unused).
+ */
+void kcapreclaim(void *arg)
+{
+	/*
+	 * Detach kcapreclaim as nobody will call thread_join_timeout() on it.
+	 */
+	thread_detach(THREAD);
+
+	while (true) {
+		waitq_sleep(&CPU->cap_reclaim_wq);
+		caps_reclaim();
+
+		ipl_t ipl = interrupts_disable();
+		CPU->cap_reclaim_pending = false;
+		interrupts_restore(ipl);
+	}
+}
+
+/** Find capability in the capability table.
+ *
+ * Must be called either with the cap_info_t lock held or inside
+ * caps_lookup_begin() and caps_lookup_end().
+ *
+ * @param task    Task whose capability to find.
+ * @param handle  Capability handle.
+ *
+ * @return Capability or NULL if there is none with the handle.
+ */
+static cap_t *caps_lookup(task_t *task, cap_handle_t handle)
+{
+	intptr_t raw = cap_handle_raw(handle);
+
+	if ((raw < CAPS_START) || (raw > CAPS_LAST))
+		return NULL;
+
+	cap_leaf_t *leaf = atomic_load_explicit(
+	    &task->cap_info->caps[raw / CAPS_LEAF_SIZE], memory_order_acquire);
+	if (!leaf)
+		return NULL;
+
+	return atomic_load_explicit(&leaf->caps[raw % CAPS_LEAF_SIZE],
+	    memory_order_acquire);
+}
+
+/** Store capability into the capability table.
+ *
+ * The cap_info_t lock must be held.
+ *
+ * @param task    Task whose capability table to modify.
+ * @param handle  Capability handle.
+ * @param cap     Capability or NULL to clear the slot.
+ *
+ * @return EOK on success, ENOMEM if a table leaf cannot be allocated.
+ */
+static errno_t caps_store(task_t *task, cap_handle_t handle, cap_t *cap)
+{
+	intptr_t raw = cap_handle_raw(handle);
+	_Atomic(cap_leaf_t *) *slot = &task->cap_info->caps[raw / CAPS_LEAF_SIZE];
+
+	cap_leaf_t *leaf = atomic_load_explicit(slot, memory_order_relaxed);
+	if (!leaf) {
+		assert(cap != NULL);
+
+		leaf = malloc(sizeof(cap_leaf_t));
+		if (!leaf)
+			return ENOMEM;
+
+		for (size_t i = 0; i < CAPS_LEAF_SIZE; i++)
+			atomic_init(&leaf->caps[i], NULL);
+
+		atomic_store_explicit(slot, leaf, memory_order_release);
+	}
+
+	atomic_store_explicit(&leaf->caps[raw % CAPS_LEAF_SIZE], cap,
+	    memory_order_release);
+	return EOK;
+}
 
 void caps_init(void)
 {
@@ -152,8 +418,8 @@ errno_t caps_task_alloc(task_t *task)
 		goto error_handles;
 	if (!ra_span_add(task->cap_info->handles, CAPS_START, CAPS_SIZE))
 		goto error_span;
-	if (!hash_table_create(&task->cap_info->caps, 0, 0, &caps_ops))
-		goto error_span;
+	for (size_t i = 0; i < CAPS_DIR_SIZE; i++)
+		atomic_init(&task->cap_info->caps[i], NULL);
 	return EOK;
 
 error_span:
@@ -181,7 +447,12 @@ void caps_task_init(task_t *task)
  */
 void caps_task_free(task_t *task)
 {
-	hash_table_destroy(&task->cap_info->caps);
+	for (size_t i = 0; i < CAPS_DIR_SIZE; i++) {
+		cap_leaf_t *leaf = atomic_load_explicit(&task->cap_info->caps[i],
+		    memory_order_relaxed);
+		if (leaf)
+			free(leaf);
+	}
 	ra_arena_destroy(task->cap_info->handles);
 	free(task->cap_info);
 }
@@ -227,6 +498,7 @@ static void cap_initialize(cap_t *cap, task_t *task, cap_handle_t handle)
 	cap->handle = handle;
 	link_initialize(&cap->kobj_link);
 	link_initialize(&cap->type_link);
+	atomic_init(&cap->kobject, NULL);
 }
 
 /** Get capability using capability handle
@@ -242,13 +514,9 @@ static cap_t *cap_get(task_t *task, cap_handle_t handle, cap_state_t state)
 {
 	assert(mutex_locked(&task->cap_info->lock));
 
-	if ((cap_handle_raw(handle) < CAPS_START) ||
-	    (cap_handle_raw(handle) > CAPS_LAST))
-		return NULL;
-	ht_link_t *link = hash_table_find(&task->cap_info->caps, &handle);
-	if (!link)
+	cap_t *cap = caps_lookup(task, handle);
+	if (!cap)
 		return NULL;
-	cap_t *cap = hash_table_get_inst(link, cap_t, caps_link);
 	if (cap->state != state)
 		return NULL;
 	return cap;
@@ -277,7 +545,12 @@ errno_t cap_alloc(task_t *task, cap_handle_t *handle)
 		return ENOMEM;
 	}
 	cap_initialize(cap, task, (cap_handle_t) hbase);
-	hash_table_insert(&task->cap_info->caps, &cap->caps_link);
+	if (caps_store(task, cap->handle, cap) != EOK) {
+		ra_free(task->cap_info->handles, hbase, 1);
+		slab_free(cap_cache, cap);
+		mutex_unlock(&task->cap_info->lock);
+		return ENOMEM;
+	}
 
 	cap->state = CAP_STATE_ALLOCATED;
 	*handle = cap->handle;
@@ -304,8 +577,8 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 	cap_t *cap = cap_get(task, handle, CAP_STATE_ALLOCATED);
 	assert(cap);
 	cap->state = CAP_STATE_PUBLISHED;
-	/* Hand over kobj's reference to cap */
-	cap->kobject = kobj;
+	/* Hand over kobj's reference to cap, make it visible to kobject_get() */
+	atomic_store_explicit(&cap->kobject, kobj, memory_order_release);
 	list_append(&cap->kobj_link, &kobj->caps_list);
 	list_append(&cap->type_link, &task->cap_info->type_list[kobj->type]);
 	mutex_unlock(&task->cap_info->lock);
@@ -314,7 +587,7 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 
 static void cap_unpublish_unsafe(cap_t *cap)
 {
-	cap->kobject = NULL;
+	atomic_store_explicit(&cap->kobject, NULL, memory_order_relaxed);
 	list_remove(&cap->kobj_link);
 	list_remove(&cap->type_link);
 	cap->state = CAP_STATE_ALLOCATED;
@@ -343,10 +616,12 @@ restart:
 	mutex_lock(&task->cap_info->lock);
 	cap_t *cap = cap_get(task, handle, CAP_STATE_PUBLISHED);
 	if (cap) {
-		if (cap->kobject->type == type) {
+		kobject_t *ko = atomic_load_explicit(&cap->kobject,
+		    memory_order_relaxed);
+		if (ko->type == type) {
 			/* Hand over cap's reference to kobj */
-			kobj = cap->kobject;
-			if (!mutex_trylock(&kobj->caps_list_lock)) {
+			kobj = ko;
+			if (mutex_trylock(&kobj->caps_list_lock) != EOK) {
 				mutex_unlock(&task->cap_info->lock);
 				kobj = NULL;
 				goto restart;
@@ -401,10 +676,12 @@ void cap_free(task_t *task, cap_handle_t handle)
 
 	assert(cap);
 
-	hash_table_remove_item(&task->cap_info->caps, &cap->caps_link);
+	(void) caps_store(task, handle, NULL);
 	ra_free(task->cap_info->handles, cap_handle_raw(handle), 1);
-	slab_free(cap_cache, cap);
 	mutex_unlock(&task->cap_info->lock);
+
+	/* A lock-free lookup may still be looking at the capability. */
+	caps_retire(&cap->retired, cap_cache, cap);
 }
 
 kobject_t *kobject_alloc(unsigned int flags)
@@ -414,7 +691,8 @@ kobject_t *kobject_alloc(unsigned int flags)
 
 void kobject_free(kobject_t *kobj)
 {
-	slab_free(kobject_cache, kobj);
+	/* A lock-free lookup may still be looking at the kernel object. */
+	caps_retire(&kobj->retired, kobject_cache, kobj);
 }
 
 /** Initialize kernel object
@@ -427,7 +705,7 @@ void kobject_initialize(kobject_t *kobj, kobject_type_t type, void *raw)
 {
 	atomic_store(&kobj->refcnt, 1);
 
-	mutex_initialize(&kobj->caps_list_lock, MUTEX_PASSIVE);
+	mutex_initialize(&kobj->caps_list_lock, MUTEX_ADAPTIVE);
 	list_initialize(&kobj->caps_list);
 
 	kobj->type = type;
@@ -441,6 +719,11 @@ void kobject_initialize(kobject_t *kobj, kobject_type_t type, void *raw)
  * @param type    Kernel object type of the object associated with the
  *                capability referenced by handle.
  *
+ * This function does not take any lock. The capability and the kernel object
+ * it finds stay allocated until caps_lookup_end() thanks to epoch-based
+ * reclamation and a reference is only taken if the kernel object is not
+ * already being destroyed.
+ *
  * @return Kernel object with incremented reference count on success.
  * @return NULL if there is no matching capability or kernel object.
  */
@@ -449,15 +732,27 @@ kobject_get(struct task *task, cap_handle_t handle, kobject_type_t type)
 {
 	kobject_t *kobj = NULL;
 
-	mutex_lock(&task->cap_info->lock);
-	cap_t *cap = cap_get(task, handle, CAP_STATE_PUBLISHED);
+	unsigned int token = caps_lookup_begin();
+
+	cap_t *cap = caps_lookup(task, handle);
 	if (cap) {
-		if (cap->kobject->type == type) {
-			kobj = cap->kobject;
-			atomic_inc(&kobj->refcnt);
+		kobject_t *ko = atomic_load_explicit(&cap->kobject,
+		    memory_order_acquire);
+		if (ko && ko->type == type) {
+			size_t cnt = atomic_load_explicit(&ko->refcnt,
+			    memory_order_relaxed);
+			while (cnt > 0) {
+				if (atomic_compare_exchange_weak_explicit(
+				    &ko->refcnt, &cnt, cnt + 1,
+				    memory_order_acquire, memory_order_relaxed)) {
+					kobj = ko;
+					break;
+				}
+			}
 		}
 	}
-	mutex_unlock(&task->cap_info->lock);
+
+	caps_lookup_end(token);
 
 	return kobj;
 }
@@ -68,6 +68,7 @@
 #include <ipc/irq.h>
 #include <ipc/event.h>
 #include <sysinfo/sysinfo.h>
+#include <synch/lockstat.h>
 #include <symtab.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -487,6 +488,25 @@ static cmd_info_t btrace_info = {
 
 #endif /* CONFIG_UDEBUG */
 
+#ifdef CONFIG_LOCKSTAT
+
+static int cmd_lockstat(cmd_arg_t *argv);
+static cmd_arg_t lockstat_argv = {
+	.type = ARG_TYPE_STRING_OPTIONAL,
+	.buffer = flag_buf,
+	.len = sizeof(flag_buf)
+};
+static cmd_info_t lockstat_info = {
+	.name = "lockstat",
+	.description = "Show spinlock contention (use -a to list all locks, "
+	    "-r to reset).",
+	.func = cmd_lockstat,
+	.argc = 1,
+	.argv = &lockstat_argv
+};
+
+#endif /* CONFIG_LOCKSTAT */
+
 static int cmd_sched(cmd_arg_t *argv);
 static cmd_info_t sched_info = {
 	.name = "scheduler",
@@ -615,6 +635,9 @@ static cmd_info_t *basic_commands[] = {
 #endif
 #ifdef CONFIG_UDEBUG
 	&btrace_info,
+#endif
+#ifdef CONFIG_LOCKSTAT
+	&lockstat_info,
 #endif
 	&pio_read_8_info,
 	&pio_read_16_info,
@@ -1280,6 +1303,30 @@ int cmd_sched(cmd_arg_t *argv)
 	return 1;
 }
 
+#ifdef CONFIG_LOCKSTAT
+
+/** Command for printing spinlock contention statistics
+ *
+ * @param argv Optional flag.
+ *
+ * @return Always 1
+ */
+int cmd_lockstat(cmd_arg_t *argv)
+{
+	if (str_cmp(flag_buf, "-a") == 0)
+		lockstat_print(true);
+	else if (str_cmp(flag_buf, "-r") == 0)
+		lockstat_reset();
+	else if (str_cmp(flag_buf, "") == 0)
+		lockstat_print(false);
+	else
+		printf("Unknown argument \"%s\".\n", flag_buf);
+
+	return 1;
+}
+
+#endif /* CONFIG_LOCKSTAT */
+
 /** Command for listing memory zones
  *
  * @param argv Ignored
@@ -84,6 +84,8 @@ void cpu_init(void)
 			cpus[i].id = i;
 
 			irq_spinlock_initialize(&cpus[i].lock, "cpus[].lock");
+			list_initialize(&cpus[i].cap_retired);
+			waitq_initialize(&cpus[i].cap_reclaim_wq);
 
 			for (unsigned int j = 0; j < RQ_COUNT; j++) {
 				irq_spinlock_initialize(&cpus[i].rq[j].lock, "cpus[].rq[].lock");
@@ -115,9 +117,19 @@ void cpu_list(void)
 	unsigned int i;
 
 	for (i = 0; i < config.cpu_count; i++) {
-		if (cpus[i].active)
+		if (cpus[i].active) {
 			cpu_print_report(&cpus[i]);
-		else
+#ifdef CONFIG_SMP
+			printf("cpu%u: TLB shootdowns: %" PRIu64 " sent, %"
+			    PRIu64 " received, %" PRIu64 " IPIs, %" PRIu64
+			    " IPIs avoided\n", i, cpus[i].tlb_shootdowns,
+			    cpus[i].tlb_shootdowns_received, cpus[i].tlb_ipis_sent,
+			    cpus[i].tlb_ipis_avoided);
+#endif
+			printf("cpu%u: page faults: %" PRIu64 ", %" PRIu64
+			    " large pages mapped\n", i, cpus[i].page_faults,
+			    cpus[i].large_pages_mapped);
+		} else
 			printf("cpu%u: not active\n", i);
 	}
 }
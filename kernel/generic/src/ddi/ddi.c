@@ -434,7 +434,19 @@ _NO_TRACE static errno_t dmamem_map_anonymous(size_t size, uintptr_t constraint,
 		return EINVAL;
 
 	// FIXME: probably need to ensure that the memory is suitable for DMA
-	*phys = frame_alloc(frames, FRAME_ATOMIC, constraint);
+	*phys = 0;
+
+	/*
+	 * Align large buffers to the large page size if asked to, so that they
+	 * can be mapped by large pages.
+	 */
+	size_t lsize = page_large_size();
+	if ((map_flags & AS_AREA_LARGE_PAGES) && (lsize != 0) &&
+	    (size >= lsize))
+		*phys = frame_alloc(frames, FRAME_ATOMIC, constraint | (lsize - 1));
+
+	if (*phys == 0)
+		*phys = frame_alloc(frames, FRAME_ATOMIC, constraint);
 	if (*phys == 0)
 		return ENOMEM;
 
@@ -194,7 +194,7 @@ bool ipc_phone_connect(phone_t *phone, answerbox_t *box)
  */
 void ipc_phone_init(phone_t *phone, task_t *caller)
 {
-	mutex_initialize(&phone->lock, MUTEX_PASSIVE);
+	mutex_initialize(&phone->lock, MUTEX_ADAPTIVE);
 	phone->caller = caller;
 	phone->callee = NULL;
 	phone->state = IPC_PHONE_FREE;
@@ -49,6 +49,7 @@
 #include <proc/task.h>
 #include <proc/thread.h>
 #include <proc/program.h>
+#include <cap/cap.h>
 #include <panic.h>
 #include <halt.h>
 #include <cpu.h>
@@ -58,6 +59,7 @@
 #include <mm/as.h>
 #include <mm/frame.h>
 #include <mm/km.h>
+#include <mm/zero.h>
 #include <stdio.h>
 #include <log.h>
 #include <mem.h>
@@ -159,6 +161,29 @@ void kinit(void *arg)
 	else
 		log(LF_OTHER, LVL_ERROR, "Unable to create kload thread");
 
+	/*
+	 * For each CPU, create its capability reclaiming thread.
+	 */
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		thread = thread_create(kcapreclaim, NULL, TASK,
+		    THREAD_FLAG_UNCOUNTED, "kcapreclaim");
+		if (thread != NULL) {
+			thread_wire(thread, &cpus[i]);
+			thread_ready(thread);
+		} else
+			log(LF_OTHER, LVL_ERROR,
+			    "Unable to create kcapreclaim thread for cpu%u", i);
+	}
+
+	/* Start thread zeroing frames for anonymous memory */
+	zero_init();
+	thread = thread_create(kzero, NULL, TASK, THREAD_FLAG_NONE,
+	    "kzero");
+	if (thread != NULL)
+		thread_ready(thread);
+	else
+		log(LF_OTHER, LVL_ERROR, "Unable to create kzero thread");
+
 #ifdef CONFIG_KCONSOLE
 	if (stdin) {
 		/*
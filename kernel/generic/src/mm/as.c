@@ -53,6 +53,7 @@
 #include <mm/frame.h>
 #include <mm/slab.h>
 #include <mm/tlb.h>
+#include <cpu/cpu_mask.h>
 #include <arch/mm/page.h>
 #include <genarch/mm/page_pt.h>
 #include <genarch/mm/page_ht.h>
@@ -131,7 +132,7 @@ _NO_TRACE static errno_t as_constructor(void *obj, unsigned int flags)
 	as_t *as = (as_t *) obj;
 
 	link_initialize(&as->inactive_as_with_asid_link);
-	mutex_initialize(&as->lock, MUTEX_PASSIVE);
+	mutex_initialize(&as->lock, MUTEX_ADAPTIVE);
 
 	return as_constructor_arch(as, flags);
 }
@@ -172,6 +173,17 @@ as_t *as_create(unsigned int flags)
 	if (!as)
 		return NULL;
 
+	as->cpu_mask = NULL;
+	if (!(flags & FLAG_AS_KERNEL)) {
+		as->cpu_mask = (cpu_mask_t *) malloc(cpu_mask_size());
+		if (!as->cpu_mask) {
+			slab_free(as_cache, as);
+			return NULL;
+		}
+
+		cpu_mask_none(as->cpu_mask);
+	}
+
 	(void) as_create_arch(as, 0);
 
 	odict_initialize(&as->as_areas, as_areas_getkey, as_areas_cmp);
@@ -269,6 +281,7 @@ retry:
 	page_table_destroy(NULL);
 #endif
 
+	free(as->cpu_mask);
 	slab_free(as_cache, as);
 }
 
@@ -468,13 +481,14 @@ _NO_TRACE static bool check_area_conflicts(as_t *as, uintptr_t addr,
  * @param bound   Lowest address bound.
  * @param size    Requested size of the allocation.
  * @param guarded True if the allocation must be protected by guard pages.
+ * @param align   Required alignment of the address, a multiple of PAGE_SIZE.
  *
  * @return Address of the beginning of unmapped address space area.
  * @return -1 if no suitable address space area was found.
  *
  */
 _NO_TRACE static uintptr_t as_get_unmapped_area(as_t *as, uintptr_t bound,
-    size_t size, bool guarded)
+    size_t size, bool guarded, size_t align)
 {
 	assert(mutex_locked(&as->lock));
 
@@ -505,7 +519,10 @@ _NO_TRACE static uintptr_t as_get_unmapped_area(as_t *as, uintptr_t bound,
 			addr += P2SZ(1);
 		}
 
-		if (check_area_conflicts(as, addr, pages, guarded, NULL))
+		addr = ALIGN_UP(addr, align);
+
+		if ((addr >= bound) &&
+		    (check_area_conflicts(as, addr, pages, guarded, NULL)))
 			return addr;
 	}
 
@@ -524,6 +541,8 @@ _NO_TRACE static uintptr_t as_get_unmapped_area(as_t *as, uintptr_t bound,
 			addr += P2SZ(1);
 		}
 
+		addr = ALIGN_UP(addr, align);
+
 		bool avail =
 		    ((addr >= bound) && (addr >= area->base) &&
 		    (check_area_conflicts(as, addr, pages, guarded, area)));
@@ -758,10 +777,15 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 
 	bool const guarded = flags & AS_AREA_GUARD;
 
+	/* Place areas which asked for large pages so that they can use them. */
+	size_t align = PAGE_SIZE;
+	if ((flags & AS_AREA_LARGE_PAGES) && (page_large_size() != 0))
+		align = page_large_size();
+
 	mutex_lock(&as->lock);
 
 	if (*base == (uintptr_t) AS_AREA_ANY) {
-		*base = as_get_unmapped_area(as, bound, size, guarded);
+		*base = as_get_unmapped_area(as, bound, size, guarded, align);
 		if (*base == (uintptr_t) -1) {
 			mutex_unlock(&as->lock);
 			return NULL;
@@ -784,7 +808,7 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 		return NULL;
 	}
 
-	mutex_initialize(&area->lock, MUTEX_PASSIVE);
+	mutex_initialize(&area->lock, MUTEX_ADAPTIVE);
 
 	area->as = as;
 	odlink_initialize(&area->las_areas);
@@ -792,6 +816,7 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 	area->attributes = attrs;
 	area->pages = pages;
 	area->base = *base;
+	area->fault_last = 0;
 	area->backend = backend;
 	area->sh_info = NULL;
 
@@ -954,8 +979,8 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 		 * Start TLB shootdown sequence.
 		 */
 
-		ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES,
-		    as->asid, area->base + P2SZ(pages),
+		ipl_t ipl = tlb_shootdown_start_targeted(as->cpu_mask,
+		    TLB_INVL_PAGES, as->asid, area->base + P2SZ(pages),
 		    area->pages - pages);
 
 		/*
@@ -1104,8 +1129,8 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
-	    area->pages);
+	ipl_t ipl = tlb_shootdown_start_targeted(as->cpu_mask, TLB_INVL_PAGES,
+	    as->asid, area->base, area->pages);
 
 	/*
 	 * Visit only the pages mapped by used_space.
@@ -1320,6 +1345,42 @@ _NO_TRACE bool as_area_check_access(as_area_t *area, pf_access_t access)
 	return true;
 }
 
+/** Find the large page which can be mapped to service a page fault.
+ *
+ * A large page can be used only if it lies entirely within the address space
+ * area and none of its pages is mapped yet.
+ *
+ * The address space area must be already locked.
+ *
+ * @param area  Address space area.
+ * @param upage Faulting virtual page.
+ * @param lpage Place to store the base of the large page containing upage.
+ *
+ * @return True if the large page can be mapped, false otherwise.
+ *
+ */
+_NO_TRACE bool as_area_large_page_get(as_area_t *area, uintptr_t upage,
+    uintptr_t *lpage)
+{
+	assert(mutex_locked(&area->lock));
+
+	size_t lsize = page_large_size();
+	if (lsize == 0)
+		return false;
+
+	uintptr_t base = ALIGN_DOWN(upage, lsize);
+	if ((base < area->base) ||
+	    (base - area->base + lsize > P2SZ(area->pages)))
+		return false;
+
+	used_space_ival_t *ival = used_space_find_gteq(&area->used_space, base);
+	if ((ival != NULL) && (ival->page < base + lsize))
+		return false;
+
+	*lpage = base;
+	return true;
+}
+
 /** Convert address space area flags to page flags.
  *
  * @param aflags Flags of some address space area.
@@ -1404,8 +1465,8 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
-	    area->pages);
+	ipl_t ipl = tlb_shootdown_start_targeted(as->cpu_mask, TLB_INVL_PAGES,
+	    as->asid, area->base, area->pages);
 
 	/*
 	 * Remove used pages from page tables and remember their frame
@@ -1553,6 +1614,13 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 
 	page_table_lock(AS, false);
 
+	preemption_disable();
+	CPU->page_faults++;
+	preemption_enable();
+
+	atomic_fetch_add_explicit(&TASK->fault_info.page_faults, 1,
+	    memory_order_relaxed);
+
 	/*
 	 * To avoid race condition between two page faults on the same address,
 	 * we need to make sure the mapping has not been already inserted.
@@ -1675,6 +1743,18 @@ retry:
 			new_as->asid = asid_get();
 	}
 
+	/*
+	 * Record that this processor may now cache translations of the new
+	 * address space, so that TLB shootdowns concerning it are delivered
+	 * here.
+	 */
+	bool tlb_sync = false;
+	if ((new_as->cpu_mask != NULL) &&
+	    (!cpu_mask_is_set(new_as->cpu_mask, CPU->id))) {
+		cpu_mask_set(new_as->cpu_mask, CPU->id);
+		tlb_sync = true;
+	}
+
 #ifdef AS_PAGE_TABLE
 	SET_PTL0_ADDRESS(new_as->genarch.page_table);
 #endif
@@ -1685,8 +1765,16 @@ retry:
 	 */
 	as_install_arch(new_as);
 
+	asid_t asid = new_as->asid;
 	spinlock_unlock(&asidlock);
 
+	/*
+	 * A shootdown which did not see this processor in the mask
+	 * may still be in progress.
+	 */
+	if (tlb_sync)
+		tlb_shootdown_sync(asid);
+
 	AS = new_as;
 }
 
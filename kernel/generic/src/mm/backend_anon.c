@@ -45,6 +45,7 @@
 #include <mm/frame.h>
 #include <mm/slab.h>
 #include <mm/km.h>
+#include <mm/zero.h>
 #include <synch/mutex.h>
 #include <adt/list.h>
 #include <errno.h>
@@ -52,6 +53,7 @@
 #include <align.h>
 #include <mem.h>
 #include <arch.h>
+#include <proc/task.h>
 
 static bool anon_create(as_area_t *);
 static bool anon_resize(as_area_t *, size_t);
@@ -64,6 +66,9 @@ static bool anon_is_shareable(as_area_t *);
 static int anon_page_fault(as_area_t *, uintptr_t, pf_access_t);
 static void anon_frame_free(as_area_t *, uintptr_t, uintptr_t);
 
+/** Maximum number of pages mapped ahead of a sequential page fault. */
+#define ANON_FAULT_AROUND_PAGES  8
+
 mem_backend_t anon_backend = {
 	.create = anon_create,
 	.resize = anon_resize,
@@ -170,6 +175,127 @@ bool anon_is_shareable(as_area_t *area)
 	return !(area->flags & AS_AREA_LATE_RESERVE);
 }
 
+/** Get a zeroed frame for anonymous memory.
+ *
+ * A pre-zeroed frame is used if there is one, otherwise a frame is allocated
+ * and zeroed now. The frame is charged to the area's memory reservation.
+ *
+ * @param[out] prezeroed Incremented if a pre-zeroed frame was used.
+ *
+ * @return Physical address of the zeroed frame.
+ */
+static uintptr_t anon_frame_get(size_t *prezeroed)
+{
+	uintptr_t frame = zero_frame_get();
+	if (frame != 0) {
+		(*prezeroed)++;
+		return frame;
+	}
+
+	uintptr_t kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
+	memsetb((void *) kpage, PAGE_SIZE, 0);
+	km_temporary_page_put(kpage);
+
+	return frame;
+}
+
+#ifdef CONFIG_FAULT_AROUND
+
+/** Map pages following a sequential page fault in a private area.
+ *
+ * If the faulting page immediately follows or precedes the page of the last
+ * fault in the area, the area is likely being touched sequentially (e.g. a
+ * growing heap or stack) and the next few unmapped pages in the same
+ * direction are mapped right away to save the faults on them.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area      Pointer to the address space area.
+ * @param upage     Faulting virtual page, already mapped.
+ * @param[out] prezeroed Incremented for each pre-zeroed frame used.
+ *
+ * @return Number of pages mapped in addition to upage.
+ */
+static size_t anon_fault_around(as_area_t *area, uintptr_t upage,
+    size_t *prezeroed)
+{
+	uintptr_t last = area->fault_last;
+	area->fault_last = upage;
+
+	bool up;
+	if (upage == last + PAGE_SIZE)
+		up = true;
+	else if (upage + PAGE_SIZE == last)
+		up = false;
+	else
+		return 0;
+
+	size_t mapped = 0;
+	uintptr_t page = upage;
+
+	while (mapped < ANON_FAULT_AROUND_PAGES) {
+		page = up ? page + PAGE_SIZE : page - PAGE_SIZE;
+		if (page - area->base >= P2SZ(area->pages))
+			break;
+
+		pte_t pte;
+		if (page_mapping_find(AS, page, false, &pte) && PTE_VALID(&pte))
+			break;
+
+		if ((area->flags & AS_AREA_LATE_RESERVE) &&
+		    !reserve_try_alloc(1))
+			break;
+
+		uintptr_t frame = anon_frame_get(prezeroed);
+		page_mapping_insert(AS, page, frame, as_area_get_flags(area));
+		if (!used_space_insert(&area->used_space, page, 1))
+			panic("Cannot insert used space.");
+
+		area->fault_last = page;
+		mapped++;
+	}
+
+	return mapped;
+}
+
+#endif /* CONFIG_FAULT_AROUND */
+
+/** Try to service a page fault by mapping a whole large page.
+ *
+ * Only private areas with memory reserved in advance are eligible. If there
+ * is no suitable block of physical memory, the caller falls back to mapping
+ * the single page.
+ *
+ * @param area  Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ *
+ * @return True if a large page was mapped, false otherwise.
+ */
+static bool anon_page_fault_large(as_area_t *area, uintptr_t upage)
+{
+	uintptr_t lpage;
+
+	if (area->sh_info->shared || (area->flags & AS_AREA_LATE_RESERVE))
+		return false;
+
+	if (!as_area_large_page_get(area, upage, &lpage))
+		return false;
+
+	size_t lsize = page_large_size();
+	uintptr_t frame = frame_alloc(SIZE2FRAMES(lsize),
+	    FRAME_LOWMEM | FRAME_ATOMIC | FRAME_NO_RESERVE, lsize - 1);
+	if (frame == 0)
+		return false;
+
+	memsetb((void *) PA2KA(frame), lsize, 0);
+
+	page_mapping_insert_large(AS, lpage, frame, as_area_get_flags(area));
+	if (!used_space_insert(&area->used_space, lpage, SIZE2FRAMES(lsize)))
+		panic("Cannot insert used space.");
+
+	return true;
+}
+
 /** Service a page fault in the anonymous memory address space area.
  *
  * The address space area and page tables must be already locked.
@@ -183,8 +309,8 @@ bool anon_is_shareable(as_area_t *area)
  */
 int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 {
-	uintptr_t kpage;
 	uintptr_t frame;
+	size_t prezeroed = 0;
 
 	assert(page_table_locked(AS));
 	assert(mutex_locked(&area->lock));
@@ -194,6 +320,11 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		return AS_PF_FAULT;
 
 	mutex_lock(&area->sh_info->lock);
+	if (anon_page_fault_large(area, upage)) {
+		mutex_unlock(&area->sh_info->lock);
+		return AS_PF_OK;
+	}
+
 	if (area->sh_info->shared) {
 		/*
 		 * The area is shared, chances are that the mapping can be found
@@ -206,10 +337,7 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		    upage - area->base, &frame);
 		if (rc != EOK) {
 			/* Need to allocate the frame */
-			kpage = km_temporary_page_get(&frame,
-			    FRAME_NO_RESERVE);
-			memsetb((void *) kpage, PAGE_SIZE, 0);
-			km_temporary_page_put(kpage);
+			frame = anon_frame_get(&prezeroed);
 
 			/*
 			 * Insert the address of the newly allocated
@@ -246,10 +374,9 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 			}
 		}
 
-		kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
-		memsetb((void *) kpage, PAGE_SIZE, 0);
-		km_temporary_page_put(kpage);
+		frame = anon_frame_get(&prezeroed);
 	}
+	bool shared = area->sh_info->shared;
 	mutex_unlock(&area->sh_info->lock);
 
 	/*
@@ -261,6 +388,23 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	if (!used_space_insert(&area->used_space, upage, 1))
 		panic("Cannot insert used space.");
 
+	size_t around = 0;
+#ifdef CONFIG_FAULT_AROUND
+	if (!shared)
+		around = anon_fault_around(area, upage, &prezeroed);
+#else
+	(void) shared;
+#endif
+
+	if (around > 0) {
+		atomic_fetch_add_explicit(&TASK->fault_info.faulted_around,
+		    around, memory_order_relaxed);
+	}
+	if (prezeroed > 0) {
+		atomic_fetch_add_explicit(&TASK->fault_info.prezeroed,
+		    prezeroed, memory_order_relaxed);
+	}
+
 	return AS_PF_OK;
 }
 
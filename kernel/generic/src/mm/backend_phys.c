@@ -139,6 +139,27 @@ int phys_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		return AS_PF_FAULT;
 
 	assert(upage - area->base < area->backend_data.frames * FRAME_SIZE);
+
+	/*
+	 * Map the whole large page around upage if the physical memory is
+	 * aligned the same way as the virtual addresses.
+	 */
+	uintptr_t lpage;
+	if (as_area_large_page_get(area, upage, &lpage) &&
+	    (lpage - area->base + page_large_size() <=
+	    area->backend_data.frames * FRAME_SIZE) &&
+	    IS_ALIGNED(base + (lpage - area->base), page_large_size())) {
+		size_t lsize = page_large_size();
+
+		page_mapping_insert_large(AS, lpage, base + (lpage - area->base),
+		    as_area_get_flags(area));
+		if (!used_space_insert(&area->used_space, lpage,
+		    SIZE2FRAMES(lsize)))
+			panic("Cannot insert used space.");
+
+		return AS_PF_OK;
+	}
+
 	page_mapping_insert(AS, upage, base + (upage - area->base),
 	    as_area_get_flags(area));
 
@@ -39,6 +39,7 @@
 #include <mm/as.h>
 #include <mm/page.h>
 #include <mm/frame.h>
+#include <mm/km.h>
 #include <abi/mm/as.h>
 #include <abi/ipc/methods.h>
 #include <ipc/sysipc.h>
@@ -49,6 +50,7 @@
 #include <errno.h>
 #include <log.h>
 #include <str.h>
+#include <mem.h>
 
 static bool user_create(as_area_t *);
 static void user_destroy(as_area_t *);
@@ -145,6 +147,27 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	 */
 
 	uintptr_t frame = ipc_get_arg1(&data);
+
+	if (area->flags & AS_AREA_WRITE) {
+		/*
+		 * The pager may hand out the same frame to multiple tasks
+		 * (e.g. from its page cache). Writable areas must not modify
+		 * it, so they get a private copy.
+		 */
+		uintptr_t copy;
+		uintptr_t kdst = km_temporary_page_get(&copy, FRAME_NONE);
+		uintptr_t ksrc = km_map(frame, PAGE_SIZE, PAGE_SIZE,
+		    PAGE_READ | PAGE_CACHEABLE);
+		memcpy((void *) kdst, (void *) ksrc, PAGE_SIZE);
+		km_unmap(ksrc, PAGE_SIZE);
+		km_temporary_page_put(kdst);
+
+		if (find_zone(ADDR2PFN(frame), 1, 0) != (size_t) -1)
+			frame_free(frame, 1);
+
+		frame = copy;
+	}
+
 	page_mapping_insert(AS, upage, frame, as_area_get_flags(area));
 	if (!used_space_insert(&area->used_space, upage, 1))
 		panic("Cannot insert used space.");
@@ -69,6 +69,8 @@
 #include <typedefs.h>
 #include <arch/asm.h>
 #include <arch.h>
+#include <cpu.h>
+#include <preemption.h>
 #include <assert.h>
 #include <syscall/copy.h>
 #include <errno.h>
@@ -189,6 +191,54 @@ void page_mapping_make_global(uintptr_t base, size_t size)
 	return page_mapping_operations->mapping_make_global(base, size);
 }
 
+/** Get the size of large pages.
+ *
+ * @return Size of large pages or zero if large page mappings are not
+ *         supported.
+ */
+size_t page_large_size(void)
+{
+	assert(page_mapping_operations);
+
+	if (!page_mapping_operations->mapping_insert_large)
+		return 0;
+
+	return page_mapping_operations->large_page_size;
+}
+
+/** Insert mapping of large page to a block of contiguous frames.
+ *
+ * Map virtual address page to physical address frame using flags. The large
+ * page replaces any mapping structures of smaller granularity covering it,
+ * which must not contain any valid mappings.
+ *
+ * @param as    Address space to which page belongs.
+ * @param page  Virtual address of the large page to be mapped, aligned to
+ *              page_large_size().
+ * @param frame Physical address of the first frame of the block, aligned to
+ *              page_large_size().
+ * @param flags Flags to be used for mapping.
+ *
+ */
+_NO_TRACE void page_mapping_insert_large(as_t *as, uintptr_t page,
+    uintptr_t frame, unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	assert(page_large_size() != 0);
+	assert(IS_ALIGNED(page, page_large_size()));
+	assert(IS_ALIGNED(frame, page_large_size()));
+
+	page_mapping_operations->mapping_insert_large(as, page, frame, flags);
+
+	preemption_disable();
+	CPU->large_pages_mapped++;
+	preemption_enable();
+
+	/* Repel prefetched accesses to the old mapping. */
+	memory_barrier();
+}
+
 errno_t page_find_mapping(uintptr_t virt, uintptr_t *phys)
 {
 	page_table_lock(AS, true);
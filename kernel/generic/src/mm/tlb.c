@@ -35,8 +35,13 @@
  * @brief Generic TLB shootdown algorithm.
  *
  * The algorithm implemented here is based on the CMU TLB shootdown
- * algorithm and is further simplified (e.g. all CPUs receive all TLB
- * shootdown messages).
+ * algorithm and is further simplified. Shootdowns which concern a single
+ * user address space are only delivered to the CPUs on which that address
+ * space has been active since it was assigned its ASID (see as_switch()),
+ * all other shootdowns are delivered to all CPUs.
+ *
+ * Messages queued for a CPU are merged whenever possible so that a burst
+ * of small shootdowns does not degrade into a full TLB invalidation.
  */
 
 #include <mm/tlb.h>
@@ -48,9 +53,11 @@
 #include <atomic.h>
 #include <arch/interrupt.h>
 #include <config.h>
+#include <macros.h>
 #include <arch.h>
 #include <panic.h>
 #include <cpu.h>
+#include <cpu/cpu_mask.h>
 
 void tlb_init(void)
 {
@@ -67,6 +74,116 @@ void tlb_init(void)
  */
 IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
 
+/** Try to merge TLB shootdown message with those already queued.
+ *
+ * The CPU structure lock must be held.
+ *
+ * @param cpu   CPU whose queue is to be examined.
+ * @param type  Type describing scope of shootdown.
+ * @param asid  Address space, if required by type.
+ * @param page  Virtual page address, if required by type.
+ * @param count Number of pages, if required by type.
+ *
+ * @return True if the message is already covered by the queue.
+ *
+ */
+static bool tlb_message_merge(cpu_t *cpu, tlb_invalidate_type_t type,
+    asid_t asid, uintptr_t page, size_t count)
+{
+	for (size_t i = 0; i < cpu->tlb_messages_count; i++) {
+		tlb_shootdown_msg_t *msg = &cpu->tlb_messages[i];
+
+		if (msg->type == TLB_INVL_ALL)
+			return true;
+
+		if (type == TLB_INVL_ALL || msg->asid != asid)
+			continue;
+
+		if (msg->type == TLB_INVL_ASID)
+			return true;
+
+		if (type == TLB_INVL_ASID) {
+			/* Widen the message to the whole address space. */
+			msg->type = TLB_INVL_ASID;
+			msg->page = 0;
+			msg->count = 0;
+			return true;
+		}
+
+		/* Both messages are TLB_INVL_PAGES. */
+		uintptr_t msg_end = msg->page + msg->count * PAGE_SIZE;
+		uintptr_t end = page + count * PAGE_SIZE;
+
+		/* Do not merge ranges which wrap around the address space. */
+		if ((end < page) || (msg_end < msg->page))
+			continue;
+
+		if ((page <= msg_end) && (msg->page <= end)) {
+			uintptr_t base = min(page, msg->page);
+
+			msg->count = (max(end, msg_end) - base) / PAGE_SIZE;
+			msg->page = base;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Enqueue TLB shootdown message for a CPU.
+ *
+ * The CPU structure lock must be held.
+ *
+ * @param cpu   Destination CPU.
+ * @param type  Type describing scope of shootdown.
+ * @param asid  Address space, if required by type.
+ * @param page  Virtual page address, if required by type.
+ * @param count Number of pages, if required by type.
+ *
+ */
+static void tlb_message_enqueue(cpu_t *cpu, tlb_invalidate_type_t type,
+    asid_t asid, uintptr_t page, size_t count)
+{
+	if (tlb_message_merge(cpu, type, asid, page, count))
+		return;
+
+	if (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN) {
+		/*
+		 * The message queue is full. If all messages concern the
+		 * same address space, replace them with one TLB_INVL_ASID
+		 * message, otherwise store one TLB_INVL_ALL message.
+		 */
+		tlb_invalidate_type_t repl = TLB_INVL_ASID;
+		asid_t repl_asid = asid;
+
+		if (type == TLB_INVL_ALL)
+			repl = TLB_INVL_ALL;
+
+		for (size_t i = 0; i < cpu->tlb_messages_count; i++) {
+			if (cpu->tlb_messages[i].asid != asid)
+				repl = TLB_INVL_ALL;
+		}
+
+		if (repl == TLB_INVL_ALL)
+			repl_asid = ASID_INVALID;
+
+		cpu->tlb_messages_count = 1;
+		cpu->tlb_messages[0].type = repl;
+		cpu->tlb_messages[0].asid = repl_asid;
+		cpu->tlb_messages[0].page = 0;
+		cpu->tlb_messages[0].count = 0;
+	} else {
+		/*
+		 * Enqueue the message.
+		 */
+		size_t idx = cpu->tlb_messages_count++;
+		cpu->tlb_messages[idx].type = type;
+		cpu->tlb_messages[idx].asid = asid;
+		cpu->tlb_messages[idx].page = page;
+		cpu->tlb_messages[idx].count = count;
+	}
+}
+
 /** Send TLB shootdown message.
  *
  * This function attempts to deliver TLB shootdown message
@@ -82,11 +199,35 @@ IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
  */
 ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
     uintptr_t page, size_t count)
+{
+	return tlb_shootdown_start_targeted(NULL, type, asid, page, count);
+}
+
+/** Send TLB shootdown message to a set of processors.
+ *
+ * Only the processors present in @a targets are sent the message and
+ * only those are waited for. The mask is read after the shootdown lock
+ * is taken, so a processor which adds itself to the mask concurrently
+ * is synchronized by tlb_shootdown_sync() instead.
+ *
+ * @param targets Processors which may cache the affected translations
+ *                or NULL to deliver the message to all processors.
+ * @param type    Type describing scope of shootdown.
+ * @param asid    Address space, if required by type.
+ * @param page    Virtual page address, if required by type.
+ * @param count   Number of pages, if required by type.
+ *
+ * @return The interrupt priority level as it existed prior to this call.
+ *
+ */
+ipl_t tlb_shootdown_start_targeted(cpu_mask_t *targets,
+    tlb_invalidate_type_t type, asid_t asid, uintptr_t page, size_t count)
 {
 	ipl_t ipl = interrupts_disable();
 	CPU->tlb_active = false;
 	irq_spinlock_lock(&tlblock, false);
 
+	size_t sent = 0;
 	size_t i;
 	for (i = 0; i < config.cpu_count; i++) {
 		if (i == CPU->id)
@@ -94,34 +235,34 @@ ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
 
 		cpu_t *cpu = &cpus[i];
 
-		irq_spinlock_lock(&cpu->lock, false);
-		if (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN) {
-			/*
-			 * The message queue is full.
-			 * Erase the queue and store one TLB_INVL_ALL message.
-			 */
-			cpu->tlb_messages_count = 1;
-			cpu->tlb_messages[0].type = TLB_INVL_ALL;
-			cpu->tlb_messages[0].asid = ASID_INVALID;
-			cpu->tlb_messages[0].page = 0;
-			cpu->tlb_messages[0].count = 0;
-		} else {
-			/*
-			 * Enqueue the message.
-			 */
-			size_t idx = cpu->tlb_messages_count++;
-			cpu->tlb_messages[idx].type = type;
-			cpu->tlb_messages[idx].asid = asid;
-			cpu->tlb_messages[idx].page = page;
-			cpu->tlb_messages[idx].count = count;
+		if ((targets != NULL) && (!cpu_mask_is_set(targets, i))) {
+			if (cpu->active)
+				CPU->tlb_ipis_avoided++;
+			continue;
 		}
+
+		irq_spinlock_lock(&cpu->lock, false);
+		tlb_message_enqueue(cpu, type, asid, page, count);
 		irq_spinlock_unlock(&cpu->lock, false);
+		sent++;
 	}
 
-	tlb_shootdown_ipi_send();
+	CPU->tlb_shootdowns++;
+	CPU->tlb_ipis_sent += sent;
+
+	if (sent == 0)
+		return ipl;
+
+	if (targets == NULL)
+		tlb_shootdown_ipi_send();
+	else
+		ipi_multicast(VECTOR_TLB_SHOOTDOWN_IPI, targets);
 
 busy_wait:
 	for (i = 0; i < config.cpu_count; i++) {
+		if ((targets != NULL) && (!cpu_mask_is_set(targets, i)))
+			continue;
+
 		if (cpus[i].tlb_active)
 			goto busy_wait;
 	}
@@ -146,6 +287,31 @@ void tlb_shootdown_ipi_send(void)
 	ipi_broadcast(VECTOR_TLB_SHOOTDOWN_IPI);
 }
 
+/** Synchronize with TLB shootdowns in progress.
+ *
+ * Called by as_switch() when the current processor starts caching
+ * translations of an address space it was not yet recorded to use.
+ * A shootdown which read the address space's CPU mask before this
+ * processor was added to it might be in progress; wait for it to
+ * finish and drop whatever the processor might have cached meanwhile.
+ *
+ * Interrupts must be disabled.
+ *
+ * @param asid Address space identifier which is being switched to.
+ *
+ */
+void tlb_shootdown_sync(asid_t asid)
+{
+	assert(interrupts_disabled());
+
+	CPU->tlb_active = false;
+	irq_spinlock_lock(&tlblock, false);
+	irq_spinlock_unlock(&tlblock, false);
+	CPU->tlb_active = true;
+
+	tlb_invalidate_asid(asid);
+}
+
 /** Receive TLB shootdown message.
  *
  */
@@ -159,6 +325,7 @@ void tlb_shootdown_ipi_recv(void)
 
 	irq_spinlock_lock(&CPU->lock, false);
 	assert(CPU->tlb_messages_count <= TLB_MESSAGE_QUEUE_LEN);
+	CPU->tlb_shootdowns_received++;
 
 	size_t i;
 	for (i = 0; i < CPU->tlb_messages_count; i++) {
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup kernel_generic_mm
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Pool of pre-zeroed frames.
+ *
+ * Anonymous memory must be zeroed before it is handed to userspace. Instead
+ * of zeroing each frame in the page fault handler, the kzero thread zeroes
+ * frames in advance whenever its CPU has nothing else to run and keeps them
+ * in a small pool from which zero_frame_get() takes them.
+ *
+ * Frames in the pool are backed by memory reservations held by the pool.
+ * The reservation of a frame is given back when the frame is taken from the
+ * pool, because the frame is then charged to the reservation of the address
+ * space area which it is used for.
+ */
+
+#include <mm/zero.h>
+#include <mm/frame.h>
+#include <mm/km.h>
+#include <mm/reserve.h>
+#include <synch/spinlock.h>
+#include <synch/waitq.h>
+#include <proc/thread.h>
+#include <arch/mm/page.h>
+#include <atomic.h>
+#include <stdbool.h>
+#include <arch.h>
+#include <cpu.h>
+#include <mem.h>
+
+/** Number of frames kept zeroed in advance. */
+#define ZERO_POOL_SIZE  256
+
+/** The kzero thread is woken up when the pool drops to this many frames. */
+#define ZERO_POOL_LOW  (ZERO_POOL_SIZE / 2)
+
+/** Free frames which must remain available for the pool to be refilled. */
+#define ZERO_FREE_MIN  (4 * ZERO_POOL_SIZE)
+
+/** Microseconds kzero waits for its CPU to become idle. */
+#define ZERO_IDLE_WAIT  10000
+
+SPINLOCK_STATIC_INITIALIZE_NAME(zero_lock, "zero_lock");
+
+static uintptr_t zero_pool[ZERO_POOL_SIZE];
+static size_t zero_count = 0;
+
+static waitq_t zero_wq;
+static atomic_bool zero_wakeup_pending = false;
+
+/** Initialize the pool of pre-zeroed frames. */
+void zero_init(void)
+{
+	waitq_initialize(&zero_wq);
+}
+
+/** Take a zeroed frame from the pool.
+ *
+ * The frame is charged to the caller's memory reservation just as if it was
+ * allocated with FRAME_NO_RESERVE.
+ *
+ * @return Physical address of a zeroed frame or zero if the pool is empty.
+ *
+ */
+uintptr_t zero_frame_get(void)
+{
+	uintptr_t frame = 0;
+
+	spinlock_lock(&zero_lock);
+	if (zero_count > 0)
+		frame = zero_pool[--zero_count];
+	size_t count = zero_count;
+	spinlock_unlock(&zero_lock);
+
+	if (frame != 0)
+		reserve_free(1);
+
+	if ((count <= ZERO_POOL_LOW) &&
+	    !atomic_exchange(&zero_wakeup_pending, true))
+		waitq_wakeup(&zero_wq, WAKEUP_FIRST);
+
+	return frame;
+}
+
+/** Zero one frame and add it to the pool.
+ *
+ * @return True if the frame was added, false if the pool is full or there is
+ *         not enough free memory.
+ *
+ */
+static bool zero_pool_refill_one(void)
+{
+	spinlock_lock(&zero_lock);
+	bool full = (zero_count == ZERO_POOL_SIZE);
+	spinlock_unlock(&zero_lock);
+
+	if (full || (frame_total_free_get() < ZERO_FREE_MIN))
+		return false;
+
+	if (!reserve_try_alloc(1))
+		return false;
+
+	uintptr_t frame;
+	uintptr_t kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
+	memsetb((void *) kpage, PAGE_SIZE, 0);
+	km_temporary_page_put(kpage);
+
+	spinlock_lock(&zero_lock);
+	full = (zero_count == ZERO_POOL_SIZE);
+	if (!full)
+		zero_pool[zero_count++] = frame;
+	spinlock_unlock(&zero_lock);
+
+	if (full) {
+		/* Filled up by someone else in the meantime. */
+		frame_free(frame, 1);
+		return false;
+	}
+
+	return true;
+}
+
+/** Kernel thread zeroing frames for the pool at idle time.
+ *
+ * @param arg Not used.
+ *
+ */
+void kzero(void *arg)
+{
+	thread_detach(THREAD);
+
+	while (true) {
+		/* Let any other ready thread on this CPU run first. */
+		if (atomic_load(&CPU->nrdy) > 0) {
+			thread_usleep(ZERO_IDLE_WAIT);
+			continue;
+		}
+
+		if (zero_pool_refill_one())
+			continue;
+
+		atomic_store(&zero_wakeup_pending, false);
+		waitq_sleep(&zero_wq);
+	}
+}
+
+/** @}
+ */
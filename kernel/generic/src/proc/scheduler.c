@@ -43,6 +43,7 @@
 #include <proc/scheduler.h>
 #include <proc/thread.h>
 #include <proc/task.h>
+#include <cap/cap.h>
 #include <mm/frame.h>
 #include <mm/page.h>
 #include <mm/as.h>
@@ -53,6 +54,7 @@
 #include <arch/cycle.h>
 #include <atomic.h>
 #include <synch/spinlock.h>
+#include <synch/mutex.h>
 #include <config.h>
 #include <context.h>
 #include <fpu_context.h>
@@ -87,6 +89,7 @@ static void before_task_runs(void)
 static void before_thread_runs(void)
 {
 	before_thread_runs_arch();
+	mutex_owner_switch(THREAD, true);
 
 #ifdef CONFIG_FPU_LAZY
 	if (THREAD == CPU->fpu_owner)
@@ -127,6 +130,7 @@ static void before_thread_runs(void)
  */
 static void after_thread_ran(void)
 {
+	mutex_owner_switch(THREAD, false);
 	after_thread_ran_arch();
 }
 
@@ -188,6 +192,11 @@ static thread_t *find_best_thread(void)
 loop:
 
 	if (atomic_load(&CPU->nrdy) == 0) {
+		/* Have capabilities retired while the CPU was busy freed. */
+		caps_reclaim_kick();
+		if (atomic_load(&CPU->nrdy) != 0)
+			goto loop;
+
 		/*
 		 * For there was nothing to run, the CPU goes to sleep
 		 * until a hardware interrupt or an IPI comes.
@@ -220,6 +220,10 @@ task_t *task_create(as_t *as, const char *name)
 	task->ipc_info.irq_notif_received = 0;
 	task->ipc_info.forwarded = 0;
 
+	atomic_store(&task->fault_info.page_faults, 0);
+	atomic_store(&task->fault_info.faulted_around, 0);
+	atomic_store(&task->fault_info.prezeroed, 0);
+
 	event_task_init(task);
 
 	task->answerbox.active = true;
@@ -405,6 +405,7 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 	thread->fpu_context_engaged = false;
 
 	odlink_initialize(&thread->lthreads);
+	list_initialize(&thread->mutexes);
 
 #ifdef CONFIG_UDEBUG
 	/* Initialize debugging stuff */
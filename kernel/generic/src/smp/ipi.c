@@ -39,6 +39,8 @@
 
 #include <smp/ipi.h>
 #include <config.h>
+#include <cpu.h>
+#include <cpu/cpu_mask.h>
 
 /** Broadcast IPI message
  *
@@ -59,6 +61,21 @@ void ipi_broadcast(int ipi)
 		ipi_broadcast_arch(ipi);
 }
 
+/** Multicast IPI message
+ *
+ * Send IPI message to the CPUs in a mask. The current CPU is never
+ * sent the message, even if it is present in the mask.
+ *
+ * @param ipi  Message to send.
+ * @param mask Destination CPUs.
+ *
+ */
+void ipi_multicast(int ipi, cpu_mask_t *mask)
+{
+	if (config.cpu_count > 1)
+		ipi_multicast_arch(ipi, mask);
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
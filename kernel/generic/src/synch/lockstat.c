@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Spinlock contention statistics.
+ *
+ * Statistics are aggregated per lock name, so that e.g. all run queue
+ * locks are accounted together. Each spinlock caches a pointer to the
+ * record of its name, the record is looked up when the lock is first
+ * released.
+ *
+ * The code in this file is called from within the spinlock
+ * implementation, so it cannot use spinlocks itself. The records are
+ * protected by plain atomic flags, which are held with interrupts
+ * disabled for a few instructions only.
+ */
+
+#include <synch/lockstat.h>
+#include <synch/spinlock.h>
+#include <arch/asm.h>
+#include <gsort.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+
+/** Number of locks printed by default by lockstat_print(). */
+#define LOCKSTAT_PRINT_TOP  20
+
+typedef struct lockstat {
+	/** Protects the counters. */
+	atomic_flag busy;
+
+	/** Lock name, empty if the record is unused. */
+	char name[LOCK_NAME_BUFLEN];
+
+	uint64_t acquisitions;
+	uint64_t contended;
+	uint64_t spin_cycles;
+	uint64_t hold_cycles;
+	uint64_t max_hold_cycles;
+} lockstat_t;
+
+static lockstat_t lockstat_table[LOCKSTAT_ENTRIES];
+
+/** Protects allocation of records in the table. */
+static atomic_flag lockstat_table_busy = ATOMIC_FLAG_INIT;
+
+/** Number of records in use. */
+static atomic_size_t lockstat_used;
+
+/** Record of locks which did not fit into the table. */
+static lockstat_t lockstat_other = {
+	.busy = ATOMIC_FLAG_INIT,
+	.name = "(other)"
+};
+
+static void lockstat_flag_lock(atomic_flag *flag)
+{
+	while (atomic_flag_test_and_set_explicit(flag, memory_order_acquire))
+		;
+}
+
+static void lockstat_flag_unlock(atomic_flag *flag)
+{
+	atomic_flag_clear_explicit(flag, memory_order_release);
+}
+
+static size_t lockstat_hash(const char *name)
+{
+	/* FNV-1a over the part of the name which is stored. */
+	size_t hash = 2166136261U;
+
+	for (size_t i = 0; (i < LOCK_NAME_BUFLEN - 1) && (name[i] != 0); i++) {
+		hash ^= (uint8_t) name[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/** Find or allocate the record for a lock name.
+ *
+ * Interrupts must be disabled.
+ *
+ * @param name Lock name.
+ *
+ * @return Record of the lock name.
+ *
+ */
+static lockstat_t *lockstat_lookup(const char *name)
+{
+	if ((name == NULL) || (name[0] == 0))
+		name = "(unnamed)";
+
+	size_t idx = lockstat_hash(name) % LOCKSTAT_ENTRIES;
+	lockstat_t *stat = &lockstat_other;
+
+	lockstat_flag_lock(&lockstat_table_busy);
+
+	for (size_t i = 0; i < LOCKSTAT_ENTRIES; i++) {
+		lockstat_t *cur = &lockstat_table[(idx + i) % LOCKSTAT_ENTRIES];
+
+		if (cur->name[0] == 0) {
+			str_cpy(cur->name, LOCK_NAME_BUFLEN, name);
+			atomic_fetch_add_explicit(&lockstat_used, 1,
+			    memory_order_relaxed);
+			stat = cur;
+			break;
+		}
+
+		if (str_lcmp(cur->name, name, LOCK_NAME_BUFLEN - 1) == 0) {
+			stat = cur;
+			break;
+		}
+	}
+
+	lockstat_flag_unlock(&lockstat_table_busy);
+	return stat;
+}
+
+/** Note acquisition of a spinlock.
+ *
+ * @param lock      Spinlock which has just been acquired.
+ * @param contended Whether the caller had to wait for the lock.
+ * @param spin      Cycles spent waiting for the lock.
+ *
+ */
+void lockstat_acquire(spinlock_t *lock, bool contended, uint64_t spin)
+{
+	lock->contended = contended;
+	lock->spin = spin;
+	lock->acquired = lockstat_now();
+}
+
+/** Account a spinlock which is about to be released.
+ *
+ * @param lock Spinlock which is still held by the caller.
+ *
+ */
+void lockstat_release(spinlock_t *lock)
+{
+	uint64_t hold = lockstat_now() - lock->acquired;
+
+	/*
+	 * The lock may also be released by an interrupt handler on this
+	 * CPU, so disable interrupts while holding the record.
+	 */
+	ipl_t ipl = interrupts_disable();
+
+	if (lock->stat == NULL)
+		lock->stat = lockstat_lookup(lock->name);
+
+	lockstat_t *stat = lock->stat;
+
+	lockstat_flag_lock(&stat->busy);
+
+	stat->acquisitions++;
+	if (lock->contended) {
+		stat->contended++;
+		stat->spin_cycles += lock->spin;
+	}
+
+	stat->hold_cycles += hold;
+	if (hold > stat->max_hold_cycles)
+		stat->max_hold_cycles = hold;
+
+	lockstat_flag_unlock(&stat->busy);
+
+	interrupts_restore(ipl);
+}
+
+/** Get the number of lock names with recorded statistics. */
+size_t lockstat_count(void)
+{
+	return atomic_load_explicit(&lockstat_used, memory_order_relaxed) + 1;
+}
+
+static void lockstat_copy(lockstat_t *stat, stats_lock_t *out)
+{
+	lockstat_flag_lock(&stat->busy);
+
+	str_cpy(out->name, LOCK_NAME_BUFLEN, stat->name);
+	out->acquisitions = stat->acquisitions;
+	out->contended = stat->contended;
+	out->spin_cycles = stat->spin_cycles;
+	out->hold_cycles = stat->hold_cycles;
+	out->max_hold_cycles = stat->max_hold_cycles;
+
+	lockstat_flag_unlock(&stat->busy);
+}
+
+/** Copy lock statistics.
+ *
+ * @param stats Output array.
+ * @param max   Capacity of the output array.
+ *
+ * @return Number of records stored in the output array.
+ *
+ */
+size_t lockstat_snapshot(stats_lock_t *stats, size_t max)
+{
+	size_t cnt = 0;
+
+	ipl_t ipl = interrupts_disable();
+	lockstat_flag_lock(&lockstat_table_busy);
+
+	for (size_t i = 0; (i < LOCKSTAT_ENTRIES) && (cnt < max); i++) {
+		if (lockstat_table[i].name[0] == 0)
+			continue;
+
+		lockstat_copy(&lockstat_table[i], &stats[cnt]);
+		cnt++;
+	}
+
+	if (cnt < max) {
+		lockstat_copy(&lockstat_other, &stats[cnt]);
+		cnt++;
+	}
+
+	lockstat_flag_unlock(&lockstat_table_busy);
+	interrupts_restore(ipl);
+	return cnt;
+}
+
+static void lockstat_clear(lockstat_t *stat)
+{
+	lockstat_flag_lock(&stat->busy);
+
+	stat->acquisitions = 0;
+	stat->contended = 0;
+	stat->spin_cycles = 0;
+	stat->hold_cycles = 0;
+	stat->max_hold_cycles = 0;
+
+	lockstat_flag_unlock(&stat->busy);
+}
+
+/** Reset all lock statistics. */
+void lockstat_reset(void)
+{
+	ipl_t ipl = interrupts_disable();
+
+	for (size_t i = 0; i < LOCKSTAT_ENTRIES; i++)
+		lockstat_clear(&lockstat_table[i]);
+
+	lockstat_clear(&lockstat_other);
+
+	interrupts_restore(ipl);
+}
+
+static int lockstat_cmp(void *a, void *b, void *arg)
+{
+	stats_lock_t *sa = (stats_lock_t *) a;
+	stats_lock_t *sb = (stats_lock_t *) b;
+
+	if (sa->spin_cycles != sb->spin_cycles)
+		return (sa->spin_cycles > sb->spin_cycles) ? -1 : 1;
+
+	if (sa->contended != sb->contended)
+		return (sa->contended > sb->contended) ? -1 : 1;
+
+	return 0;
+}
+
+/** Print lock statistics.
+ *
+ * Locks are sorted by the total time spent waiting for them.
+ *
+ * @param all If false, only print the most contended locks.
+ *
+ */
+void lockstat_print(bool all)
+{
+	size_t max = LOCKSTAT_ENTRIES + 1;
+	stats_lock_t *stats = malloc(sizeof(stats_lock_t) * max);
+	if (stats == NULL) {
+		printf("Not enough memory.\n");
+		return;
+	}
+
+	size_t cnt = lockstat_snapshot(stats, max);
+	gsort(stats, cnt, sizeof(stats_lock_t), lockstat_cmp, NULL);
+
+	if ((!all) && (cnt > LOCKSTAT_PRINT_TOP))
+		cnt = LOCKSTAT_PRINT_TOP;
+
+	printf("[name                          ] [acquired ] [contended] "
+	    "[spin cycles   ] [avg hold ] [max hold ]\n");
+
+	for (size_t i = 0; i < cnt; i++) {
+		if (stats[i].acquisitions == 0)
+			continue;
+
+		printf("%-32s %11" PRIu64 " %11" PRIu64 " %16" PRIu64
+		    " %11" PRIu64 " %11" PRIu64 "\n", stats[i].name,
+		    stats[i].acquisitions, stats[i].contended,
+		    stats[i].spin_cycles,
+		    stats[i].hold_cycles / stats[i].acquisitions,
+		    stats[i].max_hold_cycles);
+	}
+
+	free(stats);
+}
+
+/** @}
+ */
@@ -40,6 +40,7 @@
 #include <synch/mutex.h>
 #include <synch/semaphore.h>
 #include <arch.h>
+#include <arch/asm.h>
 #include <stacktrace.h>
 #include <cpu.h>
 #include <proc/thread.h>
@@ -52,7 +53,9 @@
 void mutex_initialize(mutex_t *mtx, mutex_type_t type)
 {
 	mtx->type = type;
-	mtx->owner = NULL;
+	atomic_store_explicit(&mtx->owner, NULL, memory_order_relaxed);
+	atomic_store_explicit(&mtx->running, false, memory_order_relaxed);
+	link_initialize(&mtx->owner_link);
 	mtx->nesting = 0;
 	semaphore_initialize(&mtx->sem, 1);
 }
@@ -70,6 +73,146 @@ bool mutex_locked(mutex_t *mtx)
 
 #define MUTEX_DEADLOCK_THRESHOLD	100000000
 
+/** Maximum number of owner checks before an adaptive mutex goes to sleep. */
+#define MUTEX_SPIN_THRESHOLD	5000
+
+/** Contention statistics of adaptive and recursive mutexes. */
+static atomic_size_t mutex_contended;
+static atomic_size_t mutex_spin_acquired;
+static atomic_size_t mutex_slept;
+
+static struct thread *mutex_owner(mutex_t *mtx)
+{
+	return atomic_load_explicit(&mtx->owner, memory_order_relaxed);
+}
+
+/** Record the current thread as the owner of a mutex.
+ *
+ * The mutex is linked to the thread so that the scheduler can keep
+ * the running flag of the mutex up to date. Interrupts are disabled so
+ * that the thread is not preempted with the list half updated.
+ *
+ * @param mtx Mutex.
+ *
+ */
+static void mutex_own(mutex_t *mtx)
+{
+	ipl_t ipl = interrupts_disable();
+	atomic_store_explicit(&mtx->owner, THREAD, memory_order_relaxed);
+	atomic_store_explicit(&mtx->running, true, memory_order_relaxed);
+	list_append(&mtx->owner_link, &THREAD->mutexes);
+	interrupts_restore(ipl);
+}
+
+/** Forget the owner of a mutex.
+ *
+ * @param mtx Mutex.
+ *
+ */
+static void mutex_disown(mutex_t *mtx)
+{
+	ipl_t ipl = interrupts_disable();
+	list_remove(&mtx->owner_link);
+	atomic_store_explicit(&mtx->running, false, memory_order_relaxed);
+	atomic_store_explicit(&mtx->owner, NULL, memory_order_relaxed);
+	interrupts_restore(ipl);
+}
+
+/** Update the running flag of all mutexes held by a thread.
+ *
+ * Called by the scheduler whenever the thread is switched to or away
+ * from, so that threads spinning on the mutexes never need to look
+ * at the owner itself.
+ *
+ * @param thread  Thread being switched.
+ * @param running True if the thread is about to run, false if it has
+ *                just stopped running.
+ *
+ */
+void mutex_owner_switch(thread_t *thread, bool running)
+{
+	list_foreach(thread->mutexes, owner_link, mutex_t, mtx) {
+		atomic_store_explicit(&mtx->running, running,
+		    memory_order_relaxed);
+	}
+}
+
+/** Spin waiting for the owner of an adaptive mutex.
+ *
+ * Only the owner and running fields of the mutex are polled while
+ * spinning; the owner thread itself is never looked at, as it may have
+ * exited in the meantime. The semaphore is touched only once the owner
+ * is seen to have released the mutex, so that spinning CPUs do not keep
+ * pulling its wait queue lock.
+ *
+ * @param mtx Mutex.
+ *
+ * @return True if the mutex was acquired, false if the caller should
+ *         go to sleep.
+ *
+ */
+static bool mutex_spin(mutex_t *mtx)
+{
+	bool tried = false;
+
+	for (unsigned int i = 0; i < MUTEX_SPIN_THRESHOLD; i++) {
+		if (mutex_owner(mtx) == NULL) {
+			/*
+			 * Either the mutex has been released or the new
+			 * owner has not recorded itself yet. In the latter
+			 * case, wait for the owner to show up rather than
+			 * retrying.
+			 */
+			if (!tried) {
+				if (semaphore_trydown(&mtx->sem) == EOK)
+					return true;
+				tried = true;
+			}
+		} else if (!atomic_load_explicit(&mtx->running,
+		    memory_order_relaxed)) {
+			return false;
+		} else {
+			tried = false;
+		}
+
+		cpu_spin_hint();
+	}
+
+	return false;
+}
+
+/** Acquire adaptive or recursive mutex.
+ *
+ * @param mtx    Mutex.
+ * @param usec   Timeout in microseconds.
+ * @param flags  Specify mode of operation.
+ *
+ * @return See comment for waitq_sleep_timeout().
+ *
+ */
+static errno_t mutex_lock_adaptive(mutex_t *mtx, uint32_t usec,
+    unsigned int flags)
+{
+	errno_t rc = semaphore_trydown(&mtx->sem);
+	if (rc == EOK)
+		return EOK;
+
+	/* Conditional lock, do not wait at all. */
+	if ((usec == SYNCH_NO_TIMEOUT) && (flags & SYNCH_FLAGS_NON_BLOCKING))
+		return rc;
+
+	atomic_fetch_add_explicit(&mutex_contended, 1, memory_order_relaxed);
+
+	if (mutex_spin(mtx)) {
+		atomic_fetch_add_explicit(&mutex_spin_acquired, 1,
+		    memory_order_relaxed);
+		return EOK;
+	}
+
+	atomic_fetch_add_explicit(&mutex_slept, 1, memory_order_relaxed);
+	return _semaphore_down_timeout(&mtx->sem, usec, flags);
+}
+
 /** Acquire mutex.
  *
  * Timeout mode and non-blocking mode can be requested.
@@ -90,16 +233,20 @@ errno_t _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
 
 	if (mtx->type == MUTEX_PASSIVE && THREAD) {
 		rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+	} else if (mtx->type == MUTEX_ADAPTIVE && THREAD) {
+		rc = mutex_lock_adaptive(mtx, usec, flags);
+		if (rc == EOK)
+			mutex_own(mtx);
 	} else if (mtx->type == MUTEX_RECURSIVE) {
 		assert(THREAD);
 
-		if (mtx->owner == THREAD) {
+		if (mutex_owner(mtx) == THREAD) {
 			mtx->nesting++;
 			return EOK;
 		} else {
-			rc = _semaphore_down_timeout(&mtx->sem, usec, flags);
+			rc = mutex_lock_adaptive(mtx, usec, flags);
 			if (rc == EOK) {
-				mtx->owner = THREAD;
+				mutex_own(mtx);
 				mtx->nesting = 1;
 			}
 		}
@@ -134,13 +281,29 @@ errno_t _mutex_lock_timeout(mutex_t *mtx, uint32_t usec, unsigned int flags)
 void mutex_unlock(mutex_t *mtx)
 {
 	if (mtx->type == MUTEX_RECURSIVE) {
-		assert(mtx->owner == THREAD);
+		assert(mutex_owner(mtx) == THREAD);
 		if (--mtx->nesting > 0)
 			return;
-		mtx->owner = NULL;
+		mutex_disown(mtx);
+	} else if ((mtx->type == MUTEX_ADAPTIVE) && (mutex_owner(mtx) != NULL)) {
+		mutex_disown(mtx);
 	}
 	semaphore_up(&mtx->sem);
 }
 
+/** Get contention statistics of adaptive and recursive mutexes.
+ *
+ * @param stats Structure to be filled in.
+ */
+void mutex_stats_get(stats_mutex_t *stats)
+{
+	stats->contended = atomic_load_explicit(&mutex_contended,
+	    memory_order_relaxed);
+	stats->spin_acquired = atomic_load_explicit(&mutex_spin_acquired,
+	    memory_order_relaxed);
+	stats->slept = atomic_load_explicit(&mutex_slept,
+	    memory_order_relaxed);
+}
+
 /** @}
  */
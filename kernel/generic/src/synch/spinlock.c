@@ -45,6 +45,7 @@
 #include <symtab.h>
 #include <stacktrace.h>
 #include <cpu.h>
+#include <synch/lockstat.h>
 
 #ifdef CONFIG_SMP
 
@@ -55,10 +56,14 @@
  */
 void spinlock_initialize(spinlock_t *lock, const char *name)
 {
-	atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
+	atomic_store_explicit(&lock->ticket, 0, memory_order_relaxed);
+	atomic_store_explicit(&lock->serving, 0, memory_order_relaxed);
 #ifdef CONFIG_DEBUG_SPINLOCK
 	lock->name = name;
 #endif
+#ifdef CONFIG_LOCKSTAT
+	lock->stat = NULL;
+#endif
 }
 
 #ifdef CONFIG_DEBUG_SPINLOCK
@@ -76,9 +81,20 @@ void spinlock_lock_debug(spinlock_t *lock)
 {
 	size_t i = 0;
 	bool deadlock_reported = false;
+	bool contended = false;
+	uint64_t spin_start = 0;
 
 	preemption_disable();
-	while (atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire)) {
+
+	unsigned int ticket = atomic_fetch_add_explicit(&lock->ticket, 1,
+	    memory_order_relaxed);
+	while (atomic_load_explicit(&lock->serving, memory_order_acquire) !=
+	    ticket) {
+		if (!contended) {
+			contended = true;
+			spin_start = lockstat_now();
+		}
+
 		/*
 		 * We need to be careful about particular locks
 		 * which are directly used to report deadlocks
@@ -114,6 +130,9 @@ void spinlock_lock_debug(spinlock_t *lock)
 
 	if (deadlock_reported)
 		printf("cpu%u: not deadlocked\n", CPU->id);
+
+	lockstat_acquire(lock, contended,
+	    contended ? lockstat_now() - spin_start : 0);
 }
 
 /** Unlock spinlock
@@ -126,7 +145,11 @@ void spinlock_unlock_debug(spinlock_t *lock)
 {
 	ASSERT_SPINLOCK(spinlock_locked(lock), lock);
 
-	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+	lockstat_release(lock);
+
+	unsigned int serving = atomic_load_explicit(&lock->serving,
+	    memory_order_relaxed);
+	atomic_store_explicit(&lock->serving, serving + 1, memory_order_release);
 	preemption_enable();
 }
 
@@ -145,10 +168,21 @@ void spinlock_unlock_debug(spinlock_t *lock)
 bool spinlock_trylock(spinlock_t *lock)
 {
 	preemption_disable();
-	bool ret = !atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire);
+
+	/*
+	 * The lock is free only if there is no holder and no waiter, i.e.
+	 * when the next ticket is the one being served. Take that ticket.
+	 */
+	unsigned int ticket = atomic_load_explicit(&lock->serving,
+	    memory_order_acquire);
+	unsigned int expected = ticket;
+	bool ret = atomic_compare_exchange_strong_explicit(&lock->ticket,
+	    &expected, ticket + 1, memory_order_acquire, memory_order_relaxed);
 
 	if (!ret)
 		preemption_enable();
+	else
+		lockstat_acquire(lock, false, 0);
 
 	return ret;
 }
@@ -160,15 +194,8 @@ bool spinlock_trylock(spinlock_t *lock)
  */
 bool spinlock_locked(spinlock_t *lock)
 {
-	// NOTE: Atomic flag doesn't support simple atomic read (by design),
-	//       so instead we test_and_set and then clear if necessary.
-	//       This function is only used inside assert, so we don't need
-	//       any preemption_disable/enable here.
-
-	bool ret = atomic_flag_test_and_set_explicit(&lock->flag, memory_order_relaxed);
-	if (!ret)
-		atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
-	return ret;
+	return atomic_load_explicit(&lock->ticket, memory_order_relaxed) !=
+	    atomic_load_explicit(&lock->serving, memory_order_relaxed);
 }
 
 #endif
@@ -40,6 +40,7 @@
 #include <sysinfo/stats.h>
 #include <sysinfo/sysinfo.h>
 #include <synch/spinlock.h>
+#include <synch/lockstat.h>
 #include <synch/mutex.h>
 #include <time/clock.h>
 #include <mm/frame.h>
@@ -125,6 +126,13 @@ static void *get_stats_cpus(struct sysinfo_item *item, size_t *size,
 		stats_cpus[i].frequency_mhz = cpus[i].frequency_mhz;
 		stats_cpus[i].busy_cycles = cpus[i].busy_cycles;
 		stats_cpus[i].idle_cycles = cpus[i].idle_cycles;
+		stats_cpus[i].tlb_shootdowns = cpus[i].tlb_shootdowns;
+		stats_cpus[i].tlb_shootdowns_received =
+		    cpus[i].tlb_shootdowns_received;
+		stats_cpus[i].tlb_ipis_sent = cpus[i].tlb_ipis_sent;
+		stats_cpus[i].tlb_ipis_avoided = cpus[i].tlb_ipis_avoided;
+		stats_cpus[i].page_faults = cpus[i].page_faults;
+		stats_cpus[i].large_pages_mapped = cpus[i].large_pages_mapped;
 
 		irq_spinlock_unlock(&cpus[i].lock, true);
 	}
@@ -227,6 +235,12 @@ static void produce_stats_task(task_t *task, stats_task_t *stats_task)
 	task_get_accounting(task, &(stats_task->ucycles),
 	    &(stats_task->kcycles));
 	stats_task->ipc_info = task->ipc_info;
+	stats_task->fault_info.page_faults = atomic_load_explicit(
+	    &task->fault_info.page_faults, memory_order_relaxed);
+	stats_task->fault_info.faulted_around = atomic_load_explicit(
+	    &task->fault_info.faulted_around, memory_order_relaxed);
+	stats_task->fault_info.prezeroed = atomic_load_explicit(
+	    &task->fault_info.prezeroed, memory_order_relaxed);
 }
 
 /** Get task statistics
@@ -683,6 +697,71 @@ static void *get_stats_exceptions(struct sysinfo_item *item, size_t *size,
 	return ((void *) stats_exceptions);
 }
 
+#ifdef CONFIG_LOCKSTAT
+
+/** Get spinlock contention statistics
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several stats_lock_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_locks(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	size_t count = lockstat_count();
+
+	*size = sizeof(stats_lock_t) * count;
+	if (dry_run)
+		return NULL;
+
+	stats_lock_t *stats_locks = (stats_lock_t *) malloc(*size);
+	if (stats_locks == NULL) {
+		/* No free space for allocation */
+		*size = 0;
+		return NULL;
+	}
+
+	count = lockstat_snapshot(stats_locks, count);
+	*size = sizeof(stats_lock_t) * count;
+
+	return ((void *) stats_locks);
+}
+
+#endif /* CONFIG_LOCKSTAT */
+
+/** Get adaptive mutex statistics
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing stats_mutex_t.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_mutexes(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	*size = sizeof(stats_mutex_t);
+	if (dry_run)
+		return NULL;
+
+	stats_mutex_t *stats_mutexes = (stats_mutex_t *) malloc(*size);
+	if (stats_mutexes == NULL) {
+		*size = 0;
+		return NULL;
+	}
+
+	mutex_stats_get(stats_mutexes);
+	return ((void *) stats_mutexes);
+}
+
 /** Get exception statistics
  *
  * Get statistics of a given exception. The exception number
@@ -878,6 +957,10 @@ void stats_init(void)
 	sysinfo_set_item_gen_data("system.threads", NULL, get_stats_threads, NULL);
 	sysinfo_set_item_gen_data("system.ipccs", NULL, get_stats_ipccs, NULL);
 	sysinfo_set_item_gen_data("system.exceptions", NULL, get_stats_exceptions, NULL);
+	sysinfo_set_item_gen_data("system.mutexes", NULL, get_stats_mutexes, NULL);
+#ifdef CONFIG_LOCKSTAT
+	sysinfo_set_item_gen_data("system.locks", NULL, get_stats_locks, NULL);
+#endif
 	sysinfo_set_subtree_fn("system.tasks", NULL, get_stats_task, NULL);
 	sysinfo_set_subtree_fn("system.threads", NULL, get_stats_thread, NULL);
 	sysinfo_set_subtree_fn("system.exceptions", NULL, get_stats_exception, NULL);
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <test.h>
+#include <atomic.h>
+#include <proc/thread.h>
+#include <synch/mutex.h>
+
+#include <arch.h>
+
+#define THREADS     8
+#define ITERATIONS  10000
+
+static mutex_t counter_mtx;
+static size_t counter;
+static atomic_t threads_finished;
+
+static void increment(void *data)
+{
+	thread_detach(THREAD);
+
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		mutex_lock(&counter_mtx);
+		counter++;
+
+		/* Sometimes block while holding the mutex. */
+		if ((i % 1000) == 0)
+			thread_usleep(1000);
+
+		mutex_unlock(&counter_mtx);
+	}
+
+	atomic_inc(&threads_finished);
+}
+
+const char *test_mutex1(void)
+{
+	size_t total = 0;
+
+	mutex_initialize(&counter_mtx, MUTEX_ADAPTIVE);
+	counter = 0;
+	atomic_store(&threads_finished, 0);
+
+	stats_mutex_t before;
+	mutex_stats_get(&before);
+
+	for (unsigned int i = 0; i < THREADS; i++) {
+		thread_t *t = thread_create(increment, NULL, TASK,
+		    THREAD_FLAG_NONE, "mutex1");
+		if (t == NULL) {
+			TPRINTF("Could not create thread %u\n", i);
+			break;
+		}
+
+		thread_ready(t);
+		total++;
+	}
+
+	while (atomic_load(&threads_finished) < total) {
+		TPRINTF("Threads left: %zu\n",
+		    total - atomic_load(&threads_finished));
+		thread_usleep(100000);
+	}
+
+	stats_mutex_t after;
+	mutex_stats_get(&after);
+
+	TPRINTF("Counter: %zu (expected %zu)\n", counter, total * ITERATIONS);
+	TPRINTF("Contended: %" PRIu64 ", spun: %" PRIu64 ", slept: %" PRIu64
+	    "\n", after.contended - before.contended,
+	    after.spin_acquired - before.spin_acquired,
+	    after.slept - before.slept);
+
+	if (counter != total * ITERATIONS)
+		return "Lost updates under mutex";
+
+	mutex_lock(&counter_mtx);
+	if (mutex_trylock(&counter_mtx) == EOK) {
+		mutex_unlock(&counter_mtx);
+		mutex_unlock(&counter_mtx);
+		return "Locked mutex acquired by trylock";
+	}
+	mutex_unlock(&counter_mtx);
+
+	return NULL;
+}
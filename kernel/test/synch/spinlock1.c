@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <test.h>
+#include <atomic.h>
+#include <proc/thread.h>
+#include <synch/spinlock.h>
+
+#include <arch.h>
+
+#define THREADS     8
+#define ITERATIONS  100000
+
+SPINLOCK_STATIC_INITIALIZE(counter_lock);
+
+static volatile size_t counter;
+static atomic_t threads_finished;
+
+static void increment(void *data)
+{
+	thread_detach(THREAD);
+
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		if ((i % 2) == 0) {
+			spinlock_lock(&counter_lock);
+		} else {
+			while (!spinlock_trylock(&counter_lock))
+				;
+		}
+
+		counter++;
+		spinlock_unlock(&counter_lock);
+	}
+
+	atomic_inc(&threads_finished);
+}
+
+const char *test_spinlock1(void)
+{
+	size_t total = 0;
+
+	counter = 0;
+	atomic_store(&threads_finished, 0);
+
+	for (unsigned int i = 0; i < THREADS; i++) {
+		thread_t *t = thread_create(increment, NULL, TASK,
+		    THREAD_FLAG_NONE, "spinlock1");
+		if (t == NULL) {
+			TPRINTF("Could not create thread %u\n", i);
+			break;
+		}
+
+		thread_ready(t);
+		total++;
+	}
+
+	while (atomic_load(&threads_finished) < total) {
+		TPRINTF("Threads left: %zu\n",
+		    total - atomic_load(&threads_finished));
+		thread_usleep(100000);
+	}
+
+	TPRINTF("Counter: %zu (expected %zu)\n", counter, total * ITERATIONS);
+
+	if (counter != total * ITERATIONS)
+		return "Lost updates under spinlock";
+
+	spinlock_lock(&counter_lock);
+	if (spinlock_trylock(&counter_lock)) {
+		spinlock_unlock(&counter_lock);
+		spinlock_unlock(&counter_lock);
+		return "Locked spinlock acquired by trylock";
+	}
+	spinlock_unlock(&counter_lock);
+
+	return NULL;
+}
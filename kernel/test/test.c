@@ -47,8 +47,10 @@ test_t tests[] = {
 #include <mm/mapping1.def>
 #include <mm/slab1.def>
 #include <mm/slab2.def>
+#include <synch/mutex1.def>
 #include <synch/semaphore1.def>
 #include <synch/semaphore2.def>
+#include <synch/spinlock1.def>
 #include <print/print1.def>
 #include <print/print2.def>
 #include <print/print3.def>
@@ -40,11 +40,17 @@
 benchmark_t *benchmarks[] = {
 	&benchmark_dir_read,
 	&benchmark_fibril_mutex,
+	&benchmark_file_random_read,
 	&benchmark_file_read,
+	&benchmark_inet_checksum,
+	&benchmark_inet_checksum_copy,
 	&benchmark_malloc1,
 	&benchmark_malloc2,
 	&benchmark_ns_ping,
-	&benchmark_ping_pong
+	&benchmark_ping_pong,
+	&benchmark_ping_pong_mt,
+	&benchmark_route_lookup,
+	&benchmark_udp_loopback
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+#define BLOCK_SIZE 4096
+
+/** Simple xorshift generator so that runs are reproducible. */
+static uint64_t next_random(uint64_t *state)
+{
+	uint64_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return x;
+}
+
+/** Execute random file reading benchmark.
+ *
+ * Reads blocks at random block-aligned offsets scattered over the whole
+ * file. Use a file much larger than the block cache (several gigabytes)
+ * to measure how fast the file system maps a file offset to a device
+ * block rather than how fast it serves cached data.
+ */
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	const char *path = bench_env_param_get(env, "filename", "/data/web/helenos.png");
+	const char *seed_str = bench_env_param_get(env, "seed", "1");
+	uint64_t state;
+	vfs_stat_t st;
+	aoff64_t blocks;
+	int fd;
+	errno_t rc;
+
+	rc = str_uint64_t(seed_str, NULL, 0, true, &state);
+	if (rc != EOK || state == 0)
+		return bench_run_fail(run, "invalid seed '%s'", seed_str);
+
+	char *buf = malloc(BLOCK_SIZE);
+	if (buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %dB buffer", BLOCK_SIZE);
+	}
+
+	bool ret = true;
+
+	rc = vfs_lookup_open(path, WALK_REGULAR, MODE_READ, &fd);
+	if (rc != EOK) {
+		bench_run_fail(run, "failed to open %s for reading: %s",
+		    path, str_error(rc));
+		ret = false;
+		goto leave_free_buf;
+	}
+
+	rc = vfs_stat(fd, &st);
+	if (rc != EOK) {
+		bench_run_fail(run, "failed to stat %s: %s",
+		    path, str_error(rc));
+		ret = false;
+		goto leave_close;
+	}
+
+	blocks = st.size / BLOCK_SIZE;
+	if (blocks == 0) {
+		bench_run_fail(run, "%s is smaller than %dB", path, BLOCK_SIZE);
+		ret = false;
+		goto leave_close;
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		aoff64_t pos = (next_random(&state) % blocks) * BLOCK_SIZE;
+		size_t nread;
+
+		rc = vfs_read(fd, &pos, buf, BLOCK_SIZE, &nread);
+		if (rc != EOK || nread != BLOCK_SIZE) {
+			bench_run_fail(run, "failed to read from %s: %s",
+			    path, rc != EOK ? str_error(rc) : "short read");
+			ret = false;
+			goto leave_close;
+		}
+	}
+	bench_run_stop(run);
+
+leave_close:
+	vfs_put(fd);
+
+leave_free_buf:
+	free(buf);
+
+	return ret;
+}
+
+benchmark_t benchmark_file_random_read = {
+	.name = "file_random_read",
+	.desc = "Read 4KiB blocks at random offsets of a file (use 'filename' and 'seed' params to alter the defaults).",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/**
+ * @}
+ */
@@ -133,11 +133,17 @@ extern size_t benchmark_count;
 /* Put your benchmark descriptors here (and also to benchlist.c). */
 extern benchmark_t benchmark_dir_read;
 extern benchmark_t benchmark_fibril_mutex;
+extern benchmark_t benchmark_file_random_read;
 extern benchmark_t benchmark_file_read;
+extern benchmark_t benchmark_inet_checksum;
+extern benchmark_t benchmark_inet_checksum_copy;
 extern benchmark_t benchmark_malloc1;
 extern benchmark_t benchmark_malloc2;
 extern benchmark_t benchmark_ns_ping;
 extern benchmark_t benchmark_ping_pong;
+extern benchmark_t benchmark_ping_pong_mt;
+extern benchmark_t benchmark_route_lookup;
+extern benchmark_t benchmark_udp_loopback;
 
 #endif
 
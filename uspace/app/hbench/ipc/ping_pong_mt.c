@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ipc_test.h>
+#include <async.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Multi-threaded variant of the ping_pong benchmark. Several client fibrils,
+ * each with its own session, ping the IPC test server concurrently from
+ * multiple threads, which exercises the kernel capability lookup and phone
+ * locking from several CPUs at once.
+ */
+
+typedef struct {
+	fibril_mutex_t lock;
+	fibril_condvar_t done_cv;
+	size_t running;
+	errno_t rc;
+} shared_t;
+
+typedef struct {
+	shared_t *shared;
+	ipc_test_t *test;
+	uint64_t niter;
+} client_t;
+
+static size_t threads;
+static client_t *clients = NULL;
+static bool runners_spawned = false;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *param = bench_env_param_get(env, "threads", "4");
+	threads = strtoul(param, NULL, 10);
+	if (threads == 0)
+		return bench_run_fail(run, "invalid number of threads: %s", param);
+
+	clients = calloc(threads, sizeof(client_t));
+	if (clients == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	for (size_t i = 0; i < threads; i++) {
+		errno_t rc = ipc_test_create(&clients[i].test);
+		if (rc != EOK) {
+			return bench_run_fail(run,
+			    "failed contacting IPC test server (have you run /srv/test/ipc-test?): %s (%d)",
+			    str_error(rc), rc);
+		}
+	}
+
+	/* Runner threads stay around for the lifetime of the task. */
+	if (!runners_spawned) {
+		fibril_test_spawn_runners(threads - 1);
+		runners_spawned = true;
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	if (clients == NULL)
+		return true;
+
+	for (size_t i = 0; i < threads; i++) {
+		if (clients[i].test != NULL)
+			ipc_test_destroy(clients[i].test);
+	}
+
+	free(clients);
+	clients = NULL;
+	return true;
+}
+
+static errno_t client_fibril(void *arg)
+{
+	client_t *client = arg;
+	shared_t *shared = client->shared;
+	errno_t rc = EOK;
+
+	for (uint64_t count = 0; count < client->niter; count++) {
+		rc = ipc_test_ping(client->test);
+		if (rc != EOK)
+			break;
+	}
+
+	fibril_mutex_lock(&shared->lock);
+	if (rc != EOK)
+		shared->rc = rc;
+	shared->running--;
+	if (shared->running == 0)
+		fibril_condvar_broadcast(&shared->done_cv);
+	fibril_mutex_unlock(&shared->lock);
+
+	return EOK;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	shared_t shared;
+	fibril_mutex_initialize(&shared.lock);
+	fibril_condvar_initialize(&shared.done_cv);
+	shared.running = threads;
+	shared.rc = EOK;
+
+	fid_t *fids = calloc(threads, sizeof(fid_t));
+	if (fids == NULL)
+		return bench_run_fail(run, "out of memory");
+
+	for (size_t i = 0; i < threads; i++) {
+		clients[i].shared = &shared;
+		clients[i].niter = niter / threads;
+		if (i < niter % threads)
+			clients[i].niter++;
+
+		fids[i] = fibril_create(client_fibril, &clients[i]);
+		if (fids[i] == 0) {
+			for (size_t j = 0; j < i; j++)
+				fibril_destroy(fids[j]);
+			free(fids);
+			return bench_run_fail(run, "failed creating client fibril");
+		}
+	}
+
+	bench_run_start(run);
+
+	for (size_t i = 0; i < threads; i++)
+		fibril_add_ready(fids[i]);
+
+	fibril_mutex_lock(&shared.lock);
+	while (shared.running > 0)
+		fibril_condvar_wait(&shared.done_cv, &shared.lock);
+	fibril_mutex_unlock(&shared.lock);
+
+	bench_run_stop(run);
+
+	free(fids);
+
+	if (shared.rc != EOK) {
+		return bench_run_fail(run, "failed sending ping message: %s (%d)",
+		    str_error(shared.rc), shared.rc);
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_ping_pong_mt = {
+	.name = "ping_pong_mt",
+	.desc = "IPC ping-pong benchmark with concurrent clients",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
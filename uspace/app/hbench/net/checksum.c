@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <inet/checksum.h>
+#include <inttypes.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/** Default buffer size (typical Ethernet MTU) */
+#define DEFAULT_SIZE "1500"
+
+/** Keeps the compiler from optimizing the computation away */
+static volatile uint16_t checksum_sink;
+
+/** Execute Internet checksum benchmark.
+ *
+ * Computes checksum of a buffer of 'size' bytes (default 1500) repeatedly.
+ * When @a copy is true, the buffer is also copied to a second buffer in
+ * the same pass, as done when building outgoing PDUs.
+ */
+static bool run_checksum(bench_env_t *env, bench_run_t *run, uint64_t niter,
+    bool copy)
+{
+	const char *size_str = bench_env_param_get(env, "size", DEFAULT_SIZE);
+	uint64_t size;
+	uint16_t cs;
+	errno_t rc;
+
+	rc = str_uint64_t(size_str, NULL, 0, true, &size);
+	if (rc != EOK || size == 0)
+		return bench_run_fail(run, "invalid size '%s'", size_str);
+
+	uint8_t *src = malloc(size);
+	uint8_t *dst = malloc(size);
+	if (src == NULL || dst == NULL) {
+		free(src);
+		free(dst);
+		return bench_run_fail(run, "failed to allocate %" PRIu64 "B buffers",
+		    size);
+	}
+
+	for (uint64_t i = 0; i < size; i++)
+		src[i] = (uint8_t) (i * 7);
+
+	cs = INET_CHECKSUM_INIT;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < niter; i++) {
+		if (copy)
+			cs = inet_checksum_copy(cs, dst, src, size);
+		else
+			cs = inet_checksum_calc(cs, src, size);
+	}
+	bench_run_stop(run);
+
+	checksum_sink = cs;
+
+	free(src);
+	free(dst);
+	return true;
+}
+
+static bool runner_calc(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	return run_checksum(env, run, niter, false);
+}
+
+static bool runner_copy(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	return run_checksum(env, run, niter, true);
+}
+
+benchmark_t benchmark_inet_checksum = {
+	.name = "inet_checksum",
+	.desc = "Compute Internet checksum of a buffer (use 'size' param to alter the default).",
+	.entry = &runner_calc,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_inet_checksum_copy = {
+	.name = "inet_checksum_copy",
+	.desc = "Copy a buffer and compute its Internet checksum (use 'size' param to alter the default).",
+	.entry = &runner_copy,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <adt/prefix_trie.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/** Default number of routes */
+#define DEFAULT_ROUTES "10000"
+
+static prefix_trie_t trie;
+static uint32_t seed;
+static size_t matched;
+
+static uint32_t next_rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8 | (uint32_t) seed << 24;
+}
+
+/** Fill trie with random IPv4 routes.
+ *
+ * Prefix lengths are spread between /8 and /32 with most of them
+ * around /24, roughly like in a real routing table. The prefix trie
+ * is the structure used by inetsrv for its routing table.
+ */
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *routes_str = bench_env_param_get(env, "routes",
+	    DEFAULT_ROUTES);
+	uint64_t routes;
+	uint64_t i;
+	uint32_t addr;
+	uint8_t key[4];
+	unsigned plen;
+	errno_t rc;
+
+	rc = str_uint64_t(routes_str, NULL, 0, true, &routes);
+	if (rc != EOK || routes == 0)
+		return bench_run_fail(run, "invalid number of routes '%s'",
+		    routes_str);
+
+	prefix_trie_initialize(&trie, 32);
+	seed = 1;
+
+	i = 0;
+	while (i < routes) {
+		addr = next_rand();
+		key[0] = addr >> 24;
+		key[1] = addr >> 16;
+		key[2] = addr >> 8;
+		key[3] = addr;
+
+		plen = 8 + next_rand() % 25;
+		if (next_rand() % 2 == 0)
+			plen = 24;
+
+		/* Any non-NULL value will do */
+		rc = prefix_trie_insert(&trie, key, plen, &trie);
+		if (rc == EEXIST)
+			continue;
+		if (rc != EOK) {
+			prefix_trie_finalize(&trie);
+			return bench_run_fail(run, "out of memory");
+		}
+
+		++i;
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	prefix_trie_finalize(&trie);
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	uint32_t addr;
+	uint8_t key[4];
+
+	matched = 0;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < niter; i++) {
+		addr = next_rand();
+		key[0] = addr >> 24;
+		key[1] = addr >> 16;
+		key[2] = addr >> 8;
+		key[3] = addr;
+
+		if (prefix_trie_lookup(&trie, key) != NULL)
+			++matched;
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_route_lookup = {
+	.name = "route_lookup",
+	.desc = "Longest prefix match in a routing table (use 'routes' param to alter the default of 10000 routes).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/udp.h>
+#include <inttypes.h>
+#include <macros.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/** Default number of datagrams sent in one batch */
+#define DEFAULT_BATCH "32"
+/** Default datagram size */
+#define DEFAULT_SIZE "64"
+/** Default port to send datagrams to */
+#define DEFAULT_PORT "54321"
+/** Time to wait for datagrams still in flight */
+#define RECV_TIMEOUT SEC2USEC(10)
+
+static udp_t *udp;
+static udp_assoc_t *recv_assoc;
+static udp_assoc_t *send_assoc;
+static udp_mmsg_t *msgs;
+static void *payload;
+static size_t batch;
+static size_t msg_size;
+
+static FIBRIL_MUTEX_INITIALIZE(recv_lock);
+static FIBRIL_CONDVAR_INITIALIZE(recv_cv);
+static uint64_t received;
+
+static void recv_msg(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
+{
+	fibril_mutex_lock(&recv_lock);
+	++received;
+	fibril_mutex_unlock(&recv_lock);
+	fibril_condvar_broadcast(&recv_cv);
+}
+
+static udp_cb_t recv_cb = {
+	.recv_msg = recv_msg
+};
+
+static bool get_size_param(bench_env_t *env, bench_run_t *run,
+    const char *name, const char *def, size_t *rval)
+{
+	const char *str = bench_env_param_get(env, name, def);
+	uint64_t val;
+	errno_t rc;
+
+	rc = str_uint64_t(str, NULL, 0, true, &val);
+	if (rc != EOK || val == 0 || val > UINT16_MAX)
+		return bench_run_fail(run, "invalid %s '%s'", name, str);
+
+	*rval = val;
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	udp_assoc_destroy(send_assoc);
+	udp_assoc_destroy(recv_assoc);
+	udp_destroy(udp);
+	free(msgs);
+	free(payload);
+
+	send_assoc = NULL;
+	recv_assoc = NULL;
+	udp = NULL;
+	msgs = NULL;
+	payload = NULL;
+	return true;
+}
+
+/** Create a pair of associations talking to each other over loopback. */
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	inet_ep2_t epp;
+	size_t port;
+	size_t i;
+	errno_t rc;
+
+	if (!get_size_param(env, run, "batch", DEFAULT_BATCH, &batch) ||
+	    !get_size_param(env, run, "size", DEFAULT_SIZE, &msg_size) ||
+	    !get_size_param(env, run, "port", DEFAULT_PORT, &port))
+		return false;
+
+	payload = calloc(1, msg_size);
+	msgs = calloc(batch, sizeof(udp_mmsg_t));
+	if (payload == NULL || msgs == NULL) {
+		teardown(env, run);
+		return bench_run_fail(run, "out of memory");
+	}
+
+	for (i = 0; i < batch; i++) {
+		msgs[i].dest = NULL;
+		msgs[i].data = payload;
+		msgs[i].size = msg_size;
+	}
+
+	rc = udp_create(&udp);
+	if (rc != EOK) {
+		teardown(env, run);
+		return bench_run_fail(run, "failed contacting UDP service: "
+		    "%s (%d)", str_error(rc), rc);
+	}
+
+	inet_ep2_init(&epp);
+	inet_addr_set(0x7f000001, &epp.local.addr);
+	epp.local.port = port;
+
+	rc = udp_assoc_create(udp, &epp, &recv_cb, NULL, &recv_assoc);
+	if (rc != EOK) {
+		teardown(env, run);
+		return bench_run_fail(run, "failed creating receiving "
+		    "association: %s (%d)", str_error(rc), rc);
+	}
+
+	inet_ep2_init(&epp);
+	inet_addr_set(0x7f000001, &epp.remote.addr);
+	epp.remote.port = port;
+
+	rc = udp_assoc_create(udp, &epp, NULL, NULL, &send_assoc);
+	if (rc != EOK) {
+		teardown(env, run);
+		return bench_run_fail(run, "failed creating sending "
+		    "association: %s (%d)", str_error(rc), rc);
+	}
+
+	return true;
+}
+
+/** Send datagrams over loopback and wait until all are received.
+ *
+ * With batch size of one, datagrams are sent one per request, otherwise
+ * they are sent using the multi-message interface.
+ */
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	uint64_t left;
+	size_t n;
+	errno_t rc;
+
+	fibril_mutex_lock(&recv_lock);
+	received = 0;
+	fibril_mutex_unlock(&recv_lock);
+
+	bench_run_start(run);
+
+	left = niter;
+	while (left > 0) {
+		n = min(left, (uint64_t) batch);
+		if (batch == 1) {
+			rc = udp_assoc_send_msg(send_assoc, NULL, payload,
+			    msg_size);
+		} else {
+			rc = udp_assoc_send_mmsg(send_assoc, msgs, n, NULL);
+		}
+
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending datagrams: "
+			    "%s (%d)", str_error(rc), rc);
+		}
+
+		left -= n;
+	}
+
+	fibril_mutex_lock(&recv_lock);
+	while (received < niter) {
+		rc = fibril_condvar_wait_timeout(&recv_cv, &recv_lock,
+		    RECV_TIMEOUT);
+		if (rc == ETIMEOUT)
+			break;
+	}
+	left = niter - received;
+	fibril_mutex_unlock(&recv_lock);
+
+	bench_run_stop(run);
+
+	if (left > 0) {
+		return bench_run_fail(run, "%" PRIu64 " of %" PRIu64
+		    " datagrams were not received", left, niter);
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_udp_loopback = {
+	.name = "udp_loopback",
+	.desc = "UDP datagrams sent over loopback (use 'batch', 'size' and 'port' params to alter the defaults of 32 datagrams per request, 64 bytes and port 54321).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -0,0 +1,1442 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file Bytecode compiler.
+ *
+ * Translates the body of a procedure to bytecode which is executed by
+ * the VM (see vm.c). Local variables and temporaries of primitive type
+ * (@c int, @c char and @c bool) are allocated to VM registers, so that
+ * arithmetic, comparisons, control flow and argument passing do not need
+ * to construct data items or look up variables by name.
+ *
+ * Constructs which the compiler does not handle are left to the runner.
+ * Instruction @c bi_eval evaluates an expression using run_expr() and
+ * @c bi_stat executes a statement using run_stat(). Such code looks up
+ * local variables by name in block ARs, therefore any local variable whose
+ * name is referenced from it must be kept in a block AR, not in a register.
+ * We only learn this while compiling, so we just start over whenever the
+ * set of such names grows.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "bigint.h"
+#include "intmap.h"
+#include "list.h"
+#include "mytypes.h"
+#include "symbol.h"
+
+#include "bc.h"
+
+static void bc_pass(bc_t *bc);
+static void bc_args(bc_t *bc);
+static void bc_arg(bc_t *bc, stree_proc_arg_t *arg, bool_t reg_ok);
+
+static void bc_block(bc_t *bc, stree_block_t *block);
+static void bc_stat(bc_t *bc, stree_stat_t *stat);
+static void bc_vdecl(bc_t *bc, stree_stat_t *stat);
+static void bc_if(bc_t *bc, stree_if_t *if_s);
+static void bc_while(bc_t *bc, stree_while_t *while_s);
+static void bc_break(bc_t *bc);
+static void bc_return(bc_t *bc, stree_return_t *return_s);
+static void bc_exps(bc_t *bc, stree_stat_t *stat);
+static void bc_fallback_stat(bc_t *bc, stree_stat_t *stat);
+
+static int bc_expr(bc_t *bc, stree_expr_t *expr, int dreg);
+static int bc_nameref(bc_t *bc, stree_expr_t *expr, int dreg);
+static int bc_literal(bc_t *bc, stree_literal_t *literal, int dreg);
+static void bc_ldint(bc_t *bc, bigint_t *value, int reg);
+static int bc_binop(bc_t *bc, stree_expr_t *expr, int dreg);
+static int bc_unop(bc_t *bc, stree_expr_t *expr, int dreg);
+static void bc_call(bc_t *bc, stree_call_t *call, int dreg);
+static int bc_eval(bc_t *bc, stree_expr_t *expr, int dreg);
+
+static bool_t bc_titem_vc(tdata_item_t *titem, var_class_t *vc);
+static bool_t bc_expr_vc(stree_expr_t *expr, var_class_t *vc);
+static bool_t bc_texpr_vc(stree_texpr_t *texpr, var_class_t *vc);
+static bool_t bc_vdecl_in_ar(bc_t *bc, stree_vdecl_t *vdecl);
+
+static void bc_spill_name(bc_t *bc, stree_ident_t *name);
+static void bc_spill_block(bc_t *bc, stree_block_t *block);
+static void bc_spill_stat(bc_t *bc, stree_stat_t *stat);
+static void bc_spill_expr(bc_t *bc, stree_expr_t *expr);
+static void bc_spill_exprs(bc_t *bc, list_t *exprs);
+static void bc_spill_texpr(bc_t *bc, stree_texpr_t *texpr);
+
+static void bc_scope_push(bc_t *bc);
+static void bc_scope_pop(bc_t *bc);
+static void bc_local_declare(bc_t *bc, sid_t name, int reg, var_class_t vc);
+static bc_local_t *bc_local_lookup(bc_t *bc, sid_t name);
+
+static int bc_reg_alloc(bc_t *bc);
+static int bc_dreg(bc_t *bc, int dreg);
+static void bc_item_push(bc_t *bc);
+static bc_instr_t *bc_emit(bc_t *bc, bc_iclass_t ic);
+static int bc_last(bc_t *bc);
+static void bc_patch(bc_t *bc, int chain, int target);
+
+static void bc_intmap_clear(intmap_t *intmap, bool_t free_data);
+static void bc_proc_delete(bc_proc_t *proc);
+
+/** Compile procedure body to bytecode.
+ *
+ * @param proc		Procedure (must have a body)
+ * @param rbc		Place to store pointer to new bytecode
+ * @return		EOK on success, ENOTSUP if the body cannot
+ *			be compiled
+ */
+errno_t bc_proc_compile(stree_proc_t *proc, bc_proc_t **rbc)
+{
+	bc_t bc;
+
+	assert(proc->body != NULL);
+
+	bc.proc = proc;
+	intmap_init(&bc.spill);
+
+	do {
+		bc_pass(&bc);
+		if (bc.error || bc.respill) {
+			bc_proc_delete(bc.bc);
+			bc.bc = NULL;
+		}
+	} while (bc.respill && !bc.error);
+
+	bc_intmap_clear(&bc.spill, b_false);
+	intmap_fini(&bc.spill);
+
+	if (bc.error)
+		return ENOTSUP;
+
+	*rbc = bc.bc;
+	return EOK;
+}
+
+/** Run one compilation pass over the procedure.
+ *
+ * @param bc		Bytecode compiler
+ */
+static void bc_pass(bc_t *bc)
+{
+	bc->bc = calloc(1, sizeof(bc_proc_t));
+	if (bc->bc == NULL) {
+		printf("Memory allocation failed.\n");
+		exit(1);
+	}
+
+	bc->alloc = 0;
+	list_init(&bc->scopes);
+	bc->rnext = 0;
+	bc->nblocks = 0;
+	bc->nitems = 0;
+	bc->loop = NULL;
+	bc->respill = b_false;
+	bc->error = b_false;
+
+	/* Arguments live in a scope of their own. */
+	bc_scope_push(bc);
+	bc_args(bc);
+	bc_block(bc, bc->proc->body);
+	(void) bc_emit(bc, bi_ret);
+	bc_scope_pop(bc);
+
+	assert(bc->nblocks == 0);
+	assert(bc->nitems == 0);
+	list_fini(&bc->scopes);
+}
+
+/** Declare formal arguments of the procedure.
+ *
+ * Arguments of primitive type are loaded into registers upon entry.
+ * Others stay in the block AR filled by run_proc_ar_set_args().
+ *
+ * @param bc		Bytecode compiler
+ */
+static void bc_args(bc_t *bc)
+{
+	stree_symbol_t *outer_symbol;
+	stree_ctor_t *ctor;
+	stree_fun_t *fun;
+	stree_prop_t *prop;
+	list_t *args;
+	stree_proc_arg_t *varg;
+	stree_proc_arg_t *setter_arg;
+	list_node_t *node;
+
+	outer_symbol = bc->proc->outer_symbol;
+
+	/* Make compiler happy. */
+	args = NULL;
+	varg = NULL;
+	setter_arg = NULL;
+
+	switch (outer_symbol->sc) {
+	case sc_ctor:
+		ctor = symbol_to_ctor(outer_symbol);
+		args = &ctor->sig->args;
+		varg = ctor->sig->varg;
+		break;
+	case sc_fun:
+		fun = symbol_to_fun(outer_symbol);
+		args = &fun->sig->args;
+		varg = fun->sig->varg;
+		break;
+	case sc_prop:
+		prop = symbol_to_prop(outer_symbol);
+		args = &prop->args;
+		varg = prop->varg;
+		if (bc->proc == prop->setter)
+			setter_arg = prop->setter_arg;
+		break;
+	case sc_csi:
+	case sc_deleg:
+	case sc_enum:
+	case sc_var:
+		assert(b_false);
+	}
+
+	node = list_first(args);
+	while (node != NULL) {
+		bc_arg(bc, list_node_data(node, stree_proc_arg_t *), b_true);
+		node = list_next(args, node);
+	}
+
+	/* Packed variadic argument is an array reference. */
+	if (varg != NULL)
+		bc_arg(bc, varg, b_false);
+
+	if (setter_arg != NULL)
+		bc_arg(bc, setter_arg, b_false);
+}
+
+/** Declare formal argument.
+ *
+ * @param bc		Bytecode compiler
+ * @param arg		Formal argument
+ * @param reg_ok	@c b_true if the argument may be held in a register
+ */
+static void bc_arg(bc_t *bc, stree_proc_arg_t *arg, bool_t reg_ok)
+{
+	bc_instr_t *instr;
+	var_class_t vc;
+	int reg;
+
+	if (!reg_ok || intmap_get(&bc->spill, arg->name->sid) != NULL ||
+	    !bc_texpr_vc(arg->type, &vc)) {
+		bc_local_declare(bc, arg->name->sid, -1, vc_int);
+		return;
+	}
+
+	reg = bc_reg_alloc(bc);
+	instr = bc_emit(bc, bi_ldvar);
+	instr->a = reg;
+	instr->u.sid = arg->name->sid;
+
+	bc_local_declare(bc, arg->name->sid, reg, vc);
+}
+
+/** Compile code block.
+ *
+ * @param bc		Bytecode compiler
+ * @param block		Block
+ */
+static void bc_block(bc_t *bc, stree_block_t *block)
+{
+	list_node_t *node;
+	stree_stat_t *stat;
+	bool_t enter;
+	int rnext;
+
+	/* Variables kept in memory need a block AR. */
+	enter = b_false;
+	node = list_first(&block->stats);
+	while (node != NULL) {
+		stat = list_node_data(node, stree_stat_t *);
+		if (stat->sc == st_vdecl && bc_vdecl_in_ar(bc, stat->u.vdecl_s))
+			enter = b_true;
+		node = list_next(&block->stats, node);
+	}
+
+	rnext = bc->rnext;
+	bc_scope_push(bc);
+
+	if (enter) {
+		(void) bc_emit(bc, bi_enter);
+		++bc->nblocks;
+	}
+
+	node = list_first(&block->stats);
+	while (node != NULL) {
+		stat = list_node_data(node, stree_stat_t *);
+		bc_stat(bc, stat);
+		node = list_next(&block->stats, node);
+	}
+
+	if (enter) {
+		(void) bc_emit(bc, bi_leave);
+		--bc->nblocks;
+	}
+
+	bc_scope_pop(bc);
+	bc->rnext = rnext;
+}
+
+/** Compile statement.
+ *
+ * @param bc		Bytecode compiler
+ * @param stat		Statement
+ */
+static void bc_stat(bc_t *bc, stree_stat_t *stat)
+{
+	int rnext;
+
+	rnext = bc->rnext;
+
+	switch (stat->sc) {
+	case st_vdecl:
+		/* The variable stays allocated until the end of block. */
+		bc_vdecl(bc, stat);
+		return;
+	case st_if:
+		bc_if(bc, stat->u.if_s);
+		break;
+	case st_while:
+		bc_while(bc, stat->u.while_s);
+		break;
+	case st_break:
+		bc_break(bc);
+		break;
+	case st_return:
+		bc_return(bc, stat->u.return_s);
+		break;
+	case st_exps:
+		bc_exps(bc, stat);
+		break;
+	case st_switch:
+	case st_for:
+	case st_raise:
+	case st_wef:
+		bc_fallback_stat(bc, stat);
+		break;
+	}
+
+	/* Free temporaries. */
+	bc->rnext = rnext;
+}
+
+/** Compile variable declaration statement.
+ *
+ * @param bc		Bytecode compiler
+ * @param stat		Variable declaration statement
+ */
+static void bc_vdecl(bc_t *bc, stree_stat_t *stat)
+{
+	stree_vdecl_t *vdecl;
+	bc_instr_t *instr;
+	var_class_t vc;
+	int reg;
+
+	vdecl = stat->u.vdecl_s;
+
+	if (bc_vdecl_in_ar(bc, vdecl)) {
+		bc_fallback_stat(bc, stat);
+		bc_local_declare(bc, vdecl->name->sid, -1, vc_int);
+		return;
+	}
+
+	(void) bc_titem_vc(vdecl->titem, &vc);
+	reg = bc_reg_alloc(bc);
+
+	/* Initialize with default value. */
+	instr = bc_emit(bc, bi_ldi);
+	instr->a = reg;
+	instr->u.imm = 0;
+
+	bc_local_declare(bc, vdecl->name->sid, reg, vc);
+}
+
+/** Compile @c if statement.
+ *
+ * @param bc		Bytecode compiler
+ * @param if_s		If statement
+ */
+static void bc_if(bc_t *bc, stree_if_t *if_s)
+{
+	list_node_t *ifc_node;
+	stree_if_clause_t *ifc;
+	bc_instr_t *instr;
+	int rnext;
+	int creg;
+	int jz;
+	int end;
+
+	rnext = bc->rnext;
+	end = -1;
+
+	ifc_node = list_first(&if_s->if_clauses);
+	while (ifc_node != NULL) {
+		ifc = list_node_data(ifc_node, stree_if_clause_t *);
+
+		creg = bc_expr(bc, ifc->cond, -1);
+		instr = bc_emit(bc, bi_jz);
+		instr->a = creg;
+		jz = bc_last(bc);
+		bc->rnext = rnext;
+
+		bc_block(bc, ifc->block);
+
+		/* Jump to the end of the statement. */
+		instr = bc_emit(bc, bi_jmp);
+		instr->b = 0;
+		instr->c = end;
+		end = bc_last(bc);
+
+		bc->bc->code[jz].c = bc->bc->ninstr;
+		ifc_node = list_next(&if_s->if_clauses, ifc_node);
+	}
+
+	if (if_s->else_block != NULL)
+		bc_block(bc, if_s->else_block);
+
+	bc_patch(bc, end, bc->bc->ninstr);
+}
+
+/** Compile @c while statement.
+ *
+ * @param bc		Bytecode compiler
+ * @param while_s	While statement
+ */
+static void bc_while(bc_t *bc, stree_while_t *while_s)
+{
+	bc_loop_t loop;
+	bc_loop_t *outer;
+	bc_instr_t *instr;
+	int rnext;
+	int top;
+	int creg;
+	int jz;
+
+	rnext = bc->rnext;
+	top = bc->bc->ninstr;
+
+	creg = bc_expr(bc, while_s->cond, -1);
+	instr = bc_emit(bc, bi_jz);
+	instr->a = creg;
+	jz = bc_last(bc);
+	bc->rnext = rnext;
+
+	loop.nblocks = bc->nblocks;
+	loop.brk = -1;
+
+	outer = bc->loop;
+	bc->loop = &loop;
+	bc_block(bc, while_s->body);
+	bc->loop = outer;
+
+	instr = bc_emit(bc, bi_jmp);
+	instr->b = 0;
+	instr->c = top;
+
+	bc->bc->code[jz].c = bc->bc->ninstr;
+	bc_patch(bc, loop.brk, bc->bc->ninstr);
+}
+
+/** Compile @c break statement.
+ *
+ * @param bc		Bytecode compiler
+ */
+static void bc_break(bc_t *bc)
+{
+	bc_instr_t *instr;
+
+	if (bc->loop == NULL) {
+		/* Leave it to the runner to complain. */
+		bc->error = b_true;
+		return;
+	}
+
+	instr = bc_emit(bc, bi_jmp);
+	instr->b = bc->nblocks - bc->loop->nblocks;
+	instr->c = bc->loop->brk;
+	bc->loop->brk = bc_last(bc);
+}
+
+/** Compile @c return statement.
+ *
+ * @param bc		Bytecode compiler
+ * @param return_s	Return statement
+ */
+static void bc_return(bc_t *bc, stree_return_t *return_s)
+{
+	bc_instr_t *instr;
+	var_class_t vc;
+	int reg;
+
+	if (return_s->expr == NULL) {
+		(void) bc_emit(bc, bi_ret);
+		return;
+	}
+
+	if (bc_expr_vc(return_s->expr, &vc)) {
+		reg = bc_expr(bc, return_s->expr, -1);
+		instr = bc_emit(bc, bi_retr);
+		instr->a = reg;
+		instr->vc = vc;
+		return;
+	}
+
+	bc_spill_expr(bc, return_s->expr);
+	instr = bc_emit(bc, bi_rete);
+	instr->u.expr = return_s->expr;
+}
+
+/** Compile expression statement.
+ *
+ * Calls and assignments to local variables are compiled, anything else
+ * is executed by the runner.
+ *
+ * @param bc		Bytecode compiler
+ * @param stat		Expression statement
+ */
+static void bc_exps(bc_t *bc, stree_stat_t *stat)
+{
+	stree_expr_t *expr;
+	stree_assign_t *assign;
+	bc_local_t *local;
+	bc_instr_t *instr;
+	var_class_t vc;
+	int reg;
+
+	expr = stat->u.exp_s->expr;
+
+	switch (expr->ec) {
+	case ec_call:
+		bc_call(bc, expr->u.call, -1);
+		return;
+	case ec_assign:
+		assign = expr->u.assign;
+		if (assign->ac != ac_set || assign->dest->ec != ec_nameref)
+			break;
+
+		local = bc_local_lookup(bc, assign->dest->u.nameref->name->sid);
+		if (local == NULL || !bc_expr_vc(assign->src, &vc))
+			break;
+
+		if (local->reg >= 0) {
+			if (local->vc != vc)
+				break;
+
+			(void) bc_expr(bc, assign->src, local->reg);
+			return;
+		}
+
+		reg = bc_expr(bc, assign->src, -1);
+		instr = bc_emit(bc, bi_stvar);
+		instr->a = reg;
+		instr->vc = vc;
+		instr->u.sid = assign->dest->u.nameref->name->sid;
+		return;
+	default:
+		break;
+	}
+
+	bc_fallback_stat(bc, stat);
+}
+
+/** Leave statement to the runner.
+ *
+ * If the statement breaks out of an enclosing loop, the VM continues
+ * at the loop exit.
+ *
+ * @param bc		Bytecode compiler
+ * @param stat		Statement
+ */
+static void bc_fallback_stat(bc_t *bc, stree_stat_t *stat)
+{
+	bc_instr_t *instr;
+
+	bc_spill_stat(bc, stat);
+
+	instr = bc_emit(bc, bi_stat);
+	instr->u.stat = stat;
+
+	if (bc->loop != NULL) {
+		instr->b = bc->nblocks - bc->loop->nblocks;
+		instr->c = bc->loop->brk;
+		bc->loop->brk = bc_last(bc);
+	} else {
+		instr->b = 0;
+		instr->c = -1;
+	}
+}
+
+/** Compile expression of primitive type.
+ *
+ * @param bc		Bytecode compiler
+ * @param expr		Expression
+ * @param dreg		Destination register or -1 to choose any
+ * @return		Register holding the result
+ */
+static int bc_expr(bc_t *bc, stree_expr_t *expr, int dreg)
+{
+	var_class_t vc;
+	int reg;
+
+	if (!bc_expr_vc(expr, &vc)) {
+		bc->error = b_true;
+		return bc_dreg(bc, dreg);
+	}
+
+	switch (expr->ec) {
+	case ec_nameref:
+		return bc_nameref(bc, expr, dreg);
+	case ec_literal:
+		return bc_literal(bc, expr->u.literal, dreg);
+	case ec_binop:
+		return bc_binop(bc, expr, dreg);
+	case ec_unop:
+		return bc_unop(bc, expr, dreg);
+	case ec_call:
+		reg = bc_dreg(bc, dreg);
+		bc_call(bc, expr->u.call, reg);
+		return reg;
+	default:
+		return bc_eval(bc, expr, dreg);
+	}
+}
+
+/** Compile name reference.
+ *
+ * @param bc		Bytecode compiler
+ * @param expr		Name reference expression
+ * @param dreg		Destination register or -1 to choose any
+ * @return		Register holding the result
+ */
+static int bc_nameref(bc_t *bc, stree_expr_t *expr, int dreg)
+{
+	stree_nameref_t *nameref;
+	bc_local_t *local;
+	bc_instr_t *instr;
+	int reg;
+
+	nameref = expr->u.nameref;
+	local = bc_local_lookup(bc, nameref->name->sid);
+
+	/* Member or global symbol */
+	if (local == NULL)
+		return bc_eval(bc, expr, dreg);
+
+	if (local->reg < 0) {
+		reg = bc_dreg(bc, dreg);
+		instr = bc_emit(bc, bi_ldvar);
+		instr->a = reg;
+		instr->u.sid = nameref->name->sid;
+		return reg;
+	}
+
+	if (dreg < 0 || dreg == local->reg)
+		return local->reg;
+
+	instr = bc_emit(bc, bi_mov);
+	instr->a = dreg;
+	instr->b = local->reg;
+	return dreg;
+}
+
+/** Compile literal.
+ *
+ * @param bc		Bytecode compiler
+ * @param literal	Literal
+ * @param dreg		Destination register or -1 to choose any
+ * @return		Register holding the result
+ */
+static int bc_literal(bc_t *bc, stree_literal_t *literal, int dreg)
+{
+	bc_instr_t *instr;
+	int reg;
+
+	reg = bc_dreg(bc, dreg);
+
+	switch (literal->ltc) {
+	case ltc_bool:
+		instr = bc_emit(bc, bi_ldi);
+		instr->a = reg;
+		instr->u.imm = literal->u.lit_bool.value ? 1 : 0;
+		break;
+	case ltc_char:
+		bc_ldint(bc, &literal->u.lit_char.value, reg);
+		break;
+	case ltc_int:
+		bc_ldint(bc, &literal->u.lit_int.value, reg);
+		break;
+	case ltc_ref:
+	case ltc_string:
+		assert(b_false);
+	}
+
+	return reg;
+}
+
+/** Load integer constant into a register.
+ *
+ * @param bc		Bytecode compiler
+ * @param value		Value
+ * @param reg		Destination register
+ */
+static void bc_ldint(bc_t *bc, bigint_t *value, int reg)
+{
+	bc_instr_t *instr;
+	int ival;
+
+	if (bigint_get_value_int(value, &ival) == EOK) {
+		instr = bc_emit(bc, bi_ldi);
+		instr->u.imm = ival;
+	} else {
+		instr = bc_emit(bc, bi_ldbig);
+		instr->u.big = value;
+	}
+
+	instr->a = reg;
+}
+
+/** Compile binary operation.
+ *
+ * @param bc		Bytecode compiler
+ * @param expr		Binary operation expression
+ * @param dreg		Destination register or -1 to choose any
+ * @return		Register holding the result
+ */
+static int bc_binop(bc_t *bc, stree_expr_t *expr, int dreg)
+{
+	stree_binop_t *binop;
+	bc_iclass_t ic;
+	bc_instr_t *instr;
+	var_class_t vc1, vc2;
+	int reg1, reg2;
+	int reg;
+
+	binop = expr->u.binop;
+
+	/* Make compiler happy. */
+	ic = bi_eq;
+
+	if (!bc_expr_vc(binop->arg1, &vc1) || !bc_expr_vc(binop->arg2, &vc2) ||
+	    vc1 != vc2)
+		return bc_eval(bc, expr, dreg);
+
+	switch (binop->bc) {
+	case bo_equal:
+		ic = bi_eq;
+		break;
+	case bo_notequal:
+		ic = bi_ne;
+		break;
+	case bo_lt:
+		ic = bi_lt;
+		break;
+	case bo_gt:
+		ic = bi_gt;
+		break;
+	case bo_lt_equal:
+		ic = bi_le;
+		break;
+	case bo_gt_equal:
+		ic = bi_ge;
+		break;
+	case bo_plus:
+		ic = bi_add;
+		break;
+	case bo_minus:
+		ic = bi_sub;
+		break;
+	case bo_mult:
+		ic = bi_mul;
+		break;
+	case bo_and:
+		ic = bi_and;
+		break;
+	case bo_or:
+		ic = bi_or;
+		break;
+	}
+
+	/* Arithmetic is only defined on int, logic on bool. */
+	if ((ic == bi_add || ic == bi_sub || ic == bi_mul) && vc1 != vc_int)
+		return bc_eval(bc, expr, dreg);
+	if ((ic == bi_and || ic == bi_or) && vc1 != vc_bool)
+		return bc_eval(bc, expr, dreg);
+
+	reg1 = bc_expr(bc, binop->arg1, -1);
+	reg2 = bc_expr(bc, binop->arg2, -1);
+	reg = bc_dreg(bc, dreg);
+
+	instr = bc_emit(bc, ic);
+	instr->a = reg;
+	instr->b = reg1;
+	instr->c = reg2;
+
+	return reg;
+}
+
+/** Compile unary operation.
+ *
+ * @param bc		Bytecode compiler
+ * @param expr		Unary operation expression
+ * @param dreg		Destination register or -1 to choose any
+ * @return		Register holding the result
+ */
+static int bc_unop(bc_t *bc, stree_expr_t *expr, int dreg)
+{
+	stree_unop_t *unop;
+	bc_iclass_t ic;
+	bc_instr_t *instr;
+	var_class_t vc;
+	int reg1;
+	int reg;
+
+	unop = expr->u.unop;
+
+	if (!bc_expr_vc(unop->arg, &vc))
+		return bc_eval(bc, expr, dreg);
+
+	/* Make compiler happy. */
+	ic = bi_neg;
+
+	switch (unop->uc) {
+	case uo_plus:
+		if (vc != vc_int)
+			return bc_eval(bc, expr, dreg);
+		return bc_expr(bc, unop->arg, dreg);
+	case uo_minus:
+		if (vc != vc_int)
+			return bc_eval(bc, expr, dreg);
+		ic = bi_neg;
+		break;
+	case uo_not:
+		if (vc != vc_bool)
+			return bc_eval(bc, expr, dreg);
+		ic = bi_not;
+		break;
+	}
+
+	reg1 = bc_expr(bc, unop->arg, -1);
+	reg = bc_dreg(bc, dreg);
+
+	instr = bc_emit(bc, ic);
+	instr->a = reg;
+	instr->b = reg1;
+	return reg;
+}
+
+/** Compile function call.
+ *
+ * The delegate and then the arguments are pushed on the item stack
+ * in the order in which the runner evaluates them.
+ *
+ * @param bc		Bytecode compiler
+ * @param call		Call operation
+ * @param dreg		Register for the return value or -1 to discard it
+ */
+static void bc_call(bc_t *bc, stree_call_t *call, int dreg)
+{
+	list_node_t *node;
+	stree_expr_t *arg;
+	bc_instr_t *instr;
+	var_class_t vc;
+	int nargs;
+	int rnext;
+	int reg;
+
+	bc_spill_expr(bc, call->fun);
+	instr = bc_emit(bc, bi_fun);
+	instr->u.expr = call->fun;
+	bc_item_push(bc);
+
+	nargs = 0;
+	node = list_first(&call->args);
+	while (node != NULL) {
+		arg = list_node_data(node, stree_expr_t *);
+
+		if (bc_expr_vc(arg, &vc)) {
+			rnext = bc->rnext;
+			reg = bc_expr(bc, arg, -1);
+			instr = bc_emit(bc, bi_push);
+			instr->a = reg;
+			instr->vc = vc;
+			bc->rnext = rnext;
+		} else {
+			bc_spill_expr(bc, arg);
+			instr = bc_emit(bc, bi_pushe);
+			instr->u.expr = arg;
+		}
+
+		bc_item_push(bc);
+		++nargs;
+		node = list_next(&call->args, node);
+	}
+
+	instr = bc_emit(bc, bi_call);
+	instr->a = dreg;
+	instr->b = nargs;
+
+	bc->nitems -= nargs + 1;
+}
+
+/** Leave expression of primitive type to the runner.
+ *
+ * @param bc		Bytecode compiler
+ * @param expr		Expression
+ * @param dreg		Destination register or -1 to choose any
+ * @return		Register holding the result
+ */
+static int bc_eval(bc_t *bc, stree_expr_t *expr, int dreg)
+{
+	bc_instr_t *instr;
+	int reg;
+
+	bc_spill_expr(bc, expr);
+
+	reg = bc_dreg(bc, dreg);
+	instr = bc_emit(bc, bi_eval);
+	instr->a = reg;
+	instr->u.expr = expr;
+
+	return reg;
+}
+
+/** Determine var class for values of a type, if it fits in a register.
+ *
+ * @param titem		Type item or @c NULL
+ * @param vc		Place to store var class
+ * @return		@c b_true if values of the type fit in a register
+ */
+static bool_t bc_titem_vc(tdata_item_t *titem, var_class_t *vc)
+{
+	if (titem == NULL || titem->tic != tic_tprimitive)
+		return b_false;
+
+	switch (titem->u.tprimitive->tpc) {
+	case tpc_bool:
+		*vc = vc_bool;
+		return b_true;
+	case tpc_char:
+		*vc = vc_char;
+		return b_true;
+	case tpc_int:
+		*vc = vc_int;
+		return b_true;
+	default:
+		return b_false;
+	}
+}
+
+/** Determine var class for value of an expression, if it fits in a register.
+ *
+ * @param expr		Expression
+ * @param vc		Place to store var class
+ * @return		@c b_true if value of @a expr fits in a register
+ */
+static bool_t bc_expr_vc(stree_expr_t *expr, var_class_t *vc)
+{
+	return bc_titem_vc(expr->titem, vc);
+}
+
+/** Determine var class for a type expression, if it fits in a register.
+ *
+ * Formal arguments are not annotated with type items, we only recognize
+ * type literals.
+ *
+ * @param texpr		Type expression
+ * @param vc		Place to store var class
+ * @return		@c b_true if values of the type fit in a register
+ */
+static bool_t bc_texpr_vc(stree_texpr_t *texpr, var_class_t *vc)
+{
+	if (texpr == NULL || texpr->tc != tc_tliteral)
+		return b_false;
+
+	switch (texpr->u.tliteral->tlc) {
+	case tlc_bool:
+		*vc = vc_bool;
+		return b_true;
+	case tlc_char:
+		*vc = vc_char;
+		return b_true;
+	case tlc_int:
+		*vc = vc_int;
+		return b_true;
+	default:
+		return b_false;
+	}
+}
+
+/** Determine whether declared variable needs to be kept in a block AR.
+ *
+ * @param bc		Bytecode compiler
+ * @param vdecl		Variable declaration
+ * @return		@c b_true if the variable cannot be held in a register
+ */
+static bool_t bc_vdecl_in_ar(bc_t *bc, stree_vdecl_t *vdecl)
+{
+	var_class_t vc;
+
+	return intmap_get(&bc->spill, vdecl->name->sid) != NULL ||
+	    !bc_titem_vc(vdecl->titem, &vc);
+}
+
+/** Note that variables with this name must be kept in block ARs.
+ *
+ * @param bc		Bytecode compiler
+ * @param name		Name referenced from code left to the runner
+ */
+static void bc_spill_name(bc_t *bc, stree_ident_t *name)
+{
+	if (intmap_get(&bc->spill, name->sid) != NULL)
+		return;
+
+	intmap_set(&bc->spill, name->sid, name);
+	bc->respill = b_true;
+}
+
+/** Note names referenced from a block.
+ *
+ * @param bc		Bytecode compiler
+ * @param block		Block
+ */
+static void bc_spill_block(bc_t *bc, stree_block_t *block)
+{
+	list_node_t *node;
+
+	node = list_first(&block->stats);
+	while (node != NULL) {
+		bc_spill_stat(bc, list_node_data(node, stree_stat_t *));
+		node = list_next(&block->stats, node);
+	}
+}
+
+/** Note names referenced from a statement.
+ *
+ * @param bc		Bytecode compiler
+ * @param stat		Statement
+ */
+static void bc_spill_stat(bc_t *bc, stree_stat_t *stat)
+{
+	list_node_t *node;
+	stree_if_clause_t *ifc;
+	stree_when_t *whenc;
+	stree_except_t *except_c;
+
+	switch (stat->sc) {
+	case st_vdecl:
+		bc_spill_texpr(bc, stat->u.vdecl_s->type);
+		break;
+	case st_if:
+		node = list_first(&stat->u.if_s->if_clauses);
+		while (node != NULL) {
+			ifc = list_node_data(node, stree_if_clause_t *);
+			bc_spill_expr(bc, ifc->cond);
+			bc_spill_block(bc, ifc->block);
+			node = list_next(&stat->u.if_s->if_clauses, node);
+		}
+
+		if (stat->u.if_s->else_block != NULL)
+			bc_spill_block(bc, stat->u.if_s->else_block);
+		break;
+	case st_switch:
+		bc_spill_expr(bc, stat->u.switch_s->expr);
+		node = list_first(&stat->u.switch_s->when_clauses);
+		while (node != NULL) {
+			whenc = list_node_data(node, stree_when_t *);
+			bc_spill_exprs(bc, &whenc->exprs);
+			bc_spill_block(bc, whenc->block);
+			node = list_next(&stat->u.switch_s->when_clauses, node);
+		}
+
+		if (stat->u.switch_s->else_block != NULL)
+			bc_spill_block(bc, stat->u.switch_s->else_block);
+		break;
+	case st_while:
+		bc_spill_expr(bc, stat->u.while_s->cond);
+		bc_spill_block(bc, stat->u.while_s->body);
+		break;
+	case st_for:
+		bc_spill_block(bc, stat->u.for_s->body);
+		break;
+	case st_raise:
+		bc_spill_expr(bc, stat->u.raise_s->expr);
+		break;
+	case st_break:
+		break;
+	case st_return:
+		if (stat->u.return_s->expr != NULL)
+			bc_spill_expr(bc, stat->u.return_s->expr);
+		break;
+	case st_exps:
+		bc_spill_expr(bc, stat->u.exp_s->expr);
+		break;
+	case st_wef:
+		bc_spill_block(bc, stat->u.wef_s->with_block);
+		node = list_first(&stat->u.wef_s->except_clauses);
+		while (node != NULL) {
+			except_c = list_node_data(node, stree_except_t *);
+			bc_spill_block(bc, except_c->block);
+			node = list_next(&stat->u.wef_s->except_clauses, node);
+		}
+
+		if (stat->u.wef_s->finally_block != NULL)
+			bc_spill_block(bc, stat->u.wef_s->finally_block);
+		break;
+	}
+}
+
+/** Note names referenced from an expression.
+ *
+ * @param bc		Bytecode compiler
+ * @param expr		Expression
+ */
+static void bc_spill_expr(bc_t *bc, stree_expr_t *expr)
+{
+	switch (expr->ec) {
+	case ec_nameref:
+		bc_spill_name(bc, expr->u.nameref->name);
+		break;
+	case ec_literal:
+	case ec_self_ref:
+		break;
+	case ec_binop:
+		bc_spill_expr(bc, expr->u.binop->arg1);
+		bc_spill_expr(bc, expr->u.binop->arg2);
+		break;
+	case ec_unop:
+		bc_spill_expr(bc, expr->u.unop->arg);
+		break;
+	case ec_new:
+		bc_spill_texpr(bc, expr->u.new_op->texpr);
+		bc_spill_exprs(bc, &expr->u.new_op->ctor_args);
+		break;
+	case ec_access:
+		bc_spill_expr(bc, expr->u.access->arg);
+		break;
+	case ec_call:
+		bc_spill_expr(bc, expr->u.call->fun);
+		bc_spill_exprs(bc, &expr->u.call->args);
+		break;
+	case ec_index:
+		bc_spill_expr(bc, expr->u.index->base);
+		bc_spill_exprs(bc, &expr->u.index->args);
+		break;
+	case ec_assign:
+		bc_spill_expr(bc, expr->u.assign->dest);
+		bc_spill_expr(bc, expr->u.assign->src);
+		break;
+	case ec_as:
+		bc_spill_expr(bc, expr->u.as_op->arg);
+		bc_spill_texpr(bc, expr->u.as_op->dtype);
+		break;
+	case ec_box:
+		bc_spill_expr(bc, expr->u.box->arg);
+		break;
+	}
+}
+
+/** Note names referenced from a list of expressions.
+ *
+ * @param bc		Bytecode compiler
+ * @param exprs		List of expressions (stree_expr_t)
+ */
+static void bc_spill_exprs(bc_t *bc, list_t *exprs)
+{
+	list_node_t *node;
+
+	node = list_first(exprs);
+	while (node != NULL) {
+		bc_spill_expr(bc, list_node_data(node, stree_expr_t *));
+		node = list_next(exprs, node);
+	}
+}
+
+/** Note names referenced from a type expression.
+ *
+ * Type expressions can contain array extents.
+ *
+ * @param bc		Bytecode compiler
+ * @param texpr		Type expression or @c NULL
+ */
+static void bc_spill_texpr(bc_t *bc, stree_texpr_t *texpr)
+{
+	list_node_t *node;
+
+	if (texpr == NULL)
+		return;
+
+	switch (texpr->tc) {
+	case tc_tliteral:
+	case tc_tnameref:
+		break;
+	case tc_taccess:
+		bc_spill_texpr(bc, texpr->u.taccess->arg);
+		break;
+	case tc_tapply:
+		bc_spill_texpr(bc, texpr->u.tapply->gtype);
+		node = list_first(&texpr->u.tapply->targs);
+		while (node != NULL) {
+			bc_spill_texpr(bc, list_node_data(node, stree_texpr_t *));
+			node = list_next(&texpr->u.tapply->targs, node);
+		}
+		break;
+	case tc_tindex:
+		bc_spill_texpr(bc, texpr->u.tindex->base_type);
+		bc_spill_exprs(bc, &texpr->u.tindex->args);
+		break;
+	}
+}
+
+/** Enter new scope.
+ *
+ * @param bc		Bytecode compiler
+ */
+static void bc_scope_push(bc_t *bc)
+{
+	bc_scope_t *scope;
+
+	scope = calloc(1, sizeof(bc_scope_t));
+	if (scope == NULL) {
+		printf("Memory allocation failed.\n");
+		exit(1);
+	}
+
+	intmap_init(&scope->locals);
+	list_append(&bc->scopes, scope);
+}
+
+/** Leave innermost scope.
+ *
+ * @param bc		Bytecode compiler
+ */
+static void bc_scope_pop(bc_t *bc)
+{
+	list_node_t *node;
+	bc_scope_t *scope;
+
+	node = list_last(&bc->scopes);
+	scope = list_node_data(node, bc_scope_t *);
+	list_remove(&bc->scopes, node);
+
+	bc_intmap_clear(&scope->locals, b_true);
+	intmap_fini(&scope->locals);
+	free(scope);
+}
+
+/** Declare local variable in the innermost scope.
+ *
+ * @param bc		Bytecode compiler
+ * @param name		Variable name
+ * @param reg		Register holding the variable or -1 if kept in AR
+ * @param vc		Var class of the variable
+ */
+static void bc_local_declare(bc_t *bc, sid_t name, int reg, var_class_t vc)
+{
+	bc_scope_t *scope;
+	bc_local_t *local;
+
+	scope = list_node_data(list_last(&bc->scopes), bc_scope_t *);
+
+	if (intmap_get(&scope->locals, name) != NULL) {
+		/* Duplicate variable, leave it to the runner to complain. */
+		bc->error = b_true;
+		return;
+	}
+
+	local = calloc(1, sizeof(bc_local_t));
+	if (local == NULL) {
+		printf("Memory allocation failed.\n");
+		exit(1);
+	}
+
+	local->reg = reg;
+	local->vc = vc;
+	intmap_set(&scope->locals, name, local);
+}
+
+/** Find local variable visible at this point.
+ *
+ * @param bc		Bytecode compiler
+ * @param name		Variable name
+ * @return		Local variable or @c NULL if not found
+ */
+static bc_local_t *bc_local_lookup(bc_t *bc, sid_t name)
+{
+	list_node_t *node;
+	bc_scope_t *scope;
+	bc_local_t *local;
+
+	node = list_last(&bc->scopes);
+	while (node != NULL) {
+		scope = list_node_data(node, bc_scope_t *);
+		local = intmap_get(&scope->locals, name);
+		if (local != NULL)
+			return local;
+
+		node = list_prev(&bc->scopes, node);
+	}
+
+	return NULL;
+}
+
+/** Allocate register.
+ *
+ * @param bc		Bytecode compiler
+ * @return		Register number
+ */
+static int bc_reg_alloc(bc_t *bc)
+{
+	int reg;
+
+	reg = bc->rnext++;
+	if (bc->rnext > bc->bc->nregs)
+		bc->bc->nregs = bc->rnext;
+
+	return reg;
+}
+
+/** Get destination register.
+ *
+ * @param bc		Bytecode compiler
+ * @param dreg		Requested register or -1 to allocate a new one
+ * @return		Register number
+ */
+static int bc_dreg(bc_t *bc, int dreg)
+{
+	return dreg >= 0 ? dreg : bc_reg_alloc(bc);
+}
+
+/** Account for one more item on the item stack.
+ *
+ * @param bc		Bytecode compiler
+ */
+static void bc_item_push(bc_t *bc)
+{
+	++bc->nitems;
+	if (bc->nitems > bc->bc->nitems)
+		bc->bc->nitems = bc->nitems;
+}
+
+/** Append new instruction.
+ *
+ * The returned pointer is only valid until the next instruction
+ * is emitted.
+ *
+ * @param bc		Bytecode compiler
+ * @param ic		Instruction class
+ * @return		New instruction
+ */
+static bc_instr_t *bc_emit(bc_t *bc, bc_iclass_t ic)
+{
+	bc_instr_t *code;
+	bc_instr_t *instr;
+	size_t nalloc;
+
+	if (bc->bc->ninstr >= bc->alloc) {
+		nalloc = bc->alloc > 0 ? 2 * bc->alloc : 32;
+		code = realloc(bc->bc->code, nalloc * sizeof(bc_instr_t));
+		if (code == NULL) {
+			printf("Memory allocation failed.\n");
+			exit(1);
+		}
+
+		bc->bc->code = code;
+		bc->alloc = nalloc;
+	}
+
+	instr = &bc->bc->code[bc->bc->ninstr++];
+	instr->ic = ic;
+	instr->a = 0;
+	instr->b = 0;
+	instr->c = 0;
+	instr->vc = vc_int;
+	instr->u.expr = NULL;
+
+	return instr;
+}
+
+/** Get index of the last emitted instruction.
+ *
+ * @param bc		Bytecode compiler
+ * @return		Instruction index
+ */
+static int bc_last(bc_t *bc)
+{
+	return (int) bc->bc->ninstr - 1;
+}
+
+/** Resolve chain of forward jumps.
+ *
+ * @param bc		Bytecode compiler
+ * @param chain		First jump in chain (linked through @c c) or -1
+ * @param target	Jump target
+ */
+static void bc_patch(bc_t *bc, int chain, int target)
+{
+	int next;
+
+	while (chain >= 0) {
+		next = bc->bc->code[chain].c;
+		bc->bc->code[chain].c = target;
+		chain = next;
+	}
+}
+
+/** Remove all elements from an integer map.
+ *
+ * @param intmap	Map
+ * @param free_data	@c b_true to free the values
+ */
+static void bc_intmap_clear(intmap_t *intmap, bool_t free_data)
+{
+	map_elem_t *elem;
+
+	elem = intmap_first(intmap);
+	while (elem != NULL) {
+		if (free_data)
+			free(intmap_elem_get_value(elem));
+
+		intmap_set(intmap, intmap_elem_get_key(elem), NULL);
+		elem = intmap_first(intmap);
+	}
+}
+
+/** Deallocate bytecode.
+ *
+ * @param proc		Bytecode
+ */
+static void bc_proc_delete(bc_proc_t *proc)
+{
+	free(proc->code);
+	free(proc);
+}
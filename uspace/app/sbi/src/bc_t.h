@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BC_T_H_
+#define BC_T_H_
+
+#include "bigint_t.h"
+#include "intmap_t.h"
+#include "list_t.h"
+#include "rdata_t.h"
+#include "stree_t.h"
+
+/** Bytecode instruction class.
+ *
+ * Instructions operate on registers of the procedure activation. A register
+ * holds a value of primitive type (@c int, @c char or @c bool). Values of
+ * other types never live in registers, they are passed around as data items
+ * on the item stack of the activation.
+ */
+typedef enum {
+	/** Load small integer or boolean constant @c imm into @c a */
+	bi_ldi,
+	/** Load big integer constant @c big into @c a */
+	bi_ldbig,
+	/** Copy register @c b to @c a */
+	bi_mov,
+
+	/** @c a = @c b + @c c */
+	bi_add,
+	/** @c a = @c b - @c c */
+	bi_sub,
+	/** @c a = @c b * @c c */
+	bi_mul,
+	/** @c a = -@c b */
+	bi_neg,
+
+	/** @c a = (@c b == @c c) */
+	bi_eq,
+	/** @c a = (@c b != @c c) */
+	bi_ne,
+	/** @c a = (@c b < @c c) */
+	bi_lt,
+	/** @c a = (@c b > @c c) */
+	bi_gt,
+	/** @c a = (@c b <= @c c) */
+	bi_le,
+	/** @c a = (@c b >= @c c) */
+	bi_ge,
+
+	/** Boolean @c a = @c b and @c c */
+	bi_and,
+	/** Boolean @c a = @c b or @c c */
+	bi_or,
+	/** Boolean @c a = not @c b */
+	bi_not,
+
+	/** Leave @c b block ARs and jump to @c c */
+	bi_jmp,
+	/** Jump to @c c if @c a is false */
+	bi_jz,
+
+	/** Enter block, i.e. create block AR for variables in memory */
+	bi_enter,
+	/** Leave block, i.e. destroy the innermost block AR */
+	bi_leave,
+
+	/** Load local variable @c sid (kept in a block AR) into @c a */
+	bi_ldvar,
+	/** Store @c a of class @c vc into local variable @c sid */
+	bi_stvar,
+
+	/** Evaluate expression @c expr of primitive type into @c a */
+	bi_eval,
+	/** Execute statement @c stat, on break leave @c b ARs, jump to @c c */
+	bi_stat,
+
+	/** Evaluate delegate expression @c expr and push it on the item stack */
+	bi_fun,
+	/** Push value of register @c a of class @c vc on the item stack */
+	bi_push,
+	/** Evaluate expression @c expr and push value on the item stack */
+	bi_pushe,
+	/** Call delegate with @c b arguments from item stack, result to @c a
+	 * (or discard it if @c a is -1)
+	 */
+	bi_call,
+
+	/** Return from procedure without a value */
+	bi_ret,
+	/** Return value of register @c a of class @c vc */
+	bi_retr,
+	/** Return value of expression @c expr */
+	bi_rete
+} bc_iclass_t;
+
+/** Bytecode instruction */
+typedef struct {
+	/** Instruction class */
+	bc_iclass_t ic;
+
+	/** Register or count operands */
+	int a, b, c;
+
+	/** Var class of register @c a (for instructions converting it) */
+	var_class_t vc;
+
+	union {
+		/** Small constant */
+		int imm;
+		/** Big constant (owned by the syntax tree) */
+		bigint_t *big;
+		/** Variable name */
+		int sid;
+		/** Expression to evaluate */
+		stree_expr_t *expr;
+		/** Statement to execute */
+		stree_stat_t *stat;
+	} u;
+} bc_instr_t;
+
+/** Procedure compiled to bytecode */
+typedef struct bc_proc {
+	/** Instructions */
+	bc_instr_t *code;
+
+	/** Number of instructions */
+	size_t ninstr;
+
+	/** Number of registers */
+	int nregs;
+
+	/** Maximum depth of the item stack */
+	int nitems;
+} bc_proc_t;
+
+/** Local variable known to the bytecode compiler */
+typedef struct {
+	/** Register holding the variable or -1 if it is kept in a block AR */
+	int reg;
+
+	/** Var class of the variable (if it is held in a register) */
+	var_class_t vc;
+} bc_local_t;
+
+/** Compiler scope (corresponds to a block) */
+typedef struct {
+	/** Local variables declared in this scope */
+	intmap_t locals; /* of bc_local_t */
+} bc_scope_t;
+
+/** Loop being compiled */
+typedef struct bc_loop {
+	/** Number of block ARs entered outside of the loop */
+	int nblocks;
+
+	/** Chain of jumps to the loop exit (linked through @c c) or -1 */
+	int brk;
+} bc_loop_t;
+
+/** Bytecode compiler */
+typedef struct {
+	/** Procedure being compiled */
+	stree_proc_t *proc;
+
+	/** Bytecode being produced */
+	bc_proc_t *bc;
+
+	/** Number of allocated instruction slots */
+	size_t alloc;
+
+	/** Scopes, innermost last */
+	list_t scopes; /* of bc_scope_t */
+
+	/** First free register */
+	int rnext;
+
+	/** Number of block ARs entered at this point */
+	int nblocks;
+
+	/** Depth of the item stack at this point */
+	int nitems;
+
+	/** Innermost loop or @c NULL */
+	bc_loop_t *loop;
+
+	/** Names of variables which must be kept in block ARs */
+	intmap_t spill; /* of stree_ident_t */
+
+	/** @c b_true if @c spill has grown and we need to compile again */
+	bool_t respill;
+
+	/** @c b_true if the body cannot be compiled */
+	bool_t error;
+} bc_t;
+
+#endif
@@ -383,7 +383,7 @@ stree_symbol_t *builtin_declare_fun(stree_csi_t *csi, const char *name)
 	fun->symbol = fun_sym;
 	fun->proc->outer_symbol = fun_sym;
 
-	list_append(&csi->members, csimbr);
+	stree_csi_add_mbr(csi, csimbr);
 
 	return fun_sym;
 }
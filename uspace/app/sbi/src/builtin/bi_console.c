@@ -75,7 +75,7 @@ void bi_console_declare(builtin_t *bi)
 	symbol->outer_csi = NULL;
 	csi->symbol = symbol;
 
-	list_append(&bi->program->module->members, modm);
+	stree_module_add_mbr(bi->program->module, modm);
 
 	/* Declare Builtin.Write(). */
 
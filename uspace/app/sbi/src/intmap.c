@@ -28,25 +28,122 @@
 
 /** @file Integer map.
  *
- * Maps integers to pointers (void *). Current implementation is trivial
- * (linked list of key-value pairs).
+ * Maps integers to pointers (void *). Implemented as an open-addressed
+ * hash table with linear probing. The table grows as needed so that it is
+ * at most half full. Maps are typically small (local variables of a block,
+ * fields of an object), so the table starts out small.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
-#include "list.h"
 #include "mytypes.h"
 
 #include "intmap.h"
 
+/** Initial number of slots (must be a power of two) */
+#define INTMAP_INIT_SIZE 4
+
+/** Compute home slot of @a key in table of @a size slots. */
+static size_t intmap_slot(int key, size_t size)
+{
+	/* Fibonacci hashing spreads consecutive keys (SIDs) */
+	return ((unsigned) key * 2654435769U) & (size - 1);
+}
+
+/** Find slot containing @a key or the empty slot where it belongs.
+ *
+ * @param intmap	Map with at least one slot
+ * @param key		Key
+ * @return		Slot index
+ */
+static size_t intmap_find(intmap_t *intmap, int key)
+{
+	size_t mask = intmap->size - 1;
+	size_t i;
+
+	i = intmap_slot(key, intmap->size);
+	while (intmap->elem[i].value != NULL) {
+		if (intmap->elem[i].key == key)
+			break;
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+/** Resize map table.
+ *
+ * @param intmap	Map
+ * @param size		New number of slots (power of two)
+ */
+static void intmap_resize(intmap_t *intmap, size_t size)
+{
+	map_elem_t *old_elem;
+	size_t old_size;
+	size_t i, j;
+
+	old_elem = intmap->elem;
+	old_size = intmap->size;
+
+	intmap->elem = calloc(size, sizeof(map_elem_t));
+	if (intmap->elem == NULL) {
+		printf("Memory allocation failed.\n");
+		exit(1);
+	}
+
+	intmap->size = size;
+
+	for (i = 0; i < old_size; i++) {
+		if (old_elem[i].value == NULL)
+			continue;
+
+		j = intmap_find(intmap, old_elem[i].key);
+		intmap->elem[j] = old_elem[i];
+	}
+
+	free(old_elem);
+}
+
+/** Remove element in slot @a i, closing the gap in its probe sequence.
+ *
+ * @param intmap	Map
+ * @param i		Index of used slot
+ */
+static void intmap_remove_slot(intmap_t *intmap, size_t i)
+{
+	size_t mask = intmap->size - 1;
+	size_t j, k;
+
+	intmap->elem[i].value = NULL;
+	--intmap->count;
+
+	j = i;
+	while (b_true) {
+		j = (j + 1) & mask;
+		if (intmap->elem[j].value == NULL)
+			break;
+
+		k = intmap_slot(intmap->elem[j].key, intmap->size);
+
+		/* Move element at j to i unless its home slot lies in (i, j]. */
+		if ((i < j) ? (k <= i || k > j) : (k <= i && k > j)) {
+			intmap->elem[i] = intmap->elem[j];
+			intmap->elem[j].value = NULL;
+			i = j;
+		}
+	}
+}
+
 /** Initialize map.
  *
  * @param intmap	Map to initialize.
  */
 void intmap_init(intmap_t *intmap)
 {
-	list_init(&intmap->elem);
+	intmap->elem = NULL;
+	intmap->size = 0;
+	intmap->count = 0;
 }
 
 /** Deinitialize map.
@@ -57,7 +154,10 @@ void intmap_init(intmap_t *intmap)
  */
 void intmap_fini(intmap_t *intmap)
 {
-	list_fini(&intmap->elem);
+	assert(intmap->count == 0);
+	free(intmap->elem);
+	intmap->elem = NULL;
+	intmap->size = 0;
 }
 
 /** Set value corresponding to a key.
@@ -72,37 +172,32 @@ void intmap_fini(intmap_t *intmap)
  */
 void intmap_set(intmap_t *intmap, int key, void *value)
 {
-	list_node_t *node;
-	map_elem_t *elem;
-
-	node = list_first(&intmap->elem);
-	while (node != NULL) {
-		elem = list_node_data(node, map_elem_t *);
-		if (elem->key == key) {
-			if (value != NULL) {
-				/* Replace existing value. */
-				elem->value = value;
-			} else {
-				/* Remove map element. */
-				list_remove(&intmap->elem, node);
-				free(elem);
-			}
+	size_t i;
+
+	if (value == NULL) {
+		/* Remove map element. */
+		if (intmap->size == 0)
 			return;
-		}
-		node = list_next(&intmap->elem, node);
+
+		i = intmap_find(intmap, key);
+		if (intmap->elem[i].value != NULL)
+			intmap_remove_slot(intmap, i);
+		return;
 	}
 
-	/* Allocate new map element and add it to the list. */
+	/* Keep the table at most half full. */
+	if (2 * (intmap->count + 1) > intmap->size) {
+		intmap_resize(intmap, intmap->size != 0 ?
+		    2 * intmap->size : INTMAP_INIT_SIZE);
+	}
 
-	elem = calloc(1, sizeof(map_elem_t));
-	if (elem == NULL) {
-		printf("Memory allocation failed.\n");
-		exit(1);
+	i = intmap_find(intmap, key);
+	if (intmap->elem[i].value == NULL) {
+		intmap->elem[i].key = key;
+		++intmap->count;
 	}
 
-	elem->key = key;
-	elem->value = value;
-	list_append(&intmap->elem, elem);
+	intmap->elem[i].value = value;
 }
 
 /** Get value corresponding to a key.
@@ -115,20 +210,10 @@ void intmap_set(intmap_t *intmap, int key, void *value)
  */
 void *intmap_get(intmap_t *intmap, int key)
 {
-	list_node_t *node;
-	map_elem_t *elem;
-
-	node = list_first(&intmap->elem);
-	while (node != NULL) {
-		elem = list_node_data(node, map_elem_t *);
-		if (elem->key == key) {
-			return elem->value;
-		}
-		node = list_next(&intmap->elem, node);
-	}
+	if (intmap->size == 0)
+		return NULL;
 
-	/* Not found */
-	return NULL;
+	return intmap->elem[intmap_find(intmap, key)].value;
 }
 
 /** Get first element in the map.
@@ -141,13 +226,14 @@ void *intmap_get(intmap_t *intmap, int key)
  */
 map_elem_t *intmap_first(intmap_t *intmap)
 {
-	list_node_t *node;
+	size_t i;
 
-	node = list_first(&intmap->elem);
-	if (node == NULL)
-		return NULL;
+	for (i = 0; i < intmap->size; i++) {
+		if (intmap->elem[i].value != NULL)
+			return &intmap->elem[i];
+	}
 
-	return list_node_data(node, map_elem_t *);
+	return NULL;
 }
 
 /** Get element key.
@@ -29,15 +29,21 @@
 #ifndef INTMAP_T_H_
 #define INTMAP_T_H_
 
-#include "list_t.h"
+#include <stddef.h>
 
+/** Map element. Slot is unused if @c value is @c NULL. */
 typedef struct {
 	int key;
 	void *value;
 } map_elem_t;
 
 typedef struct intmap {
-	list_t elem; /* of (map_elem_t *) */
+	/** Open-addressed hash table, @c size slots (power of two or zero) */
+	map_elem_t *elem;
+	/** Number of slots */
+	size_t size;
+	/** Number of used slots */
+	size_t count;
 } intmap_t;
 
 #endif
@@ -57,6 +57,7 @@ typedef enum {
 #define EOK 0
 #endif
 
+#include "bc_t.h"
 #include "bigint_t.h"
 #include "builtin_t.h"
 #include "cspan_t.h"
@@ -71,5 +72,6 @@ typedef enum {
 #include "strtab_t.h"
 #include "stype_t.h"
 #include "tdata_t.h"
+#include "vm_t.h"
 
 #endif
@@ -145,14 +145,14 @@ void parse_module(parse_t *parse)
 			modm = stree_modm_new(mc_csi);
 			modm->u.csi = csi;
 
-			list_append(&parse->cur_mod->members, modm);
+			stree_module_add_mbr(parse->cur_mod, modm);
 			break;
 		case lc_enum:
 			enum_d = parse_enum(parse, NULL);
 			modm = stree_modm_new(mc_enum);
 			modm->u.enum_d = enum_d;
 
-			list_append(&parse->cur_mod->members, modm);
+			stree_module_add_mbr(parse->cur_mod, modm);
 			break;
 		default:
 			lunexpected_error(parse);
@@ -247,7 +247,7 @@ static stree_csi_t *parse_csi(parse_t *parse, lclass_t dclass,
 		if (csimbr == NULL)
 			continue;
 
-		list_append(&csi->members, csimbr);
+		stree_csi_add_mbr(csi, csimbr);
 	}
 
 	lmatch(parse, lc_end);
@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include "bc.h"
 #include "bigint.h"
 #include "builtin.h"
 #include "cspan.h"
@@ -45,6 +46,7 @@
 #include "strtab.h"
 #include "symbol.h"
 #include "tdata.h"
+#include "vm.h"
 
 #include "run.h"
 
@@ -195,8 +197,17 @@ void run_proc(run_t *run, run_proc_ar_t *proc_ar, rdata_item_t **res)
 	/* Add procedure AR to the stack. */
 	list_append(&run->thread_ar->proc_ar, proc_ar);
 
+	/* Compile main procedure block on first use. */
+	if (proc->body != NULL && !proc->bc_tried) {
+		proc->bc_tried = b_true;
+		if (bc_proc_compile(proc, &proc->bc) != EOK)
+			proc->bc = NULL;
+	}
+
 	/* Run main procedure block. */
-	if (proc->body != NULL) {
+	if (proc->bc != NULL) {
+		vm_run(run, proc_ar, proc->bc);
+	} else if (proc->body != NULL) {
 		run_block(run, proc->body);
 	} else {
 		builtin_run_proc(run, proc);
@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include "intmap.h"
 #include "list.h"
 #include "mytypes.h"
 
@@ -51,6 +52,7 @@ stree_module_t *stree_module_new(void)
 	}
 
 	list_init(&module->members);
+	intmap_init(&module->mbr_map);
 	return module;
 }
 
@@ -95,6 +97,7 @@ stree_csi_t *stree_csi_new(csi_class_t cc)
 	list_init(&csi->inherit);
 	list_init(&csi->impl_if_ti);
 	list_init(&csi->members);
+	intmap_init(&csi->mbr_map);
 
 	return csi;
 }
@@ -1175,3 +1178,79 @@ stree_ident_t *stree_csimbr_get_name(stree_csimbr_t *csimbr)
 
 	return mbr_name;
 }
+
+/** Add member to module.
+ *
+ * Appends @a modm to the list of members of @a module and indexes it by name.
+ * If there are several members with the same name, lookup returns the first
+ * one.
+ *
+ * @param module	Module
+ * @param modm		Module member
+ */
+void stree_module_add_mbr(stree_module_t *module, stree_modm_t *modm)
+{
+	stree_ident_t *mbr_name;
+
+	list_append(&module->members, modm);
+
+	/* Make compiler happy. */
+	mbr_name = NULL;
+
+	switch (modm->mc) {
+	case mc_csi:
+		mbr_name = modm->u.csi->name;
+		break;
+	case mc_enum:
+		mbr_name = modm->u.enum_d->name;
+		break;
+	}
+
+	if (mbr_name != NULL && intmap_get(&module->mbr_map, mbr_name->sid) ==
+	    NULL)
+		intmap_set(&module->mbr_map, mbr_name->sid, modm);
+}
+
+/** Find module member by name.
+ *
+ * @param module	Module
+ * @param name_sid	SID of member name
+ * @return		Member or @c NULL if not found
+ */
+stree_modm_t *stree_module_find_mbr(stree_module_t *module, sid_t name_sid)
+{
+	return (stree_modm_t *) intmap_get(&module->mbr_map, name_sid);
+}
+
+/** Add member to CSI.
+ *
+ * Appends @a csimbr to the list of members of @a csi and indexes it by name.
+ * If there are several members with the same name, lookup returns the first
+ * one.
+ *
+ * @param csi		CSI
+ * @param csimbr	CSI member
+ */
+void stree_csi_add_mbr(stree_csi_t *csi, stree_csimbr_t *csimbr)
+{
+	stree_ident_t *mbr_name;
+
+	list_append(&csi->members, csimbr);
+
+	mbr_name = stree_csimbr_get_name(csimbr);
+	if (mbr_name != NULL && intmap_get(&csi->mbr_map, mbr_name->sid) == NULL)
+		intmap_set(&csi->mbr_map, mbr_name->sid, csimbr);
+}
+
+/** Find CSI member by name.
+ *
+ * Only looks at members declared directly in @a csi (not inherited ones).
+ *
+ * @param csi		CSI
+ * @param name_sid	SID of member name
+ * @return		Member or @c NULL if not found
+ */
+stree_csimbr_t *stree_csi_find_mbr(stree_csi_t *csi, sid_t name_sid)
+{
+	return (stree_csimbr_t *) intmap_get(&csi->mbr_map, name_sid);
+}
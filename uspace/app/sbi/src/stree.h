@@ -101,5 +101,9 @@ bool_t stree_symbol_is_static(stree_symbol_t *symbol);
 stree_targ_t *stree_csi_find_targ(stree_csi_t *csi, stree_ident_t *ident);
 stree_embr_t *stree_enum_find_mbr(stree_enum_t *enum_d, stree_ident_t *ident);
 stree_ident_t *stree_csimbr_get_name(stree_csimbr_t *csimbr);
+void stree_module_add_mbr(stree_module_t *module, stree_modm_t *modm);
+stree_modm_t *stree_module_find_mbr(stree_module_t *module, sid_t name_sid);
+void stree_csi_add_mbr(stree_csi_t *csi, stree_csimbr_t *csimbr);
+stree_csimbr_t *stree_csi_find_mbr(stree_csi_t *csi, sid_t name_sid);
 
 #endif
@@ -30,6 +30,7 @@
 #define STREE_T_H_
 
 #include "bigint_t.h"
+#include "intmap_t.h"
 #include "list_t.h"
 #include "builtin_t.h"
 
@@ -565,6 +566,12 @@ typedef struct stree_proc {
 
 	/** Builtin handler for builtin procedures */
 	builtin_proc_t bi_handler;
+
+	/** Body compiled to bytecode or @c NULL */
+	struct bc_proc *bc;
+
+	/** @c b_true if compilation of the body has been attempted */
+	bool_t bc_tried;
 } stree_proc_t;
 
 /** Constructor declaration */
@@ -741,6 +748,9 @@ typedef struct stree_csi {
 
 	/** List of CSI members */
 	list_t members; /* of stree_csimbr_t */
+
+	/** Members indexed by name SID */
+	intmap_t mbr_map; /* of stree_csimbr_t */
 } stree_csi_t;
 
 typedef enum {
@@ -763,6 +773,9 @@ typedef struct {
 typedef struct stree_module {
 	/** List of module members */
 	list_t members; /* of stree_modm_t */
+
+	/** Members indexed by name SID */
+	intmap_t mbr_map; /* of stree_modm_t */
 } stree_module_t;
 
 /** Symbol attribute class */
@@ -35,22 +35,99 @@
  * The string table is a singleton as there will never be a need for
  * more than one.
  *
- * Current implementation uses a linked list and thus it is slow.
+ * Strings are stored in an array indexed by SID. They are interned using
+ * an open-addressed hash table of SIDs, so both conversions take constant
+ * time on average.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include "mytypes.h"
 #include "os/os.h"
-#include "list.h"
 
 #include "strtab.h"
 
-static list_t str_list;
+/** Initial number of hash table slots (must be a power of two) */
+#define STRTAB_INIT_SIZE 256
+
+/** Strings indexed by SID - 1 */
+static char **str_array;
+/** Number of strings */
+static size_t str_count;
+/** Allocated size of @c str_array */
+static size_t str_array_size;
+
+/** Hash table of SIDs (0 means unused slot) */
+static sid_t *str_hash;
+/** Number of slots in @c str_hash (power of two) */
+static size_t str_hash_size;
+
+/** Compute hash of a string (FNV-1a). */
+static size_t strtab_hash(const char *str)
+{
+	const unsigned char *cp;
+	size_t hash;
+
+	hash = 2166136261U;
+	for (cp = (const unsigned char *) str; *cp != '\0'; ++cp) {
+		hash ^= *cp;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/** Find hash table slot containing @a str or the empty slot where it belongs.
+ *
+ * @param str	String
+ * @return	Slot index
+ */
+static size_t strtab_find(const char *str)
+{
+	size_t mask = str_hash_size - 1;
+	size_t i;
+
+	i = strtab_hash(str) & mask;
+	while (str_hash[i] != 0) {
+		if (os_str_cmp(str, str_array[str_hash[i] - 1]) == 0)
+			break;
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+/** Double the size of the hash table. */
+static void strtab_grow_hash(void)
+{
+	size_t i;
+
+	free(str_hash);
+
+	str_hash_size = 2 * str_hash_size;
+	str_hash = calloc(str_hash_size, sizeof(sid_t));
+	if (str_hash == NULL) {
+		printf("Memory allocation failed.\n");
+		exit(1);
+	}
+
+	for (i = 0; i < str_count; i++)
+		str_hash[strtab_find(str_array[i])] = (sid_t) (i + 1);
+}
 
 /** Initialize string table. */
 void strtab_init(void)
 {
-	list_init(&str_list);
+	str_array = NULL;
+	str_count = 0;
+	str_array_size = 0;
+
+	str_hash_size = STRTAB_INIT_SIZE;
+	str_hash = calloc(str_hash_size, sizeof(sid_t));
+	if (str_hash == NULL) {
+		printf("Memory allocation failed.\n");
+		exit(1);
+	}
 }
 
 /** Get SID of a string.
@@ -63,24 +140,33 @@ void strtab_init(void)
  */
 sid_t strtab_get_sid(const char *str)
 {
-	list_node_t *node;
-	sid_t sid;
+	char **narray;
+	size_t i;
 
-	sid = 0;
-	node = list_first(&str_list);
+	i = strtab_find(str);
+	if (str_hash[i] != 0)
+		return str_hash[i];
 
-	while (node != NULL) {
-		++sid;
-		if (os_str_cmp(str, list_node_data(node, char *)) == 0)
-			return sid;
+	if (str_count == str_array_size) {
+		str_array_size = str_array_size != 0 ? 2 * str_array_size :
+		    STRTAB_INIT_SIZE;
+		narray = realloc(str_array, str_array_size * sizeof(char *));
+		if (narray == NULL) {
+			printf("Memory allocation failed.\n");
+			exit(1);
+		}
 
-		node = list_next(&str_list, node);
+		str_array = narray;
 	}
 
-	++sid;
-	list_append(&str_list, os_str_dup(str));
+	str_array[str_count++] = os_str_dup(str);
+	str_hash[i] = (sid_t) str_count;
 
-	return sid;
+	/* Keep the hash table at most half full. */
+	if (2 * str_count > str_hash_size)
+		strtab_grow_hash();
+
+	return (sid_t) str_count;
 }
 
 /** Get string with the given SID.
@@ -93,20 +179,10 @@ sid_t strtab_get_sid(const char *str)
  */
 char *strtab_get_str(sid_t sid)
 {
-	list_node_t *node;
-	sid_t cnt;
-
-	node = list_first(&str_list);
-	cnt = 1;
-	while (node != NULL && cnt < sid) {
-		node = list_next(&str_list, node);
-		cnt += 1;
-	}
-
-	if (node == NULL) {
+	if (sid < 1 || (size_t) sid > str_count) {
 		printf("Internal error: Invalid SID %d", sid);
 		abort();
 	}
 
-	return list_node_data(node, char *);
+	return str_array[sid - 1];
 }
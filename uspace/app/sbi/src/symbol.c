@@ -161,26 +161,15 @@ stree_symbol_t *symbol_search_csi(stree_program_t *prog,
 stree_symbol_t *symbol_search_csi_no_base(stree_program_t *prog,
     stree_csi_t *scope, stree_ident_t *name)
 {
-	list_node_t *node;
 	stree_csimbr_t *csimbr;
-	stree_ident_t *mbr_name;
 
 	(void) prog;
 
 	/* Look in new members in this class. */
+	csimbr = stree_csi_find_mbr(scope, name->sid);
+	if (csimbr != NULL)
+		return csimbr_to_symbol(csimbr);
 
-	node = list_first(&scope->members);
-	while (node != NULL) {
-		csimbr = list_node_data(node, stree_csimbr_t *);
-		mbr_name = stree_csimbr_get_name(csimbr);
-
-		if (name->sid == mbr_name->sid) {
-			/* Match */
-			return csimbr_to_symbol(csimbr);
-		}
-
-		node = list_next(&scope->members, node);
-	}
 	/* No match */
 	return NULL;
 }
@@ -195,49 +184,26 @@ stree_symbol_t *symbol_search_csi_no_base(stree_program_t *prog,
 static stree_symbol_t *symbol_search_global(stree_program_t *prog,
     stree_ident_t *name)
 {
-	list_node_t *node;
 	stree_modm_t *modm;
 	stree_symbol_t *symbol;
-	stree_ident_t *mbr_name;
-
-	node = list_first(&prog->module->members);
-	while (node != NULL) {
-		modm = list_node_data(node, stree_modm_t *);
 
-		/* Make compiler happy. */
-		mbr_name = NULL;
+	modm = stree_module_find_mbr(prog->module, name->sid);
+	if (modm == NULL)
+		return NULL;
 
-		switch (modm->mc) {
-		case mc_csi:
-			mbr_name = modm->u.csi->name;
-			break;
-		case mc_enum:
-			mbr_name = modm->u.enum_d->name;
-			break;
-		}
+	/* Make compiler happy. */
+	symbol = NULL;
 
-		/* The Clang static analyzer is just too picky. */
-		assert(mbr_name != NULL);
-
-		if (name->sid == mbr_name->sid) {
-			/* Make compiler happy. */
-			symbol = NULL;
-
-			/* Match */
-			switch (modm->mc) {
-			case mc_csi:
-				symbol = csi_to_symbol(modm->u.csi);
-				break;
-			case mc_enum:
-				symbol = enum_to_symbol(modm->u.enum_d);
-				break;
-			}
-			return symbol;
-		}
-		node = list_next(&prog->module->members, node);
+	switch (modm->mc) {
+	case mc_csi:
+		symbol = csi_to_symbol(modm->u.csi);
+		break;
+	case mc_enum:
+		symbol = enum_to_symbol(modm->u.enum_d);
+		break;
 	}
 
-	return NULL;
+	return symbol;
 }
 
 /** Get explicit base class for a CSI.
@@ -0,0 +1,837 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file Bytecode virtual machine.
+ *
+ * Executes procedure bodies compiled by the bytecode compiler (see bc.c).
+ * The VM works with the same procedure and block ARs as the runner, so that
+ * code left to the runner (@c bi_eval, @c bi_stat) and called procedures
+ * see the usual environment.
+ *
+ * Registers hold @c int and @c char values as machine integers as long as
+ * they fit and only fall back to big integers when they do not.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <limits.h>
+#include "bigint.h"
+#include "intmap.h"
+#include "list.h"
+#include "mytypes.h"
+#include "rdata.h"
+#include "run.h"
+#include "run_expr.h"
+#include "symbol.h"
+
+#include "vm.h"
+
+static void vm_ar_init(vm_ar_t *ar, run_proc_ar_t *proc_ar, bc_proc_t *bc);
+static void vm_ar_fini(run_t *run, vm_ar_t *ar, bc_proc_t *bc);
+static void vm_block_enter(run_t *run, vm_ar_t *ar);
+static void vm_block_leave(run_t *run, vm_ar_t *ar);
+static void vm_blocks_leave(run_t *run, vm_ar_t *ar, int nblocks);
+
+static void vm_eval(run_t *run, stree_expr_t *expr, rdata_item_t **ritem);
+static void vm_fun(run_t *run, stree_expr_t *expr, rdata_item_t **ritem);
+static void vm_call(run_t *run, vm_ar_t *ar, int nargs, rdata_item_t **res);
+static void vm_ldvar(run_t *run, vm_reg_t *reg, sid_t name);
+static void vm_stvar(run_t *run, vm_reg_t *reg, var_class_t vc, sid_t name);
+
+static void vm_arith(bc_iclass_t ic, vm_reg_t *r1, vm_reg_t *r2,
+    vm_reg_t *dest);
+static void vm_neg(vm_reg_t *r, vm_reg_t *dest);
+static bool_t vm_compare(bc_iclass_t ic, vm_reg_t *r1, vm_reg_t *r2);
+
+static void vm_reg_clear(vm_reg_t *reg);
+static void vm_reg_set_int(vm_reg_t *reg, int value);
+static void vm_reg_set_bigint(vm_reg_t *reg, bigint_t *value);
+static void vm_reg_load(vm_reg_t *reg, bigint_t *value);
+static void vm_reg_store(vm_reg_t *reg, bigint_t *dest);
+static void vm_reg_copy(vm_reg_t *src, vm_reg_t *dest);
+static void vm_reg_from_var(vm_reg_t *reg, rdata_var_t *var);
+static void vm_reg_to_var(vm_reg_t *reg, var_class_t vc, rdata_var_t **rvar);
+static void vm_reg_to_item(vm_reg_t *reg, var_class_t vc,
+    rdata_item_t **ritem);
+
+/** Run procedure body compiled to bytecode.
+ *
+ * Called by run_proc() with the procedure AR already on the stack.
+ * Return value is stored in the procedure AR. If an exception occurs,
+ * we leave with @c bo_mode set accordingly.
+ *
+ * @param run		Runner object
+ * @param proc_ar	Procedure activation record
+ * @param bc		Compiled procedure body
+ */
+void vm_run(run_t *run, run_proc_ar_t *proc_ar, bc_proc_t *bc)
+{
+	vm_ar_t ar;
+	vm_reg_t *reg;
+	bc_instr_t *instr;
+	rdata_item_t *item;
+	size_t pc;
+
+	vm_ar_init(&ar, proc_ar, bc);
+	reg = ar.reg;
+
+	pc = 0;
+	while (pc < bc->ninstr) {
+		instr = &bc->code[pc++];
+
+		switch (instr->ic) {
+		case bi_ldi:
+			vm_reg_set_int(&reg[instr->a], instr->u.imm);
+			break;
+		case bi_ldbig:
+			vm_reg_load(&reg[instr->a], instr->u.big);
+			break;
+		case bi_mov:
+			vm_reg_copy(&reg[instr->b], &reg[instr->a]);
+			break;
+
+		case bi_add:
+		case bi_sub:
+		case bi_mul:
+			vm_arith(instr->ic, &reg[instr->b], &reg[instr->c],
+			    &reg[instr->a]);
+			break;
+		case bi_neg:
+			vm_neg(&reg[instr->b], &reg[instr->a]);
+			break;
+
+		case bi_eq:
+		case bi_ne:
+		case bi_lt:
+		case bi_gt:
+		case bi_le:
+		case bi_ge:
+			vm_reg_set_int(&reg[instr->a], vm_compare(instr->ic,
+			    &reg[instr->b], &reg[instr->c]) ? 1 : 0);
+			break;
+
+		case bi_and:
+			vm_reg_set_int(&reg[instr->a],
+			    reg[instr->b].sval != 0 && reg[instr->c].sval != 0);
+			break;
+		case bi_or:
+			vm_reg_set_int(&reg[instr->a],
+			    reg[instr->b].sval != 0 || reg[instr->c].sval != 0);
+			break;
+		case bi_not:
+			vm_reg_set_int(&reg[instr->a], reg[instr->b].sval == 0);
+			break;
+
+		case bi_jmp:
+			vm_blocks_leave(run, &ar, instr->b);
+			pc = instr->c;
+			break;
+		case bi_jz:
+			if (reg[instr->a].sval == 0)
+				pc = instr->c;
+			break;
+
+		case bi_enter:
+			vm_block_enter(run, &ar);
+			break;
+		case bi_leave:
+			vm_block_leave(run, &ar);
+			break;
+
+		case bi_ldvar:
+			vm_ldvar(run, &reg[instr->a], instr->u.sid);
+			break;
+		case bi_stvar:
+			vm_stvar(run, &reg[instr->a], instr->vc, instr->u.sid);
+			break;
+
+		case bi_eval:
+			vm_eval(run, instr->u.expr, &item);
+			if (run_is_bo(run))
+				goto cleanup;
+
+			vm_reg_from_var(&reg[instr->a], item->u.value->var);
+			rdata_item_destroy(item);
+			break;
+		case bi_stat:
+			run_stat(run, instr->u.stat, NULL);
+			if (run_is_bo(run)) {
+				/* Only break can be handled here. */
+				if (run->thread_ar->bo_mode != bm_stat ||
+				    instr->c < 0)
+					goto cleanup;
+
+				run->thread_ar->bo_mode = bm_none;
+				vm_blocks_leave(run, &ar, instr->b);
+				pc = instr->c;
+			}
+			break;
+
+		case bi_fun:
+			vm_fun(run, instr->u.expr, &item);
+			if (run_is_bo(run))
+				goto cleanup;
+
+			ar.item[ar.nitems++] = item;
+			break;
+		case bi_push:
+			vm_reg_to_item(&reg[instr->a], instr->vc, &item);
+			ar.item[ar.nitems++] = item;
+			break;
+		case bi_pushe:
+			vm_eval(run, instr->u.expr, &item);
+			if (run_is_bo(run))
+				goto cleanup;
+
+			ar.item[ar.nitems++] = item;
+			break;
+		case bi_call:
+			vm_call(run, &ar, instr->b, &item);
+			if (run_is_bo(run)) {
+				if (item != NULL)
+					rdata_item_destroy(item);
+				goto cleanup;
+			}
+
+			if (instr->a >= 0) {
+				if (item == NULL) {
+					printf("Error: Sub-expression has no "
+					    "value.\n");
+					exit(1);
+				}
+
+				vm_reg_from_var(&reg[instr->a],
+				    item->u.value->var);
+			}
+
+			if (item != NULL)
+				rdata_item_destroy(item);
+			break;
+
+		case bi_ret:
+			goto cleanup;
+		case bi_retr:
+			vm_reg_to_item(&reg[instr->a], instr->vc,
+			    &proc_ar->retval);
+			goto cleanup;
+		case bi_rete:
+			vm_eval(run, instr->u.expr, &item);
+			if (run_is_bo(run))
+				goto cleanup;
+
+			proc_ar->retval = item;
+			goto cleanup;
+		}
+	}
+
+cleanup:
+	vm_ar_fini(run, &ar, bc);
+}
+
+/** Set up VM activation.
+ *
+ * @param ar		VM activation
+ * @param proc_ar	Procedure AR
+ * @param bc		Compiled procedure body
+ */
+static void vm_ar_init(vm_ar_t *ar, run_proc_ar_t *proc_ar, bc_proc_t *bc)
+{
+	ar->proc_ar = proc_ar;
+	ar->reg = NULL;
+	ar->item = NULL;
+	ar->nitems = 0;
+	ar->nblocks = 0;
+
+	if (bc->nregs > 0) {
+		ar->reg = calloc(bc->nregs, sizeof(vm_reg_t));
+		if (ar->reg == NULL) {
+			printf("Memory allocation failed.\n");
+			exit(1);
+		}
+	}
+
+	if (bc->nitems > 0) {
+		ar->item = calloc(bc->nitems, sizeof(rdata_item_t *));
+		if (ar->item == NULL) {
+			printf("Memory allocation failed.\n");
+			exit(1);
+		}
+	}
+}
+
+/** Tear down VM activation.
+ *
+ * Leaves any block ARs still entered (when returning or bailing out)
+ * and frees remaining items and registers.
+ *
+ * @param run		Runner object
+ * @param ar		VM activation
+ * @param bc		Compiled procedure body
+ */
+static void vm_ar_fini(run_t *run, vm_ar_t *ar, bc_proc_t *bc)
+{
+	int i;
+
+	vm_blocks_leave(run, ar, ar->nblocks);
+
+	for (i = 0; i < ar->nitems; i++)
+		rdata_item_destroy(ar->item[i]);
+
+	for (i = 0; i < bc->nregs; i++)
+		vm_reg_clear(&ar->reg[i]);
+
+	free(ar->item);
+	free(ar->reg);
+}
+
+/** Enter block with variables kept in memory.
+ *
+ * @param run		Runner object
+ * @param ar		VM activation
+ */
+static void vm_block_enter(run_t *run, vm_ar_t *ar)
+{
+	run_block_ar_t *block_ar;
+
+	(void) run;
+
+	block_ar = run_block_ar_new();
+	intmap_init(&block_ar->vars);
+	list_append(&ar->proc_ar->block_ar, block_ar);
+	++ar->nblocks;
+}
+
+/** Leave innermost block entered by the VM.
+ *
+ * @param run		Runner object
+ * @param ar		VM activation
+ */
+static void vm_block_leave(run_t *run, vm_ar_t *ar)
+{
+	run_block_ar_t *block_ar;
+	list_node_t *node;
+
+	assert(ar->nblocks > 0);
+
+	node = list_last(&ar->proc_ar->block_ar);
+	block_ar = list_node_data(node, run_block_ar_t *);
+	list_remove(&ar->proc_ar->block_ar, node);
+
+	run_block_ar_destroy(run, block_ar);
+	--ar->nblocks;
+}
+
+/** Leave several blocks entered by the VM.
+ *
+ * @param run		Runner object
+ * @param ar		VM activation
+ * @param nblocks	Number of blocks to leave
+ */
+static void vm_blocks_leave(run_t *run, vm_ar_t *ar, int nblocks)
+{
+	while (nblocks-- > 0)
+		vm_block_leave(run, ar);
+}
+
+/** Evaluate expression using the runner.
+ *
+ * @param run		Runner object
+ * @param expr		Expression
+ * @param ritem		Place to store value item (@c NULL on bailout)
+ */
+static void vm_eval(run_t *run, stree_expr_t *expr, rdata_item_t **ritem)
+{
+	rdata_item_t *item;
+	rdata_item_t *vitem;
+
+	*ritem = NULL;
+
+	item = NULL;
+	run_expr(run, expr, &item);
+	if (run_is_bo(run)) {
+		if (item != NULL)
+			rdata_item_destroy(item);
+		return;
+	}
+
+	vitem = NULL;
+	run_cvt_value_item(run, item, &vitem);
+	rdata_item_destroy(item);
+	if (run_is_bo(run)) {
+		if (vitem != NULL)
+			rdata_item_destroy(vitem);
+		return;
+	}
+
+	*ritem = vitem;
+}
+
+/** Evaluate function to call.
+ *
+ * @param run		Runner object
+ * @param expr		Expression yielding a delegate
+ * @param ritem		Place to store delegate value item (@c NULL on
+ *			bailout)
+ */
+static void vm_fun(run_t *run, stree_expr_t *expr, rdata_item_t **ritem)
+{
+	rdata_item_t *item;
+	rdata_deleg_t *deleg_v;
+
+	vm_eval(run, expr, &item);
+	*ritem = item;
+	if (item == NULL)
+		return;
+
+	if (item->u.value->var->vc != vc_deleg) {
+		printf("Unimplemented: Call expression of this type (");
+		rdata_item_print(item);
+		printf(").\n");
+		exit(1);
+	}
+
+	deleg_v = item->u.value->var->u.deleg_v;
+
+	if (deleg_v->sym->sc != sc_fun) {
+		printf("Error: Called symbol is not a function.\n");
+		exit(1);
+	}
+}
+
+/** Call function.
+ *
+ * The delegate and @a nargs argument values are taken from the top
+ * of the item stack.
+ *
+ * @param run		Runner object
+ * @param ar		VM activation
+ * @param nargs		Number of arguments
+ * @param res		Place to store return value
+ */
+static void vm_call(run_t *run, vm_ar_t *ar, int nargs, rdata_item_t **res)
+{
+	rdata_item_t *rdeleg_vi;
+	rdata_deleg_t *deleg_v;
+	list_t arg_vals;
+	list_node_t *node;
+	stree_fun_t *fun;
+	run_proc_ar_t *proc_ar;
+	int base;
+	int i;
+
+	base = ar->nitems - nargs;
+	assert(base > 0);
+
+	rdeleg_vi = ar->item[base - 1];
+	deleg_v = rdeleg_vi->u.value->var->u.deleg_v;
+
+	list_init(&arg_vals);
+	for (i = base; i < ar->nitems; i++)
+		list_append(&arg_vals, ar->item[i]);
+
+	ar->nitems = base - 1;
+
+	fun = symbol_to_fun(deleg_v->sym);
+	assert(fun != NULL);
+
+	/* Create procedure activation record. */
+	run_proc_ar_create(run, deleg_v->obj, fun->proc, &proc_ar);
+
+	/* Fill in argument values. */
+	run_proc_ar_set_args(run, proc_ar, &arg_vals);
+
+	/* Destroy arg_vals, they are no longer needed. */
+	while (!list_is_empty(&arg_vals)) {
+		node = list_first(&arg_vals);
+		rdata_item_destroy(list_node_data(node, rdata_item_t *));
+		list_remove(&arg_vals, node);
+	}
+	list_fini(&arg_vals);
+
+	/* Run the function. */
+	run_proc(run, proc_ar, res);
+
+	if (!run_is_bo(run) && fun->sig->rtype != NULL && *res == NULL) {
+		printf("Error: Function '");
+		symbol_print_fqn(deleg_v->sym);
+		printf("' did not return a value.\n");
+		exit(1);
+	}
+
+	/* Destroy procedure activation record. */
+	run_proc_ar_destroy(run, proc_ar);
+
+	rdata_item_destroy(rdeleg_vi);
+}
+
+/** Load local variable kept in a block AR.
+ *
+ * @param run		Runner object
+ * @param reg		Destination register
+ * @param name		Variable name
+ */
+static void vm_ldvar(run_t *run, vm_reg_t *reg, sid_t name)
+{
+	rdata_var_t *var;
+
+	var = run_local_vars_lookup(run, name);
+	assert(var != NULL);
+
+	vm_reg_from_var(reg, var);
+}
+
+/** Store to local variable kept in a block AR.
+ *
+ * @param run		Runner object
+ * @param reg		Source register
+ * @param vc		Var class of the value in @a reg
+ * @param name		Variable name
+ */
+static void vm_stvar(run_t *run, vm_reg_t *reg, var_class_t vc, sid_t name)
+{
+	rdata_var_t *var;
+	rdata_value_t *value;
+
+	var = run_local_vars_lookup(run, name);
+	assert(var != NULL);
+
+	value = rdata_value_new();
+	vm_reg_to_var(reg, vc, &value->var);
+	rdata_var_write(var, value);
+	rdata_value_destroy(value);
+}
+
+/** Perform integer arithmetic.
+ *
+ * @param ic		Instruction class (@c bi_add, @c bi_sub or @c bi_mul)
+ * @param r1		First operand
+ * @param r2		Second operand
+ * @param dest		Destination (can be the same as an operand)
+ */
+static void vm_arith(bc_iclass_t ic, vm_reg_t *r1, vm_reg_t *r2,
+    vm_reg_t *dest)
+{
+	bigint_t t1, t2;
+	bigint_t *b1, *b2;
+	bigint_t res;
+	int64_t v;
+
+	if (!r1->isbig && !r2->isbig) {
+		/* Cannot overflow, operands are within INT_MAX. */
+		switch (ic) {
+		case bi_add:
+			v = (int64_t) r1->sval + r2->sval;
+			break;
+		case bi_sub:
+			v = (int64_t) r1->sval - r2->sval;
+			break;
+		case bi_mul:
+			v = (int64_t) r1->sval * r2->sval;
+			break;
+		default:
+			assert(b_false);
+			return;
+		}
+
+		if (v >= -INT_MAX && v <= INT_MAX) {
+			vm_reg_set_int(dest, (int) v);
+			return;
+		}
+	}
+
+	/* Compute with big integers. */
+	b1 = &r1->bval;
+	if (!r1->isbig) {
+		bigint_init(&t1, r1->sval);
+		b1 = &t1;
+	}
+
+	b2 = &r2->bval;
+	if (!r2->isbig) {
+		bigint_init(&t2, r2->sval);
+		b2 = &t2;
+	}
+
+	switch (ic) {
+	case bi_add:
+		bigint_add(b1, b2, &res);
+		break;
+	case bi_sub:
+		bigint_sub(b1, b2, &res);
+		break;
+	case bi_mul:
+		bigint_mul(b1, b2, &res);
+		break;
+	default:
+		assert(b_false);
+		return;
+	}
+
+	if (!r1->isbig)
+		bigint_destroy(&t1);
+	if (!r2->isbig)
+		bigint_destroy(&t2);
+
+	vm_reg_set_bigint(dest, &res);
+}
+
+/** Negate integer.
+ *
+ * @param r		Operand
+ * @param dest		Destination (can be the same as @a r)
+ */
+static void vm_neg(vm_reg_t *r, vm_reg_t *dest)
+{
+	bigint_t res;
+
+	if (!r->isbig) {
+		vm_reg_set_int(dest, -r->sval);
+		return;
+	}
+
+	bigint_reverse_sign(&r->bval, &res);
+	vm_reg_set_bigint(dest, &res);
+}
+
+/** Compare two values.
+ *
+ * Booleans are held as 0 and 1, so they compare the same way
+ * the runner compares them.
+ *
+ * @param ic		Instruction class (relational)
+ * @param r1		First operand
+ * @param r2		Second operand
+ * @return		Result of the comparison
+ */
+static bool_t vm_compare(bc_iclass_t ic, vm_reg_t *r1, vm_reg_t *r2)
+{
+	bigint_t t1, t2;
+	bigint_t diff;
+	int v1, v2;
+
+	if (!r1->isbig && !r2->isbig) {
+		v1 = r1->sval;
+		v2 = r2->sval;
+	} else {
+		/* Reduce to comparing sign of the difference with zero. */
+		vm_reg_store(r1, &t1);
+		vm_reg_store(r2, &t2);
+		bigint_sub(&t1, &t2, &diff);
+
+		v1 = bigint_is_zero(&diff) ? 0 :
+		    (bigint_is_negative(&diff) ? -1 : 1);
+		v2 = 0;
+
+		bigint_destroy(&t1);
+		bigint_destroy(&t2);
+		bigint_destroy(&diff);
+	}
+
+	switch (ic) {
+	case bi_eq:
+		return v1 == v2;
+	case bi_ne:
+		return v1 != v2;
+	case bi_lt:
+		return v1 < v2;
+	case bi_gt:
+		return v1 > v2;
+	case bi_le:
+		return v1 <= v2;
+	case bi_ge:
+		return v1 >= v2;
+	default:
+		assert(b_false);
+		return b_false;
+	}
+}
+
+/** Release big integer held in register, if any.
+ *
+ * @param reg		Register
+ */
+static void vm_reg_clear(vm_reg_t *reg)
+{
+	if (reg->isbig) {
+		bigint_destroy(&reg->bval);
+		reg->isbig = b_false;
+	}
+}
+
+/** Set register to small value.
+ *
+ * @param reg		Register
+ * @param value		Value (between -INT_MAX and INT_MAX)
+ */
+static void vm_reg_set_int(vm_reg_t *reg, int value)
+{
+	vm_reg_clear(reg);
+	reg->sval = value;
+}
+
+/** Set register to big integer value.
+ *
+ * The register takes over @a value.
+ *
+ * @param reg		Register
+ * @param value		Value
+ */
+static void vm_reg_set_bigint(vm_reg_t *reg, bigint_t *value)
+{
+	int ival;
+
+	if (bigint_get_value_int(value, &ival) == EOK) {
+		bigint_destroy(value);
+		vm_reg_set_int(reg, ival);
+		return;
+	}
+
+	vm_reg_clear(reg);
+	reg->bval = *value;
+	reg->isbig = b_true;
+}
+
+/** Load copy of big integer into register.
+ *
+ * @param reg		Register
+ * @param value		Value
+ */
+static void vm_reg_load(vm_reg_t *reg, bigint_t *value)
+{
+	bigint_t copy;
+	int ival;
+
+	if (bigint_get_value_int(value, &ival) == EOK) {
+		vm_reg_set_int(reg, ival);
+		return;
+	}
+
+	bigint_clone(value, &copy);
+	vm_reg_set_bigint(reg, &copy);
+}
+
+/** Store integer value of register into (uninitialized) big integer.
+ *
+ * @param reg		Register
+ * @param dest		Destination
+ */
+static void vm_reg_store(vm_reg_t *reg, bigint_t *dest)
+{
+	if (reg->isbig)
+		bigint_clone(&reg->bval, dest);
+	else
+		bigint_init(dest, reg->sval);
+}
+
+/** Copy register.
+ *
+ * @param src		Source register
+ * @param dest		Destination register
+ */
+static void vm_reg_copy(vm_reg_t *src, vm_reg_t *dest)
+{
+	if (src->isbig)
+		vm_reg_load(dest, &src->bval);
+	else
+		vm_reg_set_int(dest, src->sval);
+}
+
+/** Load value of variable into register.
+ *
+ * @param reg		Register
+ * @param var		Variable of primitive type
+ */
+static void vm_reg_from_var(vm_reg_t *reg, rdata_var_t *var)
+{
+	switch (var->vc) {
+	case vc_bool:
+		vm_reg_set_int(reg, var->u.bool_v->value ? 1 : 0);
+		break;
+	case vc_char:
+		vm_reg_load(reg, &var->u.char_v->value);
+		break;
+	case vc_int:
+		vm_reg_load(reg, &var->u.int_v->value);
+		break;
+	default:
+		assert(b_false);
+	}
+}
+
+/** Construct variable from register.
+ *
+ * @param reg		Register
+ * @param vc		Var class of the value in @a reg
+ * @param rvar		Place to store pointer to new variable
+ */
+static void vm_reg_to_var(vm_reg_t *reg, var_class_t vc, rdata_var_t **rvar)
+{
+	rdata_var_t *var;
+
+	var = rdata_var_new(vc);
+
+	switch (vc) {
+	case vc_bool:
+		var->u.bool_v = rdata_bool_new();
+		var->u.bool_v->value = reg->sval != 0;
+		break;
+	case vc_char:
+		var->u.char_v = rdata_char_new();
+		vm_reg_store(reg, &var->u.char_v->value);
+		break;
+	case vc_int:
+		var->u.int_v = rdata_int_new();
+		vm_reg_store(reg, &var->u.int_v->value);
+		break;
+	default:
+		assert(b_false);
+	}
+
+	*rvar = var;
+}
+
+/** Construct value item from register.
+ *
+ * @param reg		Register
+ * @param vc		Var class of the value in @a reg
+ * @param ritem		Place to store pointer to new value item
+ */
+static void vm_reg_to_item(vm_reg_t *reg, var_class_t vc,
+    rdata_item_t **ritem)
+{
+	rdata_item_t *item;
+	rdata_value_t *value;
+
+	item = rdata_item_new(ic_value);
+	value = rdata_value_new();
+	item->u.value = value;
+	vm_reg_to_var(reg, vc, &value->var);
+
+	*ritem = item;
+}
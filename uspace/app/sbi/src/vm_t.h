@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef VM_T_H_
+#define VM_T_H_
+
+#include "bigint_t.h"
+
+/** VM register.
+ *
+ * Integers (and characters) which fit into a machine integer are held
+ * in @c sval, others in @c bval. Booleans are held in @c sval.
+ */
+typedef struct {
+	/** @c b_true if the value is held in @c bval */
+	bool_t isbig;
+
+	/** Small value */
+	int sval;
+
+	/** Big integer value */
+	bigint_t bval;
+} vm_reg_t;
+
+/** Activation of a procedure running in the VM */
+typedef struct {
+	/** Procedure AR */
+	struct run_proc_ar *proc_ar;
+
+	/** Registers */
+	vm_reg_t *reg;
+
+	/** Item stack */
+	struct rdata_item **item;
+
+	/** Number of items on the item stack */
+	int nitems;
+
+	/** Number of block ARs created by the VM */
+	int nblocks;
+} vm_ar_t;
+
+#endif
@@ -75,28 +75,33 @@ static void list_tasks(void)
 	}
 
 	printf("[taskid] [thrds] [resident] [virtual] [ucycles]"
-	    " [kcycles] [name\n");
+	    " [kcycles] [faults] [name\n");
 
 	for (size_t i = 0; i < count; i++) {
 		uint64_t resmem;
 		uint64_t virtmem;
 		uint64_t ucycles;
 		uint64_t kcycles;
+		uint64_t faults;
 		const char *resmem_suffix;
 		const char *virtmem_suffix;
 		char usuffix;
 		char ksuffix;
+		char fsuffix;
 
 		bin_order_suffix(stats_tasks[i].resmem, &resmem, &resmem_suffix, true);
 		bin_order_suffix(stats_tasks[i].virtmem, &virtmem, &virtmem_suffix, true);
 		order_suffix(stats_tasks[i].ucycles, &ucycles, &usuffix);
 		order_suffix(stats_tasks[i].kcycles, &kcycles, &ksuffix);
+		order_suffix(stats_tasks[i].fault_info.page_faults, &faults,
+		    &fsuffix);
 
 		printf("%-8" PRIu64 " %7zu %7" PRIu64 "%s %6" PRIu64 "%s"
-		    " %8" PRIu64 "%c %8" PRIu64 "%c %s\n",
+		    " %8" PRIu64 "%c %8" PRIu64 "%c %7" PRIu64 "%c %s\n",
 		    stats_tasks[i].task_id, stats_tasks[i].threads,
 		    resmem, resmem_suffix, virtmem, virtmem_suffix,
-		    ucycles, usuffix, kcycles, ksuffix, stats_tasks[i].name);
+		    ucycles, usuffix, kcycles, ksuffix, faults, fsuffix,
+		    stats_tasks[i].name);
 	}
 
 	free(stats_tasks);
@@ -0,0 +1,4 @@
+/** @addtogroup tcpload tcpload
+ * @brief TCP connection load test
+ * @ingroup apps
+ */
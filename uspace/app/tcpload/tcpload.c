@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup tcpload
+ * @{
+ */
+/** @file TCP connection load test.
+ *
+ * Opens a large number of TCP connections over loopback, keeps them
+ * all open at the same time and reports connection setup rate and
+ * memory used per connection.
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <getopt.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/tcp.h>
+#include <inttypes.h>
+#include <stats.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <task.h>
+#include <time.h>
+
+#define NAME "tcpload"
+
+/** Name of the TCP service task */
+#define TCP_TASK_NAME "tcp"
+
+/** Default number of connections */
+#define DEFAULT_COUNT 10000
+/** Default port to listen on */
+#define DEFAULT_PORT 8081
+
+static FIBRIL_MUTEX_INITIALIZE(srv_lock);
+static FIBRIL_CONDVAR_INITIALIZE(srv_cv);
+/** Number of accepted connections being held open */
+static size_t srv_active;
+/** Set to let accepted connections close */
+static bool srv_release;
+
+static void tcpload_new_conn(tcp_listener_t *, tcp_conn_t *);
+
+static tcp_listen_cb_t listen_cb = {
+	.new_conn = tcpload_new_conn
+};
+
+static const char *short_options = "b:n:p:";
+
+static void print_syntax(void)
+{
+	printf("Syntax: %s [<options>]\n", NAME);
+	printf("\t-n <count>   Number of connections (default %u)\n",
+	    DEFAULT_COUNT);
+	printf("\t-p <port>    Port to listen on (default %u)\n",
+	    DEFAULT_PORT);
+	printf("\t-b <backlog> Listener backlog\n");
+}
+
+/** Hold accepted connection open until the test is over.
+ *
+ * The TCP library calls this in a separate fibril for each connection
+ * and destroys the connection once we return.
+ */
+static void tcpload_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
+{
+	fibril_mutex_lock(&srv_lock);
+	++srv_active;
+	fibril_condvar_broadcast(&srv_cv);
+
+	while (!srv_release)
+		fibril_condvar_wait(&srv_cv, &srv_lock);
+
+	--srv_active;
+	fibril_condvar_broadcast(&srv_cv);
+	fibril_mutex_unlock(&srv_lock);
+}
+
+/** Get resident memory size of a task.
+ *
+ * @param name Task name or @c NULL for the current task
+ * @param rresmem Place to store resident memory size in bytes
+ *
+ * @return EOK on success, ENOENT if task was not found
+ */
+static errno_t tcpload_task_resmem(const char *name, size_t *rresmem)
+{
+	stats_task_t *tasks;
+	stats_task_t *task;
+	const char *tname;
+	size_t count;
+	size_t i;
+
+	if (name == NULL) {
+		task = stats_get_task(task_get_id());
+		if (task == NULL)
+			return ENOENT;
+
+		*rresmem = task->resmem;
+		free(task);
+		return EOK;
+	}
+
+	tasks = stats_get_tasks(&count);
+	if (tasks == NULL)
+		return ENOENT;
+
+	for (i = 0; i < count; i++) {
+		/* Task name may contain full path to the executable */
+		tname = str_rchr(tasks[i].name, '/');
+		tname = tname != NULL ? tname + 1 : tasks[i].name;
+
+		if (str_cmp(tname, name) == 0) {
+			*rresmem = tasks[i].resmem;
+			free(tasks);
+			return EOK;
+		}
+	}
+
+	free(tasks);
+	return ENOENT;
+}
+
+/** Get current time in microseconds. */
+static usec_t tcpload_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+/** Print memory usage difference per connection. */
+static void tcpload_print_mem(const char *what, size_t before, size_t after,
+    size_t count)
+{
+	if (after < before) {
+		printf("%s: resident memory shrank by %zu bytes\n", what,
+		    before - after);
+		return;
+	}
+
+	printf("%s: %zu bytes resident memory added, %zu bytes per "
+	    "connection\n", what, after - before, (after - before) / count);
+}
+
+int main(int argc, char *argv[])
+{
+	tcp_t *tcp = NULL;
+	tcp_listener_t *lst = NULL;
+	tcp_conn_t **conns = NULL;
+	inet_ep_t ep;
+	inet_ep2_t epp;
+	size_t count = DEFAULT_COUNT;
+	size_t backlog = 0;
+	uint16_t port = DEFAULT_PORT;
+	size_t srv_mem0 = 0, srv_mem1 = 0;
+	size_t own_mem0 = 0, own_mem1 = 0;
+	bool have_srv_mem;
+	usec_t start, stop;
+	size_t nconn;
+	size_t i;
+	int c;
+	errno_t rc;
+
+	while ((c = getopt(argc, argv, short_options)) != -1) {
+		switch (c) {
+		case 'b':
+			rc = str_size_t(optarg, NULL, 10, true, &backlog);
+			if (rc != EOK || backlog == 0) {
+				printf("Invalid backlog.\n");
+				print_syntax();
+				return 1;
+			}
+			break;
+		case 'n':
+			rc = str_size_t(optarg, NULL, 10, true, &count);
+			if (rc != EOK || count == 0) {
+				printf("Invalid connection count.\n");
+				print_syntax();
+				return 1;
+			}
+			break;
+		case 'p':
+			rc = str_uint16_t(optarg, NULL, 10, true, &port);
+			if (rc != EOK || port == 0) {
+				printf("Invalid port number.\n");
+				print_syntax();
+				return 1;
+			}
+			break;
+		default:
+			printf("Unknown option passed.\n");
+			print_syntax();
+			return 1;
+		}
+	}
+
+	if (optind < argc) {
+		printf("Unexpected argument.\n");
+		print_syntax();
+		return 1;
+	}
+
+	conns = calloc(count, sizeof(tcp_conn_t *));
+	if (conns == NULL) {
+		printf("Out of memory.\n");
+		return 1;
+	}
+
+	rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		printf("Error initializing TCP: %s.\n", str_error(rc));
+		goto error;
+	}
+
+	inet_ep_init(&ep);
+	inet_addr(&ep.addr, 127, 0, 0, 1);
+	ep.port = port;
+
+	rc = tcp_listener_create(tcp, &ep, &listen_cb, NULL, NULL, NULL,
+	    &lst);
+	if (rc != EOK) {
+		printf("Error creating listener: %s.\n", str_error(rc));
+		goto error;
+	}
+
+	if (backlog != 0) {
+		rc = tcp_listener_set_backlog(lst, backlog);
+		if (rc != EOK) {
+			printf("Error setting listener backlog: %s.\n",
+			    str_error(rc));
+			goto error;
+		}
+	}
+
+	have_srv_mem = tcpload_task_resmem(TCP_TASK_NAME, &srv_mem0) == EOK;
+	(void) tcpload_task_resmem(NULL, &own_mem0);
+
+	printf("Opening %zu connections to port %" PRIu16 "...\n", count,
+	    port);
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.remote.addr, 127, 0, 0, 1);
+	epp.remote.port = port;
+
+	start = tcpload_now();
+
+	for (nconn = 0; nconn < count; nconn++) {
+		rc = tcp_conn_create(tcp, &epp, NULL, NULL, &conns[nconn]);
+		if (rc != EOK) {
+			printf("Error creating connection %zu: %s.\n",
+			    nconn, str_error(rc));
+			break;
+		}
+
+		rc = tcp_conn_wait_connected(conns[nconn]);
+		if (rc != EOK) {
+			printf("Connection %zu failed: %s.\n", nconn,
+			    str_error(rc));
+			tcp_conn_destroy(conns[nconn]);
+			conns[nconn] = NULL;
+			break;
+		}
+	}
+
+	/* Wait until all connections have been accepted */
+	fibril_mutex_lock(&srv_lock);
+	while (srv_active < nconn)
+		fibril_condvar_wait(&srv_cv, &srv_lock);
+	fibril_mutex_unlock(&srv_lock);
+
+	stop = tcpload_now();
+
+	if (nconn == 0) {
+		printf("No connections established.\n");
+		goto error;
+	}
+
+	printf("Established %zu connections in %" PRIu64 " ms", nconn,
+	    (uint64_t) ((stop - start) / 1000));
+	if (stop > start) {
+		printf(" (%" PRIu64 " connections/s)",
+		    (uint64_t) ((usec_t) nconn * 1000000 / (stop - start)));
+	}
+	printf(".\n");
+
+	if (have_srv_mem &&
+	    tcpload_task_resmem(TCP_TASK_NAME, &srv_mem1) == EOK) {
+		tcpload_print_mem("TCP service", srv_mem0, srv_mem1, nconn);
+	} else {
+		printf("TCP service: memory usage not available\n");
+	}
+
+	if (tcpload_task_resmem(NULL, &own_mem1) == EOK)
+		tcpload_print_mem(NAME, own_mem0, own_mem1, nconn);
+
+	printf("Closing connections...\n");
+
+	for (i = 0; i < nconn; i++)
+		tcp_conn_destroy(conns[i]);
+
+	/* Let accepted connections go and wait for them to close */
+	fibril_mutex_lock(&srv_lock);
+	srv_release = true;
+	fibril_condvar_broadcast(&srv_cv);
+	while (srv_active > 0)
+		fibril_condvar_wait(&srv_cv, &srv_lock);
+	fibril_mutex_unlock(&srv_lock);
+
+	tcp_listener_destroy(lst);
+	tcp_destroy(tcp);
+	free(conns);
+	return 0;
+error:
+	fibril_mutex_lock(&srv_lock);
+	srv_release = true;
+	fibril_condvar_broadcast(&srv_cv);
+	fibril_mutex_unlock(&srv_lock);
+
+	if (conns != NULL) {
+		for (i = 0; i < count; i++)
+			tcp_conn_destroy(conns[i]);
+	}
+
+	tcp_listener_destroy(lst);
+	tcp_destroy(tcp);
+	free(conns);
+	return 1;
+}
+
+/** @}
+ */
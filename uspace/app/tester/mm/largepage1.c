@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <str_error.h>
+#include <as.h>
+#include <errno.h>
+#include <stats.h>
+#include "../tester.h"
+
+/*
+ * The area spans two large pages of 2 MiB plus a few small pages so that
+ * both large and small page mappings are exercised on architectures which
+ * support large pages. Elsewhere the test just checks ordinary mappings.
+ */
+#define LARGE_PAGE_SIZE  (2 * 1024 * 1024)
+#define AREA_SIZE        (2 * LARGE_PAGE_SIZE + 4 * PAGE_SIZE)
+#define SHRUNK_SIZE      (LARGE_PAGE_SIZE + LARGE_PAGE_SIZE / 2)
+
+static uint64_t large_pages_mapped(void)
+{
+	size_t count;
+	stats_cpu_t *cpus = stats_get_cpus(&count);
+	if (cpus == NULL)
+		return 0;
+
+	uint64_t sum = 0;
+	for (size_t i = 0; i < count; i++)
+		sum += cpus[i].large_pages_mapped;
+
+	free(cpus);
+	return sum;
+}
+
+static void fill_area(uint8_t *area, size_t size)
+{
+	TPRINTF("Touching (faulting-in) AS area...\n");
+
+	for (size_t off = 0; off < size; off += PAGE_SIZE)
+		area[off] = (uint8_t) (off / PAGE_SIZE);
+}
+
+static const char *verify_area(uint8_t *area, size_t size)
+{
+	TPRINTF("Verifying contents and mapping...\n");
+
+	for (size_t off = 0; off < size; off += PAGE_SIZE) {
+		if (area[off] != (uint8_t) (off / PAGE_SIZE))
+			return "Unexpected page contents";
+
+		errno_t rc = as_get_physical_mapping(area + off, NULL);
+		if (rc != EOK) {
+			TPRINTF("as_get_physical_mapping() = %s\n",
+			    str_error_name(rc));
+			return "Failed to find mapping";
+		}
+	}
+
+	return NULL;
+}
+
+static bool is_contiguous(uint8_t *area, size_t size)
+{
+	uintptr_t first;
+	if (as_get_physical_mapping(area, &first) != EOK)
+		return false;
+
+	for (size_t off = PAGE_SIZE; off < size; off += PAGE_SIZE) {
+		uintptr_t phys;
+		if (as_get_physical_mapping(area + off, &phys) != EOK)
+			return false;
+		if (phys != first + off)
+			return false;
+	}
+
+	return true;
+}
+
+const char *test_largepage1(void)
+{
+	uint64_t before = large_pages_mapped();
+
+	TPRINTF("Creating AS area...\n");
+	uint8_t *area = as_area_create(AS_AREA_ANY, AREA_SIZE,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE |
+	    AS_AREA_LARGE_PAGES, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return "Cannot allocate memory";
+
+	fill_area(area, AREA_SIZE);
+
+	const char *err = verify_area(area, AREA_SIZE);
+	if (err != NULL)
+		return err;
+
+	uint64_t mapped = large_pages_mapped() - before;
+	TPRINTF("Large pages mapped: %" PRIu64 "\n", mapped);
+
+	if (mapped > 0) {
+		if (((uintptr_t) area % LARGE_PAGE_SIZE) != 0)
+			return "Area is not aligned to large page size";
+
+		if (!is_contiguous(area, LARGE_PAGE_SIZE))
+			return "Large page is not physically contiguous";
+	}
+
+	/* Shrinking the area splits the second large page. */
+	TPRINTF("Shrinking AS area...\n");
+	errno_t rc = as_area_resize(area, SHRUNK_SIZE, 0);
+	if (rc != EOK)
+		return "Failed to resize AS area";
+
+	err = verify_area(area, SHRUNK_SIZE);
+	if (err != NULL)
+		return err;
+
+	rc = as_get_physical_mapping(area + SHRUNK_SIZE, NULL);
+	if (rc != ENOENT)
+		return "Mapping beyond the shrunk area still exists";
+
+	rc = as_area_destroy(area);
+	if (rc != EOK)
+		return "Failed to destroy AS area";
+
+	rc = as_get_physical_mapping(area, NULL);
+	if (rc != ENOENT)
+		return "Mapping of destroyed area still exists";
+
+	return NULL;
+}
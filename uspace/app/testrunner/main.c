@@ -26,17 +26,124 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+/** @file Unit test runner.
+ *
+ * Runs the tester suite and all pcut test binaries found in /test. The pcut
+ * binaries are independent of each other and are run concurrently by a pool
+ * of worker fibrils, each test writing into its own log file. For every test
+ * the wall time and (sampled) CPU time are recorded and the slowest tests are
+ * reported at the end.
+ */
+
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inttypes.h>
+#include <stats.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str_error.h>
 #include <task.h>
+#include <time.h>
 #include <vfs/vfs.h>
 #include <dirent.h>
 #include <str.h>
 
+#define NAME  "testrunner"
+
+/** Default per-test timeout in seconds */
+#define DEFAULT_TIMEOUT  300
+
+/** Interval at which running tests are sampled for CPU usage */
+#define SAMPLE_USEC  100000
+
+/** Number of entries in the slowest tests report */
+#define SLOWEST_COUNT  10
+
+typedef enum {
+	test_ok,
+	test_failed,
+	test_crashed,
+	test_timeout,
+	test_error
+} test_status_t;
+
+/** Result of running one test binary */
+typedef struct {
+	/** Test name */
+	char *name;
+	/** Outcome */
+	test_status_t status;
+	/** Wall clock time in microseconds */
+	usec_t wall_usec;
+	/** CPU time in microseconds */
+	usec_t cpu_usec;
+} test_result_t;
+
+/** Per-test timeout in microseconds */
+static usec_t timeout_usec = SEC2USEC(DEFAULT_TIMEOUT);
+
+/** CPU frequency used to convert cycles to time, 0 if unknown */
+static uint16_t cpu_freq_mhz;
+
+/** Pool of pcut tests */
+typedef struct {
+	/** Protects the fields below */
+	fibril_mutex_t lock;
+	/** Signalled when a worker finishes */
+	fibril_condvar_t done_cv;
+	/** Tests to run */
+	test_result_t *tests;
+	/** Number of tests */
+	size_t count;
+	/** Index of the next test to run */
+	size_t next;
+	/** Number of workers still running */
+	size_t workers;
+} test_pool_t;
+
+static const char *test_status_str(test_status_t status)
+{
+	switch (status) {
+	case test_ok:
+		return "ok";
+	case test_failed:
+		return "FAILED";
+	case test_crashed:
+		return "CRASHED";
+	case test_timeout:
+		return "TIMED OUT";
+	case test_error:
+		break;
+	}
+
+	return "ERROR";
+}
+
+/** Get CPU cycles consumed so far by a task.
+ *
+ * @return Number of cycles or 0 if the task no longer exists
+ */
+static uint64_t task_cycles(task_id_t id)
+{
+	stats_task_t *stats = stats_get_task(id);
+	if (stats == NULL)
+		return 0;
+
+	uint64_t cycles = stats->ucycles + stats->kcycles;
+	free(stats);
+	return cycles;
+}
+
+/** Run a test binary and wait for it to finish.
+ *
+ * The task is killed if it does not finish within the test timeout. While
+ * the task runs its CPU usage is sampled, so the CPU time reported in
+ * @a result does not include the last sampling interval.
+ */
 static errno_t run_test(const char *logfile, const char *logmode,
-    const char *path, const char *const args[], task_exit_t *ex, int *retval)
+    const char *path, const char *const args[], task_exit_t *ex, int *retval,
+    test_result_t *result)
 {
 	FILE *f = fopen(logfile, logmode);
 	if (!f) {
@@ -56,6 +163,10 @@ static errno_t run_test(const char *logfile, const char *logmode,
 
 	task_id_t id;
 	task_wait_t wait;
+	struct timespec start;
+	struct timespec now;
+
+	getuptime(&start);
 
 	rc = task_spawnvf(&id, &wait, path, args, -1, h, h);
 	if (rc != EOK) {
@@ -65,7 +176,29 @@ static errno_t run_test(const char *logfile, const char *logmode,
 		return rc;
 	}
 
-	rc = task_wait(&wait, ex, retval);
+	uint64_t cycles = 0;
+	bool killed = false;
+
+	while (true) {
+		rc = task_wait_timeout(&wait, SAMPLE_USEC, ex, retval);
+		if (rc != ETIMEOUT)
+			break;
+
+		uint64_t c = task_cycles(id);
+		if (c > cycles)
+			cycles = c;
+
+		getuptime(&now);
+		if (!killed &&
+		    NSEC2USEC(ts_sub_diff(&now, &start)) > timeout_usec) {
+			fprintf(stderr, "%s: timed out, killing\n", path);
+			(void) task_kill(id);
+			killed = true;
+		}
+	}
+
+	getuptime(&now);
+
 	if (rc != EOK) {
 		fprintf(stderr, "Task wait failed: %s\n",
 		    str_error_name(rc));
@@ -73,6 +206,13 @@ static errno_t run_test(const char *logfile, const char *logmode,
 		return rc;
 	}
 
+	if (result != NULL) {
+		result->wall_usec = NSEC2USEC(ts_sub_diff(&now, &start));
+		result->cpu_usec = cpu_freq_mhz != 0 ? cycles / cpu_freq_mhz : 0;
+		if (killed)
+			result->status = test_timeout;
+	}
+
 	// TODO: check that we are managing resources correctly
 	fclose(f);
 	return EOK;
@@ -119,7 +259,8 @@ static void run_tester(const char *logfile)
 
 	for (int i = 0; i < tests_count; i++) {
 		const char *const args[] = { app, tests[i], NULL };
-		errno_t rc = run_test(logfile, "a", app, args, &ex, &retval);
+		errno_t rc = run_test(logfile, "a", app, args, &ex, &retval,
+		    NULL);
 		if (rc != EOK) {
 			/* Reason already printed in run_test(). */
 			continue;
@@ -150,7 +291,7 @@ static void run_tester_fault(const char *logfile)
 
 	const char *app = "/app/tester";
 	const char *const args[] = { app, "fault1", NULL };
-	errno_t rc = run_test(logfile, "w", app, args, &ex, &retval);
+	errno_t rc = run_test(logfile, "w", app, args, &ex, &retval, NULL);
 	if (rc != EOK) {
 		/* Reason already printed in run_test(). */
 		return;
@@ -165,13 +306,81 @@ static void run_tester_fault(const char *logfile)
 	printf("`tester fault1`: terminated as expected\n");
 }
 
-static void run_pcut_tests(void)
+/** Run one pcut test binary. */
+static void run_pcut_test(test_result_t *test)
+{
+	task_exit_t ex;
+	int retval;
+
+	char *bin;
+	if (asprintf(&bin, "/test/%s", test->name) < 0) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	char *logfile;
+	if (asprintf(&logfile, "/data/web/result-%s.txt", test->name) < 0) {
+		fprintf(stderr, "out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	const char *const args[] = { bin, NULL };
+	test->status = test_ok;
+	errno_t rc = run_test(logfile, "w", bin, args, &ex, &retval, test);
+	free(bin);
+	free(logfile);
+
+	if (rc != EOK) {
+		/* Reason already printed in run_test(). */
+		test->status = test_error;
+	} else if (test->status == test_timeout) {
+		/* Killed by run_test() */
+	} else if (ex != TASK_EXIT_NORMAL) {
+		test->status = test_crashed;
+	} else if (retval != 0) {
+		test->status = test_failed;
+	}
+
+	printf("%s %s (%" PRIu64 " ms)\n", test->name,
+	    test_status_str(test->status), (uint64_t) test->wall_usec / 1000);
+}
+
+/** Worker fibril running tests from the pool until it is empty. */
+static errno_t pcut_worker(void *arg)
+{
+	test_pool_t *pool = (test_pool_t *) arg;
+
+	fibril_mutex_lock(&pool->lock);
+
+	while (pool->next < pool->count) {
+		test_result_t *test = &pool->tests[pool->next++];
+
+		fibril_mutex_unlock(&pool->lock);
+		run_pcut_test(test);
+		fibril_mutex_lock(&pool->lock);
+	}
+
+	--pool->workers;
+	fibril_condvar_broadcast(&pool->done_cv);
+	fibril_mutex_unlock(&pool->lock);
+	return EOK;
+}
+
+/** List pcut test binaries.
+ *
+ * @param rcount Place to store number of tests
+ * @return Array of tests, NULL if there are none or on failure
+ */
+static test_result_t *list_pcut_tests(size_t *rcount)
 {
-	printf("Running all pcut tests...\n");
+	test_result_t *tests = NULL;
+	size_t count = 0;
+
+	*rcount = 0;
 
 	DIR *d = opendir("/test");
 	if (!d)
-		return;
+		return NULL;
 
 	struct dirent *e;
 
@@ -179,47 +388,117 @@ static void run_pcut_tests(void)
 		if (str_lcmp(e->d_name, "test-", 5) != 0)
 			continue;
 
-		task_exit_t ex;
-		int retval;
-
-		char *bin;
-		if (asprintf(&bin, "/test/%s", e->d_name) < 0) {
+		test_result_t *ntests = realloc(tests,
+		    (count + 1) * sizeof(test_result_t));
+		if (ntests == NULL) {
 			fprintf(stderr, "out of memory\n");
 			exit(EXIT_FAILURE);
 		}
 
-		char *logfile;
-		if (asprintf(&logfile, "/data/web/result-%s.txt", e->d_name) < 0) {
+		tests = ntests;
+		tests[count].name = str_dup(e->d_name);
+		if (tests[count].name == NULL) {
 			fprintf(stderr, "out of memory\n");
 			exit(EXIT_FAILURE);
 		}
 
-		const char *const args[] = { bin, NULL };
-		errno_t rc = run_test(logfile, "w", bin, args, &ex, &retval);
-		free(bin);
-		free(logfile);
+		tests[count].status = test_error;
+		tests[count].wall_usec = 0;
+		tests[count].cpu_usec = 0;
+		++count;
+	}
+
+	closedir(d);
 
-		if (rc != EOK) {
-			/* Reason already printed in run_test(). */
-			return;
-		}
+	*rcount = count;
+	return tests;
+}
 
-		if (ex != TASK_EXIT_NORMAL) {
-			fprintf(stderr, "%s CRASHED\n", e->d_name);
-			return;
-		}
+/** Run all pcut tests using a pool of @a jobs workers. */
+static test_result_t *run_pcut_tests(size_t jobs, size_t *rcount)
+{
+	test_pool_t pool;
 
-		if (retval == 0) {
-			printf("%s ok\n", e->d_name);
-		} else {
-			printf("%s FAILED\n", e->d_name);
+	printf("Running all pcut tests (%zu jobs)...\n", jobs);
+
+	fibril_mutex_initialize(&pool.lock);
+	fibril_condvar_initialize(&pool.done_cv);
+	pool.tests = list_pcut_tests(&pool.count);
+	pool.next = 0;
+	pool.workers = 0;
+
+	for (size_t i = 0; i < jobs && i < pool.count; i++) {
+		fid_t fid = fibril_create(pcut_worker, &pool);
+		if (fid == 0) {
+			fprintf(stderr, "Failed creating worker fibril\n");
+			break;
 		}
+
+		fibril_mutex_lock(&pool.lock);
+		++pool.workers;
+		fibril_mutex_unlock(&pool.lock);
+
+		fibril_add_ready(fid);
 	}
 
-	closedir(d);
+	/* Run the tests in this fibril if no worker could be created */
+	if (pool.workers == 0)
+		(void) pcut_worker(&pool);
+
+	fibril_mutex_lock(&pool.lock);
+	while (pool.workers > 0)
+		fibril_condvar_wait(&pool.done_cv, &pool.lock);
+	fibril_mutex_unlock(&pool.lock);
+
+	*rcount = pool.count;
+	return pool.tests;
+}
+
+static int test_wall_cmp(const void *a, const void *b)
+{
+	const test_result_t *ta = (const test_result_t *) a;
+	const test_result_t *tb = (const test_result_t *) b;
+
+	if (ta->wall_usec > tb->wall_usec)
+		return -1;
+	if (ta->wall_usec < tb->wall_usec)
+		return 1;
+	return 0;
+}
+
+/** Print summary and the slowest tests.
+ *
+ * Sorts @a tests by wall time.
+ */
+static void print_report(test_result_t *tests, size_t count,
+    usec_t total_usec)
+{
+	size_t failed = 0;
+	usec_t sum_usec = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (tests[i].status != test_ok)
+			++failed;
+		sum_usec += tests[i].wall_usec;
+	}
+
+	printf("pcut: %zu tests, %zu failed, %" PRIu64 " ms elapsed, "
+	    "%" PRIu64 " ms total test time\n", count, failed,
+	    (uint64_t) total_usec / 1000, (uint64_t) sum_usec / 1000);
+
+	qsort(tests, count, sizeof(test_result_t), test_wall_cmp);
+
+	printf("Slowest tests:\n");
+	printf("  %10s %10s  %s\n", "wall [ms]", "cpu [ms]", "test");
+
+	for (size_t i = 0; i < count && i < SLOWEST_COUNT; i++) {
+		printf("  %10" PRIu64 " %10" PRIu64 "  %s\n",
+		    (uint64_t) tests[i].wall_usec / 1000,
+		    (uint64_t) tests[i].cpu_usec / 1000, tests[i].name);
+	}
 }
 
-static void gen_index(const char *fname)
+static void gen_index(const char *fname, test_result_t *tests, size_t count)
 {
 	FILE *f = fopen(fname, "w");
 	if (!f) {
@@ -234,31 +513,82 @@ static void gen_index(const char *fname)
 
 	fprintf(f, "<li><a href=\"result-tester.txt\">tester</a></li>\n");
 
-	DIR *d = opendir("/test");
-	if (d) {
-		struct dirent *e;
-
-		while ((e = readdir(d))) {
-			if (str_lcmp(e->d_name, "test-", 5) != 0)
-				continue;
-
-			fprintf(f, "<li><a href=\"result-%s.txt\">%s"
-			    "</a></li>\n", e->d_name, e->d_name);
-		}
+	for (size_t i = 0; i < count; i++) {
+		fprintf(f, "<li><a href=\"result-%s.txt\">%s</a> %s "
+		    "(wall %" PRIu64 " ms, cpu %" PRIu64 " ms)</li>\n",
+		    tests[i].name, tests[i].name,
+		    test_status_str(tests[i].status),
+		    (uint64_t) tests[i].wall_usec / 1000,
+		    (uint64_t) tests[i].cpu_usec / 1000);
 	}
 
 	fprintf(f, "</ul></body></html>\n");
 	fclose(f);
 }
 
+static void print_syntax(void)
+{
+	printf("Syntax: %s [-j <jobs>] [-t <timeout>]\n", NAME);
+	printf("\t-j <jobs>     Number of pcut tests to run in parallel "
+	    "(default: number of CPUs)\n");
+	printf("\t-t <timeout>  Per-test timeout in seconds (default: %d)\n",
+	    DEFAULT_TIMEOUT);
+}
+
 int main(int argc, char **argv)
 {
+	size_t cpus = 0;
+	stats_cpu_t *cpu_stats = stats_get_cpus(&cpus);
+	if (cpu_stats != NULL) {
+		if (cpus > 0)
+			cpu_freq_mhz = cpu_stats[0].frequency_mhz;
+		free(cpu_stats);
+	}
+
+	size_t jobs = cpus > 0 ? cpus : 1;
+
+	for (int i = 1; i < argc; i++) {
+		uint32_t val;
+
+		if (i + 1 >= argc ||
+		    str_uint32_t(argv[i + 1], NULL, 10, true, &val) != EOK ||
+		    val == 0) {
+			print_syntax();
+			return EXIT_FAILURE;
+		}
+
+		if (str_cmp(argv[i], "-j") == 0) {
+			jobs = val;
+		} else if (str_cmp(argv[i], "-t") == 0) {
+			timeout_usec = SEC2USEC(val);
+		} else {
+			print_syntax();
+			return EXIT_FAILURE;
+		}
+
+		++i;
+	}
+
 	run_tester("/data/web/result-tester.txt");
 	run_tester_fault("/tmp/tester_fault.log");
-	run_pcut_tests();
+
+	struct timespec start;
+	struct timespec end;
+	size_t count;
+
+	getuptime(&start);
+	test_result_t *tests = run_pcut_tests(jobs, &count);
+	getuptime(&end);
+
+	print_report(tests, count, NSEC2USEC(ts_sub_diff(&end, &start)));
 
 	const char *fname = "/data/web/test.html";
 	printf("Generating HTML report in %s\n", fname);
-	gen_index(fname);
+	gen_index(fname, tests, count);
+
+	for (size_t i = 0; i < count; i++)
+		free(tests[i].name);
+	free(tests);
+
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup webload
+ * @{
+ */
+/** @file HTTP load generator.
+ *
+ * Sends GET requests to a local web server from a number of concurrent
+ * clients and reports the number of requests served per second.
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <getopt.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/tcp.h>
+#include <inttypes.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <time.h>
+
+#define NAME "webload"
+
+/** Default number of requests */
+#define DEFAULT_REQUESTS 1000
+/** Default number of concurrent clients */
+#define DEFAULT_CLIENTS 8
+/** Default server port */
+#define DEFAULT_PORT 8080
+
+/** Size of client receive buffer */
+#define RBUF_SIZE 65536
+/** Maximum length of response header line */
+#define LINE_MAX 1024
+
+/** Load generator client */
+typedef struct {
+	/** Connection to server or @c NULL */
+	tcp_conn_t *conn;
+	/** Receive buffer */
+	char *rbuf;
+	/** Read position in receive buffer */
+	size_t rbuf_out;
+	/** Number of valid bytes in receive buffer */
+	size_t rbuf_in;
+} client_t;
+
+static tcp_t *tcp;
+static inet_ep2_t server_epp;
+static char *request;
+static size_t request_size;
+static bool keep_alive = true;
+
+static FIBRIL_MUTEX_INITIALIZE(load_lock);
+static FIBRIL_CONDVAR_INITIALIZE(load_cv);
+/** Number of requests not yet started */
+static size_t req_left;
+/** Number of requests completed successfully */
+static size_t req_done;
+/** Number of failed requests */
+static size_t req_failed;
+/** Number of body bytes received */
+static uint64_t bytes_recv;
+/** Number of connections opened */
+static size_t conn_opened;
+/** Number of clients still running */
+static size_t clients_active;
+
+static const char *short_options = "c:kn:p:";
+
+static void print_syntax(void)
+{
+	printf("Syntax: %s [<options>] [<path>]\n", NAME);
+	printf("\t-n <count>   Number of requests (default %u)\n",
+	    DEFAULT_REQUESTS);
+	printf("\t-c <count>   Number of concurrent clients (default %u)\n",
+	    DEFAULT_CLIENTS);
+	printf("\t-p <port>    Server port (default %u)\n", DEFAULT_PORT);
+	printf("\t-k           Do not use persistent connections\n");
+}
+
+/** Get current time in microseconds. */
+static usec_t webload_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+/** Make sure there is some data in client receive buffer. */
+static errno_t client_fill(client_t *client)
+{
+	size_t nrecv;
+	errno_t rc;
+
+	if (client->rbuf_out < client->rbuf_in)
+		return EOK;
+
+	rc = tcp_conn_recv_wait(client->conn, client->rbuf, RBUF_SIZE,
+	    &nrecv);
+	if (rc != EOK)
+		return rc;
+
+	if (nrecv == 0) {
+		/* Connection closed by server */
+		return EIO;
+	}
+
+	client->rbuf_out = 0;
+	client->rbuf_in = nrecv;
+	return EOK;
+}
+
+/** Receive response header line (without line terminator). */
+static errno_t client_recv_line(client_t *client, char *line)
+{
+	size_t len = 0;
+	char *start;
+	char *nl;
+	size_t n;
+	errno_t rc;
+
+	while (true) {
+		rc = client_fill(client);
+		if (rc != EOK)
+			return rc;
+
+		start = client->rbuf + client->rbuf_out;
+		nl = memchr(start, '\n', client->rbuf_in - client->rbuf_out);
+		n = (nl != NULL) ? (size_t) (nl - start) + 1 :
+		    client->rbuf_in - client->rbuf_out;
+
+		if (len + n > LINE_MAX)
+			return ELIMIT;
+
+		memcpy(line + len, start, n);
+		len += n;
+		client->rbuf_out += n;
+
+		if (nl != NULL)
+			break;
+	}
+
+	--len;
+	if (len > 0 && line[len - 1] == '\r')
+		--len;
+	line[len] = '\0';
+	return EOK;
+}
+
+/** Receive response and discard its body.
+ *
+ * @param client Client
+ * @param rclose Place to store @c true if server will close connection
+ * @param rsize Place to store body size
+ */
+static errno_t client_recv_response(client_t *client, bool *rclose,
+    size_t *rsize)
+{
+	char line[LINE_MAX + 1];
+	char *value;
+	size_t length = 0;
+	size_t n;
+	bool close = !keep_alive;
+	errno_t rc;
+
+	rc = client_recv_line(client, line);
+	if (rc != EOK)
+		return rc;
+
+	if (str_lcmp(line, "HTTP/1.1 200 ", 13) != 0 &&
+	    str_lcmp(line, "HTTP/1.0 200 ", 13) != 0) {
+		printf("Unexpected response '%s'.\n", line);
+		return EIO;
+	}
+
+	while (true) {
+		rc = client_recv_line(client, line);
+		if (rc != EOK)
+			return rc;
+
+		if (line[0] == '\0')
+			break;
+
+		if (str_lcasecmp(line, "Content-Length:", 15) == 0) {
+			value = line + 15;
+			while (*value == ' ')
+				++value;
+			rc = str_size_t(value, NULL, 10, true, &length);
+			if (rc != EOK)
+				return EIO;
+		} else if (str_lcasecmp(line, "Connection:", 11) == 0) {
+			value = line + 11;
+			while (*value == ' ')
+				++value;
+			if (str_casecmp(value, "close") == 0)
+				close = true;
+		}
+	}
+
+	/* Skip body */
+	*rsize = length;
+	while (length > 0) {
+		rc = client_fill(client);
+		if (rc != EOK)
+			return rc;
+
+		n = min(length, client->rbuf_in - client->rbuf_out);
+		client->rbuf_out += n;
+		length -= n;
+	}
+
+	*rclose = close;
+	return EOK;
+}
+
+/** Close client connection. */
+static void client_close(client_t *client)
+{
+	tcp_conn_destroy(client->conn);
+	client->conn = NULL;
+	client->rbuf_out = 0;
+	client->rbuf_in = 0;
+}
+
+/** Perform one request.
+ *
+ * @param client Client
+ * @param rsize Place to store response body size
+ */
+static errno_t client_request(client_t *client, size_t *rsize)
+{
+	bool close;
+	errno_t rc;
+
+	if (client->conn == NULL) {
+		rc = tcp_conn_create(tcp, &server_epp, NULL, NULL,
+		    &client->conn);
+		if (rc != EOK)
+			return rc;
+
+		rc = tcp_conn_wait_connected(client->conn);
+		if (rc != EOK) {
+			client_close(client);
+			return rc;
+		}
+
+		fibril_mutex_lock(&load_lock);
+		++conn_opened;
+		fibril_mutex_unlock(&load_lock);
+	}
+
+	rc = tcp_conn_send(client->conn, request, request_size);
+	if (rc != EOK) {
+		client_close(client);
+		return rc;
+	}
+
+	rc = client_recv_response(client, &close, rsize);
+	if (rc != EOK || close)
+		client_close(client);
+
+	return rc;
+}
+
+/** Client fibril. Performs requests until there are none left. */
+static errno_t client_fibril(void *arg)
+{
+	client_t client;
+	size_t size;
+	errno_t rc;
+
+	memset(&client, 0, sizeof(client));
+	client.rbuf = malloc(RBUF_SIZE);
+
+	fibril_mutex_lock(&load_lock);
+
+	while (client.rbuf != NULL && req_left > 0) {
+		--req_left;
+		fibril_mutex_unlock(&load_lock);
+
+		rc = client_request(&client, &size);
+
+		fibril_mutex_lock(&load_lock);
+		if (rc == EOK) {
+			++req_done;
+			bytes_recv += size;
+		} else {
+			++req_failed;
+		}
+	}
+
+	if (client.rbuf == NULL)
+		++req_failed;
+
+	--clients_active;
+	fibril_condvar_broadcast(&load_cv);
+	fibril_mutex_unlock(&load_lock);
+
+	if (client.conn != NULL)
+		client_close(&client);
+	free(client.rbuf);
+	return EOK;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *path = "/";
+	size_t requests = DEFAULT_REQUESTS;
+	size_t clients = DEFAULT_CLIENTS;
+	uint16_t port = DEFAULT_PORT;
+	usec_t start, stop;
+	fid_t fid;
+	size_t i;
+	int c;
+	errno_t rc;
+
+	while ((c = getopt(argc, argv, short_options)) != -1) {
+		switch (c) {
+		case 'c':
+			rc = str_size_t(optarg, NULL, 10, true, &clients);
+			if (rc != EOK || clients == 0) {
+				printf("Invalid number of clients.\n");
+				print_syntax();
+				return 1;
+			}
+			break;
+		case 'k':
+			keep_alive = false;
+			break;
+		case 'n':
+			rc = str_size_t(optarg, NULL, 10, true, &requests);
+			if (rc != EOK || requests == 0) {
+				printf("Invalid number of requests.\n");
+				print_syntax();
+				return 1;
+			}
+			break;
+		case 'p':
+			rc = str_uint16_t(optarg, NULL, 10, true, &port);
+			if (rc != EOK || port == 0) {
+				printf("Invalid port number.\n");
+				print_syntax();
+				return 1;
+			}
+			break;
+		default:
+			printf("Unknown option passed.\n");
+			print_syntax();
+			return 1;
+		}
+	}
+
+	if (optind < argc)
+		path = argv[optind++];
+
+	if (optind < argc || path[0] != '/') {
+		print_syntax();
+		return 1;
+	}
+
+	if (asprintf(&request, "GET %s HTTP/1.1\r\n"
+	    "Host: localhost\r\n"
+	    "Connection: %s\r\n"
+	    "\r\n", path, keep_alive ? "keep-alive" : "close") < 0) {
+		printf("Out of memory.\n");
+		return 1;
+	}
+
+	request_size = str_size(request);
+
+	rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		printf("Error initializing TCP: %s.\n", str_error(rc));
+		free(request);
+		return 1;
+	}
+
+	inet_ep2_init(&server_epp);
+	inet_addr(&server_epp.remote.addr, 127, 0, 0, 1);
+	server_epp.remote.port = port;
+
+	printf("Sending %zu requests for '%s' from %zu clients%s...\n",
+	    requests, path, clients, keep_alive ? "" :
+	    " (no persistent connections)");
+
+	req_left = requests;
+	start = webload_now();
+
+	fibril_mutex_lock(&load_lock);
+
+	for (i = 0; i < clients; i++) {
+		fid = fibril_create(client_fibril, NULL);
+		if (fid == 0) {
+			printf("Error creating client fibril.\n");
+			break;
+		}
+
+		++clients_active;
+		fibril_add_ready(fid);
+	}
+
+	while (clients_active > 0)
+		fibril_condvar_wait(&load_cv, &load_lock);
+
+	fibril_mutex_unlock(&load_lock);
+
+	stop = webload_now();
+
+	printf("%zu requests completed, %zu failed, %zu connections opened "
+	    "in %" PRIu64 " ms.\n", req_done, req_failed, conn_opened,
+	    (uint64_t) ((stop - start) / 1000));
+
+	if (stop > start) {
+		printf("%" PRIu64 " requests/s, %" PRIu64 " KiB/s.\n",
+		    (uint64_t) ((usec_t) req_done * 1000000 / (stop - start)),
+		    (uint64_t) (bytes_recv * 1000000 / 1024 /
+		    (uint64_t) (stop - start)));
+	}
+
+	tcp_destroy(tcp);
+	free(request);
+	return req_failed == 0 ? 0 : 1;
+}
+
+/** @}
+ */
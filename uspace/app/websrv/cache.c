@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup websrv
+ * @{
+ */
+/**
+ * @file In-memory cache of served files.
+ *
+ * Keeps contents of recently served small files in memory so that they
+ * can be sent without going through VFS. Entries are looked up by file
+ * name in a hash table and evicted in LRU order when the cache exceeds
+ * its size limit. Since VFS does not provide modification times, entries
+ * are simply reloaded once they are older than CACHE_TTL.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <str.h>
+#include <time.h>
+
+#include "cache.h"
+
+/** Time after which cached file is reloaded */
+#define CACHE_TTL SEC2USEC(5)
+
+/** Protects the cache */
+static FIBRIL_MUTEX_INITIALIZE(cache_lock);
+/** Cached files by name */
+static hash_table_t cache_map;
+/** Cached files, most recently used first */
+static LIST_INITIALIZE(cache_lru);
+/** Total size of cached files */
+static size_t cache_size;
+/** Maximum total size of cached files */
+static size_t cache_size_max;
+/** Maximum size of a single cached file */
+static size_t cache_fsize_max;
+
+static size_t cache_name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != '\0')
+		hash = hash_combine(hash, (uint8_t) *name++);
+
+	return hash;
+}
+
+static size_t cache_hash(const ht_link_t *item)
+{
+	cache_entry_t *entry = hash_table_get_inst(item, cache_entry_t, lmap);
+
+	return cache_name_hash(entry->fname);
+}
+
+static size_t cache_key_hash(const void *key)
+{
+	return cache_name_hash((const char *) key);
+}
+
+static bool cache_key_equal(const void *key, const ht_link_t *item)
+{
+	cache_entry_t *entry = hash_table_get_inst(item, cache_entry_t, lmap);
+
+	return str_cmp(entry->fname, (const char *) key) == 0;
+}
+
+static hash_table_ops_t cache_map_ops = {
+	.hash = cache_hash,
+	.key_hash = cache_key_hash,
+	.key_equal = cache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static usec_t cache_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+static void cache_entry_free(cache_entry_t *entry)
+{
+	free(entry->fname);
+	free(entry->data);
+	free(entry);
+}
+
+/** Remove entry from cache.
+ *
+ * The entry is freed once the last user releases it.
+ * Must be called with cache lock held.
+ *
+ * @param entry Cache entry
+ */
+static void cache_remove(cache_entry_t *entry)
+{
+	assert(fibril_mutex_is_locked(&cache_lock));
+	assert(entry->cached);
+
+	hash_table_remove_item(&cache_map, &entry->lmap);
+	list_remove(&entry->llru);
+	cache_size -= entry->size;
+	entry->cached = false;
+
+	if (entry->refcnt == 0)
+		cache_entry_free(entry);
+}
+
+/** Evict least recently used entries until @a size bytes fit in cache.
+ *
+ * Must be called with cache lock held.
+ *
+ * @param size Number of bytes to make room for
+ */
+static void cache_evict(size_t size)
+{
+	cache_entry_t *entry;
+
+	assert(fibril_mutex_is_locked(&cache_lock));
+
+	while (cache_size + size > cache_size_max && !list_empty(&cache_lru)) {
+		entry = list_get_instance(list_last(&cache_lru), cache_entry_t,
+		    llru);
+		cache_remove(entry);
+	}
+}
+
+/** Initialize file cache.
+ *
+ * @param size_max Maximum total size of cached files (zero disables cache)
+ * @param fsize_max Maximum size of a single cached file
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t cache_init(size_t size_max, size_t fsize_max)
+{
+	if (!hash_table_create(&cache_map, 0, 0, &cache_map_ops))
+		return ENOMEM;
+
+	cache_size_max = size_max;
+	cache_fsize_max = min(fsize_max, size_max);
+	return EOK;
+}
+
+/** Get maximum size of a file that can be cached.
+ *
+ * @return Maximum file size in bytes
+ */
+size_t cache_file_max(void)
+{
+	return cache_fsize_max;
+}
+
+/** Find file in cache.
+ *
+ * @param fname File name
+ * @return Cache entry (to be released by cache_release()) or @c NULL
+ *         if the file is not cached or the entry is stale
+ */
+cache_entry_t *cache_find(const char *fname)
+{
+	cache_entry_t *entry;
+	ht_link_t *link;
+
+	fibril_mutex_lock(&cache_lock);
+
+	link = hash_table_find(&cache_map, fname);
+	if (link == NULL) {
+		fibril_mutex_unlock(&cache_lock);
+		return NULL;
+	}
+
+	entry = hash_table_get_inst(link, cache_entry_t, lmap);
+	if (cache_now() - entry->loaded > CACHE_TTL) {
+		cache_remove(entry);
+		fibril_mutex_unlock(&cache_lock);
+		return NULL;
+	}
+
+	/* Move to the front of LRU list */
+	list_remove(&entry->llru);
+	list_prepend(&entry->llru, &cache_lru);
+	++entry->refcnt;
+
+	fibril_mutex_unlock(&cache_lock);
+	return entry;
+}
+
+/** Insert file into cache.
+ *
+ * On success the cache takes ownership of @a data. Any previous entry
+ * for the same file is replaced.
+ *
+ * @param fname File name
+ * @param data File contents
+ * @param size File size
+ * @param rentry Place to store new entry (to be released by
+ *               cache_release())
+ *
+ * @return EOK on success, EFBIG if the file is too large to be cached,
+ *         ENOMEM if out of memory
+ */
+errno_t cache_insert(const char *fname, void *data, size_t size,
+    cache_entry_t **rentry)
+{
+	cache_entry_t *entry;
+	ht_link_t *link;
+
+	if (size > cache_fsize_max)
+		return EFBIG;
+
+	entry = calloc(1, sizeof(cache_entry_t));
+	if (entry == NULL)
+		return ENOMEM;
+
+	entry->fname = str_dup(fname);
+	if (entry->fname == NULL) {
+		free(entry);
+		return ENOMEM;
+	}
+
+	entry->data = data;
+	entry->size = size;
+	entry->loaded = cache_now();
+	entry->refcnt = 1;
+	entry->cached = true;
+
+	fibril_mutex_lock(&cache_lock);
+
+	link = hash_table_find(&cache_map, fname);
+	if (link != NULL)
+		cache_remove(hash_table_get_inst(link, cache_entry_t, lmap));
+
+	cache_evict(size);
+
+	hash_table_insert(&cache_map, &entry->lmap);
+	list_prepend(&entry->llru, &cache_lru);
+	cache_size += size;
+
+	fibril_mutex_unlock(&cache_lock);
+
+	*rentry = entry;
+	return EOK;
+}
+
+/** Release cache entry.
+ *
+ * @param entry Cache entry obtained by cache_find() or cache_insert()
+ */
+void cache_release(cache_entry_t *entry)
+{
+	fibril_mutex_lock(&cache_lock);
+
+	assert(entry->refcnt > 0);
+	--entry->refcnt;
+
+	if (entry->refcnt == 0 && !entry->cached)
+		cache_entry_free(entry);
+
+	fibril_mutex_unlock(&cache_lock);
+}
+
+/** @}
+ */
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup websrv
+ * @{
+ */
+/**
+ * @file In-memory cache of served files.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/** Cached file */
+typedef struct {
+	/** Link to cache map */
+	ht_link_t lmap;
+	/** Link to LRU list */
+	link_t llru;
+	/** File name */
+	char *fname;
+	/** File contents */
+	void *data;
+	/** File size */
+	size_t size;
+	/** Time when the file was loaded (uptime in usec) */
+	usec_t loaded;
+	/** Number of users holding the entry */
+	size_t refcnt;
+	/** Entry is in the cache map */
+	bool cached;
+} cache_entry_t;
+
+extern errno_t cache_init(size_t, size_t);
+extern size_t cache_file_max(void);
+extern cache_entry_t *cache_find(const char *);
+extern errno_t cache_insert(const char *, void *, size_t, cache_entry_t **);
+extern void cache_release(cache_entry_t *);
+
+#endif
+
+/** @}
+ */
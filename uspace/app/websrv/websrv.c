@@ -50,9 +50,12 @@
 
 #include <arg_parse.h>
 #include <macros.h>
+#include <mem.h>
 #include <str.h>
 #include <str_error.h>
 
+#include "cache.h"
+
 #define NAME  "websrv"
 
 #define DEFAULT_PORT  8080
@@ -60,7 +63,16 @@
 #define WEB_ROOT  "/data/web"
 
 /** Buffer for receiving the request. */
-#define BUFFER_SIZE  1024
+#define BUFFER_SIZE  4096
+
+/** Default maximum total size of cached files in KiB. */
+#define DEFAULT_CACHE_SIZE  4096
+
+/** Maximum size of a single cached file. */
+#define CACHE_FILE_MAX  (256 * 1024)
+
+/** Maximum number of requests served over one connection. */
+#define KEEPALIVE_MAX  100
 
 static void websrv_new_conn(tcp_listener_t *, tcp_conn_t *);
 
@@ -73,6 +85,7 @@ static tcp_cb_t conn_cb = {
 };
 
 static uint16_t port = DEFAULT_PORT;
+static size_t cache_size = DEFAULT_CACHE_SIZE;
 
 typedef struct {
 	tcp_conn_t *conn;
@@ -83,19 +96,16 @@ typedef struct {
 
 	char lbuf[BUFFER_SIZE + 1];
 	size_t lbuf_used;
+
+	/** Connection was closed by the client */
+	bool eof;
 } recv_t;
 
 static bool verbose = false;
 
 /** Responses to send to client. */
 
-static const char *msg_ok =
-    "HTTP/1.0 200 OK\r\n"
-    "\r\n";
-
 static const char *msg_bad_request =
-    "HTTP/1.0 400 Bad Request\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>400 Bad Request</title>\r\n"
@@ -107,8 +117,6 @@ static const char *msg_bad_request =
     "</html>\r\n";
 
 static const char *msg_not_found =
-    "HTTP/1.0 404 Not Found\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>404 Not Found</title>\r\n"
@@ -120,8 +128,6 @@ static const char *msg_not_found =
     "</html>\r\n";
 
 static const char *msg_not_implemented =
-    "HTTP/1.0 501 Not Implemented\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>501 Not Implemented</title>\r\n"
@@ -144,6 +150,7 @@ static errno_t recv_create(tcp_conn_t *conn, recv_t **rrecv)
 	recv->rbuf_out = 0;
 	recv->rbuf_in = 0;
 	recv->lbuf_used = 0;
+	recv->eof = false;
 
 	*rrecv = recv;
 	return EOK;
@@ -154,53 +161,75 @@ static void recv_destroy(recv_t *recv)
 	free(recv);
 }
 
-/** Receive one character (with buffering) */
-static errno_t recv_char(recv_t *recv, char *c)
+/** Receive more data into the receive buffer */
+static errno_t recv_fill(recv_t *recv)
 {
 	size_t nrecv;
 	errno_t rc;
 
-	if (recv->rbuf_out == recv->rbuf_in) {
-		recv->rbuf_out = 0;
-		recv->rbuf_in = 0;
+	recv->rbuf_out = 0;
+	recv->rbuf_in = 0;
 
-		rc = tcp_conn_recv_wait(recv->conn, recv->rbuf, BUFFER_SIZE, &nrecv);
-		if (rc != EOK) {
-			fprintf(stderr, "tcp_conn_recv() failed: %s\n", str_error(rc));
-			return rc;
-		}
+	rc = tcp_conn_recv_wait(recv->conn, recv->rbuf, BUFFER_SIZE, &nrecv);
+	if (rc != EOK) {
+		fprintf(stderr, "tcp_conn_recv() failed: %s\n", str_error(rc));
+		return rc;
+	}
 
-		recv->rbuf_in = nrecv;
+	if (nrecv == 0) {
+		/* Connection closed */
+		recv->eof = true;
+		return EIO;
 	}
 
-	*c = recv->rbuf[recv->rbuf_out++];
+	recv->rbuf_in = nrecv;
 	return EOK;
 }
 
-/** Receive one line with length limit */
+/** Receive one line with length limit.
+ *
+ * The line terminator (CRLF or LF) is not stored in the returned line.
+ */
 static errno_t recv_line(recv_t *recv, char **rbuf)
 {
-	char *bp = recv->lbuf;
-	char c = '\0';
+	char *start;
+	char *nl;
+	size_t avail;
+	size_t n;
+	errno_t rc;
 
-	while (bp < recv->lbuf + BUFFER_SIZE) {
-		char prev = c;
-		errno_t rc = recv_char(recv, &c);
+	recv->lbuf_used = 0;
 
-		if (rc != EOK)
-			return rc;
+	while (true) {
+		if (recv->rbuf_out == recv->rbuf_in) {
+			rc = recv_fill(recv);
+			if (rc != EOK)
+				return rc;
+		}
 
-		*bp++ = c;
-		if ((prev == '\r') && (c == '\n'))
+		/* Copy everything up to and including the end of line at once */
+		start = recv->rbuf + recv->rbuf_out;
+		avail = recv->rbuf_in - recv->rbuf_out;
+		nl = memchr(start, '\n', avail);
+		n = (nl != NULL) ? (size_t) (nl - start) + 1 : avail;
+
+		if (recv->lbuf_used + n > BUFFER_SIZE)
+			return ELIMIT;
+
+		memcpy(recv->lbuf + recv->lbuf_used, start, n);
+		recv->lbuf_used += n;
+		recv->rbuf_out += n;
+
+		if (nl != NULL)
 			break;
 	}
 
-	recv->lbuf_used = bp - recv->lbuf;
-	*bp = '\0';
-
-	if (bp == recv->lbuf + BUFFER_SIZE)
-		return ELIMIT;
+	/* Strip line terminator */
+	n = recv->lbuf_used - 1;
+	if (n > 0 && recv->lbuf[n - 1] == '\r')
+		--n;
 
+	recv->lbuf[n] = '\0';
 	*rbuf = recv->lbuf;
 	return EOK;
 }
@@ -224,36 +253,136 @@ static bool uri_is_valid(char *uri)
 	return true;
 }
 
-static errno_t send_response(tcp_conn_t *conn, const char *msg)
+/** Send data, splitting it into chunks the TCP service accepts. */
+static errno_t send_data(tcp_conn_t *conn, const void *data, size_t size)
+{
+	const uint8_t *dp = data;
+	size_t now;
+	errno_t rc;
+
+	while (size > 0) {
+		now = min(size, (size_t) DATA_XFER_LIMIT);
+		rc = tcp_conn_send(conn, dp, now);
+		if (rc != EOK) {
+			fprintf(stderr, "tcp_conn_send() failed\n");
+			return rc;
+		}
+
+		dp += now;
+		size -= now;
+	}
+
+	return EOK;
+}
+
+/** Send response header.
+ *
+ * @param conn Connection
+ * @param status Status code and reason phrase
+ * @param length Length of the response body
+ * @param keep_alive @c true to keep the connection open after response
+ */
+static errno_t send_header(tcp_conn_t *conn, const char *status,
+    size_t length, bool keep_alive)
 {
-	size_t response_size = str_size(msg);
+	char *hdr;
+	int rv;
+	errno_t rc;
 
 	if (verbose)
 		fprintf(stderr, "Sending response\n");
 
-	errno_t rc = tcp_conn_send(conn, (void *) msg, response_size);
+	rv = asprintf(&hdr, "HTTP/1.1 %s\r\n"
+	    "Content-Length: %zu\r\n"
+	    "Connection: %s\r\n"
+	    "\r\n", status, length, keep_alive ? "keep-alive" : "close");
+	if (rv < 0)
+		return ENOMEM;
+
+	rc = send_data(conn, hdr, (size_t) rv);
+	free(hdr);
+	return rc;
+}
+
+/** Send response with a short message body.
+ *
+ * @param conn Connection
+ * @param status Status code and reason phrase
+ * @param msg Response body
+ * @param keep_alive @c true to keep the connection open after response
+ */
+static errno_t send_response(tcp_conn_t *conn, const char *status,
+    const char *msg, bool keep_alive)
+{
+	errno_t rc;
+
+	rc = send_header(conn, status, str_size(msg), keep_alive);
+	if (rc != EOK)
+		return rc;
+
+	return send_data(conn, msg, str_size(msg));
+}
+
+/** Load file into cache.
+ *
+ * @param fname File name
+ * @param fd Open file
+ * @param size File size
+ * @param rentry Place to store cache entry
+ */
+static errno_t file_cache_load(const char *fname, int fd, size_t size,
+    cache_entry_t **rentry)
+{
+	aoff64_t pos = 0;
+	size_t total;
+	size_t nr;
+	void *data;
+	errno_t rc;
+
+	data = malloc(max(size, (size_t) 1));
+	if (data == NULL)
+		return ENOMEM;
+
+	total = 0;
+	while (total < size) {
+		rc = vfs_read(fd, &pos, (uint8_t *) data + total,
+		    size - total, &nr);
+		if (rc != EOK) {
+			free(data);
+			return rc;
+		}
+
+		if (nr == 0)
+			break;
+
+		total += nr;
+	}
+
+	if (total != size) {
+		/* File changed under our hands */
+		free(data);
+		return EIO;
+	}
+
+	rc = cache_insert(fname, data, size, rentry);
 	if (rc != EOK) {
-		fprintf(stderr, "tcp_conn_send() failed\n");
+		free(data);
 		return rc;
 	}
 
 	return EOK;
 }
 
-static errno_t uri_get(const char *uri, tcp_conn_t *conn)
+static errno_t uri_get(const char *uri, tcp_conn_t *conn, bool keep_alive)
 {
-	char *fbuf = NULL;
+	cache_entry_t *entry = NULL;
 	char *fname = NULL;
+	vfs_stat_t st;
+	aoff64_t pos;
+	size_t nsent;
 	errno_t rc;
-	size_t nr;
 	int fd = -1;
 
-	fbuf = calloc(BUFFER_SIZE, 1);
-	if (fbuf == NULL) {
-		rc = ENOMEM;
-		goto out;
-	}
-
 	if (str_cmp(uri, "/") == 0)
 		uri = "/index.html";
 
@@ -262,79 +391,149 @@ static errno_t uri_get(const char *uri, tcp_conn_t *conn)
 		goto out;
 	}
 
-	rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ, &fd);
-	if (rc != EOK) {
-		rc = send_response(conn, msg_not_found);
-		goto out;
-	}
+	entry = cache_find(fname);
+	if (entry == NULL) {
+		rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ, &fd);
+		if (rc != EOK) {
+			rc = send_response(conn, "404 Not Found", msg_not_found,
+			    keep_alive);
+			goto out;
+		}
 
-	free(fname);
-	fname = NULL;
+		rc = vfs_stat(fd, &st);
+		if (rc != EOK)
+			goto out;
 
-	rc = send_response(conn, msg_ok);
-	if (rc != EOK)
-		goto out;
+		if (st.size <= cache_file_max()) {
+			rc = file_cache_load(fname, fd, st.size, &entry);
+			if (rc != EOK && rc != ENOMEM)
+				goto out;
+		}
+	}
 
-	aoff64_t pos = 0;
-	while (true) {
-		rc = vfs_read(fd, &pos, fbuf, BUFFER_SIZE, &nr);
+	if (entry != NULL) {
+		/* Serve from cache */
+		rc = send_header(conn, "200 OK", entry->size, keep_alive);
 		if (rc != EOK)
 			goto out;
 
-		if (nr == 0)
-			break;
+		rc = send_data(conn, entry->data, entry->size);
+		goto out;
+	}
 
-		rc = tcp_conn_send(conn, fbuf, nr);
-		if (rc != EOK) {
-			fprintf(stderr, "tcp_conn_send() failed\n");
-			goto out;
-		}
+	rc = send_header(conn, "200 OK", st.size, keep_alive);
+	if (rc != EOK)
+		goto out;
+
+	pos = 0;
+	rc = tcp_conn_send_file(conn, fd, &pos, st.size, &nsent);
+	if (rc != EOK) {
+		fprintf(stderr, "tcp_conn_send_file() failed\n");
+		goto out;
+	}
+
+	if (nsent != st.size) {
+		/* Cannot keep the promised content length */
+		rc = EIO;
+		goto out;
 	}
 
 	rc = EOK;
 out:
+	if (entry != NULL)
+		cache_release(entry);
 	if (fd >= 0)
 		vfs_put(fd);
 	free(fname);
-	free(fbuf);
 	return rc;
 }
 
-static errno_t req_process(tcp_conn_t *conn, recv_t *recv)
+/** Process one request.
+ *
+ * @param conn Connection
+ * @param recv Receive buffer
+ * @param keep_alive On input @c true if the connection may be kept open
+ *                   after this request, on output @c true if it will be
+ */
+static errno_t req_process(tcp_conn_t *conn, recv_t *recv, bool *keep_alive)
 {
 	char *reqline = NULL;
+	char *line;
+	char *uri = NULL;
+	char *version;
+	char *value;
+	bool alive;
 
 	errno_t rc = recv_line(recv, &reqline);
 	if (rc != EOK) {
-		fprintf(stderr, "recv_line() failed\n");
+		if (!recv->eof)
+			fprintf(stderr, "recv_line() failed\n");
 		return rc;
 	}
 
 	if (verbose)
-		fprintf(stderr, "Request: %s", reqline);
+		fprintf(stderr, "Request: %s\n", reqline);
 
 	if (str_lcmp(reqline, "GET ", 4) != 0) {
-		rc = send_response(conn, msg_not_implemented);
-		return rc;
+		/* We cannot tell where the request ends, close the connection */
+		*keep_alive = false;
+		return send_response(conn, "501 Not Implemented",
+		    msg_not_implemented, false);
 	}
 
-	char *uri = reqline + 4;
-	char *end_uri = str_chr(uri, ' ');
-	if (end_uri == NULL) {
-		end_uri = reqline + str_size(reqline) - 2;
-		assert(*end_uri == '\r');
+	char *end_uri = str_chr(reqline + 4, ' ');
+	if (end_uri != NULL) {
+		*end_uri = '\0';
+		version = end_uri + 1;
+	} else {
+		version = NULL;
 	}
 
-	*end_uri = '\0';
+	/* HTTP/1.1 connections are persistent by default */
+	alive = version != NULL && str_cmp(version, "HTTP/1.1") == 0;
+
+	/* Line buffer will be reused for header fields */
+	uri = str_dup(reqline + 4);
+	if (uri == NULL)
+		return ENOMEM;
+
 	if (verbose)
 		fprintf(stderr, "Requested URI: %s\n", uri);
 
+	/* Process header fields (there are none in a simple request) */
+	while (version != NULL) {
+		rc = recv_line(recv, &line);
+		if (rc != EOK) {
+			free(uri);
+			return rc;
+		}
+
+		if (line[0] == '\0')
+			break;
+
+		if (str_lcasecmp(line, "Connection:", 11) == 0) {
+			value = line + 11;
+			while (*value == ' ' || *value == '\t')
+				++value;
+
+			if (str_casecmp(value, "close") == 0)
+				alive = false;
+			else if (str_casecmp(value, "keep-alive") == 0)
+				alive = true;
+		}
+	}
+
+	*keep_alive = *keep_alive && alive;
+
 	if (!uri_is_valid(uri)) {
-		rc = send_response(conn, msg_bad_request);
-		return rc;
+		rc = send_response(conn, "400 Bad Request", msg_bad_request,
+		    *keep_alive);
+	} else {
+		rc = uri_get(uri, conn, *keep_alive);
 	}
 
-	return uri_get(uri, conn);
+	free(uri);
+	return rc;
 }
 
 static void usage(void)
@@ -347,6 +546,10 @@ static void usage(void)
 	    "-p port_number | --port=port_number\n"
 	    "\tListening port (default " STRING(DEFAULT_PORT) ").\n"
 	    "\n"
+	    "-c size | --cache=size\n"
+	    "\tFile cache size in KiB, 0 disables caching (default "
+	    STRING(DEFAULT_CACHE_SIZE) ").\n"
+	    "\n"
 	    "-h | --help\n"
 	    "\tShow this application help.\n"
 	    "-v | --verbose\n"
@@ -359,6 +562,13 @@ static errno_t parse_option(int argc, char *argv[], int *index)
 	errno_t rc;
 
 	switch (argv[*index][1]) {
+	case 'c':
+		rc = arg_parse_int(argc, argv, index, &value, 0);
+		if (rc != EOK || value < 0)
+			return EINVAL;
+
+		cache_size = (size_t) value;
+		break;
 	case 'h':
 		usage();
 		exit(0);
@@ -378,6 +588,12 @@ static errno_t parse_option(int argc, char *argv[], int *index)
 		if (str_lcmp(argv[*index] + 2, "help", 5) == 0) {
 			usage();
 			exit(0);
+		} else if (str_lcmp(argv[*index] + 2, "cache=", 6) == 0) {
+			rc = arg_parse_int(argc, argv, index, &value, 8);
+			if (rc != EOK || value < 0)
+				return EINVAL;
+
+			cache_size = (size_t) value;
 		} else if (str_lcmp(argv[*index] + 2, "port=", 5) == 0) {
 			rc = arg_parse_int(argc, argv, index, &value, 7);
 			if (rc != EOK)
@@ -399,10 +615,18 @@ static errno_t parse_option(int argc, char *argv[], int *index)
 	return EOK;
 }
 
+/** Serve requests on a new connection.
+ *
+ * Called by the TCP library in a separate fibril for each connection,
+ * so slow clients do not hold up others. Requests are served until
+ * the client closes the connection or asks for it to be closed.
+ */
 static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 {
 	errno_t rc;
 	recv_t *recv = NULL;
+	bool keep_alive;
+	unsigned nreq;
 
 	if (verbose)
 		fprintf(stderr, "New connection, waiting for request\n");
@@ -413,11 +637,21 @@ static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 		goto error;
 	}
 
-	rc = req_process(conn, recv);
-	if (rc != EOK) {
-		fprintf(stderr, "Error processing request (%s)\n",
-		    str_error(rc));
-		goto error;
+	keep_alive = true;
+	for (nreq = 1; keep_alive; nreq++) {
+		keep_alive = nreq < KEEPALIVE_MAX;
+
+		rc = req_process(conn, recv, &keep_alive);
+		if (rc != EOK) {
+			if (recv->eof) {
+				/* Client closed the connection */
+				break;
+			}
+
+			fprintf(stderr, "Error processing request (%s)\n",
+			    str_error(rc));
+			goto error;
+		}
 	}
 
 	rc = tcp_conn_send_fin(conn);
@@ -457,6 +691,12 @@ int main(int argc, char *argv[])
 
 	printf("%s: HelenOS web server\n", NAME);
 
+	rc = cache_init(cache_size * 1024, CACHE_FILE_MAX);
+	if (rc != EOK) {
+		fprintf(stderr, "Error initializing file cache.\n");
+		return 1;
+	}
+
 	if (verbose)
 		fprintf(stderr, "Creating listener\n");
 
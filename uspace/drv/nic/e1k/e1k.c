@@ -1167,11 +1167,18 @@ static uint32_t e1000_inc_tail(uint32_t tail, uint32_t descriptors_count)
 
 /** Receive frames
  *
- * @param nic NIC data
+ * @param nic    NIC data
+ * @param frames List to append the received frames to
+ * @param budget Maximal number of frames to receive
+ *
+ * @return Number of frames taken from the receive ring
  *
  */
-static void e1000_receive_frames(nic_t *nic)
+static size_t e1000_receive_frames(nic_t *nic, nic_frame_list_t *frames,
+    size_t budget)
 {
+	size_t count = 0;
+
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
 	fibril_mutex_lock(&e1000->rx_lock);
@@ -1182,13 +1189,13 @@ static void e1000_receive_frames(nic_t *nic)
 	e1000_rx_descriptor_t *rx_descriptor = (e1000_rx_descriptor_t *)
 	    (e1000->rx_ring_virt + next_tail * sizeof(e1000_rx_descriptor_t));
 
-	while (rx_descriptor->status & 0x01) {
+	while (count < budget && (rx_descriptor->status & 0x01)) {
 		uint32_t frame_size = rx_descriptor->length - E1000_CRC_SIZE;
 
 		nic_frame_t *frame = nic_alloc_frame(nic, frame_size);
 		if (frame != NULL) {
 			memcpy(frame->data, e1000->rx_frame_virt[next_tail], frame_size);
-			nic_received_frame(nic, frame);
+			nic_frame_list_append(frames, frame);
 		} else {
 			ddf_msg(LVL_ERROR, "Memory allocation failed. Frame dropped.");
 		}
@@ -1200,9 +1207,11 @@ static void e1000_receive_frames(nic_t *nic)
 
 		rx_descriptor = (e1000_rx_descriptor_t *)
 		    (e1000->rx_ring_virt + next_tail * sizeof(e1000_rx_descriptor_t));
+		count++;
 	}
 
 	fibril_mutex_unlock(&e1000->rx_lock);
+	return count;
 }
 
 /** Enable E1000 interupts
@@ -1236,8 +1245,45 @@ static void e1000_disable_interrupts(e1000_t *e1000)
  */
 static void e1000_interrupt_handler_impl(nic_t *nic, uint32_t icr)
 {
-	if (icr & ICR_RXT0)
-		e1000_receive_frames(nic);
+	if (icr & ICR_RXT0) {
+		nic_frame_list_t *frames = nic_alloc_frame_list();
+		if (frames == NULL)
+			return;
+
+		e1000_receive_frames(nic, frames, SIZE_MAX);
+		nic_received_frame_list(nic, frames);
+	}
+}
+
+/** Receive a budgeted batch of frames (NAPI poll handler)
+ *
+ * @param nic    NIC data
+ * @param frames List to append the received frames to
+ * @param budget Maximal number of frames to receive
+ *
+ * @return Number of frames received
+ *
+ */
+static size_t e1000_napi_poll(nic_t *nic, nic_frame_list_t *frames,
+    size_t budget)
+{
+	return e1000_receive_frames(nic, frames, budget);
+}
+
+/** Mask or unmask interrupts (NAPI interrupt handler)
+ *
+ * @param nic    NIC data
+ * @param enable Unmask the interrupts if true
+ *
+ */
+static void e1000_napi_irq(nic_t *nic, bool enable)
+{
+	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+
+	if (enable)
+		e1000_enable_interrupts(e1000);
+	else
+		e1000_disable_interrupts(e1000);
 }
 
 /** Handle device interrupt
@@ -1253,8 +1299,14 @@ static void e1000_interrupt_handler(ipc_call_t *icall,
 	nic_t *nic = NIC_DATA_DEV(dev);
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
-	e1000_interrupt_handler_impl(nic, icr);
-	e1000_enable_interrupts(e1000);
+	/*
+	 * The interrupts were masked by the IRQ code. Leave them masked and
+	 * let the NAPI poll drain the receive ring, it unmasks them afterwards.
+	 */
+	if (icr & ICR_RXT0)
+		nic_napi_schedule(nic);
+	else
+		e1000_enable_interrupts(e1000);
 }
 
 /** Register interrupt handler for the card in the system
@@ -1910,6 +1962,12 @@ static e1000_t *e1000_create_dev_data(ddf_dev_t *dev)
 	fibril_mutex_initialize(&e1000->tx_lock);
 	fibril_mutex_initialize(&e1000->eeprom_lock);
 
+	if (nic_set_napi_handlers(nic, e1000_napi_poll, e1000_napi_irq,
+	    0) != EOK) {
+		nic_unbind_and_destroy(dev);
+		return NULL;
+	}
+
 	return e1000;
 }
 
@@ -787,6 +787,144 @@ errno_t block_write_direct(service_id_t service_id, aoff64_t ba, size_t cnt,
 	return write_blocks(devcon, ba, cnt, (void *)data, devcon->pblock_size * cnt);
 }
 
+/** Find a cached block which is not toxic and lock it.
+ *
+ * @param cache		Block cache.
+ * @param ba		Logical block address.
+ *
+ * @return		Locked block or NULL if the block is not cached.
+ */
+static block_t *block_find_locked(cache_t *cache, aoff64_t ba)
+{
+	block_t *b;
+
+	fibril_mutex_lock(&cache->lock);
+	ht_link_t *hlink = hash_table_find(&cache->block_hash, &ba);
+	if (!hlink) {
+		fibril_mutex_unlock(&cache->lock);
+		return NULL;
+	}
+
+	b = hash_table_get_inst(hlink, block_t, hash_link);
+	fibril_mutex_lock(&b->lock);
+	fibril_mutex_unlock(&cache->lock);
+
+	if (b->toxic) {
+		fibril_mutex_unlock(&b->lock);
+		return NULL;
+	}
+
+	return b;
+}
+
+/** Read logical blocks bypassing the block cache.
+ *
+ * Large sequential reads should not evict the working set from the block
+ * cache. Blocks present in the cache are copied from there, so that data
+ * in dirty blocks is not missed. Runs of the remaining blocks are read from
+ * the device in single transfers.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param ba		Address of the first block (logical).
+ * @param cnt		Number of blocks.
+ * @param buf		Buffer for storing the data.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
+errno_t block_read_uncached(service_id_t service_id, aoff64_t ba, size_t cnt,
+    void *buf)
+{
+	devcon_t *devcon;
+	cache_t *cache;
+	block_t *b;
+	size_t i, j;
+	errno_t rc;
+
+	devcon = devcon_search(service_id);
+	assert(devcon);
+	assert(devcon->cache);
+	cache = devcon->cache;
+
+	i = 0;
+	while (i < cnt) {
+		b = block_find_locked(cache, ba + i);
+		if (b) {
+			memcpy(buf + i * cache->lblock_size, b->data,
+			    cache->lblock_size);
+			fibril_mutex_unlock(&b->lock);
+			i++;
+			continue;
+		}
+
+		/* Find the end of the run of blocks missing in the cache. */
+		for (j = i + 1; j < cnt; j++) {
+			aoff64_t lba = ba + j;
+
+			fibril_mutex_lock(&cache->lock);
+			bool cached = hash_table_find(&cache->block_hash,
+			    &lba) != NULL;
+			fibril_mutex_unlock(&cache->lock);
+			if (cached)
+				break;
+		}
+
+		rc = read_blocks(devcon, ba_ltop(devcon, ba + i),
+		    (j - i) * cache->blocks_cluster,
+		    buf + i * cache->lblock_size, (j - i) * cache->lblock_size);
+		if (rc != EOK)
+			return rc;
+
+		i = j;
+	}
+
+	return EOK;
+}
+
+/** Write logical blocks bypassing the block cache.
+ *
+ * The blocks are written to the device in a single transfer. Copies of the
+ * blocks present in the cache are updated with the new data.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param ba		Address of the first block (logical).
+ * @param cnt		Number of blocks.
+ * @param data		The data to be written.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
+errno_t block_write_uncached(service_id_t service_id, aoff64_t ba, size_t cnt,
+    const void *data)
+{
+	devcon_t *devcon;
+	cache_t *cache;
+	block_t *b;
+	size_t i;
+	errno_t rc;
+
+	devcon = devcon_search(service_id);
+	assert(devcon);
+	assert(devcon->cache);
+	cache = devcon->cache;
+
+	rc = write_blocks(devcon, ba_ltop(devcon, ba),
+	    cnt * cache->blocks_cluster, (void *) data,
+	    cnt * cache->lblock_size);
+	if (rc != EOK)
+		return rc;
+
+	for (i = 0; i < cnt; i++) {
+		b = block_find_locked(cache, ba + i);
+		if (!b)
+			continue;
+
+		memcpy(b->data, data + i * cache->lblock_size,
+		    cache->lblock_size);
+		fibril_mutex_unlock(&b->lock);
+	}
+
+	return EOK;
+}
+
 /** Synchronize blocks to persistent storage.
  *
  * @param service_id	Service ID of the block device.
@@ -119,6 +119,9 @@ extern errno_t block_read_toc(service_id_t, uint8_t, void *, size_t);
 extern errno_t block_read_direct(service_id_t, aoff64_t, size_t, void *);
 extern errno_t block_read_bytes_direct(service_id_t, aoff64_t, size_t, void *);
 extern errno_t block_write_direct(service_id_t, aoff64_t, size_t, const void *);
+extern errno_t block_read_uncached(service_id_t, aoff64_t, size_t, void *);
+extern errno_t block_write_uncached(service_id_t, aoff64_t, size_t,
+    const void *);
 extern errno_t block_sync_cache(service_id_t, aoff64_t, size_t);
 
 #endif
@@ -44,11 +44,83 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/rtld_arch.h>
 
+extern void rtld_plt_tramp(void);
+extern void *rtld_plt_resolve(module_t *, size_t);
+
 void module_process_pre_arch(module_t *m)
 {
 	/* Unused */
 }
 
+/** Prepare PLT of a module for lazy binding.
+ *
+ * GOT[1] is set to point to the module and GOT[2] to the lazy binding
+ * trampoline. Each jump slot initially points back to the second
+ * instruction of its PLT entry, which pushes the relocation index and
+ * jumps to PLT0, so it only needs to be adjusted by the load bias.
+ *
+ * @param m Module
+ * @return @c true if the PLT has been set up for lazy binding
+ */
+bool module_plt_lazy_arch(module_t *m)
+{
+	elf_rela_t *rt = m->dyn.jmp_rel;
+	size_t rt_entries = m->dyn.plt_rel_sz / sizeof(elf_rela_t);
+	uintptr_t *got = m->dyn.plt_got;
+	size_t i;
+
+	if (got == NULL || m->dyn.plt_rel != DT_RELA)
+		return false;
+
+	for (i = 0; i < rt_entries; ++i) {
+		if (ELF64_R_TYPE(rt[i].r_info) != R_X86_64_JUMP_SLOT)
+			return false;
+	}
+
+	got[1] = (uintptr_t) m;
+	got[2] = (uintptr_t) rtld_plt_tramp;
+
+	for (i = 0; i < rt_entries; ++i)
+		*(uintptr_t *)(rt[i].r_offset + m->bias) += m->bias;
+
+	return true;
+}
+
+/** Resolve a lazily bound PLT entry.
+ *
+ * Called from the lazy binding trampoline on the first call through
+ * a PLT entry.
+ *
+ * @param m   Module whose PLT entry is being resolved
+ * @param idx Index of the relocation in the PLT relocation table
+ * @return Address of the function
+ */
+void *rtld_plt_resolve(module_t *m, size_t idx)
+{
+	elf_rela_t *rela = (elf_rela_t *) m->dyn.jmp_rel + idx;
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	elf_symbol_t *sym = &sym_table[ELF64_R_SYM(rela->r_info)];
+	const char *name = m->dyn.str_tab + sym->st_name;
+	elf_symbol_t *sym_def;
+	module_t *dest;
+	uintptr_t sym_addr;
+
+	/*
+	 * We may be running concurrently with other threads, so
+	 * do not modify the symbol resolution cache.
+	 */
+	sym_def = symbol_def_find(name, m, ssf_nocache, &dest);
+	if (sym_def == NULL) {
+		printf("Definition of '%s' not found.\n", name);
+		abort();
+	}
+
+	sym_addr = (uintptr_t) symbol_get_addr(sym_def, dest, NULL);
+	*(uintptr_t *)(rela->r_offset + m->bias) = sym_addr;
+
+	return (void *) sym_addr;
+}
+
 /**
  * Process (fixup) all relocations in a relocation table with implicit addends.
  */
@@ -52,6 +52,15 @@ void module_process_pre_arch(module_t *m)
 	/* Unused */
 }
 
+/** Prepare PLT of a module for lazy binding.
+ *
+ * Lazy binding is not supported, PLT relocations are processed eagerly.
+ */
+bool module_plt_lazy_arch(module_t *m)
+{
+	return false;
+}
+
 /**
  * Process (fixup) all relocations in a relocation table with implicit addends.
  */
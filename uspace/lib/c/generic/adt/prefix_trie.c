@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup libc
+ * @{
+ */
+
+/** @file Prefix trie
+ *
+ * Path-compressed binary trie (a.k.a. PATRICIA trie) mapping bit string
+ * prefixes to values with longest prefix match lookup. Every node stores
+ * its full prefix. Nodes without a value only exist to branch, so they
+ * always have two children and the depth of the trie is bounded by the
+ * key length, while the number of nodes is less than twice the number
+ * of prefixes.
+ */
+
+#include <adt/prefix_trie.h>
+#include <assert.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define KEY_BYTES (PREFIX_TRIE_KEY_BITS / 8)
+
+/** Prefix trie node */
+struct prefix_trie_node {
+	/** Children for next bit 0 and 1 */
+	prefix_trie_node_t *child[2];
+	/** Value or @c NULL for a branching node */
+	void *value;
+	/** Prefix length in bits */
+	unsigned plen;
+	/** Prefix (bits past @c plen are zero) */
+	uint8_t key[KEY_BYTES];
+};
+
+/** Get bit of key. */
+static inline unsigned key_bit(const uint8_t *key, unsigned bit)
+{
+	return (key[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+/** Copy first @a plen bits of key, zeroing the rest. */
+static void key_copy(uint8_t *dst, const uint8_t *src, unsigned plen)
+{
+	unsigned nbytes = plen / 8;
+
+	memset(dst, 0, KEY_BYTES);
+	memcpy(dst, src, nbytes);
+	if (plen % 8 != 0)
+		dst[nbytes] = src[nbytes] & (0xff << (8 - plen % 8));
+}
+
+/** Determine length of common prefix of two keys.
+ *
+ * @param a First key
+ * @param b Second key
+ * @param maxlen Maximum number of bits to compare
+ * @return Number of leading bits in which @a a and @a b agree (at most
+ *         @a maxlen)
+ */
+static unsigned key_common(const uint8_t *a, const uint8_t *b,
+    unsigned maxlen)
+{
+	unsigned i;
+	unsigned len;
+	uint8_t diff;
+
+	for (i = 0; i * 8 < maxlen; i++) {
+		diff = a[i] ^ b[i];
+		if (diff != 0) {
+			len = i * 8;
+			while ((diff & 0x80) == 0) {
+				diff <<= 1;
+				++len;
+			}
+			return len < maxlen ? len : maxlen;
+		}
+	}
+
+	return maxlen;
+}
+
+/** Determine whether node prefix matches key. */
+static bool node_matches(prefix_trie_node_t *node, const uint8_t *key)
+{
+	unsigned nbytes = node->plen / 8;
+	unsigned rbits = node->plen % 8;
+
+	if (memcmp(node->key, key, nbytes) != 0)
+		return false;
+	if (rbits == 0)
+		return true;
+
+	return ((node->key[nbytes] ^ key[nbytes]) & (0xff << (8 - rbits))) == 0;
+}
+
+static prefix_trie_node_t *node_create(const uint8_t *key, unsigned plen,
+    void *value)
+{
+	prefix_trie_node_t *node;
+
+	node = calloc(1, sizeof(prefix_trie_node_t));
+	if (node == NULL)
+		return NULL;
+
+	key_copy(node->key, key, plen);
+	node->plen = plen;
+	node->value = value;
+	return node;
+}
+
+static void node_destroy_tree(prefix_trie_node_t *node)
+{
+	if (node == NULL)
+		return;
+
+	node_destroy_tree(node->child[0]);
+	node_destroy_tree(node->child[1]);
+	free(node);
+}
+
+/** Initialize prefix trie.
+ *
+ * @param trie Prefix trie
+ * @param key_bits Length of keys in bits (at most @c PREFIX_TRIE_KEY_BITS)
+ */
+void prefix_trie_initialize(prefix_trie_t *trie, unsigned key_bits)
+{
+	assert(key_bits <= PREFIX_TRIE_KEY_BITS);
+
+	trie->root = NULL;
+	trie->key_bits = key_bits;
+	trie->count = 0;
+}
+
+/** Finalize prefix trie.
+ *
+ * Frees all nodes. Values are not touched.
+ *
+ * @param trie Prefix trie
+ */
+void prefix_trie_finalize(prefix_trie_t *trie)
+{
+	node_destroy_tree(trie->root);
+	trie->root = NULL;
+	trie->count = 0;
+}
+
+/** Insert prefix into trie.
+ *
+ * @param trie Prefix trie
+ * @param key Key (only the first @a plen bits are used)
+ * @param plen Prefix length in bits
+ * @param value Value (not @c NULL)
+ * @return EOK on success, EEXIST if the prefix is already present,
+ *         ENOMEM if out of memory
+ */
+errno_t prefix_trie_insert(prefix_trie_t *trie, const uint8_t *key,
+    unsigned plen, void *value)
+{
+	prefix_trie_node_t **pnode;
+	prefix_trie_node_t *node;
+	prefix_trie_node_t *nnode;
+	prefix_trie_node_t *branch;
+	unsigned common;
+
+	assert(plen <= trie->key_bits);
+	assert(value != NULL);
+
+	pnode = &trie->root;
+	while (*pnode != NULL) {
+		node = *pnode;
+		common = key_common(node->key, key,
+		    node->plen < plen ? node->plen : plen);
+
+		if (common == node->plen) {
+			if (common == plen) {
+				/* Exact match */
+				if (node->value != NULL)
+					return EEXIST;
+				node->value = value;
+				++trie->count;
+				return EOK;
+			}
+
+			/* Node is a prefix of the new key, descend */
+			pnode = &node->child[key_bit(key, node->plen)];
+			continue;
+		}
+
+		nnode = node_create(key, plen, value);
+		if (nnode == NULL)
+			return ENOMEM;
+
+		if (common == plen) {
+			/* New key is a prefix of node, insert above it */
+			nnode->child[key_bit(node->key, plen)] = node;
+			*pnode = nnode;
+		} else {
+			/* Keys diverge, insert a branching node */
+			branch = node_create(key, common, NULL);
+			if (branch == NULL) {
+				free(nnode);
+				return ENOMEM;
+			}
+
+			branch->child[key_bit(key, common)] = nnode;
+			branch->child[key_bit(node->key, common)] = node;
+			*pnode = branch;
+		}
+
+		++trie->count;
+		return EOK;
+	}
+
+	nnode = node_create(key, plen, value);
+	if (nnode == NULL)
+		return ENOMEM;
+
+	*pnode = nnode;
+	++trie->count;
+	return EOK;
+}
+
+/** Remove prefix from trie.
+ *
+ * @param trie Prefix trie
+ * @param key Key (only the first @a plen bits are used)
+ * @param plen Prefix length in bits
+ * @return Value of the removed prefix or @c NULL if not found
+ */
+void *prefix_trie_remove(prefix_trie_t *trie, const uint8_t *key,
+    unsigned plen)
+{
+	prefix_trie_node_t **pparent;
+	prefix_trie_node_t **pnode;
+	prefix_trie_node_t *node;
+	prefix_trie_node_t *parent;
+	prefix_trie_node_t *sibling;
+	void *value;
+
+	pparent = NULL;
+	pnode = &trie->root;
+	while (*pnode != NULL) {
+		node = *pnode;
+		if (node->plen > plen || !node_matches(node, key))
+			return NULL;
+		if (node->plen == plen)
+			break;
+
+		pparent = pnode;
+		pnode = &node->child[key_bit(key, node->plen)];
+	}
+
+	node = *pnode;
+	if (node == NULL || node->value == NULL)
+		return NULL;
+
+	value = node->value;
+	node->value = NULL;
+	--trie->count;
+
+	if (node->child[0] != NULL && node->child[1] != NULL) {
+		/* Node stays as a branching node */
+		return value;
+	}
+
+	/* Replace node by its only child (if any) */
+	*pnode = node->child[0] != NULL ? node->child[0] : node->child[1];
+	free(node);
+
+	/* Parent branching node may now be redundant */
+	if (pparent != NULL && *pnode == NULL) {
+		parent = *pparent;
+		if (parent->value == NULL) {
+			sibling = parent->child[0] != NULL ? parent->child[0] :
+			    parent->child[1];
+			*pparent = sibling;
+			free(parent);
+		}
+	}
+
+	return value;
+}
+
+/** Get value of exact prefix.
+ *
+ * @param trie Prefix trie
+ * @param key Key (only the first @a plen bits are used)
+ * @param plen Prefix length in bits
+ * @return Value or @c NULL if the prefix is not present
+ */
+void *prefix_trie_get(prefix_trie_t *trie, const uint8_t *key, unsigned plen)
+{
+	prefix_trie_node_t *node;
+
+	node = trie->root;
+	while (node != NULL) {
+		if (node->plen > plen || !node_matches(node, key))
+			return NULL;
+		if (node->plen == plen)
+			return node->value;
+
+		node = node->child[key_bit(key, node->plen)];
+	}
+
+	return NULL;
+}
+
+/** Find longest prefix matching a key.
+ *
+ * @param trie Prefix trie
+ * @param key Key of @c key_bits bits
+ * @return Value of the longest matching prefix or @c NULL if none matches
+ */
+void *prefix_trie_lookup(prefix_trie_t *trie, const uint8_t *key)
+{
+	prefix_trie_node_t *node;
+	void *best;
+
+	best = NULL;
+	node = trie->root;
+	while (node != NULL) {
+		if (!node_matches(node, key))
+			break;
+		if (node->value != NULL)
+			best = node->value;
+		if (node->plen == trie->key_bits)
+			break;
+
+		node = node->child[key_bit(key, node->plen)];
+	}
+
+	return best;
+}
+
+/** Get number of prefixes in trie.
+ *
+ * @param trie Prefix trie
+ * @return Number of prefixes
+ */
+size_t prefix_trie_count(prefix_trie_t *trie)
+{
+	return trie->count;
+}
+
+/** @}
+ */
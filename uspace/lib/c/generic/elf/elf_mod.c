@@ -37,10 +37,11 @@
  * @brief	Userspace ELF module loader.
  *
  * This module allows loading ELF binaries (both executables and
- * shared objects) from VFS. The current implementation allocates
- * anonymous memory, fills it with segment data and then adjusts
- * the memory areas' flags to the final value. In the future,
- * the segments will be mapped directly from the file.
+ * shared objects) from VFS. Read-only segments are mapped directly
+ * from the file through the VFS pager, so their pages are faulted in
+ * on demand and shared among all tasks running the same binary.
+ * Other segments are loaded into anonymous memory, which is filled
+ * with segment data and then its flags are adjusted to the final value.
  */
 
 #include <errno.h>
@@ -58,6 +59,9 @@
 #include <str_error.h>
 #include <stdlib.h>
 #include <macros.h>
+#include <ns.h>
+#include <ipc/services.h>
+#include <fibril_synch.h>
 
 #include <elf/elf_load.h>
 
@@ -67,6 +71,10 @@ static errno_t elf_load_module(elf_ld_t *elf);
 static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry);
 static errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry);
 
+/** Session with the VFS pager used for mapping segments from files. */
+static async_sess_t *pager_sess = NULL;
+static FIBRIL_MUTEX_INITIALIZE(pager_sess_lock);
+
 /** Load ELF binary from a file.
  *
  * Load an ELF binary from the specified file. If the file is
@@ -98,10 +106,26 @@ errno_t elf_load_file(int file, eld_flags_t flags, elf_finfo_t *info)
 	elf.fd = ofile;
 	elf.info = info;
 	elf.flags = flags;
+	elf.paged_areas = NULL;
+	elf.paged_cnt = 0;
 
 	rc = elf_load_module(&elf);
 
-	vfs_put(ofile);
+	if (rc != EOK) {
+		/* Paged areas must not outlive the file descriptor. */
+		for (size_t i = 0; i < elf.paged_cnt; i++)
+			as_area_destroy(elf.paged_areas[i]);
+		elf.paged_cnt = 0;
+	}
+
+	/*
+	 * Segments mapped from the file are paged in using the file
+	 * descriptor, so it must stay open for the lifetime of the task.
+	 */
+	if (elf.paged_cnt == 0)
+		vfs_put(ofile);
+
+	free(elf.paged_areas);
 	return rc;
 }
 
@@ -371,6 +395,80 @@ static errno_t segment_header(elf_ld_t *elf, elf_segment_header_t *entry)
 	return EOK;
 }
 
+/** Get session with the VFS pager.
+ *
+ * @return VFS pager session or @c NULL if not available.
+ */
+static async_sess_t *elf_pager_sess(void)
+{
+	fibril_mutex_lock(&pager_sess_lock);
+
+	if (pager_sess == NULL) {
+		errno_t rc;
+		pager_sess = service_connect(SERVICE_VFS, INTERFACE_PAGER, 0,
+		    &rc);
+	}
+
+	fibril_mutex_unlock(&pager_sess_lock);
+	return pager_sess;
+}
+
+/** Try to map segment directly from the file.
+ *
+ * Only segments which are never written to and which do not contain
+ * any zero-initialized part qualify. Their pages are then faulted in
+ * from the VFS pager on demand and shared with other tasks mapping
+ * the same file.
+ *
+ * @param elf   Loader state.
+ * @param entry Program header entry describing segment to be mapped.
+ * @param base  Page-aligned link-time address of the segment start.
+ * @param flags Final memory area flags.
+ *
+ * @return EOK on success, ENOTSUP if the segment cannot be mapped
+ *         from the file.
+ */
+static errno_t map_segment(elf_ld_t *elf, elf_segment_header_t *entry,
+    uintptr_t base, int flags)
+{
+	if ((elf->flags & ELDF_RW) != 0 || (flags & AS_AREA_WRITE) != 0)
+		return ENOTSUP;
+
+	if (entry->p_filesz != entry->p_memsz)
+		return ENOTSUP;
+
+	if ((entry->p_offset % PAGE_SIZE) != (entry->p_vaddr % PAGE_SIZE))
+		return ENOTSUP;
+
+	async_sess_t *sess = elf_pager_sess();
+	if (sess == NULL)
+		return ENOTSUP;
+
+	size_t mem_sz = entry->p_memsz + (entry->p_vaddr - base);
+	aoff64_t file_base = ALIGN_DOWN(entry->p_offset, PAGE_SIZE);
+
+	void **areas = realloc(elf->paged_areas,
+	    (elf->paged_cnt + 1) * sizeof(void *));
+	if (areas == NULL)
+		return ENOTSUP;
+
+	elf->paged_areas = areas;
+
+	void *a = async_as_area_create((uint8_t *) base + elf->bias, mem_sz,
+	    flags, sess, elf->fd, file_base, 0);
+	if (a == AS_MAP_FAILED) {
+		DPRINTF("paged mapping failed (%p, %zu)\n",
+		    (void *) (base + elf->bias), mem_sz);
+		return ENOTSUP;
+	}
+
+	DPRINTF("async_as_area_create(%p, %#zx, %d) -> %p\n",
+	    (void *) (base + elf->bias), mem_sz, flags, a);
+
+	elf->paged_areas[elf->paged_cnt++] = a;
+	return EOK;
+}
+
 /** Load segment described by program header entry.
  *
  * @param elf	Loader state.
@@ -432,6 +530,13 @@ errno_t load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	    (void *) (entry->p_vaddr + bias +
 	    ALIGN_UP(entry->p_memsz, PAGE_SIZE)));
 
+	/*
+	 * Segment pages mapped from the file are made coherent by the pager,
+	 * so there is nothing else to do.
+	 */
+	if (map_segment(elf, entry, base, flags) == EOK)
+		return EOK;
+
 	/*
 	 * For the course of loading, the area needs to be readable
 	 * and writeable.
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Internet checksum
+ *
+ * One's complement sum of 16-bit words as defined by RFC 1071. Since the
+ * one's complement sum is independent of byte order (up to a final byte
+ * swap) and end-around carry makes it independent of the accumulator width,
+ * the data is summed as native-endian 64-bit words (or SIMD vectors where
+ * available) and only folded down to 16 bits at the end.
+ */
+
+#include <byteorder.h>
+#include <inet/checksum.h>
+#include <mem.h>
+#include <stdbool.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/** Number of vector blocks that can be summed into 32-bit lanes.
+ *
+ * Each block adds at most 2 * 0xffff to every 32-bit lane, so the lanes
+ * must be flushed into the 64-bit sum before they can overflow.
+ */
+#define CS_LANE_FLUSH 16384
+
+/** Add to 64-bit one's complement sum (with end-around carry). */
+static inline uint64_t cs_add64(uint64_t sum, uint64_t v)
+{
+	sum += v;
+	return sum + (sum < v);
+}
+
+/** Fold 64-bit one's complement sum to 16 bits. */
+static inline uint16_t cs_fold64(uint64_t sum)
+{
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return (uint16_t) sum;
+}
+
+#if defined(__SSE2__)
+
+/** Flush 32-bit vector lanes into the 64-bit sum. */
+static inline uint64_t cs_flush_vec(uint64_t sum, __m128i acc)
+{
+	__m128i zero = _mm_setzero_si128();
+	uint64_t lanes[2];
+
+	/* Widen to 64-bit lanes so that the horizontal sum cannot overflow */
+	acc = _mm_add_epi64(_mm_unpacklo_epi32(acc, zero),
+	    _mm_unpackhi_epi32(acc, zero));
+	_mm_storeu_si128((__m128i *) lanes, acc);
+	return cs_add64(cs_add64(sum, lanes[0]), lanes[1]);
+}
+
+/** Sum (and optionally copy) whole 16-byte blocks using SSE2.
+ *
+ * @param sum Running 64-bit sum
+ * @param dst Destination buffer or @c NULL
+ * @param src Source data
+ * @param nblocks Number of 16-byte blocks
+ * @return Updated 64-bit sum
+ */
+static inline uint64_t cs_sum_blocks(uint64_t sum, uint8_t *dst,
+    const uint8_t *src, size_t nblocks)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i acc;
+	__m128i v;
+	size_t n;
+
+	while (nblocks > 0) {
+		n = nblocks < CS_LANE_FLUSH ? nblocks : CS_LANE_FLUSH;
+		nblocks -= n;
+
+		acc = _mm_setzero_si128();
+		while (n-- > 0) {
+			v = _mm_loadu_si128((const __m128i *) src);
+			if (dst != NULL) {
+				_mm_storeu_si128((__m128i *) dst, v);
+				dst += 16;
+			}
+			acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+			acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+			src += 16;
+		}
+
+		sum = cs_flush_vec(sum, acc);
+	}
+
+	return sum;
+}
+
+#define CS_BLOCK_SIZE 16
+
+#elif defined(__ARM_NEON)
+
+/** Sum (and optionally copy) whole 16-byte blocks using NEON.
+ *
+ * @param sum Running 64-bit sum
+ * @param dst Destination buffer or @c NULL
+ * @param src Source data
+ * @param nblocks Number of 16-byte blocks
+ * @return Updated 64-bit sum
+ */
+static inline uint64_t cs_sum_blocks(uint64_t sum, uint8_t *dst,
+    const uint8_t *src, size_t nblocks)
+{
+	uint32x4_t acc;
+	uint64x2_t acc64;
+	uint8x16_t v;
+	size_t n;
+
+	while (nblocks > 0) {
+		n = nblocks < CS_LANE_FLUSH ? nblocks : CS_LANE_FLUSH;
+		nblocks -= n;
+
+		acc = vdupq_n_u32(0);
+		while (n-- > 0) {
+			v = vld1q_u8(src);
+			if (dst != NULL) {
+				vst1q_u8(dst, v);
+				dst += 16;
+			}
+			acc = vpadalq_u16(acc, vreinterpretq_u16_u8(v));
+			src += 16;
+		}
+
+		acc64 = vpaddlq_u32(acc);
+		sum = cs_add64(sum, vgetq_lane_u64(acc64, 0));
+		sum = cs_add64(sum, vgetq_lane_u64(acc64, 1));
+	}
+
+	return sum;
+}
+
+#define CS_BLOCK_SIZE 16
+
+#else
+
+/** Sum (and optionally copy) whole 8-byte blocks.
+ *
+ * @param sum Running 64-bit sum
+ * @param dst Destination buffer or @c NULL
+ * @param src Source data
+ * @param nblocks Number of 8-byte blocks
+ * @return Updated 64-bit sum
+ */
+static inline uint64_t cs_sum_blocks(uint64_t sum, uint8_t *dst,
+    const uint8_t *src, size_t nblocks)
+{
+	uint64_t v;
+
+	while (nblocks-- > 0) {
+		memcpy(&v, src, sizeof(v));
+		if (dst != NULL) {
+			memcpy(dst, &v, sizeof(v));
+			dst += sizeof(v);
+		}
+		sum = cs_add64(sum, v);
+		src += sizeof(v);
+	}
+
+	return sum;
+}
+
+#define CS_BLOCK_SIZE 8
+
+#endif
+
+/** Compute Internet checksum, optionally copying the data.
+ *
+ * @param ivalue Initial value (result of previous computation)
+ * @param dst Destination buffer or @c NULL not to copy
+ * @param src Source data
+ * @param size Size of data in bytes
+ * @return Internet checksum
+ */
+static inline uint16_t cs_calc(uint16_t ivalue, uint8_t *dst,
+    const uint8_t *src, size_t size)
+{
+	uint64_t sum64;
+	uint64_t tail;
+	uint32_t s;
+	size_t nblocks;
+	size_t rem;
+	uint16_t sum;
+
+	nblocks = size / CS_BLOCK_SIZE;
+	rem = size % CS_BLOCK_SIZE;
+
+	sum64 = cs_sum_blocks(0, dst, src, nblocks);
+	src += nblocks * CS_BLOCK_SIZE;
+	if (dst != NULL)
+		dst += nblocks * CS_BLOCK_SIZE;
+
+	/*
+	 * Sum the remainder as 64-bit words. A trailing odd byte ends up
+	 * padded with a zero byte, as required.
+	 */
+	while (rem > 0) {
+		size_t n = rem < sizeof(tail) ? rem : sizeof(tail);
+
+		tail = 0;
+		memcpy(&tail, src, n);
+		if (dst != NULL) {
+			memcpy(dst, src, n);
+			dst += n;
+		}
+		sum64 = cs_add64(sum64, tail);
+		src += n;
+		rem -= n;
+	}
+
+	sum = cs_fold64(sum64);
+#ifdef __LE__
+	/* We summed little-endian words, swap to get the network order sum */
+	sum = (uint16_t) ((sum << 8) | (sum >> 8));
+#endif
+
+	s = (uint32_t) (uint16_t) ~ivalue + sum;
+	s = (s & 0xffff) + (s >> 16);
+	return ~s;
+}
+
+/** Compute Internet checksum.
+ *
+ * The checksum can be computed over several discontiguous pieces of data
+ * by passing the result of the previous computation as @a ivalue. All
+ * pieces except the last one must have even size.
+ *
+ * @param ivalue Initial value, @c INET_CHECKSUM_INIT or result of previous
+ *               computation
+ * @param data Data
+ * @param size Size of data in bytes
+ * @return Internet checksum (in host byte order)
+ */
+uint16_t inet_checksum_calc(uint16_t ivalue, const void *data, size_t size)
+{
+	return cs_calc(ivalue, NULL, data, size);
+}
+
+/** Copy data and compute its Internet checksum in one pass.
+ *
+ * Equivalent to memcpy() followed by inet_checksum_calc() on the
+ * destination, but touches the data only once.
+ *
+ * @param ivalue Initial value, @c INET_CHECKSUM_INIT or result of previous
+ *               computation
+ * @param dst Destination buffer
+ * @param src Source data
+ * @param size Size of data in bytes
+ * @return Internet checksum (in host byte order)
+ */
+uint16_t inet_checksum_copy(uint16_t ivalue, void *dst, const void *src,
+    size_t size)
+{
+	return cs_calc(ivalue, dst, src, size);
+}
+
+/** @}
+ */
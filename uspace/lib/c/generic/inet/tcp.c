@@ -32,13 +32,17 @@
 /** @file TCP API
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <errno.h>
 #include <fibril.h>
 #include <inet/endpoint.h>
 #include <inet/tcp.h>
 #include <ipc/services.h>
 #include <ipc/tcp.h>
+#include <macros.h>
 #include <stdlib.h>
+#include <vfs/vfs.h>
 
 static void tcp_cb_conn(ipc_call_t *, void *);
 static errno_t tcp_conn_fibril(void *);
@@ -55,6 +59,34 @@ typedef struct {
 	tcp_conn_t *conn;
 } tcp_in_conn_t;
 
+static size_t tcp_conn_hash(const ht_link_t *item)
+{
+	tcp_conn_t *conn = hash_table_get_inst(item, tcp_conn_t, ltcp);
+
+	return hash_mix(conn->id);
+}
+
+static size_t tcp_conn_key_hash(const void *key)
+{
+	return hash_mix(*(const sysarg_t *) key);
+}
+
+static bool tcp_conn_key_equal(const void *key, const ht_link_t *item)
+{
+	tcp_conn_t *conn = hash_table_get_inst(item, tcp_conn_t, ltcp);
+
+	return conn->id == *(const sysarg_t *) key;
+}
+
+/** Connection map operations */
+static hash_table_ops_t tcp_conn_map_ops = {
+	.hash = tcp_conn_hash,
+	.key_hash = tcp_conn_key_hash,
+	.key_equal = tcp_conn_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
 /** Create callback connection from TCP service.
  *
  * @param tcp TCP service
@@ -99,7 +131,13 @@ errno_t tcp_create(tcp_t **rtcp)
 		goto error;
 	}
 
-	list_initialize(&tcp->conn);
+	if (!hash_table_create(&tcp->conn, 0, 0, &tcp_conn_map_ops)) {
+		free(tcp);
+		tcp = NULL;
+		rc = ENOMEM;
+		goto error;
+	}
+
 	list_initialize(&tcp->listener);
 	fibril_mutex_initialize(&tcp->lock);
 	fibril_condvar_initialize(&tcp->cv);
@@ -127,6 +165,8 @@ errno_t tcp_create(tcp_t **rtcp)
 	*rtcp = tcp;
 	return EOK;
 error:
+	if (tcp != NULL)
+		hash_table_destroy(&tcp->conn);
 	free(tcp);
 	return rc;
 }
@@ -147,6 +187,7 @@ void tcp_destroy(tcp_t *tcp)
 		fibril_condvar_wait(&tcp->cv, &tcp->lock);
 	fibril_mutex_unlock(&tcp->lock);
 
+	hash_table_destroy(&tcp->conn);
 	free(tcp);
 }
 
@@ -178,7 +219,7 @@ static errno_t tcp_conn_new(tcp_t *tcp, sysarg_t id, tcp_cb_t *cb, void *arg,
 	conn->cb = cb;
 	conn->cb_arg = arg;
 
-	list_append(&conn->ltcp, &tcp->conn);
+	hash_table_insert(&tcp->conn, &conn->ltcp);
 	*rconn = conn;
 
 	return EOK;
@@ -256,7 +297,7 @@ void tcp_conn_destroy(tcp_conn_t *conn)
 	if (conn == NULL)
 		return;
 
-	list_remove(&conn->ltcp);
+	hash_table_remove_item(&conn->tcp->conn, &conn->ltcp);
 
 	exch = async_exchange_begin(conn->tcp->sess);
 	errno_t rc = async_req_1_0(exch, TCP_CONN_DESTROY, conn->id);
@@ -276,14 +317,14 @@ void tcp_conn_destroy(tcp_conn_t *conn)
  */
 static errno_t tcp_conn_get(tcp_t *tcp, sysarg_t id, tcp_conn_t **rconn)
 {
-	list_foreach(tcp->conn, ltcp, tcp_conn_t, conn) {
-		if (conn->id == id) {
-			*rconn = conn;
-			return EOK;
-		}
-	}
+	ht_link_t *link;
 
-	return EINVAL;
+	link = hash_table_find(&tcp->conn, &id);
+	if (link == NULL)
+		return EINVAL;
+
+	*rconn = hash_table_get_inst(link, tcp_conn_t, ltcp);
+	return EOK;
 }
 
 /** Get the user/callback argument for a connection.
@@ -383,6 +424,29 @@ void tcp_listener_destroy(tcp_listener_t *lst)
 	(void) rc;
 }
 
+/** Set TCP connection listener backlog.
+ *
+ * The backlog limits the number of incoming connections that are being
+ * established (i.e. have received SYN, but not completed the handshake).
+ * While the limit is reached, further connection attempts are ignored.
+ *
+ * @param lst     Listener
+ * @param backlog Maximum number of connections being established
+ *
+ * @return EOK on success, EINVAL if @a backlog is zero or other error code
+ */
+errno_t tcp_listener_set_backlog(tcp_listener_t *lst, size_t backlog)
+{
+	async_exch_t *exch;
+
+	exch = async_exchange_begin(lst->tcp->sess);
+	errno_t rc = async_req_2_0(exch, TCP_LISTENER_SET_BACKLOG, lst->id,
+	    backlog);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
 /** Get TCP connection listener based on its ID.
  *
  * @param tcp TCP client
@@ -471,6 +535,84 @@ errno_t tcp_conn_send(tcp_conn_t *conn, const void *data, size_t bytes)
 	return rc;
 }
 
+/** Send data from file.
+ *
+ * Read data from file @a fd starting at position @a pos and send it over
+ * the connection. Data is transferred in chunks of the maximum IPC data
+ * transfer size. Reading the next chunk from the file overlaps with
+ * the TCP service processing the previous one.
+ *
+ * @param conn  Connection
+ * @param fd    File descriptor
+ * @param pos   Position in file, advanced by the number of bytes read
+ * @param size  Number of bytes to send
+ * @param nsent Place to store number of bytes sent (less than @a size
+ *              if end of file was reached) or @c NULL
+ *
+ * @return EOK on success or an error code
+ */
+errno_t tcp_conn_send_file(tcp_conn_t *conn, int fd, aoff64_t *pos,
+    size_t size, size_t *nsent)
+{
+	async_exch_t *exch;
+	aid_t req = 0;
+	void *buf;
+	size_t bsize;
+	size_t sent;
+	size_t nr;
+	errno_t rc;
+	errno_t retval;
+
+	bsize = min(size, (size_t) DATA_XFER_LIMIT);
+	buf = malloc(max(bsize, (size_t) 1));
+	if (buf == NULL)
+		return ENOMEM;
+
+	sent = 0;
+	rc = EOK;
+	while (sent < size) {
+		rc = vfs_read(fd, pos, buf, min(size - sent, bsize), &nr);
+
+		/* Wait for previous chunk to be accepted */
+		if (req != 0) {
+			async_wait_for(req, &retval);
+			req = 0;
+			if (retval != EOK) {
+				rc = retval;
+				break;
+			}
+		}
+
+		if (rc != EOK || nr == 0)
+			break;
+
+		exch = async_exchange_begin(conn->tcp->sess);
+		req = async_send_1(exch, TCP_CONN_SEND, conn->id, NULL);
+		rc = async_data_write_start(exch, buf, nr);
+		async_exchange_end(exch);
+
+		if (rc != EOK) {
+			async_forget(req);
+			req = 0;
+			break;
+		}
+
+		sent += nr;
+	}
+
+	if (req != 0) {
+		async_wait_for(req, &retval);
+		if (retval != EOK && rc == EOK)
+			rc = retval;
+	}
+
+	free(buf);
+
+	if (nsent != NULL)
+		*nsent = sent;
+	return rc;
+}
+
 /** Send FIN.
  *
  * Send FIN, indicating no more data will be send over the connection.
@@ -796,7 +938,9 @@ static void tcp_ev_new_conn(tcp_t *tcp, ipc_call_t *icall)
 
 		fid = fibril_create(tcp_conn_fibril, cinfo);
 		if (fid == 0) {
+			free(cinfo);
 			async_answer_0(icall, ENOMEM);
+			return;
 		}
 
 		fibril_add_ready(fid);
@@ -867,6 +1011,7 @@ static errno_t tcp_conn_fibril(void *arg)
 
 	cinfo->lst->lcb->new_conn(cinfo->lst, cinfo->conn);
 	tcp_conn_destroy(cinfo->conn);
+	free(cinfo);
 
 	return EOK;
 }
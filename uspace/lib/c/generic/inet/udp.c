@@ -38,6 +38,8 @@
 #include <ipc/services.h>
 #include <ipc/udp.h>
 #include <loc.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 static void udp_cb_conn(ipc_call_t *, void *);
@@ -90,6 +92,12 @@ errno_t udp_create(udp_t **rudp)
 	fibril_mutex_initialize(&udp->lock);
 	fibril_condvar_initialize(&udp->cv);
 
+	udp->rbuf = malloc(DATA_XFER_LIMIT);
+	if (udp->rbuf == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
 	rc = loc_service_get_id(SERVICE_NAME_UDP, &udp_svcid,
 	    IPC_FLAG_BLOCKING);
 	if (rc != EOK) {
@@ -113,6 +121,8 @@ errno_t udp_create(udp_t **rudp)
 	*rudp = udp;
 	return EOK;
 error:
+	if (udp != NULL)
+		free(udp->rbuf);
 	free(udp);
 	return rc;
 }
@@ -133,6 +143,7 @@ void udp_destroy(udp_t *udp)
 		fibril_condvar_wait(&udp->cv, &udp->lock);
 	fibril_mutex_unlock(&udp->lock);
 
+	free(udp->rbuf);
 	free(udp);
 }
 
@@ -284,6 +295,126 @@ errno_t udp_assoc_send_msg(udp_assoc_t *assoc, inet_ep_t *dest, void *data,
 	return rc;
 }
 
+/** Send one batch of messages via UDP association.
+ *
+ * @param assoc Association
+ * @param buf   Multi-message buffer
+ * @param size  Size of @a buf in bytes
+ * @param rsent Place to store number of messages sent
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t udp_assoc_send_batch(udp_assoc_t *assoc, void *buf,
+    size_t size, size_t *rsent)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+
+	*rsent = 0;
+
+	exch = async_exchange_begin(assoc->udp->sess);
+	aid_t req = async_send_1(exch, UDP_ASSOC_SEND_MMSG, assoc->id,
+	    &answer);
+	errno_t rc = async_data_write_start(exch, buf, size);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	async_wait_for(req, &rc);
+	*rsent = ipc_get_arg1(&answer);
+	return rc;
+}
+
+/** Send multiple messages via UDP association.
+ *
+ * Messages are packed together with their destination endpoints into
+ * a single buffer, which is transferred to the UDP service in one
+ * request. Messages that do not fit in one transfer are sent in several
+ * batches. Sending stops at the first message that fails.
+ *
+ * @param assoc Association
+ * @param msgs  Messages
+ * @param cnt   Number of messages
+ * @param rsent Place to store number of messages sent or @c NULL
+ *
+ * @return EOK if all messages were sent or an error code
+ */
+errno_t udp_assoc_send_mmsg(udp_assoc_t *assoc, udp_mmsg_t *msgs, size_t cnt,
+    size_t *rsent)
+{
+	udp_mmsg_hdr_t *hdr;
+	uint8_t *buf = NULL;
+	size_t buf_size = 0;
+	size_t sent = 0;
+	size_t nsent;
+	size_t size;
+	size_t off;
+	size_t i, n;
+	errno_t rc = EOK;
+
+	while (sent < cnt) {
+		if (UDP_MMSG_SPACE(msgs[sent].size) > DATA_XFER_LIMIT) {
+			/* Message too large to be batched */
+			rc = udp_assoc_send_msg(assoc, msgs[sent].dest,
+			    msgs[sent].data, msgs[sent].size);
+			if (rc != EOK)
+				break;
+
+			++sent;
+			continue;
+		}
+
+		/* Determine how many messages fit in one batch */
+		size = 0;
+		n = sent;
+		while (n < cnt && size + UDP_MMSG_SPACE(msgs[n].size) <=
+		    DATA_XFER_LIMIT) {
+			size += UDP_MMSG_SPACE(msgs[n].size);
+			++n;
+		}
+
+		if (size > buf_size) {
+			free(buf);
+			buf = malloc(size);
+			if (buf == NULL) {
+				rc = ENOMEM;
+				break;
+			}
+
+			buf_size = size;
+		}
+
+		off = 0;
+		for (i = sent; i < n; i++) {
+			hdr = (udp_mmsg_hdr_t *) (buf + off);
+			memset(hdr, 0, sizeof(udp_mmsg_hdr_t));
+			if (msgs[i].dest != NULL)
+				hdr->remote_ep = *msgs[i].dest;
+			else
+				inet_ep_init(&hdr->remote_ep);
+			hdr->size = msgs[i].size;
+
+			memcpy(buf + off + sizeof(udp_mmsg_hdr_t), msgs[i].data,
+			    msgs[i].size);
+			off += UDP_MMSG_SPACE(msgs[i].size);
+		}
+
+		rc = udp_assoc_send_batch(assoc, buf, size, &nsent);
+		sent += min(nsent, n - sent);
+		if (rc != EOK)
+			break;
+	}
+
+	free(buf);
+
+	if (rsent != NULL)
+		*rsent = sent;
+	return rc;
+}
+
 /** Get the user/callback argument for an association.
  *
  * @param assoc UDP association
@@ -322,6 +453,16 @@ errno_t udp_rmsg_read(udp_rmsg_t *rmsg, size_t off, void *buf, size_t bsize)
 	async_exch_t *exch;
 	ipc_call_t answer;
 
+	if (rmsg->data != NULL) {
+		/* Message data has been transferred already */
+		if (off > rmsg->size)
+			return EINVAL;
+
+		memcpy(buf, (uint8_t *) rmsg->data + off,
+		    min(rmsg->size - off, bsize));
+		return EOK;
+	}
+
 	exch = async_exchange_begin(rmsg->udp->sess);
 	aid_t req = async_send_1(exch, UDP_RMSG_READ, off, &answer);
 	errno_t rc = async_data_read_start(exch, buf, bsize);
@@ -406,6 +547,44 @@ static errno_t udp_rmsg_info(udp_t *udp, udp_rmsg_t *rmsg)
 	rmsg->assoc_id = ipc_get_arg1(&answer);
 	rmsg->size = ipc_get_arg2(&answer);
 	rmsg->remote_ep = ep;
+	rmsg->data = NULL;
+	return EOK;
+}
+
+/** Read a batch of received messages from UDP service.
+ *
+ * The messages are stored in @c udp->rbuf and discarded in the service.
+ *
+ * @param udp   UDP client
+ * @param rcnt  Place to store number of messages
+ * @param rsize Place to store number of bytes used in @c udp->rbuf
+ *
+ * @return EOK on success, ENOENT if there are no messages, ELIMIT if
+ *         the next message is too large to be transferred in a batch
+ *         or another error code
+ */
+static errno_t udp_rmsg_read_mmsg(udp_t *udp, size_t *rcnt, size_t *rsize)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+
+	exch = async_exchange_begin(udp->sess);
+	aid_t req = async_send_0(exch, UDP_RMSG_READ_MMSG, &answer);
+	errno_t rc = async_data_read_start(exch, udp->rbuf, DATA_XFER_LIMIT);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK)
+		return retval;
+
+	*rcnt = ipc_get_arg1(&answer);
+	*rsize = min((size_t) ipc_get_arg2(&answer), (size_t) DATA_XFER_LIMIT);
 	return EOK;
 }
 
@@ -445,39 +624,114 @@ static errno_t udp_assoc_get(udp_t *udp, sysarg_t id, udp_assoc_t **rassoc)
 	return EINVAL;
 }
 
-/** Handle 'data' event, i.e. some message(s) arrived.
+/** Deliver next received message transferred piece-wise.
  *
- * For each received message, get information about it, call @c recv_msg
+ * Get information about the next received message, call @c recv_msg
  * callback and discard it.
  *
+ * @param udp UDP client
+ * @return EOK on success or an error code
+ */
+static errno_t udp_rmsg_deliver_one(udp_t *udp)
+{
+	udp_rmsg_t rmsg;
+	udp_assoc_t *assoc;
+	errno_t rc;
+
+	rc = udp_rmsg_info(udp, &rmsg);
+	if (rc != EOK)
+		return rc;
+
+	rc = udp_assoc_get(udp, rmsg.assoc_id, &assoc);
+	if (rc == EOK && assoc->cb != NULL && assoc->cb->recv_msg != NULL)
+		assoc->cb->recv_msg(assoc, &rmsg);
+
+	return udp_rmsg_discard(udp);
+}
+
+/** Deliver batch of received messages.
+ *
+ * Call @c recv_msg callback for each message in @c udp->rbuf.
+ *
+ * @param udp  UDP client
+ * @param cnt  Number of messages
+ * @param size Number of bytes used in @c udp->rbuf
+ */
+static void udp_rmsg_deliver_batch(udp_t *udp, size_t cnt, size_t size)
+{
+	udp_mmsg_hdr_t *hdr;
+	udp_rmsg_t rmsg;
+	udp_assoc_t *assoc;
+	size_t off;
+	size_t i;
+	errno_t rc;
+
+	off = 0;
+	for (i = 0; i < cnt; i++) {
+		if (size - off < sizeof(udp_mmsg_hdr_t))
+			break;
+
+		hdr = (udp_mmsg_hdr_t *) ((uint8_t *) udp->rbuf + off);
+		if (size - off < UDP_MMSG_SPACE(hdr->size))
+			break;
+
+		rmsg.udp = udp;
+		rmsg.assoc_id = hdr->assoc_id;
+		rmsg.size = hdr->size;
+		rmsg.remote_ep = hdr->remote_ep;
+		rmsg.data = (uint8_t *) hdr + sizeof(udp_mmsg_hdr_t);
+
+		rc = udp_assoc_get(udp, rmsg.assoc_id, &assoc);
+		if (rc == EOK && assoc->cb != NULL &&
+		    assoc->cb->recv_msg != NULL)
+			assoc->cb->recv_msg(assoc, &rmsg);
+
+		off += UDP_MMSG_SPACE(hdr->size);
+	}
+}
+
+/** Handle 'data' event, i.e. some message(s) arrived.
+ *
+ * Transfer received messages in batches and call @c recv_msg callback
+ * for each of them. Messages too large for a batch (or if the batch
+ * transfer fails) are transferred piece-wise.
+ *
+ * The service only sends another event once the queue has been empty,
+ * so the queue must be drained completely. A message that cannot be
+ * transferred is dropped.
+ *
  * @param udp   UDP client
  * @param icall IPC message
  *
  */
 static void udp_ev_data(udp_t *udp, ipc_call_t *icall)
 {
-	udp_rmsg_t rmsg;
-	udp_assoc_t *assoc;
+	size_t cnt;
+	size_t size;
 	errno_t rc;
 
 	while (true) {
-		rc = udp_rmsg_info(udp, &rmsg);
-		if (rc != EOK) {
+		rc = udp_rmsg_read_mmsg(udp, &cnt, &size);
+		if (rc == ENOENT)
 			break;
-		}
 
-		rc = udp_assoc_get(udp, rmsg.assoc_id, &assoc);
 		if (rc != EOK) {
+			/* Batch too large or failed, fall back to piece-wise */
+			rc = udp_rmsg_deliver_one(udp);
+			if (rc == EOK || rc == ENOENT)
+				continue;
+
+			/* Drop the message we failed to transfer */
+			rc = udp_rmsg_discard(udp);
+			if (rc != EOK && rc != ENOENT)
+				break;
 			continue;
 		}
 
-		if (assoc->cb != NULL && assoc->cb->recv_msg != NULL)
-			assoc->cb->recv_msg(assoc, &rmsg);
-
-		rc = udp_rmsg_discard(udp);
-		if (rc != EOK) {
+		if (cnt == 0)
 			break;
-		}
+
+		udp_rmsg_deliver_batch(udp, cnt, size);
 	}
 
 	async_answer_0(icall, EOK);
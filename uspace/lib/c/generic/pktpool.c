@@ -0,0 +1,460 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup libc
+ * @{
+ */
+
+/** @file Shared packet buffer pool
+ *
+ * A pool is a single shared memory area holding a fixed number of
+ * equally sized packet buffers and two single-producer single-consumer
+ * rings. The producer (e.g. a NIC driver) allocates a buffer, writes a
+ * packet into it and posts a descriptor (buffer index and length) to the
+ * receive ring. The consumer fetches descriptors, processes the packet in
+ * place and hands the buffer back through the free ring. Packet data is
+ * therefore never copied between the two tasks; only buffer ownership,
+ * expressed by index, travels between them.
+ *
+ * The rings contain free-running positions, so each ring has exactly
+ * as many slots as there are buffers and can never overflow. Neither
+ * side trusts values read from the shared area, since the other task
+ * can modify it at any time.
+ */
+
+#include <as.h>
+#include <assert.h>
+#include <errno.h>
+#include <pktpool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/** Magic number identifying the shared area ("PKTP") */
+#define PKTPOOL_MAGIC  0x504b5450
+
+/** Buffer alignment */
+#define PKTPOOL_ALIGN  64
+
+/** State of a buffer as seen by the producer */
+typedef enum {
+	/** In the free ring or with the consumer */
+	pktpool_buf_free = 0,
+	/** Allocated by the producer */
+	pktpool_buf_alloc,
+	/** Allocated and returned to the stash */
+	pktpool_buf_stashed
+} pktpool_buf_state_t;
+
+/** Packet descriptor */
+typedef struct {
+	/** Buffer index */
+	uint32_t idx;
+	/** Packet length */
+	uint32_t size;
+} pktpool_desc_t;
+
+/** Header at the start of the shared area */
+typedef struct {
+	uint32_t magic;
+	/** Number of buffers (a power of two) */
+	uint32_t count;
+	/** Size of each buffer */
+	uint32_t buf_size;
+	/** Offset of the first buffer from the start of the area */
+	uint32_t buf_offs;
+	/** Receive ring write position (advanced by the producer) */
+	_Atomic uint32_t rx_head;
+	/** Receive ring read position (advanced by the consumer) */
+	_Atomic uint32_t rx_tail;
+	/** Free ring write position (advanced by the consumer) */
+	_Atomic uint32_t free_head;
+	/** Free ring read position (advanced by the producer) */
+	_Atomic uint32_t free_tail;
+} pktpool_hdr_t;
+
+/** Task-local view of a pool */
+struct pktpool {
+	/** Shared area */
+	pktpool_hdr_t *hdr;
+	/** Size of the shared area */
+	size_t area_size;
+	/** The area was created (and will be destroyed) by us */
+	bool owner;
+	/** Number of buffers, validated local copy */
+	uint32_t count;
+	/** Buffer size, validated local copy */
+	uint32_t buf_size;
+	/** Receive ring */
+	pktpool_desc_t *rx;
+	/** Free ring */
+	uint32_t *free;
+	/** Packet buffers */
+	uint8_t *bufs;
+	/** Buffers returned by the producer without posting them */
+	uint32_t *stash;
+	/** Number of entries in @c stash */
+	size_t nstash;
+	/** Producer-side state of each buffer (pktpool_buf_state_t) */
+	uint8_t *state;
+};
+
+/** Compute the layout of a pool area.
+ *
+ * @param count    Number of buffers
+ * @param buf_size Buffer size
+ * @param buf_offs Place to store offset of the first buffer
+ *
+ * @return Size of the area
+ */
+static size_t pktpool_layout(size_t count, size_t buf_size, size_t *buf_offs)
+{
+	size_t offs = sizeof(pktpool_hdr_t) + count * sizeof(pktpool_desc_t) +
+	    count * sizeof(uint32_t);
+	offs = (offs + PKTPOOL_ALIGN - 1) & ~((size_t) PKTPOOL_ALIGN - 1);
+
+	*buf_offs = offs;
+	return offs + count * buf_size;
+}
+
+/** Fill in the task-local pointers into the shared area. */
+static void pktpool_map(pktpool_t *pool, uint32_t buf_offs)
+{
+	pool->rx = (pktpool_desc_t *) (pool->hdr + 1);
+	pool->free = (uint32_t *) (pool->rx + pool->count);
+	pool->bufs = (uint8_t *) pool->hdr + buf_offs;
+}
+
+/** Create a new packet buffer pool.
+ *
+ * The caller becomes the producer. The area returned by pktpool_area()
+ * should be shared with the consumer, which passes it to pktpool_attach().
+ *
+ * @param count    Number of buffers, must be a power of two
+ * @param buf_size Size of each buffer
+ * @param rpool    Place to store pointer to the new pool
+ *
+ * @return EOK on success, EINVAL if the parameters are invalid,
+ *         ENOMEM if out of memory
+ */
+errno_t pktpool_create(size_t count, size_t buf_size, pktpool_t **rpool)
+{
+	if (count == 0 || (count & (count - 1)) != 0 || count > UINT16_MAX ||
+	    buf_size == 0 || buf_size > UINT16_MAX)
+		return EINVAL;
+
+	buf_size = (buf_size + PKTPOOL_ALIGN - 1) & ~((size_t) PKTPOOL_ALIGN - 1);
+
+	pktpool_t *pool = calloc(1, sizeof(pktpool_t));
+	if (pool == NULL)
+		return ENOMEM;
+
+	pool->stash = calloc(count, sizeof(uint32_t));
+	pool->state = calloc(count, sizeof(uint8_t));
+	if (pool->stash == NULL || pool->state == NULL) {
+		free(pool->stash);
+		free(pool->state);
+		free(pool);
+		return ENOMEM;
+	}
+
+	size_t buf_offs;
+	pool->area_size = pktpool_layout(count, buf_size, &buf_offs);
+	pool->hdr = as_area_create(AS_AREA_ANY, pool->area_size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (pool->hdr == AS_MAP_FAILED) {
+		free(pool->stash);
+		free(pool->state);
+		free(pool);
+		return ENOMEM;
+	}
+
+	pool->owner = true;
+	pool->count = count;
+	pool->buf_size = buf_size;
+	pktpool_map(pool, buf_offs);
+
+	pool->hdr->magic = PKTPOOL_MAGIC;
+	pool->hdr->count = count;
+	pool->hdr->buf_size = buf_size;
+	pool->hdr->buf_offs = buf_offs;
+
+	/* All buffers start out in the free ring */
+	for (size_t i = 0; i < count; i++)
+		pool->free[i] = i;
+
+	atomic_store(&pool->hdr->rx_head, 0);
+	atomic_store(&pool->hdr->rx_tail, 0);
+	atomic_store(&pool->hdr->free_tail, 0);
+	atomic_store(&pool->hdr->free_head, count);
+
+	*rpool = pool;
+	return EOK;
+}
+
+/** Attach to a packet buffer pool created by another task.
+ *
+ * The caller becomes the consumer. The area remains owned by the caller
+ * and is not destroyed by pktpool_destroy().
+ *
+ * @param area  Shared area
+ * @param size  Size of the shared area
+ * @param rpool Place to store pointer to the pool
+ *
+ * @return EOK on success, EINVAL if the area does not hold a valid pool,
+ *         ENOMEM if out of memory
+ */
+errno_t pktpool_attach(void *area, size_t size, pktpool_t **rpool)
+{
+	pktpool_hdr_t *hdr = (pktpool_hdr_t *) area;
+
+	if (size < sizeof(pktpool_hdr_t) || hdr->magic != PKTPOOL_MAGIC)
+		return EINVAL;
+
+	uint32_t count = hdr->count;
+	uint32_t buf_size = hdr->buf_size;
+	size_t buf_offs;
+
+	if (count == 0 || (count & (count - 1)) != 0 || count > UINT16_MAX ||
+	    buf_size == 0 || buf_size > UINT16_MAX ||
+	    pktpool_layout(count, buf_size, &buf_offs) > size ||
+	    hdr->buf_offs != buf_offs)
+		return EINVAL;
+
+	pktpool_t *pool = calloc(1, sizeof(pktpool_t));
+	if (pool == NULL)
+		return ENOMEM;
+
+	pool->hdr = hdr;
+	pool->area_size = size;
+	pool->owner = false;
+	pool->count = count;
+	pool->buf_size = buf_size;
+	pktpool_map(pool, buf_offs);
+
+	*rpool = pool;
+	return EOK;
+}
+
+/** Destroy the task-local view of a pool.
+ *
+ * If the pool was created by pktpool_create(), its area is destroyed
+ * as well. The other task keeps its own mapping of the area.
+ *
+ * @param pool Packet buffer pool
+ */
+void pktpool_destroy(pktpool_t *pool)
+{
+	if (pool == NULL)
+		return;
+
+	if (pool->owner)
+		as_area_destroy(pool->hdr);
+
+	free(pool->stash);
+	free(pool->state);
+	free(pool);
+}
+
+/** Get the shared area of a pool.
+ *
+ * @param pool Packet buffer pool
+ * @param size Place to store size of the area
+ * @return Start of the area
+ */
+void *pktpool_area(pktpool_t *pool, size_t *size)
+{
+	*size = pool->area_size;
+	return pool->hdr;
+}
+
+/** Get the size of the buffers of a pool. */
+size_t pktpool_buf_size(pktpool_t *pool)
+{
+	return pool->buf_size;
+}
+
+/** Get the data of a pool buffer.
+ *
+ * @param pool Packet buffer pool
+ * @param idx  Buffer index obtained from pktpool_alloc() or pktpool_fetch()
+ * @return Start of the buffer
+ */
+void *pktpool_data(pktpool_t *pool, size_t idx)
+{
+	assert(idx < pool->count);
+	return pool->bufs + idx * pool->buf_size;
+}
+
+/** Allocate a buffer (producer side).
+ *
+ * @param pool Packet buffer pool
+ * @param ridx Place to store the buffer index
+ *
+ * @return EOK on success, ENOMEM if all buffers are in use
+ */
+errno_t pktpool_alloc(pktpool_t *pool, size_t *ridx)
+{
+	if (pool->nstash > 0) {
+		uint32_t idx = pool->stash[--pool->nstash];
+		pool->state[idx] = pktpool_buf_alloc;
+		*ridx = idx;
+		return EOK;
+	}
+
+	pktpool_hdr_t *hdr = pool->hdr;
+	uint32_t tail = atomic_load_explicit(&hdr->free_tail,
+	    memory_order_relaxed);
+
+	while (true) {
+		uint32_t head = atomic_load_explicit(&hdr->free_head,
+		    memory_order_acquire);
+		if (head == tail || head - tail > pool->count)
+			return ENOMEM;
+
+		uint32_t idx = pool->free[tail % pool->count];
+		atomic_store_explicit(&hdr->free_tail, ++tail,
+		    memory_order_release);
+
+		/*
+		 * Skip indices corrupted by the consumer, including buffers
+		 * it hands back while we already hold them.
+		 */
+		if (idx < pool->count && pool->state[idx] == pktpool_buf_free) {
+			pool->state[idx] = pktpool_buf_alloc;
+			*ridx = idx;
+			return EOK;
+		}
+	}
+}
+
+/** Return an allocated buffer without posting it (producer side).
+ *
+ * Indices of buffers that are not currently allocated are ignored.
+ *
+ * @param pool Packet buffer pool
+ * @param idx  Buffer index
+ */
+void pktpool_discard(pktpool_t *pool, size_t idx)
+{
+	if (idx >= pool->count || pool->state[idx] != pktpool_buf_alloc)
+		return;
+
+	assert(pool->nstash < pool->count);
+	pool->state[idx] = pktpool_buf_stashed;
+	pool->stash[pool->nstash++] = idx;
+}
+
+/** Post a filled buffer to the consumer (producer side).
+ *
+ * The caller must notify the consumer if the function returns true.
+ * No notification is needed otherwise, because the consumer is still
+ * busy draining the ring and will see the new descriptor.
+ *
+ * @param pool Packet buffer pool
+ * @param idx  Buffer index
+ * @param size Length of the packet in the buffer
+ *
+ * @return @c true if the consumer may have gone idle and needs a wakeup
+ */
+bool pktpool_post(pktpool_t *pool, size_t idx, size_t size)
+{
+	assert(idx < pool->count);
+	assert(size <= pool->buf_size);
+	assert(pool->state[idx] == pktpool_buf_alloc);
+
+	pool->state[idx] = pktpool_buf_free;
+
+	pktpool_hdr_t *hdr = pool->hdr;
+	uint32_t head = atomic_load_explicit(&hdr->rx_head,
+	    memory_order_relaxed);
+
+	pool->rx[head % pool->count].idx = idx;
+	pool->rx[head % pool->count].size = size;
+	atomic_store(&hdr->rx_head, head + 1);
+
+	/*
+	 * Sequentially consistent ordering of the head store above and the
+	 * tail load below against the consumer's tail store and head load
+	 * guarantees that either the consumer sees the new descriptor or
+	 * we see that it has consumed everything before it.
+	 */
+	return atomic_load(&hdr->rx_tail) == head;
+}
+
+/** Fetch the next posted buffer (consumer side).
+ *
+ * @param pool  Packet buffer pool
+ * @param ridx  Place to store the buffer index
+ * @param rsize Place to store the packet length
+ *
+ * @return @c true if a buffer was fetched, @c false if the ring is empty
+ */
+bool pktpool_fetch(pktpool_t *pool, size_t *ridx, size_t *rsize)
+{
+	pktpool_hdr_t *hdr = pool->hdr;
+	uint32_t tail = atomic_load_explicit(&hdr->rx_tail,
+	    memory_order_relaxed);
+
+	while (true) {
+		uint32_t head = atomic_load(&hdr->rx_head);
+		if (head == tail || head - tail > pool->count)
+			return false;
+
+		pktpool_desc_t desc = pool->rx[tail % pool->count];
+		atomic_store(&hdr->rx_tail, ++tail);
+
+		/* Skip descriptors corrupted by the producer */
+		if (desc.idx < pool->count && desc.size <= pool->buf_size) {
+			*ridx = desc.idx;
+			*rsize = desc.size;
+			return true;
+		}
+	}
+}
+
+/** Hand a fetched buffer back to the producer (consumer side).
+ *
+ * @param pool Packet buffer pool
+ * @param idx  Buffer index obtained from pktpool_fetch()
+ */
+void pktpool_release(pktpool_t *pool, size_t idx)
+{
+	assert(idx < pool->count);
+
+	pktpool_hdr_t *hdr = pool->hdr;
+	uint32_t head = atomic_load_explicit(&hdr->free_head,
+	    memory_order_relaxed);
+
+	pool->free[head % pool->count] = idx;
+	atomic_store_explicit(&hdr->free_head, head + 1, memory_order_release);
+}
+
+/** @}
+ */
@@ -44,6 +44,7 @@
 #include <stdlib.h>
 #include <str.h>
 #include <macros.h>
+#include <perf.h>
 
 #include <rtld/rtld.h>
 #include <rtld/rtld_debug.h>
@@ -100,30 +101,56 @@ errno_t module_create_static_exec(rtld_t *rtld, module_t **rmodule)
 	return EOK;
 }
 
-/** (Eagerly) process all relocation tables in a module.
+/** Process all relocation tables in a module.
  *
- * Currently works as if LD_BIND_NOW was specified.
+ * PLT relocations are bound lazily on the first call if the architecture
+ * supports it, unless the module requests immediate binding (DT_BIND_NOW).
+ * All other relocations are processed eagerly.
  */
 void module_process_relocs(module_t *m)
 {
+#ifdef RTLD_TIMING
+	stopwatch_t sw;
+	size_t lookups = m->rtld->sym_lookups;
+	size_t hits = m->rtld->sym_cache_hits;
+	size_t nrel = 0;
+	bool lazy = false;
+#endif
+
 	DPRINTF("module_process_relocs('%s')\n", m->dyn.soname);
 
 	/* Do not relocate twice. */
 	if (m->relocated)
 		return;
 
+#ifdef RTLD_TIMING
+	stopwatch_init(&sw);
+	stopwatch_start(&sw);
+#endif
+
 	module_process_pre_arch(m);
 
 	/* jmp_rel table */
 	if (m->dyn.jmp_rel != NULL) {
 		DPRINTF("jmp_rel table\n");
-		if (m->dyn.plt_rel == DT_REL) {
+		if (!m->dyn.bind_now && module_plt_lazy_arch(m)) {
+			DPRINTF("jmp_rel table bound lazily\n");
+#ifdef RTLD_TIMING
+			lazy = true;
+#endif
+		} else if (m->dyn.plt_rel == DT_REL) {
 			DPRINTF("jmp_rel table type DT_REL\n");
 			rel_table_process(m, m->dyn.jmp_rel, m->dyn.plt_rel_sz);
+#ifdef RTLD_TIMING
+			nrel += m->dyn.plt_rel_sz / sizeof(elf_rel_t);
+#endif
 		} else {
 			assert(m->dyn.plt_rel == DT_RELA);
 			DPRINTF("jmp_rel table type DT_RELA\n");
 			rela_table_process(m, m->dyn.jmp_rel, m->dyn.plt_rel_sz);
+#ifdef RTLD_TIMING
+			nrel += m->dyn.plt_rel_sz / sizeof(elf_rela_t);
+#endif
 		}
 	}
 
@@ -131,15 +158,30 @@ void module_process_relocs(module_t *m)
 	if (m->dyn.rel != NULL) {
 		DPRINTF("rel table\n");
 		rel_table_process(m, m->dyn.rel, m->dyn.rel_sz);
+#ifdef RTLD_TIMING
+		nrel += m->dyn.rel_sz / sizeof(elf_rel_t);
+#endif
 	}
 
 	/* rela table */
 	if (m->dyn.rela != NULL) {
 		DPRINTF("rela table\n");
 		rela_table_process(m, m->dyn.rela, m->dyn.rela_sz);
+#ifdef RTLD_TIMING
+		nrel += m->dyn.rela_sz / sizeof(elf_rela_t);
+#endif
 	}
 
 	m->relocated = true;
+
+#ifdef RTLD_TIMING
+	stopwatch_stop(&sw);
+	printf("rtld: '%s': %zu relocations%s in %lld us, %zu lookups "
+	    "(%zu cached)\n", m->dyn.soname, nrel, lazy ? " + lazy PLT" : "",
+	    NSEC2USEC(stopwatch_get_nanos(&sw)),
+	    m->rtld->sym_lookups - lookups,
+	    m->rtld->sym_cache_hits - hits);
+#endif
 }
 
 /** Find module structure by soname/pathname.
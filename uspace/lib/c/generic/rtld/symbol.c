@@ -44,6 +44,15 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/symbol.h>
 
+/** Symbol name together with its precomputed hashes. */
+typedef struct {
+	const char *name;
+	/** SysV ELF hash */
+	elf_word hash;
+	/** GNU hash */
+	elf_word gnu_hash;
+} symbol_key_t;
+
 /*
  * Hash tables are 32-bit (elf_word) even for 64-bit ELF files.
  */
@@ -62,38 +71,125 @@ static elf_word elf_hash(const unsigned char *name)
 	return h;
 }
 
-static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
+/** GNU hash function (DJB hash) used by DT_GNU_HASH tables. */
+static elf_word gnu_hash(const unsigned char *name)
+{
+	elf_word h = 5381;
+
+	while (*name)
+		h = (h << 5) + h + *name++;
+
+	return h;
+}
+
+static void symbol_key_init(symbol_key_t *key, const char *name)
+{
+	key->name = name;
+	key->hash = elf_hash((const unsigned char *) name);
+	key->gnu_hash = gnu_hash((const unsigned char *) name);
+}
+
+/** Look up symbol in the GNU hash table of a module.
+ *
+ * The GNU hash table consists of a header (nbuckets, symoffset,
+ * bloom_size, bloom_shift), a Bloom filter of native-sized words,
+ * the buckets and the hash value chain. The Bloom filter allows to
+ * reject most symbols not defined in the module without touching
+ * the symbol or string tables.
+ */
+static elf_symbol_t *gnu_hash_find(symbol_key_t *key, module_t *m)
+{
+	const elf_word *ht = m->dyn.gnu_hash;
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	const size_t bloom_bits = sizeof(uintptr_t) * 8;
+
+	elf_word nbuckets = ht[0];
+	elf_word symoffset = ht[1];
+	elf_word bloom_size = ht[2];
+	elf_word bloom_shift = ht[3];
+	const uintptr_t *bloom = (const uintptr_t *) &ht[4];
+	const elf_word *buckets = (const elf_word *) &bloom[bloom_size];
+	const elf_word *chain = &buckets[nbuckets];
+
+	elf_word h = key->gnu_hash;
+
+	if (nbuckets == 0 || bloom_size == 0)
+		return NULL;
+
+	uintptr_t word = bloom[(h / bloom_bits) % bloom_size];
+	uintptr_t mask = ((uintptr_t) 1 << (h % bloom_bits)) |
+	    ((uintptr_t) 1 << ((h >> bloom_shift) % bloom_bits));
+
+	if ((word & mask) != mask)
+		return NULL;
+
+	elf_word i = buckets[h % nbuckets];
+	if (i < symoffset)
+		return NULL;
+
+	while (true) {
+		elf_word h2 = chain[i - symoffset];
+
+		if ((h | 1) == (h2 | 1)) {
+			elf_symbol_t *s = &sym_table[i];
+			if (str_cmp(key->name, m->dyn.str_tab + s->st_name) == 0)
+				return s;
+		}
+
+		/* The lowest bit marks the end of the chain. */
+		if ((h2 & 1) != 0)
+			break;
+
+		++i;
+	}
+
+	return NULL;
+}
+
+/** Look up symbol in the SysV hash table of a module. */
+static elf_symbol_t *elf_hash_find(symbol_key_t *key, module_t *m)
 {
 	elf_symbol_t *sym_table;
-	elf_symbol_t *s, *sym;
+	elf_symbol_t *s;
 	elf_word nbucket;
 	/* elf_word nchain; */
 	elf_word i;
 	char *s_name;
 	elf_word bucket;
 
-	DPRINTF("def_find_in_module('%s', %s)\n", name, m->dyn.soname);
-
 	sym_table = m->dyn.sym_tab;
 	nbucket = m->dyn.hash[0];
 	/* nchain = m->dyn.hash[1]; XXX Use to check HT range */
 
-	bucket = elf_hash((unsigned char *)name) % nbucket;
+	bucket = key->hash % nbucket;
 	i = m->dyn.hash[2 + bucket];
 
-	sym = NULL;
 	while (i != STN_UNDEF) {
 		s = &sym_table[i];
 		s_name = m->dyn.str_tab + s->st_name;
 
-		if (str_cmp(name, s_name) == 0) {
-			sym = s;
-			break;
-		}
+		if (str_cmp(key->name, s_name) == 0)
+			return s;
 
 		i = m->dyn.hash[2 + nbucket + i];
 	}
 
+	return NULL;
+}
+
+static elf_symbol_t *def_find_in_module(symbol_key_t *key, module_t *m)
+{
+	elf_symbol_t *sym;
+
+	DPRINTF("def_find_in_module('%s', %s)\n", key->name, m->dyn.soname);
+
+	if (m->dyn.gnu_hash != NULL)
+		sym = gnu_hash_find(key, m);
+	else if (m->dyn.hash != NULL)
+		sym = elf_hash_find(key, m);
+	else
+		sym = NULL;
+
 	if (!sym)
 		return NULL;	/* Not found */
 
@@ -105,6 +201,66 @@ static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
 	return sym; /* Found */
 }
 
+/** Look up symbol in the resolution cache.
+ *
+ * @param rtld  RTLD instance
+ * @param key   Symbol name and hashes
+ * @param flags Search flags
+ * @param mod   (output) Module that contains the symbol
+ * @return Symbol or @c NULL if not cached
+ */
+static elf_symbol_t *symcache_find(rtld_t *rtld, symbol_key_t *key,
+    unsigned flags, module_t **mod)
+{
+	rtld_symcache_entry_t *e;
+
+	e = rtld->symcache[key->gnu_hash % RTLD_SYMCACHE_BUCKETS];
+	while (e != NULL) {
+		if (e->hash == key->gnu_hash && e->flags == flags &&
+		    str_cmp(e->name, key->name) == 0) {
+			*mod = e->mod;
+			return e->sym;
+		}
+
+		e = e->next;
+	}
+
+	return NULL;
+}
+
+/** Insert symbol into the resolution cache.
+ *
+ * The cache only holds results of searching the global namespace.
+ * Since new modules are always appended to the end of the module list,
+ * such results remain valid when more modules are loaded.
+ *
+ * @param rtld  RTLD instance
+ * @param key   Symbol name and hashes
+ * @param flags Search flags
+ * @param sym   Symbol definition
+ * @param mod   Module that contains the symbol
+ */
+static void symcache_insert(rtld_t *rtld, symbol_key_t *key, unsigned flags,
+    elf_symbol_t *sym, module_t *mod)
+{
+	rtld_symcache_entry_t *e;
+	size_t bucket;
+
+	e = malloc(sizeof(rtld_symcache_entry_t));
+	if (e == NULL)
+		return;
+
+	e->name = mod->dyn.str_tab + sym->st_name;
+	e->hash = key->gnu_hash;
+	e->flags = flags;
+	e->sym = sym;
+	e->mod = mod;
+
+	bucket = key->gnu_hash % RTLD_SYMCACHE_BUCKETS;
+	e->next = rtld->symcache[bucket];
+	rtld->symcache[bucket] = e;
+}
+
 /** Find the definition of a symbol in a module and its deps.
  *
  * Search the module dependency graph is breadth-first, beginning
@@ -121,9 +277,12 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 {
 	module_t *m, *dm;
 	elf_symbol_t *sym, *s;
+	symbol_key_t key;
 	list_t queue;
 	size_t i;
 
+	symbol_key_init(&key, name);
+
 	/*
 	 * Do a BFS using the queue_link and bfs_tag fields.
 	 * Vertices (modules) are tagged the moment they are inserted
@@ -149,7 +308,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 		list_remove(&m->queue_link);
 
 		/* If ssf_noroot is specified, do not look in start module */
-		s = def_find_in_module(name, m);
+		s = def_find_in_module(&key, m);
 		if (s != NULL) {
 			/* Symbol found */
 			sym = s;
@@ -188,18 +347,29 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
  * origin is searched first. Otherwise, search global modules in the default
  * order.
  *
+ * Results of searching the global modules are cached, so that resolving
+ * the same symbol again (e.g. from another module) does not need to walk
+ * the module list.
+ *
  * @param name		Name of the symbol to search for.
  * @param origin	Module in which the dependency originates.
  * @param flags		@c ssf_none or @c ssf_noexec to not look for the symbol
- *			in the executable program.
+ *			in the executable program. @c ssf_nocache to not insert
+ *			the result into the resolution cache.
  * @param mod		(output) Will be filled with a pointer to the module
  *			that contains the symbol.
  */
 elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
     symbol_search_flags_t flags, module_t **mod)
 {
+	rtld_t *rtld = origin->rtld;
+	unsigned cflags = flags & ssf_noexec;
+	symbol_key_t key;
 	elf_symbol_t *s;
 
+	symbol_key_init(&key, name);
+	rtld->sym_lookups++;
+
 	DPRINTF("symbol_def_find('%s', origin='%s'\n",
 	    name, origin->dyn.soname);
 	if (origin->dyn.symbolic && (!origin->exec || (flags & ssf_noexec) == 0)) {
@@ -208,7 +378,7 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 		 * Origin module has a DT_SYMBOLIC flag.
 		 * Try this module first
 		 */
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -218,13 +388,21 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 
 	/* Not DT_SYMBOLIC or no match. Now try other locations. */
 
-	list_foreach(origin->rtld->modules, modules_link, module_t, m) {
+	s = symcache_find(rtld, &key, cflags, mod);
+	if (s != NULL) {
+		rtld->sym_cache_hits++;
+		return s;
+	}
+
+	list_foreach(rtld->modules, modules_link, module_t, m) {
 		DPRINTF("module '%s' local?\n", m->dyn.soname);
 		if (!m->local && (!m->exec || (flags & ssf_noexec) == 0)) {
 			DPRINTF("!local->find '%s' in module '%s'\n", name, m->dyn.soname);
-			s = def_find_in_module(name, m);
+			s = def_find_in_module(&key, m);
 			if (s != NULL) {
 				/* Found */
+				if ((flags & ssf_nocache) == 0)
+					symcache_insert(rtld, &key, cflags, s, m);
 				*mod = m;
 				return s;
 			}
@@ -237,7 +415,7 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 	    origin->dyn.soname);
 
 	if (!origin->exec || (flags & ssf_noexec) == 0) {
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -458,6 +458,38 @@ errno_t task_wait(task_wait_t *wait, task_exit_t *texit, int *retval)
 	return rc;
 }
 
+/** Wait for a task to finish, timeout variant.
+ *
+ * If the wait times out, the caller may wait again using task_wait() or
+ * task_wait_timeout(), or give up via task_cancel_wait().
+ *
+ * @param wait    task_wait_t previously initialized by task_setup_wait.
+ * @param timeout Timeout in microseconds.
+ * @param texit   Store type of task exit here.
+ * @param retval  Store return value of the task here.
+ *
+ * @return EOK on success, ETIMEOUT if the task did not finish in time,
+ *         else error code.
+ */
+errno_t task_wait_timeout(task_wait_t *wait, usec_t timeout,
+    task_exit_t *texit, int *retval)
+{
+	assert(texit);
+	assert(retval);
+
+	errno_t rc;
+	errno_t wrc = async_wait_timeout(wait->aid, &rc, timeout);
+	if (wrc != EOK)
+		return wrc;
+
+	if (rc == EOK) {
+		*texit = ipc_get_arg1(&wait->result);
+		*retval = ipc_get_arg2(&wait->result);
+	}
+
+	return rc;
+}
+
 /** Wait for a task to finish by its id.
  *
  * Note that this will fail with ENOENT if the task id is not registered in ns
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Prefix trie
+ */
+
+#ifndef _LIBC_PREFIX_TRIE_H_
+#define _LIBC_PREFIX_TRIE_H_
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Maximum key length in bits */
+#define PREFIX_TRIE_KEY_BITS 128
+
+typedef struct prefix_trie_node prefix_trie_node_t;
+
+/** Path-compressed binary trie for longest prefix matching.
+ *
+ * Keys are bit strings stored most significant bit first (i.e. network
+ * byte order for addresses). Each prefix maps to one non-NULL value.
+ */
+typedef struct {
+	/** Root node or @c NULL if empty */
+	prefix_trie_node_t *root;
+	/** Length of keys in bits */
+	unsigned key_bits;
+	/** Number of prefixes */
+	size_t count;
+} prefix_trie_t;
+
+#define PREFIX_TRIE_INITIALIZER(bits) \
+	{ \
+		.root = NULL, \
+		.key_bits = (bits), \
+		.count = 0 \
+	}
+
+extern void prefix_trie_initialize(prefix_trie_t *, unsigned);
+extern void prefix_trie_finalize(prefix_trie_t *);
+extern errno_t prefix_trie_insert(prefix_trie_t *, const uint8_t *, unsigned,
+    void *);
+extern void *prefix_trie_remove(prefix_trie_t *, const uint8_t *, unsigned);
+extern void *prefix_trie_get(prefix_trie_t *, const uint8_t *, unsigned);
+extern void *prefix_trie_lookup(prefix_trie_t *, const uint8_t *);
+extern size_t prefix_trie_count(prefix_trie_t *);
+
+#endif
+
+/** @}
+ */
@@ -38,6 +38,7 @@
 #define ELF_MOD_H_
 
 #include <elf/elf.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <loader/pcb.h>
@@ -96,6 +97,11 @@ typedef struct {
 
 	/** Store extracted info here */
 	elf_finfo_t *info;
+
+	/** Areas mapped from the file by the VFS pager */
+	void **paged_areas;
+	/** Number of entries in @c paged_areas */
+	size_t paged_cnt;
 } elf_ld_t;
 
 extern errno_t elf_load_file(int, eld_flags_t, elf_finfo_t *);
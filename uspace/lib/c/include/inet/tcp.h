@@ -35,17 +35,20 @@
 #ifndef _LIBC_INET_TCP_H_
 #define _LIBC_INET_TCP_H_
 
+#include <adt/hash_table.h>
 #include <fibril_synch.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
 #include <inet/inet.h>
+#include <offset.h>
 
 /** TCP connection */
 typedef struct {
 	fibril_mutex_t lock;
 	fibril_condvar_t cv;
 	struct tcp *tcp;
-	link_t ltcp;
+	/** Link to tcp_t.conn */
+	ht_link_t ltcp;
 	sysarg_t id;
 	struct tcp_cb *cb;
 	void *cb_arg;
@@ -85,8 +88,8 @@ typedef struct tcp_listen_cb {
 typedef struct tcp {
 	/** TCP session */
 	async_sess_t *sess;
-	/** List of connections */
-	list_t conn; /* of tcp_conn_t */
+	/** Connections indexed by ID */
+	hash_table_t conn; /* of tcp_conn_t */
 	/** List of listeners */
 	list_t listener; /* of tcp_listener_t */
 	/** TCP service lock */
@@ -106,10 +109,13 @@ extern void *tcp_conn_userptr(tcp_conn_t *);
 extern errno_t tcp_listener_create(tcp_t *, inet_ep_t *, tcp_listen_cb_t *, void *,
     tcp_cb_t *, void *, tcp_listener_t **);
 extern void tcp_listener_destroy(tcp_listener_t *);
+extern errno_t tcp_listener_set_backlog(tcp_listener_t *, size_t);
 extern void *tcp_listener_userptr(tcp_listener_t *);
 
 extern errno_t tcp_conn_wait_connected(tcp_conn_t *);
 extern errno_t tcp_conn_send(tcp_conn_t *, const void *, size_t);
+extern errno_t tcp_conn_send_file(tcp_conn_t *, int, aoff64_t *, size_t,
+    size_t *);
 extern errno_t tcp_conn_send_fin(tcp_conn_t *);
 extern errno_t tcp_conn_push(tcp_conn_t *);
 extern errno_t tcp_conn_reset(tcp_conn_t *);
@@ -35,7 +35,10 @@
 #ifndef _LIBC_IPC_UDP_H_
 #define _LIBC_IPC_UDP_H_
 
+#include <align.h>
+#include <inet/endpoint.h>
 #include <ipc/common.h>
+#include <stddef.h>
 
 typedef enum {
 	UDP_CALLBACK_CREATE = IPC_FIRST_USER_METHOD,
@@ -43,11 +46,34 @@ typedef enum {
 	UDP_ASSOC_DESTROY,
 	UDP_ASSOC_SET_NOLOCAL,
 	UDP_ASSOC_SEND_MSG,
+	UDP_ASSOC_SEND_MMSG,
 	UDP_RMSG_INFO,
 	UDP_RMSG_READ,
+	UDP_RMSG_READ_MMSG,
 	UDP_RMSG_DISCARD
 } udp_request_t;
 
+/** Header of one message in a multi-message buffer.
+ *
+ * The header is followed by message data padded to @c UDP_MMSG_ALIGN
+ * bytes, then by the header of the next message.
+ */
+typedef struct {
+	/** Remote endpoint, unspecified to use association's remote ep. */
+	inet_ep_t remote_ep;
+	/** Association ID (only for received messages) */
+	sysarg_t assoc_id;
+	/** Message size in bytes */
+	size_t size;
+} udp_mmsg_hdr_t;
+
+/** Alignment of messages in a multi-message buffer */
+#define UDP_MMSG_ALIGN  8
+
+/** Space taken by a message of @a size bytes in a multi-message buffer */
+#define UDP_MMSG_SPACE(size) \
+	(sizeof(udp_mmsg_hdr_t) + (size_t) ALIGN_UP((size), UDP_MMSG_ALIGN))
+
 typedef enum {
 	UDP_EV_DATA = IPC_FIRST_USER_METHOD
 } udp_event_t;
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Shared packet buffer pool
+ */
+
+#ifndef _LIBC_PKTPOOL_H_
+#define _LIBC_PKTPOOL_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct pktpool;
+
+/** Packet buffer pool shared between a producer and a consumer task */
+typedef struct pktpool pktpool_t;
+
+extern errno_t pktpool_create(size_t, size_t, pktpool_t **);
+extern errno_t pktpool_attach(void *, size_t, pktpool_t **);
+extern void pktpool_destroy(pktpool_t *);
+extern void *pktpool_area(pktpool_t *, size_t *);
+extern size_t pktpool_buf_size(pktpool_t *);
+extern void *pktpool_data(pktpool_t *, size_t);
+
+extern errno_t pktpool_alloc(pktpool_t *, size_t *);
+extern void pktpool_discard(pktpool_t *, size_t);
+extern bool pktpool_post(pktpool_t *, size_t, size_t);
+
+extern bool pktpool_fetch(pktpool_t *, size_t *, size_t *);
+extern void pktpool_release(pktpool_t *, size_t);
+
+#endif
+
+/** @}
+ */
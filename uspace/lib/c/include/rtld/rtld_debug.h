@@ -46,6 +46,12 @@
 #define DPRINTF(format, ...) if (0) printf(format, ##__VA_ARGS__)
 #endif
 
+/*
+ * Define to report the time spent processing relocations in each module
+ * together with the number of symbol lookups and resolution cache hits.
+ */
+#undef RTLD_TIMING
+
 #endif
 
 /** @}
@@ -70,6 +70,7 @@ extern errno_t task_spawnl(task_id_t *, task_wait_t *, const char *path, ...)
 extern errno_t task_setup_wait(task_id_t, task_wait_t *);
 extern void task_cancel_wait(task_wait_t *);
 extern errno_t task_wait(task_wait_t *, task_exit_t *, int *);
+extern errno_t task_wait_timeout(task_wait_t *, usec_t, task_exit_t *, int *);
 extern errno_t task_wait_task_id(task_id_t, task_exit_t *, int *);
 extern errno_t task_retval(int);
 
@@ -42,6 +42,29 @@
 
 #include <types/rtld/module.h>
 
+/** Number of buckets in the symbol resolution cache */
+#define RTLD_SYMCACHE_BUCKETS 256
+
+/** Symbol resolution cache entry.
+ *
+ * Caches the result of a successful search of the global symbol
+ * namespace. Entries are never freed since modules are never unloaded.
+ */
+typedef struct rtld_symcache_entry {
+	/** Next entry in the same bucket */
+	struct rtld_symcache_entry *next;
+	/** Symbol name (points into the string table of some module) */
+	const char *name;
+	/** GNU hash of the symbol name */
+	elf_word hash;
+	/** Search flags used for the lookup */
+	unsigned flags;
+	/** Symbol definition */
+	elf_symbol_t *sym;
+	/** Module containing the definition */
+	module_t *mod;
+} rtld_symcache_entry_t;
+
 typedef struct rtld {
 	elf_dyn_t *rtld_dynamic;
 	module_t rtld;
@@ -60,6 +83,14 @@ typedef struct rtld {
 
 	/** List of initial modules */
 	list_t imodules;
+
+	/** Symbol resolution cache */
+	rtld_symcache_entry_t *symcache[RTLD_SYMCACHE_BUCKETS];
+
+	/** Number of symbol lookups */
+	size_t sym_lookups;
+	/** Number of symbol lookups satisfied from the cache */
+	size_t sym_cache_hits;
 } rtld_t;
 
 #endif
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <adt/prefix_trie.h>
+#include <pcut/pcut.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(prefix_trie);
+
+enum {
+	/** Number of prefixes in the randomized test */
+	rand_count = 256,
+	/** Number of randomized operations */
+	rand_ops = 20000
+};
+
+typedef struct {
+	uint8_t key[4];
+	unsigned plen;
+	bool used;
+} test_prefix_t;
+
+static test_prefix_t prefixes[rand_count];
+static uint32_t seed = 1;
+
+static uint32_t test_rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+/** Determine whether prefix matches key (reference implementation). */
+static bool test_match(test_prefix_t *p, const uint8_t *key)
+{
+	unsigned i;
+
+	for (i = 0; i < p->plen; i++) {
+		if (((p->key[i / 8] ^ key[i / 8]) & (0x80 >> (i % 8))) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+/** Empty trie matches nothing */
+PCUT_TEST(empty)
+{
+	prefix_trie_t trie;
+	uint8_t key[4] = { 10, 0, 0, 1 };
+
+	prefix_trie_initialize(&trie, 32);
+	PCUT_ASSERT_INT_EQUALS(0, prefix_trie_count(&trie));
+	PCUT_ASSERT_NULL(prefix_trie_lookup(&trie, key));
+	PCUT_ASSERT_NULL(prefix_trie_get(&trie, key, 8));
+	PCUT_ASSERT_NULL(prefix_trie_remove(&trie, key, 8));
+	prefix_trie_finalize(&trie);
+}
+
+/** Longest prefix wins, default route matches everything */
+PCUT_TEST(longest_match)
+{
+	prefix_trie_t trie;
+	uint8_t net0[4] = { 0, 0, 0, 0 };
+	uint8_t net8[4] = { 10, 0, 0, 0 };
+	uint8_t net24[4] = { 10, 1, 2, 0 };
+	uint8_t host[4] = { 10, 1, 2, 3 };
+	uint8_t other[4] = { 10, 1, 3, 3 };
+	uint8_t far[4] = { 192, 168, 0, 1 };
+	int v0, v8, v24;
+	errno_t rc;
+
+	prefix_trie_initialize(&trie, 32);
+
+	rc = prefix_trie_insert(&trie, net8, 8, &v8);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = prefix_trie_insert(&trie, net24, 24, &v24);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = prefix_trie_insert(&trie, net0, 0, &v0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(3, prefix_trie_count(&trie));
+
+	PCUT_ASSERT_EQUALS(&v24, prefix_trie_lookup(&trie, host));
+	PCUT_ASSERT_EQUALS(&v8, prefix_trie_lookup(&trie, other));
+	PCUT_ASSERT_EQUALS(&v0, prefix_trie_lookup(&trie, far));
+
+	/* Host bits past prefix length are ignored */
+	PCUT_ASSERT_EQUALS(&v24, prefix_trie_get(&trie, host, 24));
+	rc = prefix_trie_insert(&trie, host, 24, &v0);
+	PCUT_ASSERT_ERRNO_VAL(EEXIST, rc);
+
+	PCUT_ASSERT_EQUALS(&v24, prefix_trie_remove(&trie, net24, 24));
+	PCUT_ASSERT_EQUALS(&v8, prefix_trie_lookup(&trie, host));
+	PCUT_ASSERT_EQUALS(&v0, prefix_trie_remove(&trie, net0, 0));
+	PCUT_ASSERT_NULL(prefix_trie_lookup(&trie, far));
+	PCUT_ASSERT_INT_EQUALS(1, prefix_trie_count(&trie));
+
+	prefix_trie_finalize(&trie);
+}
+
+/** Random inserts, removals and lookups agree with linear search */
+PCUT_TEST(random)
+{
+	prefix_trie_t trie;
+	test_prefix_t *p;
+	test_prefix_t *best;
+	uint8_t key[4];
+	uint32_t r;
+	unsigned i, j;
+	errno_t rc;
+
+	prefix_trie_initialize(&trie, 32);
+
+	for (i = 0; i < rand_ops; i++) {
+		p = &prefixes[test_rand() % rand_count];
+		r = test_rand();
+
+		switch (r % 3) {
+		case 0:
+			if (p->used)
+				break;
+			/* Few distinct top bytes so that prefixes nest */
+			r = test_rand();
+			p->key[0] = 10 + r % 4;
+			p->key[1] = r >> 8;
+			p->key[2] = r >> 16;
+			p->key[3] = test_rand();
+			p->plen = test_rand() % 33;
+			rc = prefix_trie_insert(&trie, p->key, p->plen, p);
+			if (rc == EOK)
+				p->used = true;
+			else
+				PCUT_ASSERT_ERRNO_VAL(EEXIST, rc);
+			break;
+		case 1:
+			if (!p->used)
+				break;
+			PCUT_ASSERT_EQUALS(p, prefix_trie_remove(&trie, p->key,
+			    p->plen));
+			p->used = false;
+			break;
+		default:
+			r = test_rand();
+			key[0] = 10 + r % 4;
+			key[1] = r >> 8;
+			key[2] = r >> 16;
+			key[3] = test_rand();
+
+			best = NULL;
+			for (j = 0; j < rand_count; j++) {
+				if (!prefixes[j].used ||
+				    !test_match(&prefixes[j], key))
+					continue;
+				if (best == NULL || prefixes[j].plen > best->plen)
+					best = &prefixes[j];
+			}
+
+			PCUT_ASSERT_EQUALS(best, prefix_trie_lookup(&trie, key));
+			break;
+		}
+	}
+
+	prefix_trie_finalize(&trie);
+}
+
+PCUT_EXPORT(prefix_trie);
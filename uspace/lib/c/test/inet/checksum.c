@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <inet/checksum.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stddef.h>
+#include <stdint.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(inet_checksum);
+
+enum {
+	/** Large enough to exercise the vector lane flushing */
+	buf_size = 300000
+};
+
+static uint8_t src_buf[buf_size + 16];
+static uint8_t dst_buf[buf_size + 16];
+
+/** Straightforward RFC 1071 checksum used as reference. */
+static uint16_t ref_checksum(uint16_t ivalue, const uint8_t *data, size_t size)
+{
+	uint32_t sum;
+	size_t i;
+
+	sum = (uint16_t) ~ivalue;
+	for (i = 0; i + 1 < size; i += 2) {
+		sum += ((uint16_t) data[i] << 8) | data[i + 1];
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	if (size % 2 != 0) {
+		sum += (uint16_t) data[size - 1] << 8;
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return ~sum;
+}
+
+/** Fill buffer with a pseudo-random pattern. */
+static void fill_pattern(uint8_t *buf, size_t size, uint32_t seed)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+}
+
+/** Checksum of an empty buffer is the initial value */
+PCUT_TEST(empty)
+{
+	PCUT_ASSERT_INT_EQUALS(INET_CHECKSUM_INIT,
+	    inet_checksum_calc(INET_CHECKSUM_INIT, src_buf, 0));
+	PCUT_ASSERT_INT_EQUALS(0x1234, inet_checksum_calc(0x1234, src_buf, 0));
+}
+
+/** Example from RFC 1071 section 3 */
+PCUT_TEST(rfc1071_example)
+{
+	uint8_t data[] = { 0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7 };
+
+	/* One's complement sum is 0xddf2 */
+	PCUT_ASSERT_INT_EQUALS((uint16_t) ~0xddf2,
+	    inet_checksum_calc(INET_CHECKSUM_INIT, data, sizeof(data)));
+}
+
+/** Checksum matches reference for all small sizes and alignments */
+PCUT_TEST(sizes_alignments)
+{
+	size_t size;
+	size_t offs;
+
+	fill_pattern(src_buf, 1024, 1);
+
+	for (offs = 0; offs < 16; offs++) {
+		for (size = 0; size < 512; size++) {
+			PCUT_ASSERT_INT_EQUALS(
+			    ref_checksum(INET_CHECKSUM_INIT, src_buf + offs,
+			    size),
+			    inet_checksum_calc(INET_CHECKSUM_INIT,
+			    src_buf + offs, size));
+		}
+	}
+}
+
+/** Checksum matches reference for all-ones data of large size */
+PCUT_TEST(large_ones)
+{
+	memset(src_buf, 0xff, buf_size);
+	PCUT_ASSERT_INT_EQUALS(ref_checksum(INET_CHECKSUM_INIT, src_buf,
+	    buf_size), inet_checksum_calc(INET_CHECKSUM_INIT, src_buf,
+	    buf_size));
+
+	fill_pattern(src_buf, buf_size, 2);
+	PCUT_ASSERT_INT_EQUALS(ref_checksum(INET_CHECKSUM_INIT, src_buf + 1,
+	    buf_size - 1), inet_checksum_calc(INET_CHECKSUM_INIT, src_buf + 1,
+	    buf_size - 1));
+}
+
+/** Checksum can be computed in pieces */
+PCUT_TEST(chained)
+{
+	uint16_t cs;
+
+	fill_pattern(src_buf, 1000, 3);
+
+	cs = inet_checksum_calc(INET_CHECKSUM_INIT, src_buf, 12);
+	cs = inet_checksum_calc(cs, src_buf + 12, 40);
+	cs = inet_checksum_calc(cs, src_buf + 52, 947);
+	PCUT_ASSERT_INT_EQUALS(ref_checksum(INET_CHECKSUM_INIT, src_buf, 999),
+	    cs);
+}
+
+/** Copying checksum copies data and matches the plain checksum */
+PCUT_TEST(copy)
+{
+	size_t size;
+	size_t offs;
+	uint16_t cs;
+
+	fill_pattern(src_buf, 1024, 4);
+
+	for (offs = 0; offs < 8; offs++) {
+		for (size = 0; size < 300; size += 7) {
+			memset(dst_buf, 0xaa, size + 32);
+			cs = inet_checksum_copy(0x5a5a, dst_buf + offs + 1,
+			    src_buf + offs, size);
+			PCUT_ASSERT_INT_EQUALS(ref_checksum(0x5a5a,
+			    src_buf + offs, size), cs);
+			PCUT_ASSERT_INT_EQUALS(0, memcmp(dst_buf + offs + 1,
+			    src_buf + offs, size));
+			/* Nothing written past the end */
+			PCUT_ASSERT_INT_EQUALS(0xaa, dst_buf[offs + 1 + size]);
+		}
+	}
+
+	fill_pattern(src_buf, buf_size, 5);
+	cs = inet_checksum_copy(INET_CHECKSUM_INIT, dst_buf, src_buf, buf_size);
+	PCUT_ASSERT_INT_EQUALS(ref_checksum(INET_CHECKSUM_INIT, src_buf,
+	    buf_size), cs);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(dst_buf, src_buf, buf_size));
+}
+
+PCUT_EXPORT(inet_checksum);
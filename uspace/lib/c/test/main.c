@@ -40,11 +40,14 @@ PCUT_IMPORT(getopt);
 PCUT_IMPORT(gsort);
 PCUT_IMPORT(ieee_double);
 PCUT_IMPORT(imath);
+PCUT_IMPORT(inet_checksum);
 PCUT_IMPORT(inttypes);
 PCUT_IMPORT(mem);
 PCUT_IMPORT(odict);
 PCUT_IMPORT(perf);
 PCUT_IMPORT(perm);
+PCUT_IMPORT(pktpool);
+PCUT_IMPORT(prefix_trie);
 PCUT_IMPORT(qsort);
 PCUT_IMPORT(scanf);
 PCUT_IMPORT(sprintf);
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <pcut/pcut.h>
+#include <pktpool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <str.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(pktpool);
+
+enum {
+	pool_count = 8,
+	pool_buf_size = 1500
+};
+
+/** Create a pool and attach a consumer view to the same area. */
+static void pool_pair(pktpool_t **prod, pktpool_t **cons)
+{
+	void *area;
+	size_t size;
+	errno_t rc;
+
+	rc = pktpool_create(pool_count, pool_buf_size, prod);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	area = pktpool_area(*prod, &size);
+	rc = pktpool_attach(area, size, cons);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_TRUE(pktpool_buf_size(*cons) >= pool_buf_size);
+}
+
+/** Creating a pool with invalid parameters fails */
+PCUT_TEST(create_invalid)
+{
+	pktpool_t *pool;
+
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, pktpool_create(0, pool_buf_size, &pool));
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, pktpool_create(3, pool_buf_size, &pool));
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, pktpool_create(pool_count, 0, &pool));
+}
+
+/** Attaching to something that is not a pool fails */
+PCUT_TEST(attach_invalid)
+{
+	uint8_t area[256];
+	pktpool_t *pool;
+
+	memset(area, 0, sizeof(area));
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, pktpool_attach(area, sizeof(area),
+	    &pool));
+}
+
+/** A posted packet reaches the consumer intact */
+PCUT_TEST(post_fetch)
+{
+	pktpool_t *prod, *cons;
+	size_t idx, cidx, size;
+	errno_t rc;
+
+	pool_pair(&prod, &cons);
+
+	PCUT_ASSERT_FALSE(pktpool_fetch(cons, &cidx, &size));
+
+	rc = pktpool_alloc(prod, &idx);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	str_cpy(pktpool_data(prod, idx), pool_buf_size, "Hello");
+
+	/* Consumer is idle, so the first post asks for a wakeup */
+	PCUT_ASSERT_TRUE(pktpool_post(prod, idx, 6));
+
+	PCUT_ASSERT_TRUE(pktpool_fetch(cons, &cidx, &size));
+	PCUT_ASSERT_INT_EQUALS(idx, cidx);
+	PCUT_ASSERT_INT_EQUALS(6, size);
+	PCUT_ASSERT_STR_EQUALS("Hello", pktpool_data(cons, cidx));
+	PCUT_ASSERT_FALSE(pktpool_fetch(cons, &cidx, &size));
+
+	pktpool_release(cons, cidx);
+
+	pktpool_destroy(cons);
+	pktpool_destroy(prod);
+}
+
+/** Only a post to an empty ring requests a wakeup */
+PCUT_TEST(post_wakeup)
+{
+	pktpool_t *prod, *cons;
+	size_t idx, cidx, size;
+
+	pool_pair(&prod, &cons);
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+	PCUT_ASSERT_TRUE(pktpool_post(prod, idx, 1));
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+	PCUT_ASSERT_FALSE(pktpool_post(prod, idx, 1));
+
+	PCUT_ASSERT_TRUE(pktpool_fetch(cons, &cidx, &size));
+	pktpool_release(cons, cidx);
+
+	/* Consumer has not drained the ring yet */
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+	PCUT_ASSERT_FALSE(pktpool_post(prod, idx, 1));
+
+	PCUT_ASSERT_TRUE(pktpool_fetch(cons, &cidx, &size));
+	pktpool_release(cons, cidx);
+	PCUT_ASSERT_TRUE(pktpool_fetch(cons, &cidx, &size));
+	pktpool_release(cons, cidx);
+	PCUT_ASSERT_FALSE(pktpool_fetch(cons, &cidx, &size));
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+	PCUT_ASSERT_TRUE(pktpool_post(prod, idx, 1));
+
+	pktpool_destroy(cons);
+	pktpool_destroy(prod);
+}
+
+/** Buffers run out until the consumer hands them back */
+PCUT_TEST(exhaust)
+{
+	pktpool_t *prod, *cons;
+	size_t idx, cidx, size;
+	bool seen[pool_count];
+	size_t i;
+
+	pool_pair(&prod, &cons);
+
+	for (i = 0; i < pool_count; i++)
+		seen[i] = false;
+
+	for (i = 0; i < pool_count; i++) {
+		PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+		PCUT_ASSERT_TRUE(idx < pool_count);
+		PCUT_ASSERT_FALSE(seen[idx]);
+		seen[idx] = true;
+		(void) pktpool_post(prod, idx, i);
+	}
+
+	PCUT_ASSERT_ERRNO_VAL(ENOMEM, pktpool_alloc(prod, &idx));
+
+	for (i = 0; i < pool_count; i++) {
+		PCUT_ASSERT_TRUE(pktpool_fetch(cons, &cidx, &size));
+		PCUT_ASSERT_INT_EQUALS(i, size);
+		pktpool_release(cons, cidx);
+	}
+
+	for (i = 0; i < pool_count; i++)
+		PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+
+	PCUT_ASSERT_ERRNO_VAL(ENOMEM, pktpool_alloc(prod, &idx));
+
+	pktpool_destroy(cons);
+	pktpool_destroy(prod);
+}
+
+/** Discarded buffers can be allocated again */
+PCUT_TEST(discard)
+{
+	pktpool_t *prod, *cons;
+	size_t idx, idx2;
+
+	pool_pair(&prod, &cons);
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+	pktpool_discard(prod, idx);
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx2));
+	PCUT_ASSERT_INT_EQUALS(idx, idx2);
+
+	pktpool_destroy(cons);
+	pktpool_destroy(prod);
+}
+
+/** Discarding a buffer that is not allocated is ignored */
+PCUT_TEST(discard_invalid)
+{
+	pktpool_t *prod, *cons;
+	size_t idx, idx2;
+
+	pool_pair(&prod, &cons);
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+	pktpool_discard(prod, idx);
+	pktpool_discard(prod, idx);
+	pktpool_discard(prod, pool_count);
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx2));
+	PCUT_ASSERT_INT_EQUALS(idx, idx2);
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx2));
+	PCUT_ASSERT_TRUE(idx != idx2);
+
+	pktpool_destroy(cons);
+	pktpool_destroy(prod);
+}
+
+/** A buffer handed back twice by the consumer is allocated only once */
+PCUT_TEST(release_duplicate)
+{
+	pktpool_t *prod, *cons;
+	size_t a, b, idx, cidx, size;
+	size_t i;
+
+	pool_pair(&prod, &cons);
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &a));
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &b));
+	(void) pktpool_post(prod, a, 1);
+	(void) pktpool_post(prod, b, 1);
+
+	PCUT_ASSERT_TRUE(pktpool_fetch(cons, &cidx, &size));
+	PCUT_ASSERT_INT_EQUALS(a, cidx);
+	PCUT_ASSERT_TRUE(pktpool_fetch(cons, &cidx, &size));
+	PCUT_ASSERT_INT_EQUALS(b, cidx);
+
+	/* Misbehaving consumer returns @a a twice and keeps @a b */
+	pktpool_release(cons, a);
+	pktpool_release(cons, a);
+
+	for (i = 0; i < pool_count - 2; i++)
+		PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, pktpool_alloc(prod, &idx));
+	PCUT_ASSERT_INT_EQUALS(a, idx);
+	PCUT_ASSERT_ERRNO_VAL(ENOMEM, pktpool_alloc(prod, &idx));
+
+	pktpool_destroy(cons);
+	pktpool_destroy(prod);
+}
+
+PCUT_EXPORT(pktpool);
@@ -34,6 +34,7 @@
  * @brief Driver-side RPC skeletons for DDF NIC interface
  */
 
+#include <as.h>
 #include <assert.h>
 #include <async.h>
 #include <errno.h>
@@ -85,7 +86,8 @@ typedef enum {
 	NIC_OFFLOAD_SET,
 	NIC_POLL_GET_MODE,
 	NIC_POLL_SET_MODE,
-	NIC_POLL_NOW
+	NIC_POLL_NOW,
+	NIC_RX_POOL_CREATE
 } nic_funcs_t;
 
 /** Send frame from NIC
@@ -1335,6 +1337,47 @@ errno_t nic_poll_now(async_sess_t *dev_sess)
 	return rc;
 }
 
+/** Set up a shared receive buffer pool.
+ *
+ * The driver creates a packet buffer pool (see pktpool.h) and shares it
+ * with the caller. Received frames are then posted to the pool and only
+ * announced by NIC_EV_RX_POOL notifications instead of being copied
+ * with NIC_EV_RECEIVED.
+ *
+ * @param[in]  dev_sess
+ * @param[in]  count    Requested number of buffers
+ * @param[in]  buf_size Requested buffer size
+ * @param[out] area     Place to store the shared area
+ * @param[out] size     Place to store size of the shared area
+ *
+ * @return EOK If the operation was successfully completed
+ *
+ */
+errno_t nic_rx_pool_create(async_sess_t *dev_sess, size_t count,
+    size_t buf_size, void **area, size_t *size)
+{
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	sysarg_t area_size;
+	errno_t rc = async_req_3_1(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_RX_POOL_CREATE, count, buf_size, &area_size);
+	if (rc != EOK) {
+		async_exchange_end(exch);
+		return rc;
+	}
+
+	void *dst;
+	rc = async_share_in_start_0_0(exch, area_size, &dst);
+	async_exchange_end(exch);
+
+	if (rc != EOK)
+		return rc;
+
+	*area = dst;
+	*size = area_size;
+	return EOK;
+}
+
 static void remote_nic_send_frame(ddf_fun_t *dev, void *iface,
     ipc_call_t *call)
 {
@@ -2485,6 +2528,42 @@ static void remote_nic_poll_now(ddf_fun_t *dev, void *iface,
 	async_answer_0(call, rc);
 }
 
+static void remote_nic_rx_pool_create(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+	if (nic_iface->rx_pool_create == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	size_t count = ipc_get_arg2(call);
+	size_t buf_size = ipc_get_arg3(call);
+	void *area;
+	size_t size;
+
+	errno_t rc = nic_iface->rx_pool_create(dev, count, buf_size, &area,
+	    &size);
+	async_answer_1(call, rc, size);
+	if (rc != EOK)
+		return;
+
+	ipc_call_t share;
+	size_t share_size;
+	if (!async_share_in_receive(&share, &share_size)) {
+		async_answer_0(&share, EINVAL);
+		return;
+	}
+
+	if (share_size != size) {
+		async_answer_0(&share, ELIMIT);
+		return;
+	}
+
+	(void) async_share_in_finalize(&share, area, AS_AREA_READ |
+	    AS_AREA_WRITE);
+}
+
 /** Remote NIC interface operations.
  *
  */
@@ -2529,7 +2608,8 @@ static const remote_iface_func_ptr_t remote_nic_iface_ops[] = {
 	[NIC_OFFLOAD_SET] = remote_nic_offload_set,
 	[NIC_POLL_GET_MODE] = remote_nic_poll_get_mode,
 	[NIC_POLL_SET_MODE] = remote_nic_poll_set_mode,
-	[NIC_POLL_NOW] = remote_nic_poll_now
+	[NIC_POLL_NOW] = remote_nic_poll_now,
+	[NIC_RX_POOL_CREATE] = remote_nic_rx_pool_create
 };
 
 /** Remote NIC interface structure.
@@ -42,9 +42,18 @@
 typedef enum {
 	NIC_EV_ADDR_CHANGED = IPC_FIRST_USER_METHOD,
 	NIC_EV_RECEIVED,
-	NIC_EV_DEVICE_STATE
+	NIC_EV_DEVICE_STATE,
+	NIC_EV_RX_POOL,
+	/**
+	 * Several frames received. The data written consist of frames, each
+	 * preceded by its length as uint32_t and padded to NIC_EV_BATCH_ALIGN.
+	 */
+	NIC_EV_RECEIVED_BATCH
 } nic_event_t;
 
+/** Alignment of frames in NIC_EV_RECEIVED_BATCH data */
+#define NIC_EV_BATCH_ALIGN  4
+
 extern errno_t nic_send_frame(async_sess_t *, void *, size_t);
 extern errno_t nic_callback_create(async_sess_t *, async_port_handler_t, void *);
 extern errno_t nic_get_state(async_sess_t *, nic_device_state_t *);
@@ -109,6 +118,9 @@ extern errno_t nic_poll_set_mode(async_sess_t *, nic_poll_mode_t,
     const struct timespec *);
 extern errno_t nic_poll_now(async_sess_t *);
 
+extern errno_t nic_rx_pool_create(async_sess_t *, size_t, size_t, void **,
+    size_t *);
+
 #endif
 
 /** @}
@@ -62,6 +62,8 @@ extern errno_t ext4_filesystem_free_inode(ext4_inode_ref_t *);
 extern errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *, aoff64_t);
 extern errno_t ext4_filesystem_get_inode_data_block_index(ext4_inode_ref_t *,
     aoff64_t iblock, uint32_t *);
+extern errno_t ext4_filesystem_get_inode_data_block_run(ext4_inode_ref_t *,
+    aoff64_t, uint32_t, uint32_t *, uint32_t *);
 extern errno_t ext4_filesystem_set_inode_data_block_index(ext4_inode_ref_t *,
     aoff64_t, uint32_t);
 extern errno_t ext4_filesystem_release_inode_block(ext4_inode_ref_t *, uint32_t);
@@ -36,6 +36,7 @@
 #define LIBEXT4_TYPES_H_
 
 #include <block.h>
+#include <fibril_synch.h>
 
 /*
  * Structure of the super block
@@ -227,11 +228,36 @@ typedef struct ext4_superblock {
 	EXT4_FEATURE_RO_COMPAT_GDT_CSUM | \
 	EXT4_FEATURE_RO_COMPAT_EXTRA_ISIZE)
 
+/* Geometry of the extent lookup cache */
+#define EXT4_EXTENT_CACHE_SETS  64
+#define EXT4_EXTENT_CACHE_WAYS  4
+
+/*
+ * Extent remembered by the extent lookup cache.
+ */
+typedef struct ext4_extent_cache_entry {
+	uint32_t inode;        /* I-node index, zero for an unused entry */
+	uint32_t first_block;  /* First logical block covered by the extent */
+	uint32_t block_count;  /* Number of blocks covered by the extent */
+	uint64_t start;        /* First physical block of the extent */
+} ext4_extent_cache_entry_t;
+
+/*
+ * Set-associative cache of recently used extents, indexed by i-node.
+ */
+typedef struct ext4_extent_cache {
+	fibril_mutex_t lock;
+	ext4_extent_cache_entry_t
+	    entries[EXT4_EXTENT_CACHE_SETS][EXT4_EXTENT_CACHE_WAYS];
+	unsigned victim[EXT4_EXTENT_CACHE_SETS];  /* Next way to replace */
+} ext4_extent_cache_t;
+
 typedef struct ext4_filesystem {
 	service_id_t device;
 	ext4_superblock_t *superblock;
 	aoff64_t inode_block_limits[4];
 	aoff64_t inode_blocks_per_level[4];
+	ext4_extent_cache_t extent_cache;
 } ext4_filesystem_t;
 
 /** Size of buffer for volume name. To hold 16 latin-1 chars encoded as UTF-8
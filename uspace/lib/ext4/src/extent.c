@@ -441,6 +441,199 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 	return rc;
 }
 
+/** Initialize the extent lookup cache.
+ *
+ * @param cache Cache to initialize
+ *
+ */
+void ext4_extent_cache_init(ext4_extent_cache_t *cache)
+{
+	fibril_mutex_initialize(&cache->lock);
+	memset(cache->entries, 0, sizeof(cache->entries));
+	memset(cache->victim, 0, sizeof(cache->victim));
+}
+
+/** Look up a logical block in the extent lookup cache.
+ *
+ * @param inode_ref I-node the block belongs to
+ * @param iblock    Logical block number to find
+ * @param fblock    Output value for physical block number
+ * @param count     Output value for number of blocks of the extent
+ *                  starting with iblock
+ *
+ * @return True if the block was found in the cache
+ *
+ */
+static bool ext4_extent_cache_find(ext4_inode_ref_t *inode_ref,
+    uint32_t iblock, uint64_t *fblock, uint32_t *count)
+{
+	ext4_extent_cache_t *cache = &inode_ref->fs->extent_cache;
+	unsigned set = inode_ref->index % EXT4_EXTENT_CACHE_SETS;
+	bool found = false;
+
+	fibril_mutex_lock(&cache->lock);
+
+	for (unsigned way = 0; way < EXT4_EXTENT_CACHE_WAYS; way++) {
+		ext4_extent_cache_entry_t *entry = &cache->entries[set][way];
+
+		if ((entry->inode == inode_ref->index) &&
+		    (iblock >= entry->first_block) &&
+		    (iblock - entry->first_block < entry->block_count)) {
+			*fblock = entry->start + iblock - entry->first_block;
+			*count = entry->block_count -
+			    (iblock - entry->first_block);
+			found = true;
+			break;
+		}
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+	return found;
+}
+
+/** Remember an extent in the extent lookup cache.
+ *
+ * @param inode_ref I-node the extent belongs to
+ * @param extent    Extent to remember
+ *
+ */
+static void ext4_extent_cache_insert(ext4_inode_ref_t *inode_ref,
+    ext4_extent_t *extent)
+{
+	ext4_extent_cache_t *cache = &inode_ref->fs->extent_cache;
+	unsigned set = inode_ref->index % EXT4_EXTENT_CACHE_SETS;
+
+	fibril_mutex_lock(&cache->lock);
+
+	ext4_extent_cache_entry_t *entry =
+	    &cache->entries[set][cache->victim[set]];
+	cache->victim[set] = (cache->victim[set] + 1) % EXT4_EXTENT_CACHE_WAYS;
+
+	entry->inode = inode_ref->index;
+	entry->first_block = ext4_extent_get_first_block(extent);
+	entry->block_count = ext4_extent_get_block_count(extent);
+	entry->start = ext4_extent_get_start(extent);
+
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Forget all cached extents of an i-node.
+ *
+ * Must be called whenever blocks are released from the i-node.
+ *
+ * @param inode_ref I-node to forget extents of
+ *
+ */
+static void ext4_extent_cache_invalidate(ext4_inode_ref_t *inode_ref)
+{
+	ext4_extent_cache_t *cache = &inode_ref->fs->extent_cache;
+	unsigned set = inode_ref->index % EXT4_EXTENT_CACHE_SETS;
+
+	fibril_mutex_lock(&cache->lock);
+
+	for (unsigned way = 0; way < EXT4_EXTENT_CACHE_WAYS; way++) {
+		if (cache->entries[set][way].inode == inode_ref->index)
+			cache->entries[set][way].inode = 0;
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Find a run of physically contiguous blocks in the extent tree.
+ *
+ * Unlike ext4_extent_find_block(), this also tells how many of the following
+ * logical blocks are mapped contiguously, so that they can be transferred at
+ * once. Extents found are remembered in the extent lookup cache.
+ *
+ * @param inode_ref I-node to load blocks from
+ * @param iblock    Logical block number to find
+ * @param fblock    Output value for physical block number of iblock,
+ *                  zero if iblock is not allocated
+ * @param count     Output value for number of blocks starting with iblock
+ *                  which are mapped contiguously or which are not
+ *                  allocated; at least one
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_extent_find_run(ext4_inode_ref_t *inode_ref, uint32_t iblock,
+    uint64_t *fblock, uint32_t *count)
+{
+	errno_t rc = EOK;
+
+	if (ext4_extent_cache_find(inode_ref, iblock, fblock, count))
+		return EOK;
+
+	*fblock = 0;
+	*count = 1;
+
+	/* Compute bound defined by i-node size */
+	uint64_t inode_size =
+	    ext4_inode_get_size(inode_ref->fs->superblock, inode_ref->inode);
+
+	uint32_t block_size =
+	    ext4_superblock_get_block_size(inode_ref->fs->superblock);
+
+	if ((inode_size == 0) || (iblock > (inode_size - 1) / block_size))
+		return EOK;
+
+	block_t *block = NULL;
+
+	/* Walk through extent tree */
+	ext4_extent_header_t *header =
+	    ext4_inode_get_extent_header(inode_ref->inode);
+
+	while (ext4_extent_header_get_depth(header) != 0) {
+		ext4_extent_index_t *index;
+		ext4_extent_binsearch_idx(header, &index, iblock);
+
+		uint64_t child = ext4_extent_index_get_leaf(index);
+
+		if (block != NULL) {
+			rc = block_put(block);
+			if (rc != EOK)
+				return rc;
+		}
+
+		rc = block_get(&block, inode_ref->fs->device, child,
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			return rc;
+
+		header = (ext4_extent_header_t *)block->data;
+	}
+
+	ext4_extent_t *extent = NULL;
+	ext4_extent_binsearch(header, &extent, iblock);
+
+	if (extent != NULL) {
+		uint32_t first = ext4_extent_get_first_block(extent);
+		uint16_t block_count = ext4_extent_get_block_count(extent);
+
+		if ((iblock >= first) && (iblock - first < block_count)) {
+			*fblock = ext4_extent_get_start(extent) + iblock - first;
+			*count = block_count - (iblock - first);
+			ext4_extent_cache_insert(inode_ref, extent);
+		} else {
+			/* The block lies in a hole, find where it ends */
+			ext4_extent_t *last = EXT4_EXTENT_FIRST(header) +
+			    ext4_extent_header_get_entries_count(header) - 1;
+
+			if ((iblock < first) || (extent < last)) {
+				ext4_extent_t *next = (iblock < first) ?
+				    extent : extent + 1;
+				*count = ext4_extent_get_first_block(next) -
+				    iblock;
+			}
+		}
+	}
+
+	if (block != NULL)
+		rc = block_put(block);
+
+	return rc;
+}
+
 /** Find extent for specified iblock.
  *
  * This function is used for finding block in the extent tree with
@@ -619,6 +812,8 @@ static errno_t ext4_extent_release_branch(ext4_inode_ref_t *inode_ref,
 errno_t ext4_extent_release_blocks_from(ext4_inode_ref_t *inode_ref,
     uint32_t iblock_from)
 {
+	ext4_extent_cache_invalidate(inode_ref);
+
 	/* Find the first extent to modify */
 	ext4_extent_path_t *path;
 	errno_t rc2;
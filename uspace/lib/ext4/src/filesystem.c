@@ -114,6 +114,8 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 		    fs->inode_blocks_per_level[i];
 	}
 
+	ext4_extent_cache_init(&fs->extent_cache);
+
 	/* Return loaded superblock */
 	fs->superblock = temp_superblock;
 
@@ -1689,6 +1691,68 @@ errno_t ext4_filesystem_get_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 	return EOK;
 }
 
+/** Get physical block addresses for a run of data blocks of i-node.
+ *
+ * @param inode_ref I-node to read block addresses from
+ * @param iblock    Logical index of the first block
+ * @param max_count Maximum number of blocks to return
+ * @param fblock    Output value for physical address of the first block,
+ *                  zero if the block is not allocated
+ * @param count     Output value for number of blocks starting with iblock
+ *                  which are either mapped to consecutive physical blocks
+ *                  or all not allocated; at least one
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_filesystem_get_inode_data_block_run(ext4_inode_ref_t *inode_ref,
+    aoff64_t iblock, uint32_t max_count, uint32_t *fblock, uint32_t *count)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	errno_t rc;
+
+	assert(max_count > 0);
+
+	/* Handle i-node using extents */
+	if ((ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
+		uint64_t start;
+		uint32_t run;
+
+		rc = ext4_extent_find_run(inode_ref, iblock, &start, &run);
+		if (rc != EOK)
+			return rc;
+
+		*fblock = start;
+		*count = min(run, max_count);
+		return EOK;
+	}
+
+	/* Otherwise look up the following blocks one by one */
+	uint32_t first;
+	rc = ext4_filesystem_get_inode_data_block_index(inode_ref, iblock,
+	    &first);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t n;
+	for (n = 1; n < max_count; n++) {
+		uint32_t next;
+		rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
+		    iblock + n, &next);
+		if (rc != EOK)
+			return rc;
+
+		if (next != ((first == 0) ? 0 : first + n))
+			break;
+	}
+
+	*fblock = first;
+	*count = n;
+	return EOK;
+}
+
 /** Set physical block address for the block logical address into the i-node.
  *
  * @param inode_ref I-node to set block address to
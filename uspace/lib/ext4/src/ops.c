@@ -55,6 +55,9 @@
 #include "ext4/fstypes.h"
 #include "ext4/superblock.h"
 
+/** Largest amount of file data moved by a single read or write request */
+#define EXT4_IO_MAX_SIZE  (128 * 1024)
+
 /* Forward declarations of auxiliary functions */
 
 static errno_t ext4_read_directory(ipc_call_t *, aoff64_t, size_t,
@@ -1181,6 +1184,9 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 }
 
 /** Read data from file.
+ *
+ * Reads spanning several blocks that are contiguous on the device are
+ * served by a single transfer which bypasses the block cache.
  *
  * @param call      IPC call
  * @param pos       Position to start reading from
@@ -1205,30 +1211,35 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 		return EOK;
 	}
 
-	/* For now, we only read data from one block at a time */
 	uint32_t block_size = ext4_superblock_get_block_size(sb);
 	aoff64_t file_block = pos / block_size;
 	uint32_t offset_in_block = pos % block_size;
-	uint32_t bytes = min(block_size - offset_in_block, size);
+	size_t bytes = min(size, EXT4_IO_MAX_SIZE - offset_in_block);
 
 	/* Handle end of file */
 	if (pos + bytes > file_size)
 		bytes = file_size - pos;
 
-	/* Get the real block number */
+	/* Get the real block numbers of as many blocks as are contiguous */
+	uint32_t nblocks = (offset_in_block + bytes + block_size - 1) /
+	    block_size;
 	uint32_t fs_block;
-	errno_t rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
-	    file_block, &fs_block);
+	uint32_t count;
+	errno_t rc = ext4_filesystem_get_inode_data_block_run(inode_ref,
+	    file_block, nblocks, &fs_block, &count);
 	if (rc != EOK) {
 		async_answer_0(call, rc);
 		return rc;
 	}
 
+	if (count < nblocks)
+		bytes = count * block_size - offset_in_block;
+
 	/*
 	 * Check for sparse file.
-	 * If ext4_filesystem_get_inode_data_block_index returned
-	 * fs_block == 0, it means that the given block is not allocated for the
-	 * file and we need to return a buffer of zeros
+	 * If ext4_filesystem_get_inode_data_block_run returned
+	 * fs_block == 0, it means that the given blocks are not allocated for
+	 * the file and we need to return a buffer of zeros
 	 */
 	uint8_t *buffer;
 	if (fs_block == 0) {
@@ -1247,6 +1258,32 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 		return rc;
 	}
 
+	if (count > 1) {
+		/* Large read - transfer the whole run at once */
+		buffer = malloc(count * block_size);
+		if (buffer == NULL) {
+			async_answer_0(call, ENOMEM);
+			return ENOMEM;
+		}
+
+		rc = block_read_uncached(inst->service_id, fs_block, count,
+		    buffer);
+		if (rc != EOK) {
+			free(buffer);
+			async_answer_0(call, rc);
+			return rc;
+		}
+
+		rc = async_data_read_finalize(call, buffer + offset_in_block,
+		    bytes);
+		free(buffer);
+		if (rc != EOK)
+			return rc;
+
+		*rbytes = bytes;
+		return EOK;
+	}
+
 	/* Usual case - we need to read a block from device */
 	block_t *block;
 	rc = block_get(&block, inst->service_id, fs_block, BLOCK_FLAGS_NONE);
@@ -1270,6 +1307,174 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 	return EOK;
 }
 
+/** Get physical block for writing, allocating it if necessary.
+ *
+ * @param inode_ref I-node being written to
+ * @param iblock    Logical block number within the i-node
+ * @param fblock    Output value - physical block number
+ * @param fresh     Output value - true if the block was newly allocated
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_write_get_block(ext4_inode_ref_t *inode_ref,
+    uint32_t iblock, uint32_t *fblock, bool *fresh)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
+
+	*fresh = false;
+
+	errno_t rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
+	    iblock, fblock);
+	if (rc != EOK)
+		return rc;
+
+	/* Check for sparse file */
+	if (*fblock != 0)
+		return EOK;
+
+	if ((ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
+		uint32_t last_iblock =
+		    ext4_inode_get_size(fs->superblock, inode_ref->inode) /
+		    block_size;
+
+		while (last_iblock < iblock) {
+			rc = ext4_extent_append_block(inode_ref, &last_iblock,
+			    fblock, true);
+			if (rc != EOK)
+				return rc;
+		}
+
+		rc = ext4_extent_append_block(inode_ref, &last_iblock,
+		    fblock, false);
+		if (rc != EOK)
+			return rc;
+	} else {
+		rc = ext4_balloc_alloc_block(inode_ref, fblock);
+		if (rc != EOK)
+			return rc;
+
+		rc = ext4_filesystem_set_inode_data_block_index(inode_ref,
+		    iblock, *fblock);
+		if (rc != EOK) {
+			ext4_balloc_free_block(inode_ref, *fblock);
+			return rc;
+		}
+	}
+
+	*fresh = true;
+	inode_ref->dirty = true;
+	return EOK;
+}
+
+/** Write whole blocks to file, bypassing the block cache.
+ *
+ * Receives up to EXT4_IO_MAX_SIZE bytes of whole blocks, maps or
+ * allocates the target blocks and writes each physically contiguous
+ * run of them in a single transfer.
+ *
+ * @param call      IPC call
+ * @param inode_ref I-node to write to
+ * @param pos       Block-aligned position in file
+ * @param len       Number of bytes offered by the client
+ * @param wbytes    Output value - real number of written bytes
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_write_blocks(ipc_call_t *call, ext4_inode_ref_t *inode_ref,
+    aoff64_t pos, size_t len, size_t *wbytes)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
+	uint32_t iblock = pos / block_size;
+	uint32_t nblocks = min(len, EXT4_IO_MAX_SIZE) / block_size;
+
+	uint32_t *fblocks = malloc(nblocks * sizeof(uint32_t));
+	uint8_t *buffer = malloc(nblocks * block_size);
+	if ((fblocks == NULL) || (buffer == NULL)) {
+		free(fblocks);
+		free(buffer);
+		async_answer_0(call, ENOMEM);
+		return ENOMEM;
+	}
+
+	errno_t rc = async_data_write_finalize(call, buffer,
+	    nblocks * block_size);
+	if (rc != EOK)
+		goto out;
+
+	/*
+	 * Map or allocate the blocks. Extent appends place new blocks after
+	 * the i-node size, so it is advanced with every block while mapping
+	 * and settled once the data are on the disk. Running out of space
+	 * part way through results in a short write.
+	 */
+	aoff64_t old_size = ext4_inode_get_size(fs->superblock,
+	    inode_ref->inode);
+
+	uint32_t n;
+	for (n = 0; n < nblocks; n++) {
+		bool fresh;
+		rc = ext4_write_get_block(inode_ref, iblock + n, &fblocks[n],
+		    &fresh);
+		if (rc != EOK)
+			break;
+
+		aoff64_t end = (aoff64_t) (iblock + n + 1) * block_size;
+		if (end > ext4_inode_get_size(fs->superblock, inode_ref->inode))
+			ext4_inode_set_size(inode_ref->inode, end);
+	}
+
+	/* Write each physically contiguous run in a single transfer */
+	uint32_t i = 0;
+	while (i < n) {
+		uint32_t j = i + 1;
+		while ((j < n) && (fblocks[j] == fblocks[i] + (j - i)))
+			j++;
+
+		rc = block_write_uncached(fs->device, fblocks[i], j - i,
+		    buffer + i * block_size);
+		if (rc != EOK)
+			break;
+
+		i = j;
+	}
+
+	/*
+	 * The i-node covers only the blocks actually written. Blocks mapped
+	 * beyond them are released again.
+	 */
+	aoff64_t new_size = max(old_size, pos + (aoff64_t) i * block_size);
+	aoff64_t new_end = ((new_size + block_size - 1) / block_size) *
+	    block_size;
+
+	errno_t rc2 = EOK;
+	if (ext4_inode_get_size(fs->superblock, inode_ref->inode) > new_end)
+		rc2 = ext4_filesystem_truncate_inode(inode_ref, new_end);
+
+	ext4_inode_set_size(inode_ref->inode, new_size);
+	if (new_size != old_size)
+		inode_ref->dirty = true;
+
+	if (i == 0)
+		goto out;
+
+	rc = rc2;
+	if (rc != EOK)
+		goto out;
+
+	*wbytes = i * block_size;
+
+out:
+	free(fblocks);
+	free(buffer);
+	return rc;
+}
+
 /** Write bytes to file
  *
  * @param service_id Device identifier
@@ -1300,9 +1505,20 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 
 	ext4_node_t *enode = EXT4_NODE(fn);
 	ext4_filesystem_t *fs = enode->instance->filesystem;
+	ext4_inode_ref_t *inode_ref = enode->inode_ref;
 
 	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
 
+	/* Large aligned writes are transferred several blocks at a time */
+	if ((pos % block_size == 0) && (len >= 2 * block_size)) {
+		rc = ext4_write_blocks(&call, inode_ref, pos, len, wbytes);
+		if (rc != EOK)
+			goto exit;
+
+		*nsize = ext4_inode_get_size(fs->superblock, inode_ref->inode);
+		goto exit;
+	}
+
 	/* Prevent writing to more than one block */
 	uint32_t bytes = min(len, block_size - (pos % block_size));
 
@@ -1312,59 +1528,16 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 
 	uint32_t iblock =  pos / block_size;
 	uint32_t fblock;
+	bool fresh;
 
-	/* Load inode */
-	ext4_inode_ref_t *inode_ref = enode->inode_ref;
-	rc = ext4_filesystem_get_inode_data_block_index(inode_ref, iblock,
-	    &fblock);
+	rc = ext4_write_get_block(inode_ref, iblock, &fblock, &fresh);
 	if (rc != EOK) {
 		async_answer_0(&call, rc);
 		goto exit;
 	}
 
-	/* Check for sparse file */
-	if (fblock == 0) {
-		if ((ext4_superblock_has_feature_incompatible(fs->superblock,
-		    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
-		    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
-			uint32_t last_iblock =
-			    ext4_inode_get_size(fs->superblock, inode_ref->inode) /
-			    block_size;
-
-			while (last_iblock < iblock) {
-				rc = ext4_extent_append_block(inode_ref, &last_iblock,
-				    &fblock, true);
-				if (rc != EOK) {
-					async_answer_0(&call, rc);
-					goto exit;
-				}
-			}
-
-			rc = ext4_extent_append_block(inode_ref, &last_iblock,
-			    &fblock, false);
-			if (rc != EOK) {
-				async_answer_0(&call, rc);
-				goto exit;
-			}
-		} else {
-			rc = ext4_balloc_alloc_block(inode_ref, &fblock);
-			if (rc != EOK) {
-				async_answer_0(&call, rc);
-				goto exit;
-			}
-
-			rc = ext4_filesystem_set_inode_data_block_index(inode_ref,
-			    iblock, fblock);
-			if (rc != EOK) {
-				ext4_balloc_free_block(inode_ref, fblock);
-				async_answer_0(&call, rc);
-				goto exit;
-			}
-		}
-
+	if (fresh)
 		flags = BLOCK_FLAGS_NOREAD;
-		inode_ref->dirty = true;
-	}
 
 	/* Load target block */
 	block_t *write_block;
@@ -36,21 +36,22 @@
 #ifndef LIBNETTL_AMAP_H_
 #define LIBNETTL_AMAP_H_
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <inet/endpoint.h>
 #include <nettl/portrng.h>
 #include <loc.h>
 
-/** Port range for (remote endpoint, local address) */
+/** Fully specified association (remote endpoint, local endpoint) */
 typedef struct {
 	/** Link to amap_t.repla */
-	link_t lamap;
+	ht_link_t lamap;
 	/** Remote endpoint */
 	inet_ep_t rep;
-	/* Local address */
-	inet_addr_t laddr;
-	/** Port range */
-	portrng_t *portrng;
+	/** Local endpoint */
+	inet_ep_t lep;
+	/** User argument */
+	void *arg;
 } amap_repla_t;
 
 /** Port range for local address */
@@ -75,8 +76,10 @@ typedef struct {
 
 /** Association map */
 typedef struct {
-	/** Remote endpoint, local address */
-	list_t repla; /* of amap_repla_t */
+	/** Remote endpoint, local endpoint */
+	hash_table_t repla; /* of amap_repla_t */
+	/** Next dynamic port number to try for repla allocation */
+	uint16_t repla_dyn_next;
 	/** Local addresses */
 	list_t laddr; /* of amap_laddr_t */
 	/** Local links */
@@ -40,15 +40,21 @@
  * set of attributes (key) they specify. In order from most specific to the
  * least specific one:
  *
- *  - repla (remote endpoint, local address)
+ *  - repla (remote endpoint, local endpoint)
  *  - laddr (local address)
  *  - llink (local link)
  *  - unspec (unspecified)
  *
  * In the unspecified case only the local port is known and the entry matches
  * all remote and local addresses.
+ *
+ * Repla entries (one per connection) are kept in a hash table keyed by
+ * the full endpoint pair so that per-segment lookup does not depend on
+ * the number of connections.
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
 #include <inet/addr.h>
@@ -74,6 +80,74 @@ static portrng_flags_t aflags_to_pflags(amap_flags_t flags)
 	return pflags;
 }
 
+static size_t amap_addr_hash(const inet_addr_t *addr)
+{
+	size_t hash = addr->version;
+	size_t i;
+
+	switch (addr->version) {
+	case ip_v4:
+		hash = hash_combine(hash, hash_mix32(addr->addr));
+		break;
+	case ip_v6:
+		for (i = 0; i < 16; i += 4) {
+			hash = hash_combine(hash, hash_mix32(
+			    ((uint32_t) addr->addr6[i] << 24) |
+			    ((uint32_t) addr->addr6[i + 1] << 16) |
+			    ((uint32_t) addr->addr6[i + 2] << 8) |
+			    addr->addr6[i + 3]));
+		}
+		break;
+	default:
+		break;
+	}
+
+	return hash;
+}
+
+static size_t amap_repla_hash_fn(const inet_ep_t *rep, const inet_ep_t *lep)
+{
+	size_t hash;
+
+	hash = hash_mix32(((uint32_t) rep->port << 16) | lep->port);
+	hash = hash_combine(hash, amap_addr_hash(&rep->addr));
+	hash = hash_combine(hash, amap_addr_hash(&lep->addr));
+	return hash;
+}
+
+static size_t amap_repla_hash(const ht_link_t *item)
+{
+	amap_repla_t *repla = hash_table_get_inst(item, amap_repla_t, lamap);
+
+	return amap_repla_hash_fn(&repla->rep, &repla->lep);
+}
+
+static size_t amap_repla_key_hash(const void *key)
+{
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
+
+	return amap_repla_hash_fn(&epp->remote, &epp->local);
+}
+
+static bool amap_repla_key_equal(const void *key, const ht_link_t *item)
+{
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
+	amap_repla_t *repla = hash_table_get_inst(item, amap_repla_t, lamap);
+
+	return repla->rep.port == epp->remote.port &&
+	    repla->lep.port == epp->local.port &&
+	    inet_addr_compare(&repla->rep.addr, &epp->remote.addr) &&
+	    inet_addr_compare(&repla->lep.addr, &epp->local.addr);
+}
+
+static hash_table_ops_t amap_repla_ops = {
+	.hash = amap_repla_hash,
+	.key_hash = amap_repla_key_hash,
+	.key_equal = amap_repla_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
 /** Create association map.
  *
  * @param rmap Place to store pointer to new association map
@@ -97,7 +171,13 @@ errno_t amap_create(amap_t **rmap)
 		return ENOMEM;
 	}
 
-	list_initialize(&map->repla);
+	if (!hash_table_create(&map->repla, 0, 0, &amap_repla_ops)) {
+		portrng_destroy(map->unspec);
+		free(map);
+		return ENOMEM;
+	}
+
+	map->repla_dyn_next = inet_port_dyn_lo;
 	list_initialize(&map->laddr);
 	list_initialize(&map->llink);
 
@@ -113,104 +193,82 @@ void amap_destroy(amap_t *map)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_destroy()");
 
-	assert(list_empty(&map->repla));
+	assert(hash_table_empty(&map->repla));
 	assert(list_empty(&map->laddr));
 	assert(list_empty(&map->llink));
+	hash_table_destroy(&map->repla);
+	portrng_destroy(map->unspec);
 	free(map);
 }
 
 /** Find exact repla.
  *
- * Find repla (remote endpoint, local address) entry by exact match.
+ * Find repla (remote endpoint, local endpoint) entry by exact match.
  *
  * @param map Association map
  * @param rep Remote endpoint
- * @param la  Local address
+ * @param lep Local endpoint
  * @param rrepla Place to store pointer to repla
  *
  * @return EOK on success, ENOENT if not found
  */
-static errno_t amap_repla_find(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
+static errno_t amap_repla_find(amap_t *map, inet_ep_t *rep, inet_ep_t *lep,
     amap_repla_t **rrepla)
 {
-	char *sraddr, *sladdr;
-
-	(void) inet_addr_format(&rep->addr, &sraddr);
-	(void) inet_addr_format(la, &sladdr);
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): rep=(%s,%" PRIu16
-	    ") la=%s", sraddr, rep->port, sladdr);
-	free(sraddr);
-	free(sladdr);
-
-	list_foreach(map->repla, lamap, amap_repla_t, repla) {
-		(void) inet_addr_format(&repla->rep.addr, &sraddr);
-		(void) inet_addr_format(&repla->laddr, &sladdr);
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): "
-		    "compare to rep=(%s, %" PRIu16 ") la=%s",
-		    sraddr, repla->rep.port, sladdr);
-		free(sraddr);
-		free(sladdr);
-		if (inet_addr_compare(&repla->rep.addr, &rep->addr) &&
-		    repla->rep.port == rep->port &&
-		    inet_addr_compare(&repla->laddr, la)) {
-			*rrepla = repla;
-			return EOK;
-		}
+	inet_ep2_t key;
+	ht_link_t *link;
+
+	key.local_link = 0;
+	key.local = *lep;
+	key.remote = *rep;
+
+	link = hash_table_find(&map->repla, &key);
+	if (link == NULL) {
+		*rrepla = NULL;
+		return ENOENT;
 	}
 
-	*rrepla = NULL;
-	return ENOENT;
+	*rrepla = hash_table_get_inst(link, amap_repla_t, lamap);
+	return EOK;
 }
 
 /** Insert repla.
  *
- * Insert new repla (remote endpoint, local address) entry to association map.
+ * Insert new repla (remote endpoint, local endpoint) entry to association map.
  *
  * @param amap   Association map
  * @param rep    Remote endpoint
- * @param la     Local address
- * @param rrepla Place to store pointer to new repla
+ * @param lep    Local endpoint
+ * @param arg    User argument
  *
  * @return EOK on success, ENOMEM if out of memory
  */
-static errno_t amap_repla_insert(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
-    amap_repla_t **rrepla)
+static errno_t amap_repla_insert(amap_t *map, inet_ep_t *rep, inet_ep_t *lep,
+    void *arg)
 {
 	amap_repla_t *repla;
-	errno_t rc;
 
 	repla = calloc(1, sizeof(amap_repla_t));
-	if (repla == NULL) {
-		*rrepla = NULL;
+	if (repla == NULL)
 		return ENOMEM;
-	}
-
-	rc = portrng_create(&repla->portrng);
-	if (rc != EOK) {
-		free(repla);
-		return ENOMEM;
-	}
 
 	repla->rep = *rep;
-	repla->laddr = *la;
-	list_append(&repla->lamap, &map->repla);
-
-	*rrepla = repla;
+	repla->lep = *lep;
+	repla->arg = arg;
+	hash_table_insert(&map->repla, &repla->lamap);
 	return EOK;
 }
 
 /** Remove repla from association map.
  *
- * Remove repla (remote endpoint, local address) from association map.
+ * Remove repla (remote endpoint, local endpoint) from association map.
  *
  * @param map   Association map
  * @param repla Repla
  */
 static void amap_repla_remove(amap_t *map, amap_repla_t *repla)
 {
-	list_remove(&repla->lamap);
-	portrng_destroy(repla->portrng);
+	hash_table_remove_item(&map->repla, &repla->lamap);
 	free(repla);
 }
 
@@ -376,26 +434,53 @@ static errno_t amap_insert_repla(amap_t *map, inet_ep2_t *epp, void *arg,
 {
 	amap_repla_t *repla;
 	inet_ep2_t mepp;
+	uint32_t i;
 	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_insert_repla()");
 
-	rc = amap_repla_find(map, &epp->remote, &epp->local.addr, &repla);
-	if (rc != EOK) {
-		/* New repla */
-		rc = amap_repla_insert(map, &epp->remote, &epp->local.addr,
-		    &repla);
-		if (rc != EOK) {
-			assert(rc == ENOMEM);
-			return rc;
+	mepp = *epp;
+
+	if (mepp.local.port == inet_port_any) {
+		/*
+		 * Try dynamic ports starting from where the last allocation
+		 * left off so that recently freed ports are not reused
+		 * immediately.
+		 */
+		for (i = inet_port_dyn_lo; i <= inet_port_dyn_hi; i++) {
+			mepp.local.port = map->repla_dyn_next;
+			if (map->repla_dyn_next == inet_port_dyn_hi)
+				map->repla_dyn_next = inet_port_dyn_lo;
+			else
+				++map->repla_dyn_next;
+
+			rc = amap_repla_find(map, &mepp.remote, &mepp.local,
+			    &repla);
+			if (rc != EOK)
+				break;
 		}
-	}
 
-	mepp = *epp;
+		if (i > inet_port_dyn_hi) {
+			/* No free port found */
+			return ENOENT;
+		}
+	} else {
+		if ((flags & af_allow_system) == 0 &&
+		    mepp.local.port < inet_port_user_lo) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG2, "system port not allowed");
+			return EINVAL;
+		}
 
-	rc = portrng_alloc(repla->portrng, epp->local.port, arg, aflags_to_pflags(flags),
-	    &mepp.local.port);
+		rc = amap_repla_find(map, &mepp.remote, &mepp.local, &repla);
+		if (rc == EOK) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG2, "port already used");
+			return EEXIST;
+		}
+	}
+
+	rc = amap_repla_insert(map, &mepp.remote, &mepp.local, arg);
 	if (rc != EOK) {
+		assert(rc == ENOMEM);
 		return rc;
 	}
 
@@ -600,16 +685,13 @@ static void amap_remove_repla(amap_t *map, inet_ep2_t *epp)
 	amap_repla_t *repla;
 	errno_t rc;
 
-	rc = amap_repla_find(map, &epp->remote, &epp->local.addr, &repla);
+	rc = amap_repla_find(map, &epp->remote, &epp->local, &repla);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_remove_repla: not found");
 		return;
 	}
 
-	portrng_free_port(repla->portrng, epp->local.port);
-
-	if (portrng_empty(repla->portrng))
-		amap_repla_remove(map, repla);
+	amap_repla_remove(map, repla);
 }
 
 /** Remove endpoint pair using laddr as key from map.
@@ -730,16 +812,13 @@ errno_t amap_find_match(amap_t *map, inet_ep2_t *epp, void **rarg)
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_find_match(llink=%zu)",
 	    epp->local_link);
 
-	/* Remode endpoint, local address */
-	rc = amap_repla_find(map, &epp->remote, &epp->local.addr, &repla);
+	/* Remote endpoint, local endpoint */
+	rc = amap_repla_find(map, &epp->remote, &epp->local, &repla);
 	if (rc == EOK) {
-		rc = portrng_find_port(repla->portrng, epp->local.port,
-		    rarg);
-		if (rc == EOK) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched repla / "
-			    "port %" PRIu16, epp->local.port);
-			return EOK;
-		}
+		*rarg = repla->arg;
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched repla / "
+		    "port %" PRIu16, epp->local.port);
+		return EOK;
 	}
 
 	/* Local address */
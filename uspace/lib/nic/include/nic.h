@@ -68,6 +68,10 @@ typedef struct {
 	link_t link;
 	void *data;
 	size_t size;
+	/** Receive pool holding the data, NULL if the data were allocated */
+	struct nic_rx_pool *pool;
+	/** Index of the pool buffer holding the data */
+	size_t pool_idx;
 } nic_frame_t;
 
 typedef list_t nic_frame_list_t;
@@ -205,6 +209,27 @@ typedef errno_t (*poll_mode_change_handler)(nic_t *,
  */
 typedef void (*poll_request_handler)(nic_t *);
 
+/**
+ * Handler for NAPI-style budgeted polling. Called from the NICF polling
+ * fibril with the receive interrupts of the NIC masked.
+ *
+ * @param nic_data	NICF main structure
+ * @param frames	List to append the received frames to
+ * @param budget	Maximal number of frames to receive
+ *
+ * @return Number of frames received. Returning less than budget means
+ * 		   that the receive buffers are empty.
+ */
+typedef size_t (*napi_poll_handler)(nic_t *, nic_frame_list_t *, size_t);
+
+/**
+ * Handler masking or unmasking receive interrupts of the NIC.
+ *
+ * @param nic_data	NICF main structure
+ * @param enable	Unmask the interrupts if true, mask them otherwise
+ */
+typedef void (*napi_irq_handler)(nic_t *, bool);
+
 /* nic_t allocation and deallocation */
 extern nic_t *nic_create_and_bind(ddf_dev_t *);
 extern void nic_unbind_and_destroy(ddf_dev_t *);
@@ -228,6 +253,8 @@ extern void nic_set_wol_virtue_change_handlers(nic_t *,
     wol_virtue_add_handler, wol_virtue_remove_handler);
 extern void nic_set_poll_handlers(nic_t *,
     poll_mode_change_handler, poll_request_handler);
+extern errno_t nic_set_napi_handlers(nic_t *, napi_poll_handler,
+    napi_irq_handler, size_t);
 
 /* General driver functions */
 extern ddf_dev_t *nic_get_ddf_dev(nic_t *);
@@ -243,6 +270,7 @@ extern errno_t nic_report_poll_mode(nic_t *, nic_poll_mode_t, struct timespec *)
 extern void nic_query_address(nic_t *, nic_address_t *);
 extern void nic_received_frame(nic_t *, nic_frame_t *);
 extern void nic_received_frame_list(nic_t *, nic_frame_list_t *);
+extern void nic_napi_schedule(nic_t *);
 extern nic_poll_mode_t nic_query_poll_mode(nic_t *, struct timespec *);
 
 /* Statistics updates */
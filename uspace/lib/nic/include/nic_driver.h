@@ -45,6 +45,7 @@
 #include <fibril_synch.h>
 #include <nic/nic.h>
 #include <async.h>
+#include <pktpool.h>
 
 #include "nic.h"
 #include "nic_rx_control.h"
@@ -56,6 +57,31 @@ struct sw_poll_info {
 	volatile int running;
 };
 
+/** Receive buffer pool shared with the client */
+typedef struct nic_rx_pool {
+	/** Packet buffer pool */
+	pktpool_t *pool;
+	/** Number of frames whose data currently live in the pool */
+	size_t nframes;
+	/** Client has gone, destroy the pool once the last frame is released */
+	bool retired;
+} nic_rx_pool_t;
+
+/** Receive statistics updated by a single fibril */
+typedef struct nic_rx_stats {
+	/** Link in nic_t.rx_stats */
+	link_t link;
+	/** Fibril updating the statistics */
+	fid_t fid;
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t multicast;
+	uint64_t broadcast;
+	uint64_t filtered_unicast;
+	uint64_t filtered_multicast;
+	uint64_t filtered_broadcast;
+} nic_rx_stats_t;
+
 struct nic {
 	/**
 	 * Device from device manager's point of view.
@@ -79,6 +105,15 @@ struct nic {
 	nic_address_t default_mac;
 	/** Client callback session */
 	async_sess_t *client_session;
+	/** Receive buffer pool shared with the client or NULL */
+	nic_rx_pool_t *rx_pool;
+	/**
+	 * Lock for the receive buffer pool. No other lock from nic_t may be
+	 * acquired while holding this lock.
+	 */
+	fibril_mutex_t rx_pool_lock;
+	/** Client does not understand NIC_EV_RECEIVED_BATCH */
+	bool client_no_batch;
 	/** Current polling mode of the NIC */
 	nic_poll_mode_t poll_mode;
 	/** Polling period (applicable when poll_mode == NIC_POLL_PERIODIC) */
@@ -97,6 +132,20 @@ struct nic {
 	fibril_rwlock_t main_lock;
 	/** Device statistics */
 	nic_device_stats_t stats;
+	/**
+	 * Receive statistics of the fibrils delivering received frames
+	 * (of the type nic_rx_stats_t). These are not part of stats, so that
+	 * receiving does not need to take stats_lock for writing. Each block
+	 * is only ever written by its own fibril.
+	 */
+	list_t rx_stats;
+	/** Unique number of this instance, tags the per-fibril rx_stats cache */
+	unsigned long rx_stats_id;
+	/**
+	 * Lock for the rx_stats list. No other lock from nic_t may be
+	 * acquired while holding this lock.
+	 */
+	fibril_mutex_t rx_stats_lock;
 	/**
 	 * Lock for statistics. You must not hold any other lock from nic_t except
 	 * the main_lock at the same moment. If both this lock and main_lock should
@@ -194,6 +243,25 @@ struct nic {
 	 * The implementation is optional.
 	 */
 	poll_request_handler on_poll_request;
+	/**
+	 * NAPI-style budgeted receive handler. The implementation is optional,
+	 * set by nic_set_napi_handlers().
+	 */
+	napi_poll_handler napi_poll;
+	/** Receive interrupt masking handler, used with napi_poll */
+	napi_irq_handler napi_irq;
+	/** Maximal number of frames received by one napi_poll call */
+	size_t napi_budget;
+	/** Fibril calling napi_poll */
+	fid_t napi_fibril;
+	/** Polling was requested by nic_napi_schedule() */
+	bool napi_scheduled;
+	/** The polling fibril was asked to terminate */
+	bool napi_stop;
+	/** Lock for napi_fibril, napi_scheduled and napi_stop */
+	fibril_mutex_t napi_lock;
+	/** Signalled when polling or termination is requested */
+	fibril_condvar_t napi_cv;
 	/** Data specific for particular driver */
 	void *specific;
 };
@@ -209,6 +277,9 @@ typedef struct nic_globals {
 	fibril_mutex_t lock;
 } nic_globals_t;
 
+extern void nic_rx_pool_retire(nic_t *);
+extern void nic_rx_stats_collect(nic_t *, nic_device_stats_t *);
+
 #endif
 
 /** @}
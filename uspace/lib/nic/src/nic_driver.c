@@ -36,6 +36,7 @@
  * @brief Internal implementation of general NIC operations
  */
 
+#include <align.h>
 #include <assert.h>
 #include <fibril_synch.h>
 #include <ns.h>
@@ -44,8 +45,10 @@
 #include <sysinfo.h>
 #include <as.h>
 #include <ddf/interrupt.h>
+#include <nic_iface.h>
 #include <ops/nic.h>
 #include <errno.h>
+#include <stdatomic.h>
 
 #include "nic_driver.h"
 #include "nic_ev.h"
@@ -143,6 +146,8 @@ void nic_driver_implement(driver_ops_t *driver_ops, ddf_dev_ops_t *dev_ops,
 			iface->poll_set_mode = nic_poll_set_mode_impl;
 		if (!iface->poll_now)
 			iface->poll_now = nic_poll_now_impl;
+		if (!iface->rx_pool_create)
+			iface->rx_pool_create = nic_rx_pool_create_impl;
 	}
 }
 
@@ -280,16 +285,90 @@ nic_frame_t *nic_alloc_frame(nic_t *nic_data, size_t size)
 		link_initialize(&frame->link);
 	}
 
-	frame->data = malloc(size);
-	if (frame->data == NULL) {
-		free(frame);
-		return NULL;
+	frame->pool = NULL;
+
+	/* Place the data directly in the buffer pool shared with the client */
+	fibril_mutex_lock(&nic_data->rx_pool_lock);
+	nic_rx_pool_t *rx_pool = nic_data->rx_pool;
+	if (rx_pool != NULL && size <= pktpool_buf_size(rx_pool->pool) &&
+	    pktpool_alloc(rx_pool->pool, &frame->pool_idx) == EOK) {
+		frame->pool = rx_pool;
+		frame->data = pktpool_data(rx_pool->pool, frame->pool_idx);
+		rx_pool->nframes++;
+	}
+	fibril_mutex_unlock(&nic_data->rx_pool_lock);
+
+	if (frame->pool == NULL) {
+		frame->data = malloc(size);
+		if (frame->data == NULL) {
+			free(frame);
+			return NULL;
+		}
 	}
 
 	frame->size = size;
 	return frame;
 }
 
+/** Destroy a receive buffer pool. */
+static void nic_rx_pool_destroy(nic_rx_pool_t *rx_pool)
+{
+	pktpool_destroy(rx_pool->pool);
+	free(rx_pool);
+}
+
+/** Stop using the receive buffer pool shared with the client.
+ *
+ * The pool is destroyed as soon as no frames live in it.
+ *
+ * @param nic_data	The driver data
+ */
+void nic_rx_pool_retire(nic_t *nic_data)
+{
+	fibril_mutex_lock(&nic_data->rx_pool_lock);
+	nic_rx_pool_t *rx_pool = nic_data->rx_pool;
+	nic_data->rx_pool = NULL;
+
+	if (rx_pool != NULL) {
+		if (rx_pool->nframes == 0)
+			nic_rx_pool_destroy(rx_pool);
+		else
+			rx_pool->retired = true;
+	}
+
+	fibril_mutex_unlock(&nic_data->rx_pool_lock);
+}
+
+/** Detach frame data from its pool buffer.
+ *
+ * @param nic_data	The driver data
+ * @param frame		Frame with data in a pool buffer
+ * @param post		Pass the buffer to the client instead of freeing it
+ *
+ * @return @c true if the client needs to be notified about the posted frame
+ */
+static bool nic_frame_pool_put(nic_t *nic_data, nic_frame_t *frame, bool post)
+{
+	nic_rx_pool_t *rx_pool = frame->pool;
+	bool notify = false;
+
+	fibril_mutex_lock(&nic_data->rx_pool_lock);
+	if (post)
+		notify = pktpool_post(rx_pool->pool, frame->pool_idx, frame->size);
+	else
+		pktpool_discard(rx_pool->pool, frame->pool_idx);
+
+	frame->pool = NULL;
+	frame->data = NULL;
+	frame->size = 0;
+
+	if (--rx_pool->nframes == 0 && rx_pool->retired)
+		nic_rx_pool_destroy(rx_pool);
+	fibril_mutex_unlock(&nic_data->rx_pool_lock);
+
+	return notify;
+}
+
 /** Release frame
  *
  * @param nic_data	The driver data
@@ -300,6 +379,9 @@ void nic_release_frame(nic_t *nic_data, nic_frame_t *frame)
 	if (!frame)
 		return;
 
+	if (frame->pool != NULL)
+		(void) nic_frame_pool_put(nic_data, frame, false);
+
 	if (frame->data != NULL) {
 		free(frame->data);
 		frame->data = NULL;
@@ -507,66 +589,307 @@ void nic_set_tx_busy(nic_t *nic_data, int busy)
 	nic_data->tx_busy = busy;
 }
 
+/** Maximal size of the data of one NIC_EV_RECEIVED_BATCH event */
+#define NIC_BATCH_MAX_SIZE  (64 * 1024)
+
+/** Default number of frames received by one NAPI poll */
+#define NIC_NAPI_BUDGET_DEFAULT  64
+
+/** Source of nic_t.rx_stats_id */
+static atomic_ulong nic_rx_stats_ids;
+
+/** Receive statistics block of the current fibril */
+static fibril_local nic_rx_stats_t *nic_rx_stats_cur;
 /**
- * This is the function that the driver should call when it receives a frame.
- * The frame is checked by filters and then sent up to the NIL layer or
- * discarded. The frame is released.
+ * Instance the receive statistics block of the current fibril belongs to.
+ * The instance number is used rather than the pointer, so that the block
+ * of a destroyed NIC is never mistaken for one of a NIC allocated later
+ * at the same address.
+ */
+static fibril_local unsigned long nic_rx_stats_nic;
+
+/** Get the receive statistics block of the current fibril.
  *
- * @param nic_data
+ * @param nic_data	The driver data
+ *
+ * @return Statistics block or NULL if out of memory
+ */
+static nic_rx_stats_t *nic_rx_stats_get(nic_t *nic_data)
+{
+	if (nic_rx_stats_nic == nic_data->rx_stats_id)
+		return nic_rx_stats_cur;
+
+	fid_t fid = fibril_get_id();
+	nic_rx_stats_t *stats = NULL;
+
+	fibril_mutex_lock(&nic_data->rx_stats_lock);
+	list_foreach(nic_data->rx_stats, link, nic_rx_stats_t, cur) {
+		if (cur->fid == fid) {
+			stats = cur;
+			break;
+		}
+	}
+
+	if (stats == NULL) {
+		stats = calloc(1, sizeof(nic_rx_stats_t));
+		if (stats == NULL) {
+			fibril_mutex_unlock(&nic_data->rx_stats_lock);
+			return NULL;
+		}
+
+		link_initialize(&stats->link);
+		stats->fid = fid;
+		list_append(&stats->link, &nic_data->rx_stats);
+	}
+	fibril_mutex_unlock(&nic_data->rx_stats_lock);
+
+	nic_rx_stats_nic = nic_data->rx_stats_id;
+	nic_rx_stats_cur = stats;
+	return stats;
+}
+
+/** Add receive statistics to device statistics. */
+static void nic_rx_stats_add(nic_device_stats_t *stats,
+    const nic_rx_stats_t *rxs)
+{
+	stats->receive_packets += rxs->packets;
+	stats->receive_bytes += rxs->bytes;
+	stats->receive_multicast += rxs->multicast;
+	stats->receive_broadcast += rxs->broadcast;
+	stats->receive_filtered_unicast += rxs->filtered_unicast;
+	stats->receive_filtered_multicast += rxs->filtered_multicast;
+	stats->receive_filtered_broadcast += rxs->filtered_broadcast;
+}
+
+/** Add the per-fibril receive statistics to device statistics.
+ *
+ * The counters are read without synchronization with the fibrils
+ * updating them, so the result is a snapshot that may be slightly
+ * behind.
+ *
+ * @param nic_data	The driver data
+ * @param stats		Statistics to add to
+ */
+void nic_rx_stats_collect(nic_t *nic_data, nic_device_stats_t *stats)
+{
+	fibril_mutex_lock(&nic_data->rx_stats_lock);
+	list_foreach(nic_data->rx_stats, link, nic_rx_stats_t, rxs)
+		nic_rx_stats_add(stats, rxs);
+	fibril_mutex_unlock(&nic_data->rx_stats_lock);
+}
+
+/** Check a received frame by filters and count it.
+ *
+ * Must be called with rxc_lock locked for reading.
+ *
+ * @param nic_data	The driver data
  * @param frame		The received frame
+ * @param rxs		Receive statistics to update
+ *
+ * @return @c true if the frame should be passed to the client
  */
-void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+static bool nic_frame_accept(nic_t *nic_data, nic_frame_t *frame,
+    nic_rx_stats_t *rxs)
 {
-	/*
-	 * Note: this function must not lock main lock, because loopback driver
-	 * 		 calls it inside send_frame handler (with locked main lock)
-	 */
-	fibril_rwlock_read_lock(&nic_data->rxc_lock);
 	nic_frame_type_t frame_type;
 	bool check = nic_rxc_check(&nic_data->rx_control, frame->data,
 	    frame->size, &frame_type);
-	fibril_rwlock_read_unlock(&nic_data->rxc_lock);
-	/* Update statistics */
-	fibril_rwlock_write_lock(&nic_data->stats_lock);
 
 	if (nic_data->state == NIC_STATE_ACTIVE && check) {
-		nic_data->stats.receive_packets++;
-		nic_data->stats.receive_bytes += frame->size;
+		rxs->packets++;
+		rxs->bytes += frame->size;
 		switch (frame_type) {
 		case NIC_FRAME_MULTICAST:
-			nic_data->stats.receive_multicast++;
+			rxs->multicast++;
 			break;
 		case NIC_FRAME_BROADCAST:
-			nic_data->stats.receive_broadcast++;
+			rxs->broadcast++;
 			break;
 		default:
 			break;
 		}
-		fibril_rwlock_write_unlock(&nic_data->stats_lock);
-		nic_ev_received(nic_data->client_session, frame->data,
-		    frame->size);
-	} else {
-		switch (frame_type) {
-		case NIC_FRAME_UNICAST:
-			nic_data->stats.receive_filtered_unicast++;
-			break;
-		case NIC_FRAME_MULTICAST:
-			nic_data->stats.receive_filtered_multicast++;
-			break;
-		case NIC_FRAME_BROADCAST:
-			nic_data->stats.receive_filtered_broadcast++;
-			break;
+		return true;
+	}
+
+	switch (frame_type) {
+	case NIC_FRAME_UNICAST:
+		rxs->filtered_unicast++;
+		break;
+	case NIC_FRAME_MULTICAST:
+		rxs->filtered_multicast++;
+		break;
+	case NIC_FRAME_BROADCAST:
+		rxs->filtered_broadcast++;
+		break;
+	}
+	return false;
+}
+
+/** Pass frames to the client with as few IPC calls as possible.
+ *
+ * Consecutive frames are packed into NIC_EV_RECEIVED_BATCH events. If the
+ * client does not understand these, the frames are sent one by one.
+ * The frames are released.
+ *
+ * @param nic_data	The driver data
+ * @param frames	Frames to pass
+ */
+static void nic_send_frames(nic_t *nic_data, list_t *frames)
+{
+	while (!list_empty(frames)) {
+		size_t count = 0;
+		size_t size = 0;
+
+		list_foreach(*frames, link, nic_frame_t, frame) {
+			size_t fsize = sizeof(uint32_t) + ALIGN_UP(frame->size,
+			    NIC_EV_BATCH_ALIGN);
+			if (count > 0 && size + fsize > NIC_BATCH_MAX_SIZE)
+				break;
+			size += fsize;
+			count++;
+		}
+
+		uint8_t *batch = NULL;
+		if (count > 1 && !nic_data->client_no_batch)
+			batch = malloc(size);
+
+		if (batch != NULL) {
+			uint8_t *dp = batch;
+			link_t *link = list_first(frames);
+			for (size_t i = 0; i < count; i++) {
+				nic_frame_t *frame = list_get_instance(link,
+				    nic_frame_t, link);
+				uint32_t fsize = frame->size;
+
+				memcpy(dp, &fsize, sizeof(uint32_t));
+				memcpy(dp + sizeof(uint32_t), frame->data, fsize);
+				memset(dp + sizeof(uint32_t) + fsize, 0,
+				    ALIGN_UP(fsize, NIC_EV_BATCH_ALIGN) - fsize);
+				dp += sizeof(uint32_t) +
+				    ALIGN_UP(fsize, NIC_EV_BATCH_ALIGN);
+				link = list_next(link, frames);
+			}
+
+			errno_t rc = nic_ev_received_batch(nic_data->client_session,
+			    batch, size);
+			free(batch);
+
+			if (rc == ENOTSUP) {
+				/* Fall back to sending the frames one by one */
+				nic_data->client_no_batch = true;
+				continue;
+			}
+
+			for (size_t i = 0; i < count; i++) {
+				nic_frame_t *frame = list_get_instance(
+				    list_first(frames), nic_frame_t, link);
+				list_remove(&frame->link);
+				nic_release_frame(nic_data, frame);
+			}
+		} else {
+			nic_frame_t *frame = list_get_instance(list_first(frames),
+			    nic_frame_t, link);
+			list_remove(&frame->link);
+			nic_ev_received(nic_data->client_session, frame->data,
+			    frame->size);
+			nic_release_frame(nic_data, frame);
 		}
+	}
+}
+
+/** Check received frames by filters and pass them to the client.
+ *
+ * @param nic_data	The driver data
+ * @param frames	The received frames, all of them are released
+ */
+static void nic_deliver_frames(nic_t *nic_data, list_t *frames)
+{
+	nic_rx_stats_t local_rxs;
+	list_t rejected;
+	bool notify = false;
+
+	/*
+	 * Statistics are counted in the block of the current fibril without
+	 * any locking, unless it cannot be allocated.
+	 */
+	nic_rx_stats_t *rxs = nic_rx_stats_get(nic_data);
+	if (rxs == NULL) {
+		memset(&local_rxs, 0, sizeof(local_rxs));
+		rxs = &local_rxs;
+	}
+
+	list_initialize(&rejected);
+
+	fibril_rwlock_read_lock(&nic_data->rxc_lock);
+	list_foreach_safe(*frames, cur, next) {
+		nic_frame_t *frame = list_get_instance(cur, nic_frame_t, link);
+		if (!nic_frame_accept(nic_data, frame, rxs)) {
+			list_remove(&frame->link);
+			list_append(&frame->link, &rejected);
+		}
+	}
+	fibril_rwlock_read_unlock(&nic_data->rxc_lock);
+
+	if (rxs == &local_rxs) {
+		fibril_rwlock_write_lock(&nic_data->stats_lock);
+		nic_rx_stats_add(&nic_data->stats, &local_rxs);
 		fibril_rwlock_write_unlock(&nic_data->stats_lock);
 	}
-	nic_release_frame(nic_data, frame);
+
+	while (!list_empty(&rejected)) {
+		nic_frame_t *frame = list_get_instance(list_first(&rejected),
+		    nic_frame_t, link);
+		list_remove(&frame->link);
+		nic_release_frame(nic_data, frame);
+	}
+
+	/*
+	 * Frames in the pool shared with the client are passed by index with
+	 * at most one notification, others (and those in a retired pool) are
+	 * copied over IPC.
+	 */
+	list_foreach_safe(*frames, cur, next) {
+		nic_frame_t *frame = list_get_instance(cur, nic_frame_t, link);
+		if (frame->pool != NULL && !frame->pool->retired) {
+			list_remove(&frame->link);
+			if (nic_frame_pool_put(nic_data, frame, true))
+				notify = true;
+			nic_release_frame(nic_data, frame);
+		}
+	}
+
+	if (notify)
+		nic_ev_rx_pool(nic_data->client_session);
+
+	nic_send_frames(nic_data, frames);
+}
+
+/**
+ * This is the function that the driver should call when it receives a frame.
+ * The frame is checked by filters and then sent up to the NIL layer or
+ * discarded. The frame is released.
+ *
+ * @param nic_data
+ * @param frame		The received frame
+ */
+void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+{
+	/*
+	 * Note: this function must not lock main lock, because loopback driver
+	 * 		 calls it inside send_frame handler (with locked main lock)
+	 */
+	list_t frames;
+
+	list_initialize(&frames);
+	list_append(&frame->link, &frames);
+	nic_deliver_frames(nic_data, &frames);
 }
 
 /**
  * Some NICs can receive multiple frames during single interrupt. These can
  * send them in whole list of frames (actually nic_frame_t structures), then
- * the list is deallocated and each frame is passed to the
- * nic_received_packet function.
+ * the frames are checked by filters together and passed to the client
+ * in batches, and the list is deallocated.
  *
  * @param nic_data
  * @param frames		List of received frames
@@ -575,16 +898,131 @@ void nic_received_frame_list(nic_t *nic_data, nic_frame_list_t *frames)
 {
 	if (frames == NULL)
 		return;
-	while (!list_empty(frames)) {
-		nic_frame_t *frame =
-		    list_get_instance(list_first(frames), nic_frame_t, link);
 
-		list_remove(&frame->link);
-		nic_received_frame(nic_data, frame);
-	}
+	nic_deliver_frames(nic_data, frames);
 	nic_driver_release_frame_list(frames);
 }
 
+/** Main function of the NAPI polling fibril
+ *
+ * Waits until polling is requested by nic_napi_schedule(), then calls
+ * napi_poll() with the receive interrupts masked for as long as it keeps
+ * exhausting its budget. Under load the NIC is thus served by polling
+ * without any interrupts, once it drains, the interrupts are unmasked.
+ *
+ * @param data The NIC structure pointer
+ *
+ * @return EOK once terminated by nic_napi_stop()
+ */
+static errno_t napi_fibril_fun(void *data)
+{
+	nic_t *nic = data;
+
+	while (true) {
+		fibril_mutex_lock(&nic->napi_lock);
+		while (!nic->napi_scheduled && !nic->napi_stop)
+			fibril_condvar_wait(&nic->napi_cv, &nic->napi_lock);
+		if (nic->napi_stop) {
+			nic->napi_fibril = 0;
+			fibril_condvar_broadcast(&nic->napi_cv);
+			fibril_mutex_unlock(&nic->napi_lock);
+			return EOK;
+		}
+		nic->napi_scheduled = false;
+		fibril_mutex_unlock(&nic->napi_lock);
+
+		while (true) {
+			nic_frame_list_t *frames = nic_alloc_frame_list();
+			if (frames == NULL)
+				break;
+
+			size_t count = nic->napi_poll(nic, frames,
+			    nic->napi_budget);
+			nic_received_frame_list(nic, frames);
+
+			if (count < nic->napi_budget)
+				break;
+
+			/* Let other fibrils run while we keep polling */
+			fibril_yield();
+		}
+
+		/*
+		 * Interrupts are unmasked only in the immediate mode. In the
+		 * polling modes the driver is polled instead, and they stay
+		 * masked when the NIC went down in the meantime.
+		 */
+		fibril_rwlock_read_lock(&nic->main_lock);
+		if (nic->state == NIC_STATE_ACTIVE &&
+		    nic->poll_mode == NIC_POLL_IMMEDIATE)
+			nic->napi_irq(nic, true);
+		fibril_rwlock_read_unlock(&nic->main_lock);
+	}
+
+	return EOK;
+}
+
+/** Enable NAPI-style budgeted receive
+ *
+ * The driver's interrupt handler should then leave the receive interrupts
+ * masked and call nic_napi_schedule() instead of receiving the frames
+ * itself. Should be called in the add_device handler.
+ *
+ * @param nic_data	The driver data
+ * @param poll		Budgeted receive handler
+ * @param irq		Receive interrupt masking handler
+ * @param budget	Frames received by one poll, 0 for default
+ *
+ * @return EOK on success, ENOMEM if the polling fibril cannot be created
+ */
+errno_t nic_set_napi_handlers(nic_t *nic_data, napi_poll_handler poll,
+    napi_irq_handler irq, size_t budget)
+{
+	assert(nic_data->napi_fibril == 0);
+
+	nic_data->napi_poll = poll;
+	nic_data->napi_irq = irq;
+	nic_data->napi_budget = budget != 0 ? budget : NIC_NAPI_BUDGET_DEFAULT;
+
+	nic_data->napi_fibril = fibril_create(napi_fibril_fun, nic_data);
+	if (nic_data->napi_fibril == 0)
+		return ENOMEM;
+
+	fibril_add_ready(nic_data->napi_fibril);
+	return EOK;
+}
+
+/** Request NAPI polling of the NIC
+ *
+ * Called by the driver's interrupt handler with the receive interrupts
+ * masked. They are unmasked by NICF once the receive buffers are drained.
+ *
+ * @param nic_data	The driver data
+ */
+void nic_napi_schedule(nic_t *nic_data)
+{
+	assert(nic_data->napi_poll != NULL);
+
+	fibril_mutex_lock(&nic_data->napi_lock);
+	nic_data->napi_scheduled = true;
+	fibril_condvar_signal(&nic_data->napi_cv);
+	fibril_mutex_unlock(&nic_data->napi_lock);
+}
+
+/** Terminate the NAPI polling fibril and wait for it to finish
+ *
+ * @param nic_data	The driver data
+ */
+static void nic_napi_stop(nic_t *nic_data)
+{
+	fibril_mutex_lock(&nic_data->napi_lock);
+	nic_data->napi_stop = true;
+	fibril_condvar_broadcast(&nic_data->napi_cv);
+	while (nic_data->napi_fibril != 0)
+		fibril_condvar_wait(&nic_data->napi_cv, &nic_data->napi_lock);
+	fibril_mutex_unlock(&nic_data->napi_lock);
+}
+
 /** Allocate and initialize the driver data.
  *
  * @return Allocated structure or NULL.
@@ -609,6 +1047,7 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	nic_data->fun = NULL;
 	nic_data->state = NIC_STATE_STOPPED;
 	nic_data->client_session = NULL;
+	nic_data->rx_pool = NULL;
 	nic_data->poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->default_poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->send_frame = NULL;
@@ -621,6 +1060,12 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	fibril_rwlock_initialize(&nic_data->stats_lock);
 	fibril_rwlock_initialize(&nic_data->rxc_lock);
 	fibril_rwlock_initialize(&nic_data->wv_lock);
+	fibril_mutex_initialize(&nic_data->rx_pool_lock);
+	fibril_mutex_initialize(&nic_data->rx_stats_lock);
+	fibril_mutex_initialize(&nic_data->napi_lock);
+	fibril_condvar_initialize(&nic_data->napi_cv);
+	list_initialize(&nic_data->rx_stats);
+	nic_data->rx_stats_id = atomic_fetch_add(&nic_rx_stats_ids, 1) + 1;
 
 	memset(&nic_data->mac, 0, sizeof(nic_address_t));
 	memset(&nic_data->default_mac, 0, sizeof(nic_address_t));
@@ -658,6 +1103,21 @@ nic_t *nic_create_and_bind(ddf_dev_t *device)
  */
 static void nic_destroy(nic_t *nic_data)
 {
+	nic_napi_stop(nic_data);
+	nic_rx_pool_retire(nic_data);
+
+	while (!list_empty(&nic_data->rx_stats)) {
+		nic_rx_stats_t *rxs = list_get_instance(
+		    list_first(&nic_data->rx_stats), nic_rx_stats_t, link);
+		list_remove(&rxs->link);
+		free(rxs);
+	}
+
+	if (nic_rx_stats_nic == nic_data->rx_stats_id) {
+		nic_rx_stats_nic = 0;
+		nic_rx_stats_cur = NULL;
+	}
+
 	free(nic_data->specific);
 }
 
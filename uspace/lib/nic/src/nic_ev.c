@@ -93,5 +93,38 @@ errno_t nic_ev_received(async_sess_t *sess, void *data, size_t size)
 	return retval;
 }
 
+/** Several frames received.
+ *
+ * The data consist of frames as described at NIC_EV_RECEIVED_BATCH.
+ */
+errno_t nic_ev_received_batch(async_sess_t *sess, void *data, size_t size)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, NIC_EV_RECEIVED_BATCH, &answer);
+	errno_t retval = async_data_write_start(exch, data, size);
+
+	async_exchange_end(exch);
+
+	if (retval != EOK) {
+		async_forget(req);
+		return retval;
+	}
+
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Frames were posted to the receive buffer pool. */
+errno_t nic_ev_rx_pool(async_sess_t *sess)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	async_msg_0(exch, NIC_EV_RX_POOL);
+	async_exchange_end(exch);
+
+	return EOK;
+}
+
 /** @}
  */
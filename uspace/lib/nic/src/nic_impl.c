@@ -39,6 +39,7 @@
 #include <str_error.h>
 #include <ipc/services.h>
 #include <ns.h>
+#include <stdlib.h>
 #include "nic_driver.h"
 #include "nic_ev.h"
 #include "nic_impl.h"
@@ -203,6 +204,10 @@ errno_t nic_callback_create_impl(ddf_fun_t *fun)
 		return ENOMEM;
 	}
 
+	/* A pool shared with the previous client must not be used anymore */
+	nic_rx_pool_retire(nic);
+	nic->client_no_batch = false;
+
 	fibril_rwlock_write_unlock(&nic->main_lock);
 	return EOK;
 }
@@ -243,6 +248,7 @@ errno_t nic_get_stats_impl(ddf_fun_t *fun, nic_device_stats_t *stats)
 	fibril_rwlock_read_lock(&nic_data->stats_lock);
 	memcpy(stats, &nic_data->stats, sizeof (nic_device_stats_t));
 	fibril_rwlock_read_unlock(&nic_data->stats_lock);
+	nic_rx_stats_collect(nic_data, stats);
 	return EOK;
 }
 
@@ -842,5 +848,46 @@ void nic_close_impl(ddf_fun_t *fun)
 {
 }
 
+/**
+ * Default implementation of the rx_pool_create method.
+ * Creates a receive buffer pool to be shared with the client. Frames
+ * allocated by nic_alloc_frame() are placed directly in the pool buffers
+ * from now on and passed to the client by index.
+ *
+ * @param[in]	fun
+ * @param[in]	count		Number of buffers
+ * @param[in]	buf_size	Size of each buffer
+ * @param[out]	area		Shared area of the pool
+ * @param[out]	size		Size of the shared area
+ *
+ * @return EOK		If the pool was created
+ * @return EINVAL	If the parameters are invalid
+ * @return ENOMEM	If there was not enough memory
+ */
+errno_t nic_rx_pool_create_impl(ddf_fun_t *fun, size_t count, size_t buf_size,
+    void **area, size_t *size)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+
+	nic_rx_pool_t *rx_pool = calloc(1, sizeof(nic_rx_pool_t));
+	if (rx_pool == NULL)
+		return ENOMEM;
+
+	errno_t rc = pktpool_create(count, buf_size, &rx_pool->pool);
+	if (rc != EOK) {
+		free(rx_pool);
+		return rc;
+	}
+
+	nic_rx_pool_retire(nic_data);
+
+	fibril_mutex_lock(&nic_data->rx_pool_lock);
+	nic_data->rx_pool = rx_pool;
+	*area = pktpool_area(rx_pool->pool, size);
+	fibril_mutex_unlock(&nic_data->rx_pool_lock);
+
+	return EOK;
+}
+
 /** @}
  */
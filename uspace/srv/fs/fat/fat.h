@@ -221,6 +221,16 @@ typedef struct {
 	struct fat_node	*nodep;
 } fat_idx_t;
 
+/** Run of physically contiguous clusters in a node's cluster chain. */
+typedef struct {
+	/** Index of the first cluster of the run within the node. */
+	uint32_t	fcl;
+	/** First cluster of the run on the device. */
+	fat_cluster_t	dcl;
+	/** Number of clusters in the run. */
+	uint32_t	count;
+} fat_extent_t;
+
 /** FAT in-core node. */
 typedef struct fat_node {
 	/** Back pointer to the FS node. */
@@ -249,14 +259,56 @@ typedef struct fat_node {
 	/* Node's last cluster in FAT. */
 	bool		lastc_cached_valid;
 	fat_cluster_t	lastc_cached_value;
-	/* Node's "current" cluster, i.e. where the last I/O took place. */
-	bool		currc_cached_valid;
-	aoff64_t	currc_cached_bn;
-	fat_cluster_t	currc_cached_value;
+
+	/*
+	 * Cache of the contiguous cluster runs forming a prefix of the node's
+	 * cluster chain. The runs are sorted by the node cluster index, which
+	 * makes looking up an arbitrary cluster a binary search instead of a
+	 * FAT walk from the first cluster.
+	 */
+	fat_extent_t	*extents;
+	/* Number of valid entries in extents. */
+	size_t		extents_count;
+	/* Number of allocated entries in extents. */
+	size_t		extents_size;
+	/* Number of node clusters covered by the cached runs. */
+	uint32_t	extents_clusters;
 } fat_node_t;
 
+/** Free cluster bookkeeping of a mounted FAT file system. */
+typedef struct fat_free_map {
+	/** Serializes cluster allocation and protects the fields below. */
+	fibril_mutex_t		lock;
+	/** Signalled when the builder fibril finishes. */
+	fibril_condvar_t	built_cv;
+	service_id_t		service_id;
+	/**
+	 * Bitmap of used clusters, bit 0 standing for FAT_CLST_FIRST. NULL if
+	 * it could not be allocated, in which case the FAT itself is scanned.
+	 */
+	uint32_t		*used;
+	/** Number of clusters on the file system. */
+	uint32_t		clusters;
+	/** Clusters below this one are accounted for in the bitmap. */
+	fat_cluster_t		scanned;
+	/** Number of free clusters below scanned. */
+	uint32_t		free;
+	/**
+	 * Free cluster count read from the FAT32 FSInfo sector and adjusted by
+	 * later allocations, or UINT32_MAX if not known.
+	 */
+	uint32_t		hint_free;
+	/** Cluster where the search for free clusters starts. */
+	fat_cluster_t		next_free;
+	/** The builder fibril is running. */
+	bool			building;
+	/** The builder fibril was asked to stop. */
+	bool			stop;
+} fat_free_map_t;
+
 typedef struct {
 	bool lfn_enabled;
+	fat_free_map_t free_map;
 } fat_instance_t;
 
 extern vfs_out_ops_t fat_ops;
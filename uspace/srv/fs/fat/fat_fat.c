@@ -52,12 +52,12 @@
 
 #define IS_ODD(number)	(number & 0x1)
 
-/**
- * The fat_alloc_lock mutex protects all copies of the File Allocation Table
- * during allocation of clusters. The lock does not have to be held durring
- * deallocation of clusters.
- */
-static FIBRIL_MUTEX_INITIALIZE(fat_alloc_lock);
+/** Number of FAT entries the free map builder examines at a time. */
+#define FAT_FREE_MAP_CHUNK	4096
+
+/** Initial and maximum number of cached cluster runs per node. */
+#define FAT_EXTENTS_MIN	8
+#define FAT_EXTENTS_MAX	4096
 
 /** Walk the cluster chain.
  *
@@ -112,6 +112,166 @@ fat_cluster_walk(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc,
 	return EOK;
 }
 
+/** Release the cluster run cache of a node.
+ *
+ * @param nodep		FAT node.
+ */
+void fat_extents_fini(fat_node_t *nodep)
+{
+	free(nodep->extents);
+	nodep->extents = NULL;
+	nodep->extents_count = 0;
+	nodep->extents_size = 0;
+	nodep->extents_clusters = 0;
+}
+
+/** Record the location of the next node cluster in the cluster run cache.
+ *
+ * @param nodep		FAT node.
+ * @param fcl		Index of the cluster within the node.
+ * @param clst		Cluster number on the device.
+ *
+ * @return		True if the cluster was recorded, false if the cache
+ *			cannot grow any further or no longer ends at fcl.
+ */
+static bool fat_extents_add(fat_node_t *nodep, uint32_t fcl, fat_cluster_t clst)
+{
+	fat_extent_t *ext;
+
+	/*
+	 * The cache may have been extended or truncated by someone else while
+	 * we were blocked reading the FAT.
+	 */
+	if (fcl != nodep->extents_clusters)
+		return false;
+
+	if (nodep->extents_count > 0) {
+		ext = &nodep->extents[nodep->extents_count - 1];
+		if (ext->dcl + ext->count == clst) {
+			ext->count++;
+			nodep->extents_clusters++;
+			return true;
+		}
+	}
+
+	if (nodep->extents_count == nodep->extents_size) {
+		size_t size;
+
+		if (nodep->extents_size >= FAT_EXTENTS_MAX)
+			return false;
+		size = nodep->extents_size ? 2 * nodep->extents_size :
+		    FAT_EXTENTS_MIN;
+		ext = realloc(nodep->extents, size * sizeof(fat_extent_t));
+		if (!ext)
+			return false;
+		nodep->extents = ext;
+		nodep->extents_size = size;
+	}
+
+	ext = &nodep->extents[nodep->extents_count++];
+	ext->fcl = fcl;
+	ext->dcl = clst;
+	ext->count = 1;
+	nodep->extents_clusters++;
+	return true;
+}
+
+/** Forget cached cluster runs past a given cluster.
+ *
+ * @param nodep		FAT node.
+ * @param lcl		Last cluster which remains in the node.
+ */
+static void fat_extents_truncate(fat_node_t *nodep, fat_cluster_t lcl)
+{
+	size_t i;
+
+	/* Files are usually truncated close to their end. */
+	for (i = nodep->extents_count; i > 0; i--) {
+		fat_extent_t *ext = &nodep->extents[i - 1];
+
+		if (lcl >= ext->dcl && lcl < ext->dcl + ext->count) {
+			ext->count = lcl - ext->dcl + 1;
+			nodep->extents_count = i;
+			nodep->extents_clusters = ext->fcl + ext->count;
+			return;
+		}
+	}
+
+	/*
+	 * The last remaining cluster lies past the cached prefix of the
+	 * cluster chain, so the prefix remains valid.
+	 */
+}
+
+/** Find the device cluster holding a node cluster.
+ *
+ * The cluster is looked up in the node's cluster run cache. If the cache
+ * does not reach that far yet, the cluster chain is walked from the end of
+ * the cached prefix and the cache is extended along the way.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param nodep		FAT node.
+ * @param fcl		Index of the cluster within the node.
+ * @param clp		Address where the cluster number will be stored.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t fat_cluster_lookup(fat_bs_t *bs, fat_node_t *nodep,
+    uint32_t fcl, fat_cluster_t *clp)
+{
+	fat_cluster_t clst, clst_last1 = FAT_CLST_LAST1(bs);
+	fat_extent_t *ext;
+	bool caching;
+	uint32_t i;
+	errno_t rc;
+
+	if (fcl < nodep->extents_clusters) {
+		size_t lo = 0;
+		size_t hi = nodep->extents_count;
+
+		while (hi - lo > 1) {
+			size_t mid = lo + (hi - lo) / 2;
+
+			if (nodep->extents[mid].fcl <= fcl)
+				lo = mid;
+			else
+				hi = mid;
+		}
+
+		ext = &nodep->extents[lo];
+		assert(fcl >= ext->fcl && fcl < ext->fcl + ext->count);
+		*clp = ext->dcl + (fcl - ext->fcl);
+		return EOK;
+	}
+
+	if (nodep->extents_clusters == 0) {
+		i = 0;
+		clst = nodep->firstc;
+		caching = fat_extents_add(nodep, i, clst);
+	} else {
+		ext = &nodep->extents[nodep->extents_count - 1];
+		i = nodep->extents_clusters - 1;
+		clst = ext->dcl + ext->count - 1;
+		caching = true;
+	}
+
+	while (i < fcl) {
+		rc = fat_get_cluster(bs, nodep->idx->service_id, FAT1, clst,
+		    &clst);
+		if (rc != EOK)
+			return rc;
+
+		assert(clst >= FAT_CLST_FIRST && clst < clst_last1);
+		i++;
+
+		if (caching)
+			caching = fat_extents_add(nodep, i, clst);
+	}
+
+	*clp = clst;
+	return EOK;
+}
+
 /** Read block from file located on a FAT file system.
  *
  * @param block		Pointer to a block pointer for storing result.
@@ -126,16 +286,16 @@ errno_t
 fat_block_get(block_t **block, struct fat_bs *bs, fat_node_t *nodep,
     aoff64_t bn, int flags)
 {
-	fat_cluster_t firstc = nodep->firstc;
-	fat_cluster_t currc = 0;
-	aoff64_t relbn = bn;
+	fat_cluster_t currc;
 	errno_t rc;
 
 	if (!nodep->size)
 		return ELIMIT;
 
-	if (!FAT_IS_FAT32(bs) && nodep->firstc == FAT_CLST_ROOT)
-		goto fall_through;
+	if (!FAT_IS_FAT32(bs) && nodep->firstc == FAT_CLST_ROOT) {
+		return _fat_block_get(block, bs, nodep->idx->service_id,
+		    nodep->firstc, NULL, bn, flags);
+	}
 
 	if (((((nodep->size - 1) / BPS(bs)) / SPC(bs)) == bn / SPC(bs)) &&
 	    nodep->lastc_cached_valid) {
@@ -147,29 +307,12 @@ fat_block_get(block_t **block, struct fat_bs *bs, fat_node_t *nodep,
 		    CLBN2PBN(bs, nodep->lastc_cached_value, bn), flags);
 	}
 
-	if (nodep->currc_cached_valid && bn >= nodep->currc_cached_bn) {
-		/*
-		 * We can start with the cluster cached by the previous call to
-		 * fat_block_get().
-		 */
-		firstc = nodep->currc_cached_value;
-		relbn -= (nodep->currc_cached_bn / SPC(bs)) * SPC(bs);
-	}
-
-fall_through:
-	rc = _fat_block_get(block, bs, nodep->idx->service_id, firstc,
-	    &currc, relbn, flags);
+	rc = fat_cluster_lookup(bs, nodep, bn / SPC(bs), &currc);
 	if (rc != EOK)
 		return rc;
 
-	/*
-	 * Update the "current" cluster cache.
-	 */
-	nodep->currc_cached_valid = true;
-	nodep->currc_cached_bn = bn;
-	nodep->currc_cached_value = currc;
-
-	return rc;
+	return block_get(block, nodep->idx->service_id,
+	    CLBN2PBN(bs, currc, bn), flags);
 }
 
 /** Read block from file located on a FAT file system.
@@ -654,6 +797,310 @@ errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
 	return EOK;
 }
 
+/** Look up the free map of a mounted file system.
+ *
+ * @param service_id	Device service ID of the file system.
+ *
+ * @return		Free map or NULL if the file system is not mounted.
+ */
+static fat_free_map_t *fat_free_map_get(service_id_t service_id)
+{
+	fat_instance_t *instance;
+
+	if (fs_instance_get(service_id, (void **) &instance) != EOK)
+		return NULL;
+
+	return &instance->free_map;
+}
+
+/** Test whether a cluster is marked as used in the free map bitmap. */
+static bool fat_free_map_test(fat_free_map_t *fmap, fat_cluster_t clst)
+{
+	uint32_t i = clst - FAT_CLST_FIRST;
+
+	return (fmap->used[i / 32] & (1U << (i % 32))) != 0;
+}
+
+/** Tell whether the free map bitmap describes the whole file system. */
+static bool fat_free_map_ready(fat_free_map_t *fmap)
+{
+	return fmap->used != NULL &&
+	    fmap->scanned == FAT_CLST_FIRST + fmap->clusters;
+}
+
+/** Mark a cluster as used or free in the free map.
+ *
+ * Must be called with fmap->lock held and after the FAT has been updated so
+ * that the builder fibril never overwrites the bitmap with stale data.
+ *
+ * @param fmap		Free map.
+ * @param clst		Cluster number.
+ * @param used		True if the cluster has been allocated, false if it
+ *			has been freed.
+ */
+static void fat_free_map_set(fat_free_map_t *fmap, fat_cluster_t clst,
+    bool used)
+{
+	uint32_t i = clst - FAT_CLST_FIRST;
+	uint32_t mask = 1U << (i % 32);
+	bool was_used;
+
+	if (fmap->hint_free != UINT32_MAX) {
+		if (!used)
+			fmap->hint_free++;
+		else if (fmap->hint_free > 0)
+			fmap->hint_free--;
+	}
+
+	if (!fmap->used)
+		return;
+
+	was_used = (fmap->used[i / 32] & mask) != 0;
+	if (used)
+		fmap->used[i / 32] |= mask;
+	else
+		fmap->used[i / 32] &= ~mask;
+
+	/* Clusters past the builder will be accounted for by the builder. */
+	if (clst < fmap->scanned && was_used != used) {
+		if (used)
+			fmap->free--;
+		else
+			fmap->free++;
+	}
+}
+
+/** Build the free map bitmap from FAT1.
+ *
+ * The builder runs in its own fibril after mount and examines the FAT in
+ * chunks. It holds the free map lock only while examining a chunk so that
+ * clusters can be allocated in the meantime.
+ *
+ * @param arg		Free map.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t fat_free_map_builder(void *arg)
+{
+	fat_free_map_t *fmap = (fat_free_map_t *) arg;
+	fat_bs_t *bs = block_bb_get(fmap->service_id);
+	fat_cluster_t end = FAT_CLST_FIRST + fmap->clusters;
+	fat_cluster_t clst, value;
+	uint32_t i;
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&fmap->lock);
+	while (!fmap->stop && fmap->scanned < end) {
+		for (clst = fmap->scanned;
+		    clst < end && clst - fmap->scanned < FAT_FREE_MAP_CHUNK;
+		    clst++) {
+			rc = fat_get_cluster(bs, fmap->service_id, FAT1, clst,
+			    &value);
+			if (rc != EOK)
+				break;
+
+			i = clst - FAT_CLST_FIRST;
+			if (value == FAT_CLST_RES0) {
+				fmap->used[i / 32] &= ~(1U << (i % 32));
+				fmap->free++;
+			} else {
+				fmap->used[i / 32] |= 1U << (i % 32);
+			}
+		}
+
+		if (rc != EOK) {
+			/* Fall back to scanning the FAT. */
+			free(fmap->used);
+			fmap->used = NULL;
+			break;
+		}
+
+		fmap->scanned = clst;
+
+		fibril_mutex_unlock(&fmap->lock);
+		fibril_yield();
+		fibril_mutex_lock(&fmap->lock);
+	}
+
+	if (fat_free_map_ready(fmap))
+		fmap->hint_free = fmap->free;
+
+	fmap->building = false;
+	fibril_condvar_broadcast(&fmap->built_cv);
+	fibril_mutex_unlock(&fmap->lock);
+
+	return rc;
+}
+
+/** Initialize the free map of a file system and start building it.
+ *
+ * @param fmap		Free map to initialize.
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ * @param hint_free	Free cluster count from FSInfo or UINT32_MAX.
+ * @param next_free	First cluster to consider for allocation or
+ *			FAT_CLST_RES0 if not known.
+ */
+void fat_free_map_init(fat_free_map_t *fmap, fat_bs_t *bs,
+    service_id_t service_id, uint32_t hint_free, fat_cluster_t next_free)
+{
+	fid_t fid;
+
+	fibril_mutex_initialize(&fmap->lock);
+	fibril_condvar_initialize(&fmap->built_cv);
+	fmap->service_id = service_id;
+	fmap->clusters = CC(bs);
+	fmap->scanned = FAT_CLST_FIRST;
+	fmap->free = 0;
+	fmap->hint_free = (hint_free <= fmap->clusters) ? hint_free :
+	    UINT32_MAX;
+	fmap->next_free = (next_free >= FAT_CLST_FIRST &&
+	    next_free < FAT_CLST_FIRST + fmap->clusters) ? next_free :
+	    FAT_CLST_FIRST;
+	fmap->building = false;
+	fmap->stop = false;
+
+	fmap->used = calloc((fmap->clusters + 31) / 32, sizeof(uint32_t));
+	if (!fmap->used)
+		return;
+
+	fid = fibril_create(fat_free_map_builder, fmap);
+	if (fid == 0) {
+		free(fmap->used);
+		fmap->used = NULL;
+		return;
+	}
+
+	fmap->building = true;
+	fibril_add_ready(fid);
+}
+
+/** Stop building the free map and release it.
+ *
+ * @param fmap		Free map.
+ */
+void fat_free_map_fini(fat_free_map_t *fmap)
+{
+	fibril_mutex_lock(&fmap->lock);
+	fmap->stop = true;
+	while (fmap->building)
+		fibril_condvar_wait(&fmap->built_cv, &fmap->lock);
+	free(fmap->used);
+	fmap->used = NULL;
+	fibril_mutex_unlock(&fmap->lock);
+}
+
+/** Get the free cluster statistics of a file system.
+ *
+ * @param fmap		Free map.
+ * @param count		Output argument holding the number of free clusters or
+ *			UINT32_MAX if it is not known yet.
+ * @param next_free	If not NULL, output argument holding the cluster where
+ *			the search for free clusters will start.
+ */
+void fat_free_map_stats(fat_free_map_t *fmap, uint32_t *count,
+    fat_cluster_t *next_free)
+{
+	fibril_mutex_lock(&fmap->lock);
+	*count = fat_free_map_ready(fmap) ? fmap->free : fmap->hint_free;
+	if (next_free)
+		*next_free = fmap->next_free;
+	fibril_mutex_unlock(&fmap->lock);
+}
+
+/** Find a run of contiguous free clusters in the free map bitmap.
+ *
+ * The search starts at the allocation hint and wraps around to the first
+ * cluster.
+ *
+ * @param fmap		Free map with the bitmap fully built.
+ * @param nclsts	Length of the run.
+ * @param clp		Output argument holding the first cluster of the run.
+ *
+ * @return		True if such a run was found.
+ */
+static bool fat_free_map_find_run(fat_free_map_t *fmap, unsigned nclsts,
+    fat_cluster_t *clp)
+{
+	fat_cluster_t end = FAT_CLST_FIRST + fmap->clusters;
+	fat_cluster_t clst, first;
+	unsigned pass;
+	unsigned len;
+
+	for (pass = 0; pass < 2; pass++) {
+		clst = (pass == 0) ? fmap->next_free : FAT_CLST_FIRST;
+		first = clst;
+		len = 0;
+
+		while (clst < end) {
+			uint32_t i = clst - FAT_CLST_FIRST;
+
+			/* Skip fully used bitmap words at once. */
+			if (i % 32 == 0 && fmap->used[i / 32] == UINT32_MAX) {
+				clst += 32;
+				first = clst;
+				len = 0;
+				continue;
+			}
+
+			if (fat_free_map_test(fmap, clst)) {
+				first = clst + 1;
+				len = 0;
+			} else if (++len == nclsts) {
+				*clp = first;
+				return true;
+			}
+
+			clst++;
+		}
+	}
+
+	return false;
+}
+
+/** Gather free clusters for an allocation.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param fmap		Free map.
+ * @param start		First cluster to examine.
+ * @param nclsts	Number of clusters to gather.
+ * @param lifo		Stack of the gathered clusters. It is filled from its
+ *			top so that lifo[0] holds the highest numbered cluster.
+ * @param found		Output argument holding the number of clusters found.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t fat_free_map_gather(fat_bs_t *bs, fat_free_map_t *fmap,
+    fat_cluster_t start, unsigned nclsts, fat_cluster_t *lifo,
+    unsigned *found)
+{
+	fat_cluster_t end = FAT_CLST_FIRST + fmap->clusters;
+	bool ready = fat_free_map_ready(fmap);
+	fat_cluster_t clst;
+	fat_cluster_t value;
+	errno_t rc;
+
+	*found = 0;
+	for (clst = start; clst < end && *found < nclsts; clst++) {
+		if (ready) {
+			if (fat_free_map_test(fmap, clst))
+				continue;
+		} else {
+			rc = fat_get_cluster(bs, fmap->service_id, FAT1, clst,
+			    &value);
+			if (rc != EOK)
+				return rc;
+			if (value != FAT_CLST_RES0)
+				continue;
+		}
+
+		lifo[nclsts - 1 - *found] = clst;
+		(*found)++;
+	}
+
+	return EOK;
+}
+
 /** Allocate clusters in all copies of FAT.
  *
  * This function will attempt to allocate the requested number of clusters in
@@ -661,6 +1108,10 @@ errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
  * clusters form an independent chain (i.e. a chain which does not belong to any
  * file yet).
  *
+ * The clusters are preferably taken from a single run of contiguous free
+ * clusters, searched for from where the previous allocation ended. The chain
+ * is always linked in the ascending order of cluster numbers.
+ *
  * @param bs		Buffer holding the boot sector of the file system.
  * @param service_id	Device service ID of the file system.
  * @param nclsts	Number of clusters to allocate.
@@ -675,66 +1126,103 @@ errno_t
 fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
     fat_cluster_t *mcl, fat_cluster_t *lcl)
 {
+	fat_free_map_t *fmap;
 	fat_cluster_t *lifo;    /* stack for storing free cluster numbers */
-	unsigned found = 0;     /* top of the free cluster number stack */
+	unsigned found = 0;     /* number of clusters in the stack */
 	fat_cluster_t clst;
-	fat_cluster_t value = 0;
 	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
-	errno_t rc = EOK;
+	unsigned c;
+	errno_t rc;
+
+	fmap = fat_free_map_get(service_id);
+	if (!fmap)
+		return ENOENT;
 
 	lifo = (fat_cluster_t *) malloc(nclsts * sizeof(fat_cluster_t));
 	if (!lifo)
 		return ENOMEM;
 
-	/*
-	 * Search FAT1 for unused clusters.
-	 */
-	fibril_mutex_lock(&fat_alloc_lock);
-	for (clst = FAT_CLST_FIRST; clst < CC(bs) + 2 && found < nclsts;
-	    clst++) {
-		rc = fat_get_cluster(bs, service_id, FAT1, clst, &value);
-		if (rc != EOK)
-			break;
+	fibril_mutex_lock(&fmap->lock);
 
-		if (value == FAT_CLST_RES0) {
-			/*
-			 * The cluster is free. Put it into our stack
-			 * of found clusters and mark it as non-free.
-			 */
-			lifo[found] = clst;
-			rc = fat_set_cluster(bs, service_id, FAT1, clst,
-			    (found == 0) ?  clst_last1 : lifo[found - 1]);
-			if (rc != EOK)
-				break;
+	if (fat_free_map_ready(fmap)) {
+		if (fmap->free < nclsts) {
+			rc = ENOSPC;
+			goto error;
+		}
 
-			found++;
+		if (fat_free_map_find_run(fmap, nclsts, &clst)) {
+			for (found = 0; found < nclsts; found++)
+				lifo[nclsts - 1 - found] = clst + found;
 		}
 	}
 
-	if (rc == EOK && found == nclsts) {
-		rc = fat_alloc_shadow_clusters(bs, service_id, lifo, nclsts);
-		if (rc == EOK) {
-			*mcl = lifo[found - 1];
-			*lcl = lifo[0];
-			free(lifo);
-			fibril_mutex_unlock(&fat_alloc_lock);
-			return EOK;
+	if (found < nclsts) {
+		rc = fat_free_map_gather(bs, fmap, fmap->next_free, nclsts,
+		    lifo, &found);
+		if (rc != EOK)
+			goto error;
+	}
+
+	if (found < nclsts && fmap->next_free != FAT_CLST_FIRST) {
+		/* Start over so that the chain stays in ascending order. */
+		rc = fat_free_map_gather(bs, fmap, FAT_CLST_FIRST, nclsts,
+		    lifo, &found);
+		if (rc != EOK)
+			goto error;
+	}
+
+	if (found < nclsts) {
+		rc = ENOSPC;
+		goto error;
+	}
+
+	/*
+	 * Link the clusters into a chain in FAT1 and in all shadow copies.
+	 */
+	for (c = 0; c < nclsts; c++) {
+		rc = fat_set_cluster(bs, service_id, FAT1, lifo[c],
+		    c == 0 ? clst_last1 : lifo[c - 1]);
+		if (rc != EOK) {
+			found = c + 1;
+			goto rollback;
 		}
 	}
 
+	rc = fat_alloc_shadow_clusters(bs, service_id, lifo, nclsts);
+	if (rc != EOK)
+		goto rollback;
+
+	for (c = 0; c < nclsts; c++)
+		fat_free_map_set(fmap, lifo[c], true);
+
+	fmap->next_free = lifo[0] + 1;
+	if (fmap->next_free == FAT_CLST_FIRST + fmap->clusters)
+		fmap->next_free = FAT_CLST_FIRST;
+
+	*mcl = lifo[nclsts - 1];
+	*lcl = lifo[0];
+	fibril_mutex_unlock(&fmap->lock);
+	free(lifo);
+	return EOK;
+
+rollback:
 	/* If something wrong - free the clusters */
 	while (found--) {
 		(void) fat_set_cluster(bs, service_id, FAT1, lifo[found],
 		    FAT_CLST_RES0);
 	}
 
+error:
+	fibril_mutex_unlock(&fmap->lock);
 	free(lifo);
-	fibril_mutex_unlock(&fat_alloc_lock);
 
-	return ENOSPC;
+	return rc;
 }
 
 /** Free clusters forming a cluster chain in all copies of FAT.
+ *
+ * The free map lock does not have to be held while the FAT is being updated.
+ * It is only taken to account for each freed cluster afterwards.
  *
  * @param bs		Buffer hodling the boot sector of the file system.
  * @param service_id	Device service ID of the file system.
@@ -745,11 +1233,14 @@ fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 errno_t
 fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 {
+	fat_free_map_t *fmap;
 	unsigned fatno;
 	fat_cluster_t nextc = 0;
 	fat_cluster_t clst_bad = FAT_CLST_BAD(bs);
 	errno_t rc;
 
+	fmap = fat_free_map_get(service_id);
+
 	/* Mark all clusters in the chain as free in all copies of FAT. */
 	while (firstc < FAT_CLST_LAST1(bs)) {
 		assert(firstc >= FAT_CLST_FIRST && firstc < clst_bad);
@@ -765,6 +1256,12 @@ fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 				return rc;
 		}
 
+		if (fmap) {
+			fibril_mutex_lock(&fmap->lock);
+			fat_free_map_set(fmap, firstc, false);
+			fibril_mutex_unlock(&fmap->lock);
+		}
+
 		firstc = nextc;
 	}
 
@@ -837,8 +1334,10 @@ errno_t fat_chop_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t lcl)
 	 * Invalidate cached cluster numbers.
 	 */
 	nodep->lastc_cached_valid = false;
-	if (nodep->currc_cached_value != lcl)
-		nodep->currc_cached_valid = false;
+	if (lcl == FAT_CLST_RES0)
+		fat_extents_fini(nodep);
+	else
+		fat_extents_truncate(nodep, lcl);
 
 	if (lcl == FAT_CLST_RES0) {
 		/* The node will have zero size and no clusters allocated. */
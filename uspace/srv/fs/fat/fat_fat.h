@@ -102,6 +102,7 @@
 struct block;
 struct fat_node;
 struct fat_bs;
+struct fat_free_map;
 
 typedef uint32_t fat_cluster_t;
 
@@ -110,6 +111,7 @@ typedef uint32_t fat_cluster_t;
 extern errno_t fat_cluster_walk(struct fat_bs *, service_id_t, fat_cluster_t,
     fat_cluster_t *, uint32_t *, uint32_t);
 
+extern void fat_extents_fini(struct fat_node *);
 extern errno_t fat_block_get(block_t **, struct fat_bs *, struct fat_node *,
     aoff64_t, int);
 extern errno_t _fat_block_get(block_t **, struct fat_bs *, service_id_t,
@@ -119,6 +121,11 @@ extern errno_t fat_append_clusters(struct fat_bs *, struct fat_node *,
     fat_cluster_t, fat_cluster_t);
 extern errno_t fat_chop_clusters(struct fat_bs *, struct fat_node *,
     fat_cluster_t);
+extern void fat_free_map_init(struct fat_free_map *, struct fat_bs *,
+    service_id_t, uint32_t, fat_cluster_t);
+extern void fat_free_map_fini(struct fat_free_map *);
+extern void fat_free_map_stats(struct fat_free_map *, uint32_t *,
+    fat_cluster_t *);
 extern errno_t fat_alloc_clusters(struct fat_bs *, service_id_t, unsigned,
     fat_cluster_t *, fat_cluster_t *);
 extern errno_t fat_free_clusters(struct fat_bs *, service_id_t, fat_cluster_t);
@@ -108,9 +108,10 @@ static void fat_node_initialize(fat_node_t *node)
 	node->dirty = false;
 	node->lastc_cached_valid = false;
 	node->lastc_cached_value = 0;
-	node->currc_cached_valid = false;
-	node->currc_cached_bn = 0;
-	node->currc_cached_value = 0;
+	node->extents = NULL;
+	node->extents_count = 0;
+	node->extents_size = 0;
+	node->extents_clusters = 0;
 }
 
 static errno_t fat_node_sync(fat_node_t *node)
@@ -192,6 +193,7 @@ restart:
 				return rc;
 		}
 		nodep->idx->nodep = NULL;
+		fat_extents_fini(nodep);
 		free(nodep->bp);
 		free(nodep);
 
@@ -230,12 +232,14 @@ static errno_t fat_node_get_new(fat_node_t **nodepp)
 				idxp_tmp->nodep = NULL;
 				fibril_mutex_unlock(&nodep->lock);
 				fibril_mutex_unlock(&idxp_tmp->lock);
+				fat_extents_fini(nodep);
 				free(nodep->bp);
 				free(nodep);
 				return rc;
 			}
 		}
 		idxp_tmp->nodep = NULL;
+		fat_extents_fini(nodep);
 		fibril_mutex_unlock(&nodep->lock);
 		fibril_mutex_unlock(&idxp_tmp->lock);
 		fn = FS_NODE(nodep);
@@ -476,6 +480,7 @@ errno_t fat_node_put(fs_node_t *fn)
 	}
 	fibril_mutex_unlock(&nodep->lock);
 	if (destroy) {
+		fat_extents_fini(nodep);
 		free(nodep->bp);
 		free(nodep);
 	}
@@ -569,6 +574,7 @@ errno_t fat_destroy_node(fs_node_t *fn)
 	}
 
 	fat_idx_destroy(nodep->idx);
+	fat_extents_fini(nodep);
 	free(nodep->bp);
 	free(nodep);
 	return rc;
@@ -863,12 +869,22 @@ errno_t fat_total_block_count(service_id_t service_id, uint64_t *count)
 
 errno_t fat_free_block_count(service_id_t service_id, uint64_t *count)
 {
+	fat_instance_t *instance;
 	fat_bs_t *bs;
 	fat_cluster_t e0;
 	uint64_t block_count;
 	errno_t rc;
 	uint32_t cluster_no, clusters;
 
+	if (fs_instance_get(service_id, (void **) &instance) == EOK) {
+		fat_free_map_stats(&instance->free_map, &clusters, NULL);
+		if (clusters != UINT32_MAX) {
+			*count = clusters;
+			return EOK;
+		}
+	}
+
+	/* The free map is not built yet, scan the FAT. */
 	block_count = 0;
 	bs = block_bb_get(service_id);
 	clusters = (SPC(bs)) ? TS(bs) / SPC(bs) : 0;
@@ -1024,6 +1040,7 @@ static errno_t fat_fs_open(service_id_t service_id, enum cache_mode cmode,
 
 static void fat_fs_close(service_id_t service_id, fs_node_t *rfn)
 {
+	fat_extents_fini(FAT_NODE(rfn));
 	free(rfn->data);
 	free(rfn);
 	(void) block_cache_fini(service_id);
@@ -1074,6 +1091,69 @@ static errno_t fat_fsprobe(service_id_t service_id, vfs_fs_probe_info_t *info)
 	return EOK;
 }
 
+/** Get the FAT32 FSInfo sector.
+ *
+ * @param service_id	Service ID of the file system.
+ * @param block		Output argument holding the block with the sector.
+ *
+ * @return		EOK on success, EINVAL if the sector is not valid or
+ *			another error code.
+ */
+static errno_t fat_fat32_fsinfo_get(service_id_t service_id, block_t **block)
+{
+	fat_bs_t *bs;
+	fat32_fsinfo_t *info;
+	block_t *b;
+	errno_t rc;
+
+	bs = block_bb_get(service_id);
+	assert(FAT_IS_FAT32(bs));
+
+	rc = block_get(&b, service_id, uint16_t_le2host(bs->fat32.fsinfo_sec),
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK)
+		return rc;
+
+	info = (fat32_fsinfo_t *) b->data;
+
+	if (memcmp(info->sig1, FAT32_FSINFO_SIG1, sizeof(info->sig1)) != 0 ||
+	    memcmp(info->sig2, FAT32_FSINFO_SIG2, sizeof(info->sig2)) != 0 ||
+	    memcmp(info->sig3, FAT32_FSINFO_SIG3, sizeof(info->sig3)) != 0) {
+		(void) block_put(b);
+		return EINVAL;
+	}
+
+	*block = b;
+	return EOK;
+}
+
+/** Read the free cluster hints from the FAT32 FSInfo sector.
+ *
+ * @param service_id	Service ID of the file system.
+ * @param free_clusters	Output argument holding the free cluster count or
+ *			UINT32_MAX if it is not known.
+ * @param next_free	Output argument holding the next free cluster hint or
+ *			FAT_CLST_RES0 if it is not known.
+ */
+static void fat_read_fat32_fsinfo(service_id_t service_id,
+    uint32_t *free_clusters, fat_cluster_t *next_free)
+{
+	fat32_fsinfo_t *info;
+	block_t *b;
+
+	*free_clusters = UINT32_MAX;
+	*next_free = FAT_CLST_RES0;
+
+	if (fat_fat32_fsinfo_get(service_id, &b) != EOK)
+		return;
+
+	info = (fat32_fsinfo_t *) b->data;
+	*free_clusters = uint32_t_le2host(info->free_clusters);
+	*next_free = uint32_t_le2host(info->last_allocated_cluster);
+
+	(void) block_put(b);
+}
+
 static errno_t
 fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
     aoff64_t *size)
@@ -1082,6 +1162,9 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 	fat_instance_t *instance;
 	fat_idx_t *ridxp;
 	fs_node_t *rfn;
+	fat_bs_t *bs;
+	uint32_t free_clusters = UINT32_MAX;
+	fat_cluster_t next_free = FAT_CLST_RES0;
 	errno_t rc;
 
 	instance = malloc(sizeof(fat_instance_t));
@@ -1105,11 +1188,18 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 		return rc;
 	}
 
+	bs = block_bb_get(service_id);
+	if (FAT_IS_FAT32(bs))
+		fat_read_fat32_fsinfo(service_id, &free_clusters, &next_free);
+	fat_free_map_init(&instance->free_map, bs, service_id, free_clusters,
+	    next_free);
+
 	fibril_mutex_lock(&ridxp->lock);
 
 	rc = fs_instance_create(service_id, instance);
 	if (rc != EOK) {
 		fibril_mutex_unlock(&ridxp->lock);
+		fat_free_map_fini(&instance->free_map);
 		fat_fs_close(service_id, rfn);
 		free(instance);
 		return rc;
@@ -1123,32 +1213,32 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 	return EOK;
 }
 
-static errno_t fat_update_fat32_fsinfo(service_id_t service_id)
+/** Write the free cluster hints to the FAT32 FSInfo sector.
+ *
+ * @param service_id	Service ID of the file system.
+ * @param fmap		Free map of the file system.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t fat_update_fat32_fsinfo(service_id_t service_id,
+    fat_free_map_t *fmap)
 {
-	fat_bs_t *bs;
 	fat32_fsinfo_t *info;
+	uint32_t free_clusters;
+	fat_cluster_t next_free;
 	block_t *b;
 	errno_t rc;
 
-	bs = block_bb_get(service_id);
-	assert(FAT_IS_FAT32(bs));
-
-	rc = block_get(&b, service_id, uint16_t_le2host(bs->fat32.fsinfo_sec),
-	    BLOCK_FLAGS_NONE);
+	rc = fat_fat32_fsinfo_get(service_id, &b);
 	if (rc != EOK)
 		return rc;
 
 	info = (fat32_fsinfo_t *) b->data;
 
-	if (memcmp(info->sig1, FAT32_FSINFO_SIG1, sizeof(info->sig1)) != 0 ||
-	    memcmp(info->sig2, FAT32_FSINFO_SIG2, sizeof(info->sig2)) != 0 ||
-	    memcmp(info->sig3, FAT32_FSINFO_SIG3, sizeof(info->sig3)) != 0) {
-		(void) block_put(b);
-		return EINVAL;
-	}
-
-	/* For now, invalidate the counter. */
-	info->free_clusters = host2uint16_t_le(-1);
+	/* An unknown count is stored as 0xffffffff as well. */
+	fat_free_map_stats(fmap, &free_clusters, &next_free);
+	info->free_clusters = host2uint32_t_le(free_clusters);
+	info->last_allocated_cluster = host2uint32_t_le(next_free);
 
 	b->dirty = true;
 	return block_put(b);
@@ -1156,6 +1246,7 @@ static errno_t fat_update_fat32_fsinfo(service_id_t service_id)
 
 static errno_t fat_unmounted(service_id_t service_id)
 {
+	fat_instance_t *instance;
 	fs_node_t *fn;
 	fat_node_t *nodep;
 	fat_bs_t *bs;
@@ -1177,11 +1268,21 @@ static errno_t fat_unmounted(service_id_t service_id)
 		return EBUSY;
 	}
 
+	rc = fs_instance_get(service_id, (void **) &instance);
+	if (rc != EOK) {
+		(void) fat_node_put(fn);
+		return rc;
+	}
+
+	/* Stop the free map builder before libblock goes away. */
+	fat_free_map_fini(&instance->free_map);
+
 	if (FAT_IS_FAT32(bs)) {
 		/*
 		 * Attempt to update the FAT32 FS info.
 		 */
-		(void) fat_update_fat32_fsinfo(service_id);
+		(void) fat_update_fat32_fsinfo(service_id,
+		    &instance->free_map);
 	}
 
 	/*
@@ -1197,11 +1298,8 @@ static errno_t fat_unmounted(service_id_t service_id)
 	(void) fat_node_fini_by_service_id(service_id);
 	fat_fs_close(service_id, fn);
 
-	void *data;
-	if (fs_instance_get(service_id, &data) == EOK) {
-		fs_instance_destroy(service_id);
-		free(data);
-	}
+	fs_instance_destroy(service_id);
+	free(instance);
 
 	return EOK;
 }
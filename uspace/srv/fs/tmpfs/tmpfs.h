@@ -52,6 +52,8 @@ struct tmpfs_node;
 
 typedef struct tmpfs_dentry {
 	link_t link;		/**< Linkage for the list of siblings. */
+	ht_link_t dh_link;	/**< Dentries hash table link. */
+	struct tmpfs_node *parent;/**< Directory containing the dentry. */
 	struct tmpfs_node *node;/**< Back pointer to TMPFS node. */
 	char *name;		/**< Name of dentry. */
 } tmpfs_dentry_t;
@@ -64,8 +66,15 @@ typedef struct tmpfs_node {
 	tmpfs_dentry_type_t type;
 	unsigned lnkcnt;	/**< Link count. */
 	size_t size;		/**< File size if type is TMPFS_FILE. */
-	void *data;		/**< File content's if type is TMPFS_FILE. */
+	/**
+	 * Radix tree of page-sized chunks holding the file content if type is
+	 * TMPFS_FILE. Missing chunks are holes which read as zeros.
+	 */
+	void *chunks;
+	unsigned height;	/**< Number of inner levels of chunks. */
 	list_t cs_list;		/**< Child's siblings list. */
+	tmpfs_dentry_t *rd_dentry;/**< Dentry last returned by a read. */
+	aoff64_t rd_pos;	/**< Position of rd_dentry in cs_list. */
 } tmpfs_node_t;
 
 extern vfs_out_ops_t tmpfs_ops;
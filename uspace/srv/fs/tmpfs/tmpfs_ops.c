@@ -50,11 +50,22 @@
 #include <adt/hash_table.h>
 #include <adt/hash.h>
 #include <as.h>
+#include <malloc.h>
+#include <mem.h>
 #include <libfs.h>
 
 /** All root nodes have index 0. */
 #define TMPFS_SOME_ROOT  0
 
+/** Size of a chunk of file content. */
+#define TMPFS_CHUNK_SIZE  PAGE_SIZE
+
+/** Number of slots in an inner node of the chunk radix tree. */
+#define TMPFS_RADIX_SLOTS  (PAGE_SIZE / sizeof(void *))
+
+/** Content of file holes. */
+static const uint8_t tmpfs_zero_chunk[TMPFS_CHUNK_SIZE];
+
 /** Global counter for assigning node indices. Shared by all instances. */
 fs_index_t tmpfs_next_index = 1;
 
@@ -137,6 +148,9 @@ libfs_ops_t tmpfs_libfs_ops = {
 /** Hash table of all TMPFS nodes. */
 hash_table_t nodes;
 
+/** Hash table of all TMPFS dentries, hashed by their parent and name. */
+hash_table_t dentries;
+
 /*
  * Implementation of hash table interface for the nodes hash table.
  */
@@ -166,6 +180,8 @@ static bool nodes_key_equal(const void *key_arg, const ht_link_t *item)
 	return key->service_id == node->service_id && key->index == node->index;
 }
 
+static void tmpfs_chunks_truncate(tmpfs_node_t *, size_t);
+
 static void nodes_remove_callback(ht_link_t *item)
 {
 	tmpfs_node_t *nodep = hash_table_get_inst(item, tmpfs_node_t, nh_link);
@@ -176,12 +192,14 @@ static void nodes_remove_callback(ht_link_t *item)
 
 		assert(nodep->type == TMPFS_DIRECTORY);
 		list_remove(&dentryp->link);
+		hash_table_remove_item(&dentries, &dentryp->dh_link);
+		free(dentryp->name);
 		free(dentryp);
 	}
 
-	if (nodep->data) {
+	if (nodep->chunks) {
 		assert(nodep->type == TMPFS_FILE);
-		free(nodep->data);
+		tmpfs_chunks_truncate(nodep, 0);
 	}
 	free(nodep->bp);
 	free(nodep);
@@ -196,6 +214,214 @@ hash_table_ops_t nodes_ops = {
 	.remove_callback = nodes_remove_callback
 };
 
+/*
+ * Implementation of hash table interface for the dentries hash table.
+ */
+
+typedef struct {
+	tmpfs_node_t *parent;
+	const char *name;
+} dentry_key_t;
+
+static size_t dentry_hash(tmpfs_node_t *parent, const char *name)
+{
+	size_t hash = (size_t) parent;
+
+	while (*name != '\0')
+		hash = hash_combine(hash, (uint8_t) *name++);
+
+	return hash;
+}
+
+static size_t dentries_key_hash(const void *k)
+{
+	const dentry_key_t *key = k;
+	return dentry_hash(key->parent, key->name);
+}
+
+static size_t dentries_hash(const ht_link_t *item)
+{
+	tmpfs_dentry_t *dentryp = hash_table_get_inst(item, tmpfs_dentry_t,
+	    dh_link);
+	return dentry_hash(dentryp->parent, dentryp->name);
+}
+
+static bool dentries_key_equal(const void *key_arg, const ht_link_t *item)
+{
+	tmpfs_dentry_t *dentryp = hash_table_get_inst(item, tmpfs_dentry_t,
+	    dh_link);
+	const dentry_key_t *key = key_arg;
+
+	return key->parent == dentryp->parent &&
+	    str_cmp(key->name, dentryp->name) == 0;
+}
+
+/** TMPFS dentries hash table operations. */
+hash_table_ops_t dentries_ops = {
+	.hash = dentries_hash,
+	.key_hash = dentries_key_hash,
+	.key_equal = dentries_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static tmpfs_dentry_t *tmpfs_dentry_find(tmpfs_node_t *parentp,
+    const char *name)
+{
+	dentry_key_t key = {
+		.parent = parentp,
+		.name = name
+	};
+
+	ht_link_t *lnk = hash_table_find(&dentries, &key);
+	if (!lnk)
+		return NULL;
+
+	return hash_table_get_inst(lnk, tmpfs_dentry_t, dh_link);
+}
+
+/*
+ * Implementation of the chunk radix tree.
+ *
+ * The content of a file is stored in page-sized chunks. A tree of height zero
+ * consists of a single chunk, a tree of height h addresses TMPFS_RADIX_SLOTS
+ * subtrees of height h - 1. Missing chunks and subtrees are holes.
+ */
+
+/** Number of chunks addressable by a subtree of the given height. */
+static uint64_t tmpfs_radix_span(unsigned height)
+{
+	uint64_t span = 1;
+
+	while (height-- > 0)
+		span *= TMPFS_RADIX_SLOTS;
+
+	return span;
+}
+
+/** Find a chunk of file content.
+ *
+ * @param nodep		TMPFS file node.
+ * @param idx		Index of the chunk.
+ * @param alloc		Allocate the chunk if it is a hole.
+ *
+ * @return		The chunk or NULL if it is a hole or if it cannot be
+ *			allocated.
+ */
+static void *tmpfs_chunk_get(tmpfs_node_t *nodep, uint64_t idx, bool alloc)
+{
+	void **slot;
+	unsigned level;
+
+	/* Grow the tree until it can address the chunk. */
+	while (idx >= tmpfs_radix_span(nodep->height)) {
+		if (!alloc)
+			return NULL;
+
+		if (nodep->chunks) {
+			void **inner = calloc(TMPFS_RADIX_SLOTS,
+			    sizeof(void *));
+			if (!inner)
+				return NULL;
+			inner[0] = nodep->chunks;
+			nodep->chunks = inner;
+		}
+
+		nodep->height++;
+	}
+
+	slot = &nodep->chunks;
+	for (level = nodep->height; level > 0; level--) {
+		if (!*slot) {
+			if (!alloc)
+				return NULL;
+			*slot = calloc(TMPFS_RADIX_SLOTS, sizeof(void *));
+			if (!*slot)
+				return NULL;
+		}
+
+		slot = &((void **) *slot)[(idx / tmpfs_radix_span(level - 1)) %
+		    TMPFS_RADIX_SLOTS];
+	}
+
+	if (!*slot && alloc) {
+		/* Page-aligned chunks can be handed out as whole pages. */
+		*slot = memalign(PAGE_SIZE, TMPFS_CHUNK_SIZE);
+		if (*slot)
+			memset(*slot, 0, TMPFS_CHUNK_SIZE);
+	}
+
+	return *slot;
+}
+
+/** Free chunks of a subtree starting with a given chunk index.
+ *
+ * @param slot		Slot holding the subtree.
+ * @param level		Height of the subtree.
+ * @param base		Index of the first chunk addressed by the subtree.
+ * @param first		Index of the first chunk to free.
+ */
+static void tmpfs_radix_trim(void **slot, unsigned level, uint64_t base,
+    uint64_t first)
+{
+	uint64_t span;
+	void **inner;
+	bool empty = true;
+	size_t i;
+
+	if (!*slot)
+		return;
+
+	if (level == 0) {
+		if (base >= first) {
+			free(*slot);
+			*slot = NULL;
+		}
+		return;
+	}
+
+	span = tmpfs_radix_span(level - 1);
+	inner = *slot;
+	for (i = 0; i < TMPFS_RADIX_SLOTS; i++) {
+		if (first < base + (i + 1) * span)
+			tmpfs_radix_trim(&inner[i], level - 1, base + i * span,
+			    first);
+		if (inner[i])
+			empty = false;
+	}
+
+	if (empty) {
+		free(inner);
+		*slot = NULL;
+	}
+}
+
+/** Drop file content past a new file size.
+ *
+ * The tail of the last remaining chunk is cleared so that the file reads as
+ * zeros there if it grows again.
+ *
+ * @param nodep		TMPFS file node.
+ * @param size		New file size.
+ */
+static void tmpfs_chunks_truncate(tmpfs_node_t *nodep, size_t size)
+{
+	uint64_t nchunks = (size + TMPFS_CHUNK_SIZE - 1) / TMPFS_CHUNK_SIZE;
+	uint8_t *chunk;
+
+	tmpfs_radix_trim(&nodep->chunks, nodep->height, 0, nchunks);
+	if (!nodep->chunks)
+		nodep->height = 0;
+
+	if (size % TMPFS_CHUNK_SIZE != 0) {
+		chunk = tmpfs_chunk_get(nodep, size / TMPFS_CHUNK_SIZE, false);
+		if (chunk) {
+			memset(chunk + size % TMPFS_CHUNK_SIZE, 0,
+			    TMPFS_CHUNK_SIZE - size % TMPFS_CHUNK_SIZE);
+		}
+	}
+}
+
 static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 {
 	nodep->bp = NULL;
@@ -204,14 +430,18 @@ static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 	nodep->type = TMPFS_NONE;
 	nodep->lnkcnt = 0;
 	nodep->size = 0;
-	nodep->data = NULL;
+	nodep->chunks = NULL;
+	nodep->height = 0;
 	list_initialize(&nodep->cs_list);
+	nodep->rd_dentry = NULL;
+	nodep->rd_pos = 0;
 }
 
 static void tmpfs_dentry_initialize(tmpfs_dentry_t *dentryp)
 {
 	link_initialize(&dentryp->link);
 	dentryp->name = NULL;
+	dentryp->parent = NULL;
 	dentryp->node = NULL;
 }
 
@@ -220,6 +450,11 @@ bool tmpfs_init(void)
 	if (!hash_table_create(&nodes, 0, 0, &nodes_ops))
 		return false;
 
+	if (!hash_table_create(&dentries, 0, 0, &dentries_ops)) {
+		hash_table_destroy(&nodes);
+		return false;
+	}
+
 	return true;
 }
 
@@ -253,16 +488,10 @@ static void tmpfs_instance_done(service_id_t service_id)
 
 errno_t tmpfs_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 {
-	tmpfs_node_t *parentp = TMPFS_NODE(pfn);
-
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dentryp) {
-		if (!str_cmp(dentryp->name, component)) {
-			*rfn = FS_NODE(dentryp->node);
-			return EOK;
-		}
-	}
+	tmpfs_dentry_t *dentryp;
 
-	*rfn = NULL;
+	dentryp = tmpfs_dentry_find(TMPFS_NODE(pfn), component);
+	*rfn = dentryp ? FS_NODE(dentryp->node) : NULL;
 	return EOK;
 }
 
@@ -362,10 +591,8 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 	assert(parentp->type == TMPFS_DIRECTORY);
 
 	/* Check for duplicit entries. */
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dp) {
-		if (!str_cmp(dp->name, nm))
-			return EEXIST;
-	}
+	if (tmpfs_dentry_find(parentp, nm))
+		return EEXIST;
 
 	/* Allocate and initialize the dentry. */
 	dentryp = malloc(sizeof(tmpfs_dentry_t));
@@ -381,9 +608,11 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 		return ENOMEM;
 	}
 	str_cpy(dentryp->name, size + 1, nm);
+	dentryp->parent = parentp;
 	dentryp->node = childp;
 	childp->lnkcnt++;
 	list_append(&dentryp->link, &parentp->cs_list);
+	hash_table_insert(&dentries, &dentryp->dh_link);
 
 	return EOK;
 }
@@ -397,13 +626,10 @@ errno_t tmpfs_unlink_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 	if (!parentp)
 		return EBUSY;
 
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dp) {
-		if (!str_cmp(dp->name, nm)) {
-			dentryp = dp;
-			childp = dentryp->node;
-			assert(FS_NODE(childp) == cfn);
-			break;
-		}
+	dentryp = tmpfs_dentry_find(parentp, nm);
+	if (dentryp) {
+		childp = dentryp->node;
+		assert(FS_NODE(childp) == cfn);
 	}
 
 	if (!childp)
@@ -412,7 +638,12 @@ errno_t tmpfs_unlink_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 	if ((childp->lnkcnt == 1) && !list_empty(&childp->cs_list))
 		return ENOTEMPTY;
 
+	/* Positions of the following dentries change. */
+	parentp->rd_dentry = NULL;
+
 	list_remove(&dentryp->link);
+	hash_table_remove_item(&dentries, &dentryp->dh_link);
+	free(dentryp->name);
 	free(dentryp);
 	childp->lnkcnt--;
 
@@ -491,9 +722,22 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 
 	size_t bytes;
 	if (nodep->type == TMPFS_FILE) {
-		bytes = min(nodep->size - pos, size);
-		(void) async_data_read_finalize(&call, nodep->data + pos,
-		    bytes);
+		const uint8_t *chunk;
+		size_t off = pos % TMPFS_CHUNK_SIZE;
+
+		/*
+		 * Serve at most one chunk at a time. A page-aligned read of
+		 * a page, such as one issued by the VFS pager, is answered
+		 * directly from the chunk.
+		 */
+		bytes = (pos < nodep->size) ? min(nodep->size - pos, size) : 0;
+		bytes = min(bytes, TMPFS_CHUNK_SIZE - off);
+
+		chunk = tmpfs_chunk_get(nodep, pos / TMPFS_CHUNK_SIZE, false);
+		if (!chunk)
+			chunk = tmpfs_zero_chunk;
+
+		(void) async_data_read_finalize(&call, chunk + off, bytes);
 	} else {
 		tmpfs_dentry_t *dentryp;
 		link_t *lnk;
@@ -501,11 +745,17 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 		assert(nodep->type == TMPFS_DIRECTORY);
 
 		/*
-		 * Yes, we really use O(n) algorithm here.
-		 * If it bothers someone, it could be fixed by introducing a
-		 * hash table.
+		 * Directories are usually read sequentially, so continue
+		 * from the dentry returned by the previous read if possible.
 		 */
-		lnk = list_nth(&nodep->cs_list, pos);
+		if (nodep->rd_dentry && nodep->rd_pos + 1 == pos) {
+			lnk = list_next(&nodep->rd_dentry->link,
+			    &nodep->cs_list);
+		} else if (nodep->rd_dentry && nodep->rd_pos == pos) {
+			lnk = &nodep->rd_dentry->link;
+		} else {
+			lnk = list_nth(&nodep->cs_list, pos);
+		}
 
 		if (lnk == NULL) {
 			async_answer_0(&call, ENOENT);
@@ -513,6 +763,8 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 		}
 
 		dentryp = list_get_instance(lnk, tmpfs_dentry_t, link);
+		nodep->rd_dentry = dentryp;
+		nodep->rd_pos = pos;
 
 		(void) async_data_read_finalize(&call, dentryp->name,
 		    str_size(dentryp->name) + 1);
@@ -553,33 +805,23 @@ tmpfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	}
 
 	/*
-	 * Check whether the file needs to grow.
-	 */
-	if (pos + size <= nodep->size) {
-		/* The file size is not changing. */
-		(void) async_data_write_finalize(&call, nodep->data + pos,
-		    size);
-		goto out;
-	}
-	size_t delta = (pos + size) - nodep->size;
-	/*
-	 * At this point, we are deliberately extremely straightforward and
-	 * simply realloc the contents of the file on every write that grows the
-	 * file. In the end, the situation might not be as bad as it may look:
-	 * our heap allocator can save us and just grow the block whenever
-	 * possible.
+	 * Write at most one chunk at a time, allocating it if it is a hole.
+	 * Growing the file never copies its existing content.
 	 */
-	void *newdata = realloc(nodep->data, nodep->size + delta);
-	if (!newdata) {
+	size = min(size, TMPFS_CHUNK_SIZE - pos % TMPFS_CHUNK_SIZE);
+
+	uint8_t *chunk = tmpfs_chunk_get(nodep, pos / TMPFS_CHUNK_SIZE, true);
+	if (!chunk) {
 		async_answer_0(&call, ENOMEM);
 		size = 0;
 		goto out;
 	}
-	/* Clear any newly allocated memory in order to emulate gaps. */
-	memset(newdata + nodep->size, 0, delta);
-	nodep->size += delta;
-	nodep->data = newdata;
-	(void) async_data_write_finalize(&call, nodep->data + pos, size);
+
+	(void) async_data_write_finalize(&call, chunk + pos % TMPFS_CHUNK_SIZE,
+	    size);
+
+	if (pos + size > nodep->size)
+		nodep->size = pos + size;
 
 out:
 	*wbytes = size;
@@ -609,17 +851,11 @@ static errno_t tmpfs_truncate(service_id_t service_id, fs_index_t index,
 	if (size > SIZE_MAX)
 		return ENOMEM;
 
-	void *newdata = realloc(nodep->data, size);
-	if (!newdata && size)
-		return ENOMEM;
-
-	if (size > nodep->size) {
-		size_t delta = size - nodep->size;
-		memset(newdata + nodep->size, 0, delta);
-	}
+	/* Growing the file just creates a hole. */
+	if (size < nodep->size)
+		tmpfs_chunks_truncate(nodep, size);
 
 	nodep->size = size;
-	nodep->data = newdata;
 	return EOK;
 }
 
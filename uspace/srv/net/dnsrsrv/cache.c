@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup dnsrsrv
+ * @{
+ */
+/**
+ * @file DNS resolver cache.
+ *
+ * Results of name queries are cached per (name, query type) for the time
+ * to live indicated by the server. Negative answers (the name or the record
+ * type does not exist) are cached as well, following RFC 2308. Transient
+ * errors are not cached.
+ *
+ * While a query is in progress its entry is kept in the cache marked as
+ * pending, so that concurrent lookups of the same name wait for the result
+ * instead of sending duplicate queries.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inttypes.h>
+#include <io/log.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <time.h>
+#include "cache.h"
+#include "dns_type.h"
+
+/** Lookup key */
+typedef struct {
+	const char *name;
+	dns_qtype_t qtype;
+} dns_cache_key_t;
+
+static size_t dns_cache_key_hash_calc(const dns_cache_key_t *key)
+{
+	size_t hash = (size_t) key->qtype;
+	const char *cp;
+
+	/* Domain names compare case-insensitively */
+	for (cp = key->name; *cp != '\0'; cp++)
+		hash = hash_combine(hash, tolower((unsigned char) *cp));
+
+	return hash;
+}
+
+static size_t dns_cache_entry_hash(const ht_link_t *item)
+{
+	dns_cache_entry_t *entry = hash_table_get_inst(item, dns_cache_entry_t,
+	    htlink);
+	dns_cache_key_t key = { .name = entry->name, .qtype = entry->qtype };
+
+	return dns_cache_key_hash_calc(&key);
+}
+
+static size_t dns_cache_key_hash(const void *arg)
+{
+	return dns_cache_key_hash_calc((const dns_cache_key_t *) arg);
+}
+
+static bool dns_cache_key_equal(const void *arg, const ht_link_t *item)
+{
+	const dns_cache_key_t *key = (const dns_cache_key_t *) arg;
+	dns_cache_entry_t *entry = hash_table_get_inst(item, dns_cache_entry_t,
+	    htlink);
+
+	return entry->qtype == key->qtype &&
+	    str_casecmp(entry->name, key->name) == 0;
+}
+
+static hash_table_ops_t dns_cache_ops = {
+	.hash = dns_cache_entry_hash,
+	.key_hash = dns_cache_key_hash,
+	.key_equal = dns_cache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static time_t dns_cache_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return ts.tv_sec;
+}
+
+static void dns_cache_entry_free(dns_cache_entry_t *entry)
+{
+	free(entry->name);
+	free(entry->cname);
+	free(entry);
+}
+
+/** Drop a reference to a cache entry.
+ *
+ * The entry is freed once it has been removed from the cache and the last
+ * reference has been dropped.
+ */
+static void dns_cache_entry_release(dns_cache_entry_t *entry)
+{
+	assert(entry->refcnt > 0);
+	--entry->refcnt;
+
+	if (entry->refcnt == 0 && !entry->in_table)
+		dns_cache_entry_free(entry);
+}
+
+/** Remove resolved entry from the cache. */
+static void dns_cache_remove(dns_cache_t *cache, dns_cache_entry_t *entry)
+{
+	assert(!entry->pending);
+	assert(entry->in_table);
+
+	hash_table_remove_item(&cache->entries, &entry->htlink);
+	list_remove(&entry->lru_link);
+	entry->in_table = false;
+	--cache->stats.entries;
+
+	if (entry->refcnt == 0)
+		dns_cache_entry_free(entry);
+}
+
+/** Copy result stored in a resolved entry to @a info. */
+static errno_t dns_cache_entry_get(dns_cache_entry_t *entry,
+    dns_host_info_t *info)
+{
+	if (entry->rc != EOK)
+		return entry->rc;
+
+	info->cname = str_dup(entry->cname);
+	if (info->cname == NULL)
+		return ENOMEM;
+
+	info->addr = entry->addr;
+	return EOK;
+}
+
+/** Create DNS cache.
+ *
+ * @param resolve Function used to resolve names not found in the cache
+ * @param rcache Place to store pointer to the new cache
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t dns_cache_create(dns_cache_resolve_t resolve, dns_cache_t **rcache)
+{
+	dns_cache_t *cache = calloc(1, sizeof(dns_cache_t));
+	if (cache == NULL)
+		return ENOMEM;
+
+	if (!hash_table_create(&cache->entries, 0, 0, &dns_cache_ops)) {
+		free(cache);
+		return ENOMEM;
+	}
+
+	fibril_mutex_initialize(&cache->lock);
+	fibril_condvar_initialize(&cache->done_cv);
+	list_initialize(&cache->lru);
+	cache->resolve = resolve;
+
+	*rcache = cache;
+	return EOK;
+}
+
+/** Destroy DNS cache.
+ *
+ * There must be no lookups in progress.
+ *
+ * @param cache DNS cache
+ */
+void dns_cache_destroy(dns_cache_t *cache)
+{
+	dns_cache_flush(cache);
+	assert(hash_table_empty(&cache->entries));
+
+	hash_table_destroy(&cache->entries);
+	free(cache);
+}
+
+/** Make room for a new entry by evicting the least recently used ones. */
+static void dns_cache_trim(dns_cache_t *cache)
+{
+	while (cache->stats.entries > DNS_CACHE_MAX_ENTRIES) {
+		link_t *link = list_last(&cache->lru);
+		if (link == NULL)
+			break;
+
+		dns_cache_entry_t *entry = list_get_instance(link,
+		    dns_cache_entry_t, lru_link);
+		dns_cache_remove(cache, entry);
+		++cache->stats.evictions;
+	}
+}
+
+/** Look up name, querying the network if there is no cached answer.
+ *
+ * @param cache DNS cache
+ * @param name Name to look up
+ * @param qtype Query type
+ * @param info Host information to fill in. The caller is responsible for
+ *             freeing @c info->cname on success.
+ * @return EOK on success, ENOENT if the name does not exist or has no
+ *         record of the requested type, other error code on failure
+ */
+errno_t dns_cache_lookup(dns_cache_t *cache, const char *name,
+    dns_qtype_t qtype, dns_host_info_t *info)
+{
+	dns_cache_key_t key = { .name = name, .qtype = qtype };
+	dns_cache_entry_t *entry;
+	ht_link_t *link;
+	uint32_t ttl;
+	errno_t rc;
+
+	fibril_mutex_lock(&cache->lock);
+
+	link = hash_table_find(&cache->entries, &key);
+	if (link != NULL) {
+		entry = hash_table_get_inst(link, dns_cache_entry_t, htlink);
+
+		if (!entry->pending && entry->expires <= dns_cache_now()) {
+			dns_cache_remove(cache, entry);
+			++cache->stats.expired;
+			link = NULL;
+		}
+	}
+
+	if (link != NULL) {
+		if (entry->pending) {
+			/* Wait for the query already in progress */
+			++cache->stats.coalesced;
+			++entry->refcnt;
+
+			while (entry->pending)
+				fibril_condvar_wait(&cache->done_cv, &cache->lock);
+
+			rc = dns_cache_entry_get(entry, info);
+			dns_cache_entry_release(entry);
+			fibril_mutex_unlock(&cache->lock);
+			return rc;
+		}
+
+		if (entry->rc == EOK)
+			++cache->stats.hits;
+		else
+			++cache->stats.neg_hits;
+
+		list_remove(&entry->lru_link);
+		list_prepend(&entry->lru_link, &cache->lru);
+
+		rc = dns_cache_entry_get(entry, info);
+		fibril_mutex_unlock(&cache->lock);
+		return rc;
+	}
+
+	++cache->stats.misses;
+
+	entry = calloc(1, sizeof(dns_cache_entry_t));
+	if (entry == NULL) {
+		fibril_mutex_unlock(&cache->lock);
+		return ENOMEM;
+	}
+
+	entry->name = str_dup(name);
+	if (entry->name == NULL) {
+		free(entry);
+		fibril_mutex_unlock(&cache->lock);
+		return ENOMEM;
+	}
+
+	link_initialize(&entry->lru_link);
+	entry->qtype = qtype;
+	entry->pending = true;
+	entry->in_table = true;
+	entry->refcnt = 1;
+	hash_table_insert(&cache->entries, &entry->htlink);
+
+	fibril_mutex_unlock(&cache->lock);
+
+	ttl = 0;
+	rc = cache->resolve(name, qtype, info, &ttl);
+
+	fibril_mutex_lock(&cache->lock);
+
+	entry->rc = rc;
+	if (rc == EOK) {
+		entry->cname = str_dup(info->cname);
+		entry->addr = info->addr;
+		if (entry->cname == NULL)
+			entry->rc = ENOMEM;
+	}
+
+	entry->pending = false;
+	fibril_condvar_broadcast(&cache->done_cv);
+
+	if ((entry->rc == EOK || entry->rc == ENOENT) && ttl > 0) {
+		if (ttl > DNS_CACHE_TTL_MAX)
+			ttl = DNS_CACHE_TTL_MAX;
+
+		entry->expires = dns_cache_now() + ttl;
+		list_prepend(&entry->lru_link, &cache->lru);
+		++cache->stats.entries;
+		dns_cache_trim(cache);
+	} else {
+		/* Do not cache transient failures */
+		hash_table_remove_item(&cache->entries, &entry->htlink);
+		entry->in_table = false;
+	}
+
+	dns_cache_entry_release(entry);
+	fibril_mutex_unlock(&cache->lock);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "dns_cache_lookup: '%s' type %u "
+	    "resolved, rc=%s ttl=%" PRIu32, name, (unsigned) qtype,
+	    str_error_name(rc), ttl);
+	return rc;
+}
+
+/** Remove all resolved entries from the cache.
+ *
+ * Queries that are in progress are not affected.
+ *
+ * @param cache DNS cache
+ */
+void dns_cache_flush(dns_cache_t *cache)
+{
+	fibril_mutex_lock(&cache->lock);
+
+	list_foreach_safe(cache->lru, cur, next) {
+		dns_cache_entry_t *entry = list_get_instance(cur,
+		    dns_cache_entry_t, lru_link);
+		dns_cache_remove(cache, entry);
+	}
+
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** Get cache statistics.
+ *
+ * @param cache DNS cache
+ * @param stats Place to store statistics
+ */
+void dns_cache_get_stats(dns_cache_t *cache, dnsr_cache_stats_t *stats)
+{
+	fibril_mutex_lock(&cache->lock);
+	*stats = cache->stats;
+	fibril_mutex_unlock(&cache->lock);
+}
+
+/** @}
+ */
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/** @addtogroup dnsrsrv
+ * @{
+ */
+/**
+ * @file
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <types/inet/dnsr.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "dns_std.h"
+#include "dns_type.h"
+
+/** Maximum number of resolved entries kept in the cache */
+#define DNS_CACHE_MAX_ENTRIES 256
+
+/** Upper bound on the time (in seconds) any entry is kept */
+#define DNS_CACHE_TTL_MAX 86400
+
+/** Negative caching time (in seconds) used when the reply carries no SOA */
+#define DNS_CACHE_NEG_TTL 60
+
+/** Resolve a name by querying the network.
+ *
+ * Returns EOK and fills in the host information, ENOENT if the server
+ * authoritatively answered that no such record exists, or any other
+ * error code on transient failure. On EOK and ENOENT the time to live
+ * (in seconds) of the answer is stored in the last argument.
+ */
+typedef errno_t (*dns_cache_resolve_t)(const char *, dns_qtype_t,
+    dns_host_info_t *, uint32_t *);
+
+/** DNS cache entry */
+typedef struct {
+	/** Link to dns_cache_t.entries */
+	ht_link_t htlink;
+	/** Link to dns_cache_t.lru */
+	link_t lru_link;
+	/** Queried name */
+	char *name;
+	/** Query type */
+	dns_qtype_t qtype;
+	/** Query is still in progress */
+	bool pending;
+	/** Entry is in dns_cache_t.entries */
+	bool in_table;
+	/** Number of fibrils referencing the entry */
+	unsigned refcnt;
+	/** Result of the query */
+	errno_t rc;
+	/** Canonical name (if @c rc is EOK) */
+	char *cname;
+	/** Host address (if @c rc is EOK) */
+	inet_addr_t addr;
+	/** Uptime (in seconds) at which the entry expires */
+	time_t expires;
+} dns_cache_entry_t;
+
+/** DNS cache */
+typedef struct {
+	/** Protects the whole cache */
+	fibril_mutex_t lock;
+	/** Signalled when a pending query completes */
+	fibril_condvar_t done_cv;
+	/** Entries hashed by name and query type */
+	hash_table_t entries;
+	/** Resolved entries, least recently used last */
+	list_t lru;
+	/** Function used to resolve names on a cache miss */
+	dns_cache_resolve_t resolve;
+	/** Statistics */
+	dnsr_cache_stats_t stats;
+} dns_cache_t;
+
+extern errno_t dns_cache_create(dns_cache_resolve_t, dns_cache_t **);
+extern void dns_cache_destroy(dns_cache_t *);
+extern errno_t dns_cache_lookup(dns_cache_t *, const char *, dns_qtype_t,
+    dns_host_info_t *);
+extern void dns_cache_flush(dns_cache_t *);
+extern void dns_cache_get_stats(dns_cache_t *, dnsr_cache_stats_t *);
+
+#endif
+
+/** @}
+ */
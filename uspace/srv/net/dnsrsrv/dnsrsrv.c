@@ -59,6 +59,12 @@ static errno_t dnsr_init(void)
 	errno_t rc;
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "dnsr_init()");
 
+	rc = dns_query_init();
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing resolver cache.");
+		return ENOMEM;
+	}
+
 	rc = transport_init();
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing transport.");
@@ -203,6 +209,45 @@ static void dnsr_set_srvaddr_srv(dnsr_client_t *client, ipc_call_t *icall)
 		return;
 	}
 
+	/* Answers from the previous server no longer apply */
+	dns_query_cache_flush();
+
+	async_answer_0(icall, rc);
+}
+
+static void dnsr_cache_flush_srv(dnsr_client_t *client, ipc_call_t *icall)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "dnsr_cache_flush_srv()");
+
+	dns_query_cache_flush();
+	async_answer_0(icall, EOK);
+}
+
+static void dnsr_cache_stats_srv(dnsr_client_t *client, ipc_call_t *icall)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "dnsr_cache_stats_srv()");
+
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	if (size != sizeof(dnsr_cache_stats_t)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	dnsr_cache_stats_t stats;
+	dns_query_cache_stats(&stats);
+
+	errno_t rc = async_data_read_finalize(&call, &stats, size);
+	if (rc != EOK)
+		async_answer_0(&call, rc);
+
 	async_answer_0(icall, rc);
 }
 
@@ -236,6 +281,12 @@ static void dnsr_client_conn(ipc_call_t *icall, void *arg)
 		case DNSR_SET_SRVADDR:
 			dnsr_set_srvaddr_srv(&client, &call);
 			break;
+		case DNSR_CACHE_FLUSH:
+			dnsr_cache_flush_srv(&client, &call);
+			break;
+		case DNSR_CACHE_STATS:
+			dnsr_cache_stats_srv(&client, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 		}
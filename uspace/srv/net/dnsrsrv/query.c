@@ -35,9 +35,12 @@
 
 #include <errno.h>
 #include <io/log.h>
+#include <macros.h>
 #include <mem.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <str.h>
+#include "cache.h"
 #include "dns_msg.h"
 #include "dns_std.h"
 #include "dns_type.h"
@@ -45,9 +48,58 @@
 #include "transport.h"
 
 static uint16_t msg_id;
+static dns_cache_t *query_cache;
 
+/** Determine negative caching time from an answer without a usable record.
+ *
+ * Per RFC 2308 this is the lesser of the TTL of the SOA record in the
+ * authority section and the SOA MINIMUM field.
+ *
+ * @param amsg Answer message
+ * @return Time to live in seconds
+ */
+static uint32_t dns_negative_ttl(dns_message_t *amsg)
+{
+	list_foreach(amsg->authority, msg, dns_rr_t, rr) {
+		if (rr->rtype != DTYPE_SOA || rr->rclass != DC_IN)
+			continue;
+
+		char *mname;
+		char *rname;
+		size_t eoff;
+
+		/* Skip MNAME and RNAME */
+		if (dns_name_decode(&amsg->pdu, rr->roff, &mname, &eoff) != EOK)
+			break;
+		free(mname);
+		if (dns_name_decode(&amsg->pdu, eoff, &rname, &eoff) != EOK)
+			break;
+		free(rname);
+
+		/* SERIAL, REFRESH, RETRY, EXPIRE, MINIMUM */
+		if (eoff + 5 * sizeof(uint32_t) > amsg->pdu.size)
+			break;
+
+		uint32_t minimum = dns_uint32_t_decode(amsg->pdu.data + eoff +
+		    4 * sizeof(uint32_t), sizeof(uint32_t));
+
+		return min(rr->ttl, minimum);
+	}
+
+	return DNS_CACHE_NEG_TTL;
+}
+
+/** Query the DNS server.
+ *
+ * @param name Name to look up
+ * @param qtype Query type
+ * @param info Host information to fill in
+ * @param rttl Place to store time to live of the answer in seconds
+ * @return EOK on success, ENOENT if the server answered that the name
+ *         or record does not exist, other error code on failure
+ */
 static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
-    dns_host_info_t *info)
+    dns_host_info_t *info, uint32_t *rttl)
 {
 	/* Start with the caller-provided name */
 	char *sname = str_dup(name);
@@ -98,6 +150,20 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 		return rc;
 	}
 
+	if (amsg->rcode != RC_OK && amsg->rcode != RC_NAME_ERR) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "server returned rcode %u",
+		    (unsigned) amsg->rcode);
+
+		dns_message_destroy(msg);
+		dns_message_destroy(amsg);
+		free(sname);
+
+		return EIO;
+	}
+
+	/* Answer is valid for the lowest TTL along the CNAME chain */
+	uint32_t ttl = UINT32_MAX;
+
 	list_foreach(amsg->answer, msg, dns_rr_t, rr) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, " - '%s' %u/%u, dsize %zu",
 		    rr->name, rr->rtype, rr->rclass, rr->rdata_size);
@@ -129,6 +195,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			/* Continue looking for the more canonical name */
 			free(sname);
 			sname = cname;
+			ttl = min(ttl, rr->ttl);
 		}
 
 		if ((qtype == DTYPE_A) && (rr->rtype == DTYPE_A) &&
@@ -146,6 +213,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 			inet_addr_set(dns_uint32_t_decode(rr->rdata, rr->rdata_size),
 			    &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -171,6 +239,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			dns_addr128_t_decode(rr->rdata, rr->rdata_size, addr);
 
 			inet_addr_set6(addr, &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -182,11 +251,37 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "'%s' not resolved, fail", sname);
 
+	*rttl = dns_negative_ttl(amsg);
+
 	dns_message_destroy(msg);
 	dns_message_destroy(amsg);
 	free(sname);
 
-	return EIO;
+	return ENOENT;
+}
+
+/** Initialize name queries.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t dns_query_init(void)
+{
+	return dns_cache_create(dns_name_query, &query_cache);
+}
+
+/** Discard all cached answers. */
+void dns_query_cache_flush(void)
+{
+	dns_cache_flush(query_cache);
+}
+
+/** Get resolver cache statistics.
+ *
+ * @param stats Place to store statistics
+ */
+void dns_query_cache_stats(dnsr_cache_stats_t *stats)
+{
+	dns_cache_get_stats(query_cache, stats);
 }
 
 errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
@@ -199,27 +294,32 @@ errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
 
 	switch (ver) {
 	case ip_any:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
+		rc = dns_cache_lookup(query_cache, name, DTYPE_AAAA, info);
 
 		if (rc != EOK)
-			rc = dns_name_query(name, DTYPE_A, info);
+			rc = dns_cache_lookup(query_cache, name, DTYPE_A, info);
 
 		break;
 	case ip_v4:
-		rc = dns_name_query(name, DTYPE_A, info);
+		rc = dns_cache_lookup(query_cache, name, DTYPE_A, info);
 		break;
 	case ip_v6:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
+		rc = dns_cache_lookup(query_cache, name, DTYPE_AAAA, info);
 		break;
 	default:
 		rc = EINVAL;
 	}
 
-	if (rc == EOK)
+	if (rc == EOK) {
 		*rinfo = info;
-	else
+	} else {
 		free(info);
 
+		/* Clients have always seen EIO for names that do not resolve */
+		if (rc == ENOENT)
+			rc = EIO;
+	}
+
 	return rc;
 }
 
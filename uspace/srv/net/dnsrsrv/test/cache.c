@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <io/log.h>
+#include <pcut/pcut.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+
+#include "../cache.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(cache);
+
+/** Number of times the test resolver was called */
+static unsigned resolve_cnt;
+/** Result the test resolver returns */
+static errno_t resolve_rc;
+/** Time to live the test resolver returns */
+static uint32_t resolve_ttl;
+/** Test resolver blocks until released */
+static bool resolve_block;
+
+static FIBRIL_MUTEX_INITIALIZE(resolve_lock);
+static FIBRIL_CONDVAR_INITIALIZE(resolve_cv);
+
+static errno_t test_resolve(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info, uint32_t *rttl)
+{
+	++resolve_cnt;
+
+	fibril_mutex_lock(&resolve_lock);
+	while (resolve_block)
+		fibril_condvar_wait(&resolve_cv, &resolve_lock);
+	fibril_mutex_unlock(&resolve_lock);
+
+	if (resolve_rc == EOK) {
+		info->cname = str_dup(name);
+		if (info->cname == NULL)
+			return ENOMEM;
+
+		inet_addr(&info->addr, 192, 168, 0, 1);
+	}
+
+	*rttl = resolve_ttl;
+	return resolve_rc;
+}
+
+static dns_cache_t *cache;
+
+PCUT_TEST_BEFORE
+{
+	errno_t rc;
+
+	/* We will be calling functions that perform logging */
+	rc = log_init("test-dnsrsrv");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	resolve_cnt = 0;
+	resolve_rc = EOK;
+	resolve_ttl = 300;
+	resolve_block = false;
+
+	rc = dns_cache_create(test_resolve, &cache);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
+PCUT_TEST_AFTER
+{
+	dns_cache_destroy(cache);
+}
+
+/** Second lookup of the same name is answered from the cache */
+PCUT_TEST(positive_hit)
+{
+	dns_host_info_t info;
+	dnsr_cache_stats_t stats;
+	inet_addr_t expected;
+	errno_t rc;
+
+	inet_addr(&expected, 192, 168, 0, 1);
+
+	rc = dns_cache_lookup(cache, "www.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_STR_EQUALS("www.example.org", info.cname);
+	PCUT_ASSERT_TRUE(inet_addr_compare(&expected, &info.addr));
+	free(info.cname);
+
+	/* Domain names compare case-insensitively */
+	rc = dns_cache_lookup(cache, "WWW.Example.ORG", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_STR_EQUALS("www.example.org", info.cname);
+	free(info.cname);
+
+	PCUT_ASSERT_INT_EQUALS(1, resolve_cnt);
+
+	/* Different query type is a different entry */
+	rc = dns_cache_lookup(cache, "www.example.org", DTYPE_AAAA, &info);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	free(info.cname);
+
+	PCUT_ASSERT_INT_EQUALS(2, resolve_cnt);
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.hits);
+	PCUT_ASSERT_INT_EQUALS(2, stats.misses);
+	PCUT_ASSERT_INT_EQUALS(2, stats.entries);
+}
+
+/** Non-existence of a name is cached */
+PCUT_TEST(negative_hit)
+{
+	dns_host_info_t info;
+	dnsr_cache_stats_t stats;
+	errno_t rc;
+
+	resolve_rc = ENOENT;
+	resolve_ttl = 60;
+
+	rc = dns_cache_lookup(cache, "nx.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	rc = dns_cache_lookup(cache, "nx.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	PCUT_ASSERT_INT_EQUALS(1, resolve_cnt);
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.hits);
+	PCUT_ASSERT_INT_EQUALS(1, stats.neg_hits);
+}
+
+/** Transient failures and zero TTL answers are not cached */
+PCUT_TEST(not_cached)
+{
+	dns_host_info_t info;
+	dnsr_cache_stats_t stats;
+	errno_t rc;
+
+	resolve_rc = EIO;
+
+	rc = dns_cache_lookup(cache, "www.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(EIO, rc);
+
+	resolve_rc = EOK;
+	resolve_ttl = 0;
+
+	rc = dns_cache_lookup(cache, "www.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	free(info.cname);
+
+	rc = dns_cache_lookup(cache, "www.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	free(info.cname);
+
+	PCUT_ASSERT_INT_EQUALS(3, resolve_cnt);
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.entries);
+}
+
+/** Flushing the cache forces a new query */
+PCUT_TEST(flush)
+{
+	dns_host_info_t info;
+	dnsr_cache_stats_t stats;
+	errno_t rc;
+
+	rc = dns_cache_lookup(cache, "www.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	free(info.cname);
+
+	dns_cache_flush(cache);
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(0, stats.entries);
+
+	rc = dns_cache_lookup(cache, "www.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	free(info.cname);
+
+	PCUT_ASSERT_INT_EQUALS(2, resolve_cnt);
+}
+
+/** Least recently used entries are evicted when the cache is full */
+PCUT_TEST(evict)
+{
+	dns_host_info_t info;
+	dnsr_cache_stats_t stats;
+	char name[32];
+	unsigned i;
+	errno_t rc;
+
+	for (i = 0; i < DNS_CACHE_MAX_ENTRIES + 1; i++) {
+		snprintf(name, sizeof(name), "host%u.example.org", i);
+
+		rc = dns_cache_lookup(cache, name, DTYPE_A, &info);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		free(info.cname);
+	}
+
+	dns_cache_get_stats(cache, &stats);
+	PCUT_ASSERT_INT_EQUALS(DNS_CACHE_MAX_ENTRIES, stats.entries);
+	PCUT_ASSERT_INT_EQUALS(1, stats.evictions);
+
+	/* Later entries are still cached */
+	rc = dns_cache_lookup(cache, "host1.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	free(info.cname);
+	PCUT_ASSERT_INT_EQUALS(DNS_CACHE_MAX_ENTRIES + 1, resolve_cnt);
+
+	/* The least recently used one was evicted */
+	rc = dns_cache_lookup(cache, "host0.example.org", DTYPE_A, &info);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	free(info.cname);
+	PCUT_ASSERT_INT_EQUALS(DNS_CACHE_MAX_ENTRIES + 2, resolve_cnt);
+}
+
+static unsigned lookups_done;
+
+static errno_t test_lookup_fibril(void *arg)
+{
+	dns_host_info_t info;
+	errno_t rc;
+
+	rc = dns_cache_lookup(cache, "www.example.org", DTYPE_A, &info);
+	if (rc == EOK)
+		free(info.cname);
+
+	*(errno_t *) arg = rc;
+	++lookups_done;
+	return EOK;
+}
+
+/** Concurrent lookups of the same name send only one query */
+PCUT_TEST(coalesce)
+{
+	dnsr_cache_stats_t stats;
+	errno_t rc1 = EINVAL, rc2 = EINVAL;
+	fid_t fid1, fid2;
+
+	lookups_done = 0;
+	resolve_block = true;
+
+	fid1 = fibril_create(test_lookup_fibril, &rc1);
+	PCUT_ASSERT_FALSE(fid1 == 0);
+	fid2 = fibril_create(test_lookup_fibril, &rc2);
+	PCUT_ASSERT_FALSE(fid2 == 0);
+
+	fibril_add_ready(fid1);
+	fibril_add_ready(fid2);
+
+	/* Wait until the second lookup joins the first one */
+	do {
+		fibril_yield();
+		dns_cache_get_stats(cache, &stats);
+	} while (stats.coalesced < 1);
+
+	fibril_mutex_lock(&resolve_lock);
+	resolve_block = false;
+	fibril_condvar_broadcast(&resolve_cv);
+	fibril_mutex_unlock(&resolve_lock);
+
+	while (lookups_done < 2)
+		fibril_yield();
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc2);
+	PCUT_ASSERT_INT_EQUALS(1, resolve_cnt);
+	PCUT_ASSERT_INT_EQUALS(1, stats.misses);
+}
+
+PCUT_EXPORT(cache);
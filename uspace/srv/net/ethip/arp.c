@@ -46,9 +46,6 @@
 #include "pdu.h"
 #include "std.h"
 
-/** Time to wait for ARP reply in microseconds */
-#define ARP_REQUEST_TIMEOUT (3 * 1000 * 1000)
-
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet);
 
 void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
@@ -93,32 +90,55 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 	}
 }
 
-errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+/** Send ARP request.
+ *
+ * @param nic NIC
+ * @param src_addr Sender IPv4 address
+ * @param ip_addr IPv4 address to resolve
+ * @param mac_addr Cached MAC address of the neighbour to refresh by
+ *                 a unicast request or @c NULL to broadcast the request
+ * @return EOK on success or an error code
+ */
+errno_t arp_send_request(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
     addr48_t mac_addr)
 {
-	/* Broadcast address */
-	if (ip_addr == addr32_broadcast_all_hosts) {
-		addr48(addr48_broadcast, mac_addr);
-		return EOK;
-	}
-
-	errno_t rc = atrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
-
 	arp_eth_packet_t packet;
 
 	packet.opcode = aop_request;
 	addr48(nic->mac_addr, packet.sender_hw_addr);
 	packet.sender_proto_addr = src_addr;
-	addr48(addr48_broadcast, packet.target_hw_addr);
+	addr48(mac_addr != NULL ? mac_addr : addr48_broadcast,
+	    packet.target_hw_addr);
 	packet.target_proto_addr = ip_addr;
 
-	rc = arp_send_packet(nic, &packet);
-	if (rc != EOK)
+	return arp_send_packet(nic, &packet);
+}
+
+/** Send IPv4 frame, translating the destination address.
+ *
+ * @param nic NIC
+ * @param src_addr Source IPv4 address
+ * @param ip_addr Destination IPv4 address
+ * @param data Encoded Ethernet frame whose destination address is to be
+ *             filled in. Ownership is passed to this function.
+ * @param size Frame size
+ * @return EOK if the frame was sent or queued waiting for address
+ *         resolution, error code otherwise
+ */
+errno_t arp_send_frame(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    void *data, size_t size)
+{
+	errno_t rc;
+
+	/* Broadcast address */
+	if (ip_addr == addr32_broadcast_all_hosts) {
+		eth_pdu_set_dest(data, addr48_broadcast);
+		rc = ethip_nic_send(nic, data, size);
+		free(data);
 		return rc;
+	}
 
-	return atrans_lookup_timeout(ip_addr, ARP_REQUEST_TIMEOUT, mac_addr);
+	return atrans_send(nic, src_addr, ip_addr, data, size);
 }
 
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet)
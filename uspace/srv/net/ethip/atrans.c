@@ -34,131 +34,481 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <inet/iplink_srv.h>
+#include <inttypes.h>
+#include <io/log.h>
 #include <stdlib.h>
+#include <time.h>
 
+#include "arp.h"
 #include "atrans.h"
 #include "ethip.h"
+#include "ethip_nic.h"
+#include "pdu.h"
 
-/** Address translation list (of ethip_atrans_t) */
-static FIBRIL_MUTEX_INITIALIZE(atrans_list_lock);
-static LIST_INITIALIZE(atrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(atrans_cv);
+/** Time for which a confirmed neighbour is considered reachable */
+#define ATRANS_REACHABLE_TIME SEC2USEC(30)
+/** Time between ARP requests for the same address */
+#define ATRANS_RETRANS_TIME SEC2USEC(1)
+/** Number of unanswered requests after which resolution fails */
+#define ATRANS_MAX_PROBES 3
+/** Time after which an unused stale entry is removed */
+#define ATRANS_GC_TIME SEC2USEC(60)
+/** Maximum number of frames queued per unresolved neighbour */
+#define ATRANS_MAX_PENDING 8
+/** Interval of the aging pass */
+#define ATRANS_AGE_INTERVAL SEC2USEC(1)
+/** Maximum number of requests sent per aging pass */
+#define ATRANS_AGE_PROBES 16
+
+/** Frame waiting for address resolution */
+typedef struct {
+	link_t link;
+	ethip_nic_t *nic;
+	void *data;
+	size_t size;
+} ethip_atrans_frame_t;
+
+/** ARP request to send after an aging pass */
+typedef struct {
+	ethip_nic_t *nic;
+	addr32_t src_addr;
+	addr32_t ip_addr;
+	addr48_t mac_addr;
+	bool unicast;
+} ethip_atrans_probe_t;
+
+/** State of an aging pass */
+typedef struct {
+	usec_t now;
+	/** Requests to send */
+	ethip_atrans_probe_t probes[ATRANS_AGE_PROBES];
+	size_t nprobes;
+	/** Frames to drop (of ethip_atrans_frame_t) */
+	list_t dropped;
+	/** Number of entries removed */
+	size_t removed;
+} ethip_atrans_age_t;
+
+/** Address translation table (of ethip_atrans_t) */
+static FIBRIL_MUTEX_INITIALIZE(atrans_lock);
+static hash_table_t atrans_table;
+static ethip_atrans_stats_t atrans_stats;
+
+static size_t atrans_ip_hash(addr32_t ip_addr)
+{
+	return hash_mix32(ip_addr);
+}
+
+static size_t atrans_hash(const ht_link_t *item)
+{
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_link);
+
+	return atrans_ip_hash(atrans->ip_addr);
+}
+
+static size_t atrans_key_hash(const void *key)
+{
+	return atrans_ip_hash(*(const addr32_t *) key);
+}
+
+static bool atrans_key_equal(const void *key, const ht_link_t *item)
+{
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_link);
+
+	return atrans->ip_addr == *(const addr32_t *) key;
+}
+
+static hash_table_ops_t atrans_ops = {
+	.hash = atrans_hash,
+	.key_hash = atrans_key_hash,
+	.key_equal = atrans_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static usec_t atrans_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
 
 static ethip_atrans_t *atrans_find(addr32_t ip_addr)
 {
-	list_foreach(atrans_list, atrans_list, ethip_atrans_t, atrans) {
-		if (atrans->ip_addr == ip_addr)
-			return atrans;
-	}
+	ht_link_t *link = hash_table_find(&atrans_table, &ip_addr);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, ethip_atrans_t, atrans_link);
 }
 
-errno_t atrans_add(addr32_t ip_addr, addr48_t mac_addr)
+static ethip_atrans_t *atrans_create(addr32_t ip_addr)
 {
 	ethip_atrans_t *atrans;
-	ethip_atrans_t *prev;
 
 	atrans = calloc(1, sizeof(ethip_atrans_t));
 	if (atrans == NULL)
-		return ENOMEM;
+		return NULL;
 
 	atrans->ip_addr = ip_addr;
-	addr48(mac_addr, atrans->mac_addr);
+	list_initialize(&atrans->pending);
+	hash_table_insert(&atrans_table, &atrans->atrans_link);
+	return atrans;
+}
 
-	fibril_mutex_lock(&atrans_list_lock);
-	prev = atrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->atrans_list);
-		free(prev);
+/** Remove entry from table, moving its pending frames to @a frames. */
+static void atrans_destroy(ethip_atrans_t *atrans, list_t *frames)
+{
+	hash_table_remove_item(&atrans_table, &atrans->atrans_link);
+	atrans_stats.dropped += atrans->npending;
+	list_concat(frames, &atrans->pending);
+	free(atrans);
+}
+
+static void atrans_frames_free(list_t *frames)
+{
+	list_foreach_safe(*frames, cur, next) {
+		ethip_atrans_frame_t *frame = list_get_instance(cur,
+		    ethip_atrans_frame_t, link);
+		list_remove(&frame->link);
+		free(frame->data);
+		free(frame);
+	}
+}
+
+/** Send frames that were waiting for resolution of @a mac_addr. */
+static void atrans_frames_send(list_t *frames, addr48_t mac_addr)
+{
+	list_foreach_safe(*frames, cur, next) {
+		ethip_atrans_frame_t *frame = list_get_instance(cur,
+		    ethip_atrans_frame_t, link);
+		list_remove(&frame->link);
+		eth_pdu_set_dest(frame->data, mac_addr);
+		(void) ethip_nic_send(frame->nic, frame->data, frame->size);
+		free(frame->data);
+		free(frame);
 	}
+}
+
+/** Age one entry.
+ *
+ * Resends requests for addresses being resolved, demotes entries that
+ * have not been confirmed recently and removes failed or unused entries.
+ */
+static bool atrans_age_entry(ht_link_t *item, void *arg)
+{
+	ethip_atrans_age_t *age = (ethip_atrans_age_t *) arg;
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_link);
+	ethip_atrans_probe_t *probe;
+
+	switch (atrans->state) {
+	case as_incomplete:
+	case as_probe:
+		if (age->now - atrans->probe_time < ATRANS_RETRANS_TIME)
+			break;
+
+		if (atrans->probes >= ATRANS_MAX_PROBES) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Neighbour 0x%" PRIx32
+			    " not reachable.", atrans->ip_addr);
+			++atrans_stats.failed;
+			++age->removed;
+			atrans_destroy(atrans, &age->dropped);
+			break;
+		}
+
+		/* Rest is retried in the next pass */
+		if (age->nprobes >= ATRANS_AGE_PROBES)
+			break;
 
-	list_append(&atrans->atrans_list, &atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
+		probe = &age->probes[age->nprobes++];
+		probe->nic = atrans->nic;
+		probe->src_addr = atrans->src_addr;
+		probe->ip_addr = atrans->ip_addr;
+		addr48(atrans->mac_addr, probe->mac_addr);
+		probe->unicast = atrans->state == as_probe;
+
+		++atrans->probes;
+		atrans->probe_time = age->now;
+		break;
+	case as_reachable:
+		if (age->now - atrans->confirmed >= ATRANS_REACHABLE_TIME)
+			atrans->state = as_stale;
+		break;
+	case as_stale:
+		if (age->now - atrans->used >= ATRANS_GC_TIME) {
+			++atrans_stats.expired;
+			++age->removed;
+			atrans_destroy(atrans, &age->dropped);
+		}
+		break;
+	}
+
+	return true;
+}
+
+/** Periodically age address translation entries. */
+static errno_t atrans_age_fibril(void *arg)
+{
+	ethip_atrans_age_t age;
+	ethip_atrans_probe_t *probe;
+	size_t i;
+
+	list_initialize(&age.dropped);
+
+	while (true) {
+		fibril_usleep(ATRANS_AGE_INTERVAL);
+
+		age.now = atrans_now();
+		age.nprobes = 0;
+		age.removed = 0;
+
+		fibril_mutex_lock(&atrans_lock);
+		hash_table_apply(&atrans_table, atrans_age_entry, &age);
+		atrans_stats.requests += age.nprobes;
+		fibril_mutex_unlock(&atrans_lock);
+
+		for (i = 0; i < age.nprobes; i++) {
+			probe = &age.probes[i];
+			(void) arp_send_request(probe->nic, probe->src_addr,
+			    probe->ip_addr, probe->unicast ? probe->mac_addr :
+			    NULL);
+		}
+
+		atrans_frames_free(&age.dropped);
+
+		if (age.removed > 0) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Address translation: "
+			    "%zu entries, %zu lookups, %zu hits, %zu misses, "
+			    "%zu coalesced, %zu requests, %zu queued, "
+			    "%zu dropped, %zu failed, %zu expired",
+			    hash_table_size(&atrans_table),
+			    atrans_stats.lookups, atrans_stats.hits,
+			    atrans_stats.misses, atrans_stats.coalesced,
+			    atrans_stats.requests, atrans_stats.queued,
+			    atrans_stats.dropped, atrans_stats.failed,
+			    atrans_stats.expired);
+		}
+	}
 
 	return EOK;
 }
 
-errno_t atrans_remove(addr32_t ip_addr)
+/** Initialize address translation table.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_init(void)
+{
+	fid_t fid;
+
+	if (!hash_table_create(&atrans_table, 0, 0, &atrans_ops))
+		return ENOMEM;
+
+	fid = fibril_create(atrans_age_fibril, NULL);
+	if (fid == 0) {
+		hash_table_destroy(&atrans_table);
+		return ENOMEM;
+	}
+
+	fibril_add_ready(fid);
+	return EOK;
+}
+
+/** Add or confirm address translation.
+ *
+ * Frames waiting for resolution of @a ip_addr are sent.
+ *
+ * @param ip_addr IPv4 address
+ * @param mac_addr MAC address of the neighbour
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_add(addr32_t ip_addr, addr48_t mac_addr)
 {
 	ethip_atrans_t *atrans;
+	list_t frames;
+
+	list_initialize(&frames);
+
+	fibril_mutex_lock(&atrans_lock);
 
-	fibril_mutex_lock(&atrans_list_lock);
 	atrans = atrans_find(ip_addr);
 	if (atrans == NULL) {
-		fibril_mutex_unlock(&atrans_list_lock);
-		return ENOENT;
+		atrans = atrans_create(ip_addr);
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_lock);
+			return ENOMEM;
+		}
+
+		atrans->used = atrans_now();
 	}
 
-	list_remove(&atrans->atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	free(atrans);
+	addr48(mac_addr, atrans->mac_addr);
+	atrans->state = as_reachable;
+	atrans->confirmed = atrans_now();
+	atrans->probes = 0;
+
+	list_concat(&frames, &atrans->pending);
+	atrans->npending = 0;
 
+	fibril_mutex_unlock(&atrans_lock);
+
+	atrans_frames_send(&frames, mac_addr);
 	return EOK;
 }
 
-static errno_t atrans_lookup_locked(addr32_t ip_addr, addr48_t mac_addr)
+/** Remove address translation.
+ *
+ * Frames waiting for resolution of @a ip_addr are dropped.
+ *
+ * @param ip_addr IPv4 address
+ * @return EOK on success, ENOENT if there is no such entry
+ */
+errno_t atrans_remove(addr32_t ip_addr)
 {
-	ethip_atrans_t *atrans = atrans_find(ip_addr);
-	if (atrans == NULL)
+	ethip_atrans_t *atrans;
+	list_t frames;
+
+	list_initialize(&frames);
+
+	fibril_mutex_lock(&atrans_lock);
+	atrans = atrans_find(ip_addr);
+	if (atrans == NULL) {
+		fibril_mutex_unlock(&atrans_lock);
 		return ENOENT;
+	}
+
+	atrans_destroy(atrans, &frames);
+	fibril_mutex_unlock(&atrans_lock);
 
-	addr48(atrans->mac_addr, mac_addr);
+	atrans_frames_free(&frames);
 	return EOK;
 }
 
-errno_t atrans_lookup(addr32_t ip_addr, addr48_t mac_addr)
+/** Send frame to neighbour, resolving its address if needed.
+ *
+ * If the address is not known yet, the frame is queued and sent once
+ * resolution completes. Only the first sender triggers an ARP request.
+ * Entries that have not been confirmed for a while are used right away
+ * and refreshed in the background.
+ *
+ * @param nic NIC
+ * @param src_addr Source address for ARP requests
+ * @param ip_addr Destination IPv4 address
+ * @param data Encoded Ethernet frame whose destination address is to be
+ *             filled in. Ownership is passed to this function.
+ * @param size Frame size
+ * @return EOK if the frame was sent or queued, error code otherwise
+ */
+errno_t atrans_send(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    void *data, size_t size)
 {
+	ethip_atrans_t *atrans;
+	ethip_atrans_frame_t *frame;
+	addr48_t mac_addr;
+	bool request = false;
+	usec_t now;
 	errno_t rc;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	rc = atrans_lookup_locked(ip_addr, mac_addr);
-	fibril_mutex_unlock(&atrans_list_lock);
+	now = atrans_now();
 
-	return rc;
-}
+	fibril_mutex_lock(&atrans_lock);
+	++atrans_stats.lookups;
 
-static void atrans_lookup_timeout_handler(void *arg)
-{
-	bool *timedout = (bool *)arg;
+	atrans = atrans_find(ip_addr);
+	if (atrans != NULL && atrans->state != as_incomplete) {
+		++atrans_stats.hits;
+		addr48(atrans->mac_addr, mac_addr);
+		atrans->used = now;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	*timedout = true;
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
-}
+		if (atrans->state == as_stale) {
+			/* Refresh in the background */
+			atrans->state = as_probe;
+			atrans->nic = nic;
+			atrans->src_addr = src_addr;
+			atrans->probes = 1;
+			atrans->probe_time = now;
+			++atrans_stats.requests;
+			request = true;
+		}
 
-errno_t atrans_lookup_timeout(addr32_t ip_addr, usec_t timeout,
-    addr48_t mac_addr)
-{
-	fibril_timer_t *t;
-	bool timedout;
-	errno_t rc;
+		fibril_mutex_unlock(&atrans_lock);
+
+		if (request)
+			(void) arp_send_request(nic, src_addr, ip_addr, mac_addr);
+
+		eth_pdu_set_dest(data, mac_addr);
+		rc = ethip_nic_send(nic, data, size);
+		free(data);
+		return rc;
+	}
+
+	++atrans_stats.misses;
 
-	t = fibril_timer_create(NULL);
-	if (t == NULL)
+	frame = calloc(1, sizeof(ethip_atrans_frame_t));
+	if (frame == NULL) {
+		fibril_mutex_unlock(&atrans_lock);
+		free(data);
 		return ENOMEM;
+	}
+
+	if (atrans == NULL) {
+		atrans = atrans_create(ip_addr);
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_lock);
+			free(frame);
+			free(data);
+			return ENOMEM;
+		}
 
-	timedout = false;
-	fibril_timer_set(t, timeout, atrans_lookup_timeout_handler, &timedout);
+		atrans->state = as_incomplete;
+		atrans->nic = nic;
+		atrans->src_addr = src_addr;
+		atrans->probes = 1;
+		atrans->probe_time = now;
+		++atrans_stats.requests;
+		request = true;
+	} else {
+		++atrans_stats.coalesced;
+	}
 
-	fibril_mutex_lock(&atrans_list_lock);
+	atrans->used = now;
 
-	while ((rc = atrans_lookup_locked(ip_addr, mac_addr)) == ENOENT &&
-	    !timedout) {
-		fibril_condvar_wait(&atrans_cv, &atrans_list_lock);
+	if (atrans->npending >= ATRANS_MAX_PENDING) {
+		/* Drop the oldest frame */
+		ethip_atrans_frame_t *old = list_get_instance(
+		    list_first(&atrans->pending), ethip_atrans_frame_t, link);
+		list_remove(&old->link);
+		--atrans->npending;
+		++atrans_stats.dropped;
+		free(old->data);
+		free(old);
 	}
 
-	fibril_mutex_unlock(&atrans_list_lock);
-	(void) fibril_timer_clear(t);
-	fibril_timer_destroy(t);
+	link_initialize(&frame->link);
+	frame->nic = nic;
+	frame->data = data;
+	frame->size = size;
+	list_append(&frame->link, &atrans->pending);
+	++atrans->npending;
+	++atrans_stats.queued;
 
-	return rc;
+	fibril_mutex_unlock(&atrans_lock);
+
+	if (request)
+		(void) arp_send_request(nic, src_addr, ip_addr, NULL);
+
+	return EOK;
 }
 
 /** @}
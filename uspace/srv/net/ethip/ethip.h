@@ -37,13 +37,17 @@
 #ifndef ETHIP_H_
 #define ETHIP_H_
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <async.h>
+#include <fibril_synch.h>
 #include <inet/iplink_srv.h>
 #include <inet/addr.h>
 #include <loc.h>
+#include <pktpool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 typedef struct {
 	link_t link;
@@ -67,6 +71,13 @@ typedef struct ethip_nic {
 	 * (of the type ethip_link_addr_t)
 	 */
 	list_t addr_list;
+
+	/** Receive buffer pool shared with the NIC driver or NULL */
+	pktpool_t *rx_pool;
+	/** Shared area of the receive buffer pool */
+	void *rx_pool_area;
+	/** Serializes draining of the receive buffer pool */
+	fibril_mutex_t rx_pool_lock;
 } ethip_nic_t;
 
 /** Ethernet frame */
@@ -108,13 +119,65 @@ typedef struct {
 	addr32_t target_proto_addr;
 } arp_eth_packet_t;
 
+/** Address translation entry state */
+typedef enum {
+	/** Address resolution in progress */
+	as_incomplete,
+	/** Recently confirmed by the neighbour */
+	as_reachable,
+	/** Not confirmed recently, refreshed when used */
+	as_stale,
+	/** Being refreshed by a unicast request */
+	as_probe
+} ethip_atrans_state_t;
+
 /** Address translation table element */
 typedef struct {
-	link_t atrans_list;
+	/** Link to address translation table */
+	ht_link_t atrans_link;
 	addr32_t ip_addr;
 	addr48_t mac_addr;
+	ethip_atrans_state_t state;
+	/** NIC used to send requests */
+	ethip_nic_t *nic;
+	/** Source address used in requests */
+	addr32_t src_addr;
+	/** Number of requests sent without reply */
+	unsigned probes;
+	/** Uptime when the last request was sent */
+	usec_t probe_time;
+	/** Uptime when the neighbour was last confirmed */
+	usec_t confirmed;
+	/** Uptime when the entry was last used */
+	usec_t used;
+	/** Frames waiting for address resolution */
+	list_t pending;
+	/** Number of frames in @c pending */
+	size_t npending;
 } ethip_atrans_t;
 
+/** Address translation statistics */
+typedef struct {
+	/** Number of lookups */
+	size_t lookups;
+	/** Lookups that found a resolved entry */
+	size_t hits;
+	/** Lookups that found no resolved entry */
+	size_t misses;
+	/** Misses that joined a resolution already in progress */
+	size_t coalesced;
+	/** ARP requests sent */
+	size_t requests;
+	/** Frames queued waiting for resolution */
+	size_t queued;
+	/** Queued frames dropped */
+	size_t dropped;
+	/** Resolutions that timed out */
+	size_t failed;
+	/** Entries removed for not being used */
+	size_t expired;
+} ethip_atrans_stats_t;
+
 extern errno_t ethip_iplink_init(ethip_nic_t *);
 extern errno_t ethip_received(iplink_srv_t *, void *, size_t);
 
@@ -35,6 +35,8 @@
  */
 
 #include <adt/list.h>
+#include <align.h>
+#include <as.h>
 #include <async.h>
 #include <stdbool.h>
 #include <errno.h>
@@ -43,13 +45,21 @@
 #include <inet/iplink_srv.h>
 #include <io/log.h>
 #include <loc.h>
+#include <macros.h>
 #include <nic_iface.h>
+#include <pktpool.h>
 #include <stdlib.h>
 #include <mem.h>
 #include "ethip.h"
 #include "ethip_nic.h"
 #include "pdu.h"
 
+/** Number of buffers in the receive buffer pool shared with a NIC */
+#define ETHIP_RX_POOL_COUNT  256
+
+/** Size of a receive buffer, enough for a tagged Ethernet frame */
+#define ETHIP_RX_POOL_BUF_SIZE  2048
+
 static errno_t ethip_nic_open(service_id_t sid);
 static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg);
 
@@ -114,6 +124,7 @@ static ethip_nic_t *ethip_nic_new(void)
 
 	link_initialize(&nic->link);
 	list_initialize(&nic->addr_list);
+	fibril_mutex_initialize(&nic->rx_pool_lock);
 
 	return nic;
 }
@@ -138,6 +149,11 @@ static void ethip_nic_delete(ethip_nic_t *nic)
 	if (nic->svc_name != NULL)
 		free(nic->svc_name);
 
+	if (nic->rx_pool != NULL) {
+		pktpool_destroy(nic->rx_pool);
+		as_area_destroy(nic->rx_pool_area);
+	}
+
 	free(nic);
 }
 
@@ -146,6 +162,70 @@ static void ethip_link_addr_delete(ethip_link_addr_t *laddr)
 	free(laddr);
 }
 
+/** Process all frames posted to the receive buffer pool.
+ *
+ * The frames are processed in place and their buffers handed back to
+ * the driver, so the frame data are never copied between the tasks.
+ * Must be called with @c rx_pool_lock held.
+ */
+static void ethip_nic_rx_pool_drain(ethip_nic_t *nic)
+{
+	size_t idx;
+	size_t size;
+
+	assert(fibril_mutex_is_locked(&nic->rx_pool_lock));
+
+	if (nic->rx_pool == NULL)
+		return;
+
+	while (pktpool_fetch(nic->rx_pool, &idx, &size)) {
+		(void) ethip_received(&nic->iplink,
+		    pktpool_data(nic->rx_pool, idx), size);
+		pktpool_release(nic->rx_pool, idx);
+	}
+}
+
+/** Set up a receive buffer pool shared with the NIC driver.
+ *
+ * If the driver does not support it, received frames keep being
+ * delivered with NIC_EV_RECEIVED.
+ */
+static void ethip_nic_rx_pool_init(ethip_nic_t *nic)
+{
+	pktpool_t *pool;
+	void *area;
+	size_t size;
+	errno_t rc;
+
+	rc = nic_rx_pool_create(nic->sess, ETHIP_RX_POOL_COUNT,
+	    ETHIP_RX_POOL_BUF_SIZE, &area, &size);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "No receive buffer pool for "
+		    "'%s': %s.", nic->svc_name, str_error_name(rc));
+		return;
+	}
+
+	rc = pktpool_attach(area, size, &pool);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Invalid receive buffer pool "
+		    "from '%s'.", nic->svc_name);
+		as_area_destroy(area);
+		return;
+	}
+
+	fibril_mutex_lock(&nic->rx_pool_lock);
+	nic->rx_pool = pool;
+	nic->rx_pool_area = area;
+
+	/*
+	 * The driver may have posted frames (and notified us) before
+	 * the pool was published. It only notifies again once the ring
+	 * becomes empty, so pick up anything that is already there.
+	 */
+	ethip_nic_rx_pool_drain(nic);
+	fibril_mutex_unlock(&nic->rx_pool_lock);
+}
+
 static errno_t ethip_nic_open(service_id_t sid)
 {
 	bool in_list = false;
@@ -177,6 +257,8 @@ static errno_t ethip_nic_open(service_id_t sid)
 		goto error;
 	}
 
+	ethip_nic_rx_pool_init(nic);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Opened NIC '%s'", nic->svc_name);
 	list_append(&nic->link, &ethip_nic_list);
 	in_list = true;
@@ -282,6 +364,51 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+static void ethip_nic_received_batch(ethip_nic_t *nic, ipc_call_t *call)
+{
+	errno_t rc;
+	uint8_t *data;
+	size_t size;
+	size_t offs;
+	uint32_t fsize;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_batch() nic=%p",
+	    nic);
+
+	rc = async_data_write_accept((void **) &data, false, 0, 0, 0, &size);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "data_write_accept() failed");
+		return;
+	}
+
+	offs = 0;
+	while (size - offs >= sizeof(uint32_t)) {
+		memcpy(&fsize, data + offs, sizeof(uint32_t));
+		offs += sizeof(uint32_t);
+
+		if (fsize > size - offs) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Truncated frame batch");
+			break;
+		}
+
+		(void) ethip_received(&nic->iplink, data + offs, fsize);
+		offs += min(ALIGN_UP(fsize, NIC_EV_BATCH_ALIGN), size - offs);
+	}
+
+	free(data);
+	async_answer_0(call, EOK);
+}
+
+/** Process frames posted to the receive buffer pool. */
+static void ethip_nic_rx_pool(ethip_nic_t *nic, ipc_call_t *call)
+{
+	async_answer_0(call, EOK);
+
+	fibril_mutex_lock(&nic->rx_pool_lock);
+	ethip_nic_rx_pool_drain(nic);
+	fibril_mutex_unlock(&nic->rx_pool_lock);
+}
+
 static void ethip_nic_device_state(ethip_nic_t *nic, ipc_call_t *call)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
@@ -313,6 +440,12 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 		case NIC_EV_DEVICE_STATE:
 			ethip_nic_device_state(nic, &call);
 			break;
+		case NIC_EV_RX_POOL:
+			ethip_nic_rx_pool(nic, &call);
+			break;
+		case NIC_EV_RECEIVED_BATCH:
+			ethip_nic_received_batch(nic, &call);
+			break;
 		default:
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "unknown IPC method: %" PRIun, ipc_get_imethod(&call));
 			async_answer_0(&call, ENOTSUP);
@@ -73,6 +73,14 @@ errno_t eth_pdu_encode(eth_frame_t *frame, void **rdata, size_t *rsize)
 	return EOK;
 }
 
+/** Set destination address of encoded Ethernet PDU. */
+void eth_pdu_set_dest(void *data, const addr48_t dest)
+{
+	eth_header_t *hdr = (eth_header_t *)data;
+
+	addr48(dest, hdr->dest);
+}
+
 /** Decode Ethernet PDU. */
 errno_t eth_pdu_decode(void *data, size_t size, eth_frame_t *frame)
 {
@@ -57,6 +57,7 @@
 #include "inetcfg.h"
 #include "inetping.h"
 #include "inet_link.h"
+#include "ntrans.h"
 #include "reass.h"
 #include "sroute.h"
 
@@ -83,12 +84,30 @@ static LIST_INITIALIZE(client_list);
 
 static void inet_default_conn(ipc_call_t *, void *);
 
+static inet_reass_cb_t inet_reass_cb = {
+	.dgram_reassembled = inet_recv_dgram_local
+};
+
 static errno_t inet_init(void)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_init()");
 
+	errno_t rc = ntrans_init();
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing neighbour "
+		    "cache.");
+		return rc;
+	}
+
+	rc = inet_reass_init(&inet_reass_cb);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing datagram "
+		    "reassembly.");
+		return rc;
+	}
+
 	port_id_t port;
-	errno_t rc = async_create_port(INTERFACE_INET,
+	rc = async_create_port(INTERFACE_INET,
 	    inet_default_conn, NULL, &port);
 	if (rc != EOK)
 		return rc;
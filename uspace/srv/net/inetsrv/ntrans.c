@@ -34,17 +34,120 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <inet/iplink_srv.h>
+#include <io/log.h>
+#include <mem.h>
 #include <stdlib.h>
+#include <time.h>
+#include "inet_link.h"
+#include "ndp.h"
 #include "ntrans.h"
 
-/** Address translation list (of inet_ntrans_t) */
-static FIBRIL_MUTEX_INITIALIZE(ntrans_list_lock);
-static LIST_INITIALIZE(ntrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
+/** Time for which a confirmed neighbour is considered reachable */
+#define NTRANS_REACHABLE_TIME SEC2USEC(30)
+/** Time between solicitations for the same address */
+#define NTRANS_RETRANS_TIME SEC2USEC(1)
+/** Number of unanswered solicitations after which resolution fails */
+#define NTRANS_MAX_PROBES 3
+/** Time after which an unused stale entry is removed */
+#define NTRANS_GC_TIME SEC2USEC(60)
+/** Maximum number of datagrams queued per unresolved neighbour */
+#define NTRANS_MAX_PENDING 8
+/** Interval of the aging pass */
+#define NTRANS_AGE_INTERVAL SEC2USEC(1)
+/** Maximum number of solicitations sent per aging pass */
+#define NTRANS_AGE_PROBES 16
+
+/** Datagram waiting for address resolution */
+typedef struct {
+	link_t link;
+	inet_link_t *ilink;
+	/** Datagram (with its own copy of the data) */
+	inet_dgram_t dgram;
+	uint8_t proto;
+	uint8_t ttl;
+	int df;
+} inet_ntrans_dgram_t;
+
+/** Neighbour solicitation to send after an aging pass */
+typedef struct {
+	inet_link_t *ilink;
+	addr128_t src_addr;
+	addr128_t ip_addr;
+	addr48_t mac_addr;
+	bool unicast;
+} inet_ntrans_probe_t;
+
+/** State of an aging pass */
+typedef struct {
+	usec_t now;
+	/** Solicitations to send */
+	inet_ntrans_probe_t probes[NTRANS_AGE_PROBES];
+	size_t nprobes;
+	/** Datagrams to drop (of inet_ntrans_dgram_t) */
+	list_t dropped;
+	/** Number of entries removed */
+	size_t removed;
+} inet_ntrans_age_t;
+
+/** Address translation table (of inet_ntrans_t) */
+static FIBRIL_MUTEX_INITIALIZE(ntrans_lock);
+static hash_table_t ntrans_table;
+static inet_ntrans_stats_t ntrans_stats;
+
+static size_t ntrans_ip_hash(const addr128_t ip_addr)
+{
+	size_t hash = 0;
+	size_t i;
+
+	for (i = 0; i < sizeof(addr128_t); i++)
+		hash = hash_combine(hash, ip_addr[i]);
+
+	return hash;
+}
+
+static size_t ntrans_hash(const ht_link_t *item)
+{
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_link);
+
+	return ntrans_ip_hash(ntrans->ip_addr);
+}
+
+static size_t ntrans_key_hash(const void *key)
+{
+	return ntrans_ip_hash((const uint8_t *) key);
+}
+
+static bool ntrans_key_equal(const void *key, const ht_link_t *item)
+{
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_link);
+
+	return addr128_compare(ntrans->ip_addr, (const uint8_t *) key);
+}
+
+static hash_table_ops_t ntrans_ops = {
+	.hash = ntrans_hash,
+	.key_hash = ntrans_key_hash,
+	.key_equal = ntrans_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static usec_t ntrans_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
 
 /** Look for address in translation table
  *
@@ -55,114 +158,393 @@ static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
  */
 static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
 {
-	list_foreach(ntrans_list, ntrans_list, inet_ntrans_t, ntrans) {
-		if (addr128_compare(ntrans->ip_addr, ip_addr))
-			return ntrans;
+	ht_link_t *link = hash_table_find(&ntrans_table, ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, inet_ntrans_t, ntrans_link);
+}
+
+static inet_ntrans_t *ntrans_create(addr128_t ip_addr)
+{
+	inet_ntrans_t *ntrans;
+
+	ntrans = calloc(1, sizeof(inet_ntrans_t));
+	if (ntrans == NULL)
+		return NULL;
+
+	addr128(ip_addr, ntrans->ip_addr);
+	list_initialize(&ntrans->pending);
+	hash_table_insert(&ntrans_table, &ntrans->ntrans_link);
+	return ntrans;
+}
+
+/** Remove entry from table, moving its pending datagrams to @a dgrams. */
+static void ntrans_destroy(inet_ntrans_t *ntrans, list_t *dgrams)
+{
+	hash_table_remove_item(&ntrans_table, &ntrans->ntrans_link);
+	ntrans_stats.dropped += ntrans->npending;
+	list_concat(dgrams, &ntrans->pending);
+	free(ntrans);
+}
+
+static void ntrans_dgram_free(inet_ntrans_dgram_t *pdgram)
+{
+	free(pdgram->dgram.data);
+	free(pdgram);
+}
+
+static void ntrans_dgrams_free(list_t *dgrams)
+{
+	list_foreach_safe(*dgrams, cur, next) {
+		inet_ntrans_dgram_t *pdgram = list_get_instance(cur,
+		    inet_ntrans_dgram_t, link);
+		list_remove(&pdgram->link);
+		ntrans_dgram_free(pdgram);
 	}
+}
 
-	return NULL;
+/** Send datagrams that were waiting for resolution of @a mac_addr. */
+static void ntrans_dgrams_send(list_t *dgrams, addr48_t mac_addr)
+{
+	list_foreach_safe(*dgrams, cur, next) {
+		inet_ntrans_dgram_t *pdgram = list_get_instance(cur,
+		    inet_ntrans_dgram_t, link);
+		list_remove(&pdgram->link);
+		(void) inet_link_send_dgram6(pdgram->ilink, mac_addr,
+		    &pdgram->dgram, pdgram->proto, pdgram->ttl, pdgram->df);
+		ntrans_dgram_free(pdgram);
+	}
 }
 
-/** Add entry to translation table
+/** Age one entry.
  *
- * @param ip_addr  IPv6 address of the new entry
- * @param mac_addr MAC address of the new entry
+ * Resends solicitations for addresses being resolved, demotes entries
+ * that have not been confirmed recently and removes failed or unused
+ * entries.
+ */
+static bool ntrans_age_entry(ht_link_t *item, void *arg)
+{
+	inet_ntrans_age_t *age = (inet_ntrans_age_t *) arg;
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_link);
+	inet_ntrans_probe_t *probe;
+
+	switch (ntrans->state) {
+	case ns_incomplete:
+	case ns_probe:
+		if (age->now - ntrans->probe_time < NTRANS_RETRANS_TIME)
+			break;
+
+		if (ntrans->probes >= NTRANS_MAX_PROBES) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Neighbour not "
+			    "reachable.");
+			++ntrans_stats.failed;
+			++age->removed;
+			ntrans_destroy(ntrans, &age->dropped);
+			break;
+		}
+
+		/* Rest is retried in the next pass */
+		if (age->nprobes >= NTRANS_AGE_PROBES)
+			break;
+
+		probe = &age->probes[age->nprobes++];
+		probe->ilink = ntrans->ilink;
+		addr128(ntrans->src_addr, probe->src_addr);
+		addr128(ntrans->ip_addr, probe->ip_addr);
+		addr48(ntrans->mac_addr, probe->mac_addr);
+		probe->unicast = ntrans->state == ns_probe;
+
+		++ntrans->probes;
+		ntrans->probe_time = age->now;
+		break;
+	case ns_reachable:
+		if (age->now - ntrans->confirmed >= NTRANS_REACHABLE_TIME)
+			ntrans->state = ns_stale;
+		break;
+	case ns_stale:
+		if (age->now - ntrans->used >= NTRANS_GC_TIME) {
+			++ntrans_stats.expired;
+			++age->removed;
+			ntrans_destroy(ntrans, &age->dropped);
+		}
+		break;
+	}
+
+	return true;
+}
+
+/** Periodically age address translation entries. */
+static errno_t ntrans_age_fibril(void *arg)
+{
+	inet_ntrans_age_t age;
+	inet_ntrans_probe_t *probe;
+	size_t i;
+
+	list_initialize(&age.dropped);
+
+	while (true) {
+		fibril_usleep(NTRANS_AGE_INTERVAL);
+
+		age.now = ntrans_now();
+		age.nprobes = 0;
+		age.removed = 0;
+
+		fibril_mutex_lock(&ntrans_lock);
+		hash_table_apply(&ntrans_table, ntrans_age_entry, &age);
+		ntrans_stats.requests += age.nprobes;
+		fibril_mutex_unlock(&ntrans_lock);
+
+		for (i = 0; i < age.nprobes; i++) {
+			probe = &age.probes[i];
+			(void) ndp_send_solicit(probe->ilink, probe->src_addr,
+			    probe->ip_addr, probe->unicast ? probe->mac_addr :
+			    NULL);
+		}
+
+		ntrans_dgrams_free(&age.dropped);
+
+		if (age.removed > 0) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Neighbour cache: "
+			    "%zu entries, %zu lookups, %zu hits, %zu misses, "
+			    "%zu coalesced, %zu requests, %zu queued, "
+			    "%zu dropped, %zu failed, %zu expired",
+			    hash_table_size(&ntrans_table),
+			    ntrans_stats.lookups, ntrans_stats.hits,
+			    ntrans_stats.misses, ntrans_stats.coalesced,
+			    ntrans_stats.requests, ntrans_stats.queued,
+			    ntrans_stats.dropped, ntrans_stats.failed,
+			    ntrans_stats.expired);
+		}
+	}
+
+	return EOK;
+}
+
+/** Initialize translation table
  *
  * @return EOK on success
  * @return ENOMEM if not enough memory
  *
  */
-errno_t ntrans_add(addr128_t ip_addr, addr48_t mac_addr)
+errno_t ntrans_init(void)
 {
-	inet_ntrans_t *ntrans;
-	inet_ntrans_t *prev;
+	fid_t fid;
 
-	ntrans = calloc(1, sizeof(inet_ntrans_t));
-	if (ntrans == NULL)
+	if (!hash_table_create(&ntrans_table, 0, 0, &ntrans_ops))
 		return ENOMEM;
 
-	addr128(ip_addr, ntrans->ip_addr);
-	addr48(mac_addr, ntrans->mac_addr);
-
-	fibril_mutex_lock(&ntrans_list_lock);
-	prev = ntrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->ntrans_list);
-		free(prev);
+	fid = fibril_create(ntrans_age_fibril, NULL);
+	if (fid == 0) {
+		hash_table_destroy(&ntrans_table);
+		return ENOMEM;
 	}
 
-	list_append(&ntrans->ntrans_list, &ntrans_list);
-	fibril_mutex_unlock(&ntrans_list_lock);
-	fibril_condvar_broadcast(&ntrans_cv);
-
+	fibril_add_ready(fid);
 	return EOK;
 }
 
-/** Remove entry from translation table
+/** Add or confirm entry in translation table
  *
- * @param ip_addr IPv6 address of the entry to be removed
+ * Datagrams waiting for resolution of @a ip_addr are sent.
+ *
+ * @param ip_addr  IPv6 address of the new entry
+ * @param mac_addr MAC address of the new entry
  *
  * @return EOK on success
- * @return ENOENT when no such address found
+ * @return ENOMEM if not enough memory
  *
  */
-errno_t ntrans_remove(addr128_t ip_addr)
+errno_t ntrans_add(addr128_t ip_addr, addr48_t mac_addr)
 {
 	inet_ntrans_t *ntrans;
+	list_t dgrams;
+
+	list_initialize(&dgrams);
+
+	fibril_mutex_lock(&ntrans_lock);
 
-	fibril_mutex_lock(&ntrans_list_lock);
 	ntrans = ntrans_find(ip_addr);
 	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
-		return ENOENT;
+		ntrans = ntrans_create(ip_addr);
+		if (ntrans == NULL) {
+			fibril_mutex_unlock(&ntrans_lock);
+			return ENOMEM;
+		}
+
+		ntrans->used = ntrans_now();
 	}
 
-	list_remove(&ntrans->ntrans_list);
-	fibril_mutex_unlock(&ntrans_list_lock);
-	free(ntrans);
+	addr48(mac_addr, ntrans->mac_addr);
+	ntrans->state = ns_reachable;
+	ntrans->confirmed = ntrans_now();
+	ntrans->probes = 0;
+
+	list_concat(&dgrams, &ntrans->pending);
+	ntrans->npending = 0;
 
+	fibril_mutex_unlock(&ntrans_lock);
+
+	ntrans_dgrams_send(&dgrams, mac_addr);
 	return EOK;
 }
 
-/** Translate IPv6 address to MAC address using the translation table
+/** Remove entry from translation table
  *
- * @param ip_addr  IPv6 address to be translated
- * @param mac_addr MAC address to be assigned
+ * Datagrams waiting for resolution of @a ip_addr are dropped.
+ *
+ * @param ip_addr IPv6 address of the entry to be removed
  *
  * @return EOK on success
  * @return ENOENT when no such address found
  *
  */
-errno_t ntrans_lookup(addr128_t ip_addr, addr48_t mac_addr)
+errno_t ntrans_remove(addr128_t ip_addr)
 {
-	fibril_mutex_lock(&ntrans_list_lock);
-	inet_ntrans_t *ntrans = ntrans_find(ip_addr);
+	inet_ntrans_t *ntrans;
+	list_t dgrams;
+
+	list_initialize(&dgrams);
+
+	fibril_mutex_lock(&ntrans_lock);
+	ntrans = ntrans_find(ip_addr);
 	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
+		fibril_mutex_unlock(&ntrans_lock);
 		return ENOENT;
 	}
 
-	fibril_mutex_unlock(&ntrans_list_lock);
-	addr48(ntrans->mac_addr, mac_addr);
+	ntrans_destroy(ntrans, &dgrams);
+	fibril_mutex_unlock(&ntrans_lock);
+
+	ntrans_dgrams_free(&dgrams);
 	return EOK;
 }
 
-/** Wait on translation table CV for some time
+/** Send datagram to neighbour, resolving its address if needed
  *
- * @param timeout Timeout in microseconds
+ * If the address is not known yet, a copy of the datagram is queued and
+ * sent once resolution completes. Only the first sender triggers
+ * a neighbour solicitation. Entries that have not been confirmed for
+ * a while are used right away and refreshed in the background.
  *
- * @return EOK if woken up by another fibril
- * @return ETIMEOUT if timed out
+ * @param ilink    Link to send on
+ * @param src_addr Source IPv6 address for solicitations
+ * @param ip_addr  Link-local destination IPv6 address
+ * @param dgram    Datagram
+ * @param proto    Protocol
+ * @param ttl      Time to live
+ * @param df       Do not fragment flag
+ *
+ * @return EOK if the datagram was sent or queued
+ * @return ENOMEM if not enough memory
  *
  */
-errno_t ntrans_wait_timeout(usec_t timeout)
+errno_t ntrans_send_dgram(inet_link_t *ilink, addr128_t src_addr,
+    addr128_t ip_addr, inet_dgram_t *dgram, uint8_t proto, uint8_t ttl,
+    int df)
 {
-	fibril_mutex_lock(&ntrans_list_lock);
-	errno_t rc = fibril_condvar_wait_timeout(&ntrans_cv, &ntrans_list_lock,
-	    timeout);
-	fibril_mutex_unlock(&ntrans_list_lock);
+	inet_ntrans_t *ntrans;
+	inet_ntrans_dgram_t *pdgram;
+	addr48_t mac_addr;
+	bool request = false;
+	usec_t now;
+
+	now = ntrans_now();
+
+	fibril_mutex_lock(&ntrans_lock);
+	++ntrans_stats.lookups;
 
-	return rc;
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans != NULL && ntrans->state != ns_incomplete) {
+		++ntrans_stats.hits;
+		addr48(ntrans->mac_addr, mac_addr);
+		ntrans->used = now;
+
+		if (ntrans->state == ns_stale) {
+			/* Refresh in the background */
+			ntrans->state = ns_probe;
+			ntrans->ilink = ilink;
+			addr128(src_addr, ntrans->src_addr);
+			ntrans->probes = 1;
+			ntrans->probe_time = now;
+			++ntrans_stats.requests;
+			request = true;
+		}
+
+		fibril_mutex_unlock(&ntrans_lock);
+
+		if (request)
+			(void) ndp_send_solicit(ilink, src_addr, ip_addr, mac_addr);
+
+		return inet_link_send_dgram6(ilink, mac_addr, dgram, proto, ttl,
+		    df);
+	}
+
+	++ntrans_stats.misses;
+
+	pdgram = calloc(1, sizeof(inet_ntrans_dgram_t));
+	if (pdgram == NULL) {
+		fibril_mutex_unlock(&ntrans_lock);
+		return ENOMEM;
+	}
+
+	pdgram->dgram = *dgram;
+	pdgram->dgram.data = malloc(dgram->size);
+	if (pdgram->dgram.data == NULL) {
+		fibril_mutex_unlock(&ntrans_lock);
+		free(pdgram);
+		return ENOMEM;
+	}
+
+	memcpy(pdgram->dgram.data, dgram->data, dgram->size);
+
+	if (ntrans == NULL) {
+		ntrans = ntrans_create(ip_addr);
+		if (ntrans == NULL) {
+			fibril_mutex_unlock(&ntrans_lock);
+			ntrans_dgram_free(pdgram);
+			return ENOMEM;
+		}
+
+		ntrans->state = ns_incomplete;
+		ntrans->ilink = ilink;
+		addr128(src_addr, ntrans->src_addr);
+		ntrans->probes = 1;
+		ntrans->probe_time = now;
+		++ntrans_stats.requests;
+		request = true;
+	} else {
+		++ntrans_stats.coalesced;
+	}
+
+	ntrans->used = now;
+
+	if (ntrans->npending >= NTRANS_MAX_PENDING) {
+		/* Drop the oldest datagram */
+		inet_ntrans_dgram_t *old = list_get_instance(
+		    list_first(&ntrans->pending), inet_ntrans_dgram_t, link);
+		list_remove(&old->link);
+		--ntrans->npending;
+		++ntrans_stats.dropped;
+		ntrans_dgram_free(old);
+	}
+
+	link_initialize(&pdgram->link);
+	pdgram->ilink = ilink;
+	pdgram->proto = proto;
+	pdgram->ttl = ttl;
+	pdgram->df = df;
+	list_append(&pdgram->link, &ntrans->pending);
+	++ntrans->npending;
+	++ntrans_stats.queued;
+
+	fibril_mutex_unlock(&ntrans_lock);
+
+	if (request)
+		(void) ndp_send_solicit(ilink, src_addr, ip_addr, NULL);
+
+	return EOK;
 }
 
 /** @}
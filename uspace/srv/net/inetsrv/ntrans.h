@@ -37,20 +37,77 @@
 #ifndef NTRANS_H_
 #define NTRANS_H_
 
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <inet/iplink_srv.h>
 #include <inet/addr.h>
+#include <time.h>
+#include "inetsrv.h"
+
+/** Neighbour entry state */
+typedef enum {
+	/** Address resolution in progress */
+	ns_incomplete,
+	/** Recently confirmed by the neighbour */
+	ns_reachable,
+	/** Not confirmed recently, refreshed when used */
+	ns_stale,
+	/** Being refreshed by a unicast solicitation */
+	ns_probe
+} inet_ntrans_state_t;
 
 /** Address translation table element */
 typedef struct {
-	link_t ntrans_list;
+	/** Link to address translation table */
+	ht_link_t ntrans_link;
 	addr128_t ip_addr;
 	addr48_t mac_addr;
+	inet_ntrans_state_t state;
+	/** Link used to send solicitations */
+	inet_link_t *ilink;
+	/** Source address used in solicitations */
+	addr128_t src_addr;
+	/** Number of solicitations sent without reply */
+	unsigned probes;
+	/** Uptime when the last solicitation was sent */
+	usec_t probe_time;
+	/** Uptime when the neighbour was last confirmed */
+	usec_t confirmed;
+	/** Uptime when the entry was last used */
+	usec_t used;
+	/** Datagrams waiting for address resolution */
+	list_t pending;
+	/** Number of datagrams in @c pending */
+	size_t npending;
 } inet_ntrans_t;
 
+/** Address translation statistics */
+typedef struct {
+	/** Number of lookups */
+	size_t lookups;
+	/** Lookups that found a resolved entry */
+	size_t hits;
+	/** Lookups that found no resolved entry */
+	size_t misses;
+	/** Misses that joined a resolution already in progress */
+	size_t coalesced;
+	/** Neighbour solicitations sent */
+	size_t requests;
+	/** Datagrams queued waiting for resolution */
+	size_t queued;
+	/** Queued datagrams dropped */
+	size_t dropped;
+	/** Resolutions that timed out */
+	size_t failed;
+	/** Entries removed for not being used */
+	size_t expired;
+} inet_ntrans_stats_t;
+
+extern errno_t ntrans_init(void);
 extern errno_t ntrans_add(addr128_t, addr48_t);
 extern errno_t ntrans_remove(addr128_t);
-extern errno_t ntrans_lookup(addr128_t, addr48_t);
-extern errno_t ntrans_wait_timeout(usec_t);
+extern errno_t ntrans_send_dgram(inet_link_t *, addr128_t, addr128_t,
+    inet_dgram_t *, uint8_t, uint8_t, int);
 
 #endif
 
@@ -34,63 +34,284 @@
  * @brief Datagram reassembly.
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "inetsrv.h"
 #include "inet_std.h"
 #include "reass.h"
 
-/** Datagram being reassembled.
+/** Default limit on memory held by incomplete datagrams, in bytes */
+#define REASS_MEM_MAX  (1024 * 1024)
+/** Default time to reassemble a datagram since its first fragment */
+#define REASS_TIMEOUT  SEC2USEC(30)
+/** Maximum number of fragments held for one datagram */
+#define REASS_MAX_FRAGS  256
+/** Largest datagram that can be reassembled, in bytes */
+#define REASS_DGRAM_MAX \
+	(FRAG_OFFS_UNIT * (1 << (FF_FRAGOFF_h - FF_FRAGOFF_l + 1)))
+
+/** Datagram reassembly key.
  *
- * Uniquely identified by (source address, destination address, protocol,
- * identification) per RFC 791 sec. 2.3 / Fragmentation.
+ * Uniquely identifies a datagram per RFC 791 sec. 2.3 / Fragmentation.
  */
 typedef struct {
-	link_t map_link;
-	/** List of fragments, @c reass_frag_t */
+	/** Source address */
+	inet_addr_t src;
+	/** Destination address */
+	inet_addr_t dest;
+	/** Protocol */
+	uint8_t proto;
+	/** Identification */
+	uint32_t ident;
+} reass_key_t;
+
+/** Datagram being reassembled. */
+typedef struct {
+	/** Link to @c reass_dgram_map */
+	ht_link_t map_link;
+	/** Link to @c reass_dgram_lru */
+	link_t lru_link;
+	/** Link to @c reass_dgram_age */
+	link_t age_link;
+	/** Datagram key */
+	reass_key_t key;
+	/** Link the first received fragment came from */
+	service_id_t link_id;
+	/** Type of service */
+	uint8_t tos;
+	/** Time the first fragment was received */
+	usec_t created;
+	/** Non-overlapping fragments sorted by offset, @c reass_frag_t */
 	list_t frags;
+	/** Number of fragments */
+	size_t nfrags;
+	/** Number of data bytes received */
+	size_t received;
+	/** @c true once the last fragment has been received */
+	bool size_known;
+	/** Datagram size, valid if @c size_known */
+	size_t size;
+	/** Memory charged to this datagram, in bytes */
+	size_t mem;
 } reass_dgram_t;
 
-/** One datagram fragment */
+/** One datagram fragment.
+ *
+ * Fragment data is allocated together with the structure.
+ */
 typedef struct {
+	/** Link to @c reass_dgram_t.frags */
 	link_t dgram_link;
-	inet_packet_t packet;
+	/** Offset of fragment into datagram, in bytes */
+	size_t offs;
+	/** Fragment data size in bytes */
+	size_t size;
+	/** Fragment data */
+	uint8_t *data;
 } reass_frag_t;
 
-/** Datagram map, list of reass_dgram_t */
-static LIST_INITIALIZE(reass_dgram_map);
-/** Protects access to @c reass_dgram_map */
+/** Callbacks */
+static inet_reass_cb_t *reass_cb;
+/** Datagram map, hash table of reass_dgram_t */
+static hash_table_t reass_dgram_map;
+/** Datagrams ordered from least to most recently updated */
+static LIST_INITIALIZE(reass_dgram_lru);
+/** Datagrams ordered from oldest to newest first fragment */
+static LIST_INITIALIZE(reass_dgram_age);
+/** Memory held by incomplete datagrams, in bytes */
+static size_t reass_mem;
+/** Limit on @c reass_mem */
+static size_t reass_mem_max = REASS_MEM_MAX;
+/** Reassembly timeout */
+static usec_t reass_timeout = REASS_TIMEOUT;
+/** Statistics */
+static inet_reass_stats_t reass_stats;
+/** Protects access to @c reass_dgram_map and associated state */
 static FIBRIL_MUTEX_INITIALIZE(reass_dgram_map_lock);
 
-static reass_dgram_t *reass_dgram_new(void);
-static reass_dgram_t *reass_dgram_get(inet_packet_t *);
+static reass_dgram_t *reass_dgram_get(inet_packet_t *, usec_t);
+static reass_dgram_t *reass_dgram_new(reass_key_t *, inet_packet_t *, usec_t);
 static errno_t reass_dgram_insert_frag(reass_dgram_t *, inet_packet_t *);
 static bool reass_dgram_complete(reass_dgram_t *);
 static void reass_dgram_remove(reass_dgram_t *);
 static errno_t reass_dgram_deliver(reass_dgram_t *);
 static void reass_dgram_destroy(reass_dgram_t *);
+static void reass_expire(usec_t);
+static void reass_evict(void);
+
+static size_t reass_addr_hash(const inet_addr_t *addr)
+{
+	size_t hash = addr->version;
+	size_t i;
+
+	switch (addr->version) {
+	case ip_v4:
+		hash = hash_combine(hash, hash_mix32(addr->addr));
+		break;
+	case ip_v6:
+		for (i = 0; i < 16; i += 4) {
+			hash = hash_combine(hash, hash_mix32(
+			    ((uint32_t) addr->addr6[i] << 24) |
+			    ((uint32_t) addr->addr6[i + 1] << 16) |
+			    ((uint32_t) addr->addr6[i + 2] << 8) |
+			    addr->addr6[i + 3]));
+		}
+		break;
+	default:
+		break;
+	}
+
+	return hash;
+}
+
+static size_t reass_key_hash_fn(const reass_key_t *key)
+{
+	size_t hash;
+
+	hash = hash_mix32(key->ident ^ ((uint32_t) key->proto << 24));
+	hash = hash_combine(hash, reass_addr_hash(&key->src));
+	hash = hash_combine(hash, reass_addr_hash(&key->dest));
+	return hash;
+}
+
+static size_t reass_hash(const ht_link_t *item)
+{
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+
+	return reass_key_hash_fn(&rdg->key);
+}
+
+static size_t reass_key_hash(const void *key)
+{
+	return reass_key_hash_fn((const reass_key_t *) key);
+}
+
+static bool reass_key_equal(const void *key, const ht_link_t *item)
+{
+	const reass_key_t *k = (const reass_key_t *) key;
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+
+	return (rdg->key.ident == k->ident) &&
+	    (rdg->key.proto == k->proto) &&
+	    (inet_addr_compare(&rdg->key.src, &k->src)) &&
+	    (inet_addr_compare(&rdg->key.dest, &k->dest));
+}
+
+static hash_table_ops_t reass_dgram_map_ops = {
+	.hash = reass_hash,
+	.key_hash = reass_key_hash,
+	.key_equal = reass_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static usec_t reass_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+/** Initialize datagram reassembly.
+ *
+ * @param cb		Callbacks invoked to deliver reassembled datagrams
+ * @return		EOK on success or ENOMEM.
+ */
+errno_t inet_reass_init(inet_reass_cb_t *cb)
+{
+	if (!hash_table_create(&reass_dgram_map, 0, 0, &reass_dgram_map_ops))
+		return ENOMEM;
+
+	reass_cb = cb;
+	reass_mem = 0;
+	reass_mem_max = REASS_MEM_MAX;
+	reass_timeout = REASS_TIMEOUT;
+	memset(&reass_stats, 0, sizeof(reass_stats));
+	return EOK;
+}
+
+/** Finalize datagram reassembly.
+ *
+ * Discards all incomplete datagrams.
+ */
+void inet_reass_fini(void)
+{
+	fibril_mutex_lock(&reass_dgram_map_lock);
+
+	while (!list_empty(&reass_dgram_lru)) {
+		reass_dgram_t *rdg = list_get_instance(
+		    list_first(&reass_dgram_lru), reass_dgram_t, lru_link);
+
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+	}
+
+	hash_table_destroy(&reass_dgram_map);
+	fibril_mutex_unlock(&reass_dgram_map_lock);
+}
+
+/** Set reassembly resource limits.
+ *
+ * @param mem_max	Memory that incomplete datagrams may hold, in bytes
+ * @param timeout	Time to reassemble a datagram since its first fragment
+ */
+void inet_reass_set_limits(size_t mem_max, usec_t timeout)
+{
+	fibril_mutex_lock(&reass_dgram_map_lock);
+	reass_mem_max = mem_max;
+	reass_timeout = timeout;
+	reass_evict();
+	fibril_mutex_unlock(&reass_dgram_map_lock);
+}
+
+/** Get reassembly statistics.
+ *
+ * @param stats		Place to store statistics
+ */
+void inet_reass_get_stats(inet_reass_stats_t *stats)
+{
+	fibril_mutex_lock(&reass_dgram_map_lock);
+	*stats = reass_stats;
+	stats->pending = hash_table_size(&reass_dgram_map);
+	stats->mem = reass_mem;
+	fibril_mutex_unlock(&reass_dgram_map_lock);
+}
 
 /** Queue packet for datagram reassembly.
  *
  * @param packet	Packet
- * @return		EOK on success or ENOMEM.
+ * @return		EOK on success or an error code. The packet is not
+ *			retained in any case.
  */
 errno_t inet_reass_queue_packet(inet_packet_t *packet)
 {
 	reass_dgram_t *rdg;
+	usec_t now;
 	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_reass_queue_packet()");
 
+	now = reass_now();
+
 	fibril_mutex_lock(&reass_dgram_map_lock);
 
+	/* Discard datagrams that ran out of time */
+	reass_expire(now);
+
 	/* Get existing or new datagram */
-	rdg = reass_dgram_get(packet);
+	rdg = reass_dgram_get(packet, now);
 	if (rdg == NULL) {
 		/* Only happens when we are out of memory */
 		fibril_mutex_unlock(&reass_dgram_map_lock);
@@ -100,13 +321,25 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 	/* Insert fragment into the datagram */
 	rc = reass_dgram_insert_frag(rdg, packet);
-	if (rc != EOK)
-		return ENOMEM;
+	if (rc != EOK) {
+		if (rc != ENOMEM || rdg->nfrags == 0) {
+			/* Malformed or oversized, drop the whole datagram */
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Invalid fragment, "
+			    "datagram dropped.");
+			reass_dgram_remove(rdg);
+			reass_dgram_destroy(rdg);
+			++reass_stats.dropped;
+		}
+
+		fibril_mutex_unlock(&reass_dgram_map_lock);
+		return rc;
+	}
 
 	/* Check if datagram is complete */
 	if (reass_dgram_complete(rdg)) {
 		/* Remove it from the map */
 		reass_dgram_remove(rdg);
+		++reass_stats.reassembled;
 		fibril_mutex_unlock(&reass_dgram_map_lock);
 
 		/* Deliver complete datagram */
@@ -115,44 +348,101 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 		return rc;
 	}
 
+	/* Mark most recently updated */
+	list_remove(&rdg->lru_link);
+	list_append(&rdg->lru_link, &reass_dgram_lru);
+
+	/* Stay within memory budget */
+	reass_evict();
+
 	fibril_mutex_unlock(&reass_dgram_map_lock);
 	return EOK;
 }
 
+/** Discard datagrams whose reassembly timed out.
+ *
+ * The timeout runs from the first fragment of a datagram, regardless of
+ * fragments received later. Datagrams are visited in the order of their
+ * first fragment, so the walk stops at the first one still within the
+ * timeout.
+ *
+ * @param now		Current time
+ */
+static void reass_expire(usec_t now)
+{
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+
+	while (!list_empty(&reass_dgram_age)) {
+		reass_dgram_t *rdg = list_get_instance(
+		    list_first(&reass_dgram_age), reass_dgram_t, age_link);
+
+		if (now - rdg->created < reass_timeout)
+			break;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly timed out, "
+		    "datagram dropped.");
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+		++reass_stats.timeouts;
+	}
+}
+
+/** Evict least recently updated datagrams to stay within memory budget. */
+static void reass_evict(void)
+{
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+
+	while (reass_mem > reass_mem_max && !list_empty(&reass_dgram_lru)) {
+		reass_dgram_t *rdg = list_get_instance(
+		    list_first(&reass_dgram_lru), reass_dgram_t, lru_link);
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly memory exhausted, "
+		    "datagram dropped.");
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+		++reass_stats.evicted;
+	}
+}
+
 /** Get datagram reassembly structure for packet.
  *
  * @param packet	Packet
+ * @param now		Current time
  * @return		Datagram reassembly structure matching @a packet
+ *			or @c NULL if out of memory
  */
-static reass_dgram_t *reass_dgram_get(inet_packet_t *packet)
+static reass_dgram_t *reass_dgram_get(inet_packet_t *packet, usec_t now)
 {
+	reass_key_t key;
+	ht_link_t *link;
+
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-	list_foreach(reass_dgram_map, map_link, reass_dgram_t, rdg) {
-		link_t *f1_link = list_first(&rdg->frags);
-		assert(f1_link != NULL);
+	memset(&key, 0, sizeof(key));
+	key.src = packet->src;
+	key.dest = packet->dest;
+	key.proto = packet->proto;
+	key.ident = packet->ident;
 
-		reass_frag_t *f1 = list_get_instance(f1_link, reass_frag_t,
-		    dgram_link);
-
-		if ((inet_addr_compare(&f1->packet.src, &packet->src)) &&
-		    (inet_addr_compare(&f1->packet.dest, &packet->dest)) &&
-		    (f1->packet.proto == packet->proto) &&
-		    (f1->packet.ident == packet->ident)) {
-			/* Match */
-			return rdg;
-		}
+	link = hash_table_find(&reass_dgram_map, &key);
+	if (link != NULL) {
+		/* Timed out datagrams were discarded by reass_expire() */
+		return hash_table_get_inst(link, reass_dgram_t, map_link);
 	}
 
 	/* No existing reassembly structure. Create a new one. */
-	return reass_dgram_new();
+	return reass_dgram_new(&key, packet, now);
 }
 
 /** Create new datagram reassembly structure.
  *
+ * @param key		Datagram key
+ * @param packet	First received fragment
+ * @param now		Current time
  * @return New datagram reassembly structure.
  */
-static reass_dgram_t *reass_dgram_new(void)
+static reass_dgram_t *reass_dgram_new(reass_key_t *key, inet_packet_t *packet,
+    usec_t now)
 {
 	reass_dgram_t *rdg;
 
@@ -160,119 +450,166 @@ static reass_dgram_t *reass_dgram_new(void)
 	if (rdg == NULL)
 		return NULL;
 
-	list_append(&rdg->map_link, &reass_dgram_map);
+	rdg->key = *key;
+	rdg->link_id = packet->link_id;
+	rdg->tos = packet->tos;
+	rdg->created = now;
+	rdg->mem = sizeof(reass_dgram_t);
 	list_initialize(&rdg->frags);
 
+	hash_table_insert(&reass_dgram_map, &rdg->map_link);
+	list_append(&rdg->lru_link, &reass_dgram_lru);
+	list_append(&rdg->age_link, &reass_dgram_age);
+	reass_mem += rdg->mem;
+
 	return rdg;
 }
 
-static reass_frag_t *reass_frag_new(void)
+/** Free fragment and release its memory charge.
+ *
+ * @param rdg		Datagram reassembly structure
+ * @param frag		Fragment belonging to @a rdg
+ */
+static void reass_frag_delete(reass_dgram_t *rdg, reass_frag_t *frag)
 {
-	reass_frag_t *frag;
-
-	frag = calloc(1, sizeof(reass_frag_t));
-	if (frag == NULL)
-		return NULL;
-
-	link_initialize(&frag->dgram_link);
-
-	return frag;
+	size_t mem = sizeof(reass_frag_t) + frag->size;
+
+	list_remove(&frag->dgram_link);
+	--rdg->nfrags;
+	rdg->received -= frag->size;
+	rdg->mem -= mem;
+	reass_mem -= mem;
+	free(frag);
 }
 
+/** Insert fragment into datagram.
+ *
+ * Fragments are kept non-overlapping. Data already received is not
+ * stored again, received fragments entirely covered by the new one are
+ * replaced.
+ *
+ * @param rdg		Datagram reassembly structure
+ * @param packet	Fragment
+ * @return		EOK on success (including duplicate fragment),
+ *			EINVAL if fragment is inconsistent with the datagram,
+ *			ELIMIT if datagram would be too large or have too many
+ *			fragments, ENOMEM if out of memory.
+ */
 static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet)
 {
 	reass_frag_t *frag;
-	void *data_copy;
+	link_t *prev;
 	link_t *link;
+	size_t b, e;
 
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-	frag = reass_frag_new();
+	b = packet->offs;
+	e = packet->offs + packet->size;
 
-	/* Clone the packet */
+	if (e > REASS_DGRAM_MAX)
+		return ELIMIT;
 
-	data_copy = malloc(packet->size);
-	if (data_copy == NULL) {
-		free(frag);
-		return ENOMEM;
-	}
+	if (!packet->mf) {
+		/* Last fragment determines datagram size */
+		if (rdg->size_known && rdg->size != e)
+			return EINVAL;
 
-	memcpy(data_copy, packet->data, packet->size);
+		if (!list_empty(&rdg->frags)) {
+			frag = list_get_instance(list_last(&rdg->frags),
+			    reass_frag_t, dgram_link);
+			if (frag->offs + frag->size > e)
+				return EINVAL;
+		}
 
-	frag->packet = *packet;
-	frag->packet.data = data_copy;
+		rdg->size_known = true;
+		rdg->size = e;
+	} else if (rdg->size_known && e > rdg->size) {
+		return EINVAL;
+	}
 
 	/*
-	 * XXX Make resource-consuming attacks harder, eliminate any duplicate
-	 * data immediately. Possibly eliminate redundant packet headers.
+	 * Find the last fragment starting at or before the new one.
+	 * Fragments mostly arrive in order, so search from the end.
 	 */
+	prev = list_last(&rdg->frags);
+	while (prev != NULL) {
+		frag = list_get_instance(prev, reass_frag_t, dgram_link);
+		if (frag->offs <= b)
+			break;
+		prev = list_prev(prev, &rdg->frags);
+	}
 
-	/*
-	 * Insert into the list, which is sorted by offs member ascending.
-	 */
+	/* Skip data already held by the preceding fragment */
+	if (prev != NULL) {
+		frag = list_get_instance(prev, reass_frag_t, dgram_link);
+		if (frag->offs + frag->size > b)
+			b = frag->offs + frag->size;
+	}
 
-	link = list_first(&rdg->frags);
-	while (link != NULL) {
-		reass_frag_t *qf = list_get_instance(link, reass_frag_t,
-		    dgram_link);
+	/* Replace following fragments covered by the new one */
+	link = (prev != NULL) ? list_next(prev, &rdg->frags) :
+	    list_first(&rdg->frags);
+	while (link != NULL && b < e) {
+		frag = list_get_instance(link, reass_frag_t, dgram_link);
+		if (frag->offs >= e)
+			break;
 
-		if (qf->packet.offs >= packet->offs)
+		if (frag->offs + frag->size > e) {
+			/* Partial overlap, keep the data already held */
+			e = frag->offs;
 			break;
+		}
 
 		link = list_next(link, &rdg->frags);
+		reass_frag_delete(rdg, frag);
+	}
+
+	if (b >= e) {
+		/* Duplicate, nothing new */
+		return EOK;
 	}
 
-	if (link != NULL)
-		list_insert_after(&frag->dgram_link, link);
+	if (rdg->nfrags >= REASS_MAX_FRAGS)
+		return ELIMIT;
+
+	frag = malloc(sizeof(reass_frag_t) + (e - b));
+	if (frag == NULL)
+		return ENOMEM;
+
+	link_initialize(&frag->dgram_link);
+	frag->offs = b;
+	frag->size = e - b;
+	frag->data = (uint8_t *) (frag + 1);
+	memcpy(frag->data, (uint8_t *) packet->data + (b - packet->offs),
+	    e - b);
+
+	if (prev != NULL)
+		list_insert_after(&frag->dgram_link, prev);
 	else
-		list_append(&frag->dgram_link, &rdg->frags);
+		list_prepend(&frag->dgram_link, &rdg->frags);
+
+	++rdg->nfrags;
+	rdg->received += frag->size;
+	rdg->mem += sizeof(reass_frag_t) + frag->size;
+	reass_mem += sizeof(reass_frag_t) + frag->size;
 
 	return EOK;
 }
 
 /** Check if datagram is complete.
+ *
+ * Fragments do not overlap, so the datagram is complete once the last
+ * fragment has been seen and all its bytes have been received.
  *
  * @param rdg		Datagram reassembly structure
  * @return		@c true if complete, @c false if not
  */
 static bool reass_dgram_complete(reass_dgram_t *rdg)
 {
-	reass_frag_t *frag, *prev;
-	link_t *link;
-
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	assert(!list_empty(&rdg->frags));
-
-	link = list_first(&rdg->frags);
-	assert(link != NULL);
-
-	frag = list_get_instance(link, reass_frag_t,
-	    dgram_link);
-
-	/* First fragment must be at offset zero */
-	if (frag->packet.offs != 0)
-		return false;
-
-	prev = frag;
-
-	while (true) {
-		link = list_next(link, &rdg->frags);
-		if (link == NULL)
-			break;
-
-		/* Each next fragment must follow immediately or overlap */
-		frag = list_get_instance(link, reass_frag_t, dgram_link);
-		if (frag->packet.offs > prev->packet.offs + prev->packet.size)
-			return false;
-
-		/* No more fragments - datagram is complete */
-		if (!frag->packet.mf)
-			return true;
-
-		prev = frag;
-	}
 
-	return false;
+	return rdg->size_known && rdg->received == rdg->size;
 }
 
 /** Remove datagram from reassembly map.
@@ -282,7 +619,10 @@ static bool reass_dgram_complete(reass_dgram_t *rdg)
 static void reass_dgram_remove(reass_dgram_t *rdg)
 {
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	list_remove(&rdg->map_link);
+	hash_table_remove_item(&reass_dgram_map, &rdg->map_link);
+	list_remove(&rdg->lru_link);
+	list_remove(&rdg->age_link);
+	reass_mem -= rdg->mem;
 }
 
 /** Deliver complete datagram.
@@ -291,75 +631,34 @@ static void reass_dgram_remove(reass_dgram_t *rdg)
  */
 static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
 {
-	size_t dgram_size;
-	size_t fragoff_limit;
 	inet_dgram_t dgram;
-	uint8_t proto;
-	reass_frag_t *frag;
 	errno_t rc;
 
-	/*
-	 * Potentially there could be something beyond the first packet
-	 * that has !MF. Make sure we ignore that.
-	 */
-	frag = NULL;
-	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		if (!cfrag->packet.mf) {
-			frag = cfrag;
-			break;
-		}
-	}
-
-	assert(frag != NULL);
-	assert(!frag->packet.mf);
-
-	dgram_size = frag->packet.offs + frag->packet.size;
-
-	/* Upper bound for fragment offset field */
-	fragoff_limit = 1 << (FF_FRAGOFF_h - FF_FRAGOFF_l + 1);
-
-	/* Verify that total size of datagram is within reasonable bounds */
-	if (dgram_size > FRAG_OFFS_UNIT * fragoff_limit)
-		return ELIMIT;
-
-	dgram.data = calloc(dgram_size, 1);
-	if (dgram.data == NULL)
+	dgram.data = malloc(rdg->size);
+	if (dgram.data == NULL && rdg->size > 0)
 		return ENOMEM;
 
 	/* XXX What if different fragments came from different link? */
-	dgram.iplink = frag->packet.link_id;
-	dgram.size = dgram_size;
-	dgram.src = frag->packet.src;
-	dgram.dest = frag->packet.dest;
-	dgram.tos = frag->packet.tos;
-	proto = frag->packet.proto;
+	dgram.iplink = rdg->link_id;
+	dgram.size = rdg->size;
+	dgram.src = rdg->key.src;
+	dgram.dest = rdg->key.dest;
+	dgram.tos = rdg->tos;
 
 	/* Pull together data from individual fragments */
-
-	size_t doffs = 0;
-
 	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		size_t cb, ce;
-
-		cb = max(doffs, cfrag->packet.offs);
-		ce = min(dgram_size, cfrag->packet.offs + cfrag->packet.size);
-
-		if (ce > cb) {
-			memcpy(dgram.data + cb,
-			    cfrag->packet.data + cb - cfrag->packet.offs,
-			    ce - cb);
-		}
-
-		if (!cfrag->packet.mf)
-			break;
+		memcpy((uint8_t *) dgram.data + cfrag->offs, cfrag->data,
+		    cfrag->size);
 	}
 
-	rc = inet_recv_dgram_local(&dgram, proto);
+	rc = reass_cb->dgram_reassembled(&dgram, rdg->key.proto);
 	free(dgram.data);
 	return rc;
 }
 
 /** Destroy datagram reassembly structure.
+ *
+ * The datagram must have been removed from the map.
  *
  * @param rdg		Datagram reassembly structure.
  */
@@ -371,7 +670,6 @@ static void reass_dgram_destroy(reass_dgram_t *rdg)
 		    dgram_link);
 
 		list_remove(&frag->dgram_link);
-		free(frag->packet.data);
 		free(frag);
 	}
 
@@ -37,8 +37,36 @@
 #ifndef INET_REASS_H_
 #define INET_REASS_H_
 
+#include <stddef.h>
+#include <time.h>
 #include "inetsrv.h"
 
+/** Datagram reassembly callbacks */
+typedef struct {
+	/** Reassembled datagram is ready for delivery */
+	errno_t (*dgram_reassembled)(inet_dgram_t *, uint8_t);
+} inet_reass_cb_t;
+
+/** Datagram reassembly statistics */
+typedef struct {
+	/** Datagrams reassembled */
+	size_t reassembled;
+	/** Datagrams dropped on reassembly timeout */
+	size_t timeouts;
+	/** Datagrams evicted to stay within memory budget */
+	size_t evicted;
+	/** Datagrams dropped due to invalid fragments */
+	size_t dropped;
+	/** Datagrams currently being reassembled */
+	size_t pending;
+	/** Memory held by datagrams being reassembled, in bytes */
+	size_t mem;
+} inet_reass_stats_t;
+
+extern errno_t inet_reass_init(inet_reass_cb_t *);
+extern void inet_reass_fini(void);
+extern void inet_reass_set_limits(size_t, usec_t);
+extern void inet_reass_get_stats(inet_reass_stats_t *);
 extern errno_t inet_reass_queue_packet(inet_packet_t *);
 
 #endif
@@ -34,21 +34,113 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/prefix_trie.h>
+#include <assert.h>
 #include <bitops.h>
+#include <byteorder.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <ipc/loc.h>
+#include <mem.h>
 #include <stdlib.h>
 #include <str.h>
 #include "sroute.h"
 #include "inetsrv.h"
 #include "inet_link.h"
 
-static FIBRIL_MUTEX_INITIALIZE(sroute_list_lock);
+/** Number of entries in the destination route cache (power of two) */
+#define SROUTE_CACHE_SIZE 64
+
+/** Destination route cache entry */
+typedef struct {
+	/** Destination address */
+	inet_addr_t addr;
+	/** Route to use or @c NULL if there is none */
+	inet_sroute_t *sroute;
+	/** Entry is valid */
+	bool valid;
+} inet_sroute_cache_ent_t;
+
+/** Protects route list and tries. Lookups only need read access. */
+static FIBRIL_RWLOCK_INITIALIZE(sroute_lock);
 static LIST_INITIALIZE(sroute_list);
 static sysarg_t sroute_id = 0;
 
+/** Longest prefix match tries of IPv4 and IPv6 routes */
+static prefix_trie_t sroute_trie4 = PREFIX_TRIE_INITIALIZER(32);
+static prefix_trie_t sroute_trie6 = PREFIX_TRIE_INITIALIZER(128);
+
+/** Protects destination route cache. Nests inside sroute_lock. */
+static FIBRIL_MUTEX_INITIALIZE(sroute_cache_lock);
+static inet_sroute_cache_ent_t sroute_cache[SROUTE_CACHE_SIZE];
+
+/** Get trie key of a route destination.
+ *
+ * @param dest Route destination
+ * @param key Place to store key
+ * @param bits Place to store prefix length
+ * @return Trie for @a dest or @c NULL if @a dest is not valid
+ */
+static prefix_trie_t *inet_sroute_key(inet_naddr_t *dest, addr128_t key,
+    unsigned *bits)
+{
+	addr32_t v4;
+	addr128_t v6;
+	uint8_t prefix;
+
+	switch (inet_naddr_get(dest, &v4, &v6, &prefix)) {
+	case ip_v4:
+		if (prefix > 32)
+			return NULL;
+		v4 = host2uint32_t_be(v4);
+		memcpy(key, &v4, sizeof(v4));
+		*bits = prefix;
+		return &sroute_trie4;
+	case ip_v6:
+		if (prefix > 128)
+			return NULL;
+		memcpy(key, v6, sizeof(addr128_t));
+		*bits = prefix;
+		return &sroute_trie6;
+	default:
+		return NULL;
+	}
+}
+
+/** Get destination route cache slot for address. */
+static inet_sroute_cache_ent_t *inet_sroute_cache_slot(inet_addr_t *addr)
+{
+	size_t hash;
+	size_t i;
+
+	if (addr->version == ip_v4) {
+		hash = hash_mix32(addr->addr);
+	} else {
+		hash = 0;
+		for (i = 0; i < sizeof(addr128_t); i++)
+			hash = hash_combine(hash, addr->addr6[i]);
+		hash = hash_mix(hash);
+	}
+
+	return &sroute_cache[hash & (SROUTE_CACHE_SIZE - 1)];
+}
+
+/** Invalidate destination route cache.
+ *
+ * Must be called with sroute_lock held for writing.
+ */
+static void inet_sroute_cache_flush(void)
+{
+	size_t i;
+
+	fibril_mutex_lock(&sroute_cache_lock);
+	for (i = 0; i < SROUTE_CACHE_SIZE; i++)
+		sroute_cache[i].valid = false;
+	fibril_mutex_unlock(&sroute_cache_lock);
+}
+
 inet_sroute_t *inet_sroute_new(void)
 {
 	inet_sroute_t *sroute = calloc(1, sizeof(inet_sroute_t));
@@ -60,9 +152,9 @@ inet_sroute_t *inet_sroute_new(void)
 	}
 
 	link_initialize(&sroute->sroute_list);
-	fibril_mutex_lock(&sroute_list_lock);
+	fibril_rwlock_write_lock(&sroute_lock);
 	sroute->id = ++sroute_id;
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_write_unlock(&sroute_lock);
 
 	return sroute;
 }
@@ -74,61 +166,128 @@ void inet_sroute_delete(inet_sroute_t *sroute)
 	free(sroute);
 }
 
-void inet_sroute_add(inet_sroute_t *sroute)
+/** Add static route.
+ *
+ * If there already is a route with the same destination, the new route
+ * is only used once the older one is removed.
+ *
+ * @param sroute Static route
+ * @return EOK on success, EINVAL if destination is not valid, ENOMEM if
+ *         out of memory
+ */
+errno_t inet_sroute_add(inet_sroute_t *sroute)
 {
-	fibril_mutex_lock(&sroute_list_lock);
+	prefix_trie_t *trie;
+	addr128_t key;
+	unsigned bits;
+	errno_t rc;
+
+	trie = inet_sroute_key(&sroute->dest, key, &bits);
+	if (trie == NULL)
+		return EINVAL;
+
+	fibril_rwlock_write_lock(&sroute_lock);
+
+	rc = prefix_trie_insert(trie, key, bits, sroute);
+	if (rc != EOK && rc != EEXIST) {
+		fibril_rwlock_write_unlock(&sroute_lock);
+		return rc;
+	}
+
 	list_append(&sroute->sroute_list, &sroute_list);
-	fibril_mutex_unlock(&sroute_list_lock);
+	inet_sroute_cache_flush();
+	fibril_rwlock_write_unlock(&sroute_lock);
+	return EOK;
 }
 
 void inet_sroute_remove(inet_sroute_t *sroute)
 {
-	fibril_mutex_lock(&sroute_list_lock);
+	prefix_trie_t *trie;
+	addr128_t key;
+	unsigned bits;
+	addr128_t okey;
+	unsigned obits;
+	errno_t rc;
+
+	trie = inet_sroute_key(&sroute->dest, key, &bits);
+	assert(trie != NULL);
+
+	fibril_rwlock_write_lock(&sroute_lock);
 	list_remove(&sroute->sroute_list);
-	fibril_mutex_unlock(&sroute_list_lock);
+
+	if (prefix_trie_get(trie, key, bits) == sroute) {
+		(void) prefix_trie_remove(trie, key, bits);
+
+		/* Let the oldest route with the same destination take over */
+		list_foreach(sroute_list, sroute_list, inet_sroute_t, osroute) {
+			if (inet_sroute_key(&osroute->dest, okey, &obits) !=
+			    trie || obits != bits)
+				continue;
+
+			rc = prefix_trie_insert(trie, okey, obits, osroute);
+			if (rc == EOK)
+				break;
+			if (rc == ENOMEM) {
+				log_msg(LOG_DEFAULT, LVL_ERROR, "Out of memory "
+				    "re-adding static route '%s'.", osroute->name);
+				break;
+			}
+		}
+	}
+
+	inet_sroute_cache_flush();
+	fibril_rwlock_write_unlock(&sroute_lock);
 }
 
 /** Find static route object matching address @a addr.
+ *
+ * Finds the route with the longest destination prefix matching @a addr.
+ * Recent results are cached.
  *
  * @param addr	Address
+ * @return	Static route or @c NULL if none matches
  */
 inet_sroute_t *inet_sroute_find(inet_addr_t *addr)
 {
-	ip_ver_t addr_ver = inet_addr_get(addr, NULL, NULL);
-
-	inet_sroute_t *best = NULL;
-	uint8_t best_bits = 0;
-
-	fibril_mutex_lock(&sroute_list_lock);
-
-	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
-		uint8_t dest_bits;
-		ip_ver_t dest_ver = inet_naddr_get(&sroute->dest, NULL, NULL,
-		    &dest_bits);
-
-		/* Skip comparison with different address family */
-		if (addr_ver != dest_ver)
-			continue;
-
-		/* Look for the most specific route */
-		if ((best != NULL) && (best_bits >= dest_bits))
-			continue;
-
-		if (inet_naddr_compare_mask(&sroute->dest, addr)) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: found candidate %p",
-			    sroute);
-
-			best = sroute;
-			best_bits = dest_bits;
-		}
+	inet_sroute_cache_ent_t *ent;
+	inet_sroute_t *sroute;
+	addr32_t v4;
+	addr128_t key;
+
+	ent = inet_sroute_cache_slot(addr);
+
+	fibril_mutex_lock(&sroute_cache_lock);
+	if (ent->valid && inet_addr_compare(&ent->addr, addr)) {
+		sroute = ent->sroute;
+		fibril_mutex_unlock(&sroute_cache_lock);
+		return sroute;
+	}
+	fibril_mutex_unlock(&sroute_cache_lock);
+
+	fibril_rwlock_read_lock(&sroute_lock);
+
+	switch (inet_addr_get(addr, &v4, &key)) {
+	case ip_v4:
+		v4 = host2uint32_t_be(v4);
+		sroute = prefix_trie_lookup(&sroute_trie4, (uint8_t *) &v4);
+		break;
+	case ip_v6:
+		sroute = prefix_trie_lookup(&sroute_trie6, key);
+		break;
+	default:
+		sroute = NULL;
+		break;
 	}
 
-	if (best == NULL)
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: Not found");
+	fibril_mutex_lock(&sroute_cache_lock);
+	ent->addr = *addr;
+	ent->sroute = sroute;
+	ent->valid = true;
+	fibril_mutex_unlock(&sroute_cache_lock);
 
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_read_unlock(&sroute_lock);
 
-	return best;
+	return sroute;
 }
 
 /** Find static route with a specific name.
@@ -141,11 +300,11 @@ inet_sroute_t *inet_sroute_find_by_name(const char *name)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find_by_name('%s')",
 	    name);
 
-	fibril_mutex_lock(&sroute_list_lock);
+	fibril_rwlock_read_lock(&sroute_lock);
 
 	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
 		if (str_cmp(sroute->name, name) == 0) {
-			fibril_mutex_unlock(&sroute_list_lock);
+			fibril_rwlock_read_unlock(&sroute_lock);
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find_by_name: found %p",
 			    sroute);
 			return sroute;
@@ -153,7 +312,7 @@ inet_sroute_t *inet_sroute_find_by_name(const char *name)
 	}
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find_by_name: Not found");
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_read_unlock(&sroute_lock);
 
 	return NULL;
 }
@@ -167,16 +326,16 @@ inet_sroute_t *inet_sroute_get_by_id(sysarg_t id)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_get_by_id(%zu)", (size_t)id);
 
-	fibril_mutex_lock(&sroute_list_lock);
+	fibril_rwlock_read_lock(&sroute_lock);
 
 	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
 		if (sroute->id == id) {
-			fibril_mutex_unlock(&sroute_list_lock);
+			fibril_rwlock_read_unlock(&sroute_lock);
 			return sroute;
 		}
 	}
 
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_read_unlock(&sroute_lock);
 
 	return NULL;
 }
@@ -187,12 +346,12 @@ errno_t inet_sroute_get_id_list(sysarg_t **rid_list, size_t *rcount)
 	sysarg_t *id_list;
 	size_t count, i;
 
-	fibril_mutex_lock(&sroute_list_lock);
+	fibril_rwlock_read_lock(&sroute_lock);
 	count = list_count(&sroute_list);
 
 	id_list = calloc(count, sizeof(sysarg_t));
 	if (id_list == NULL) {
-		fibril_mutex_unlock(&sroute_list_lock);
+		fibril_rwlock_read_unlock(&sroute_lock);
 		return ENOMEM;
 	}
 
@@ -201,7 +360,7 @@ errno_t inet_sroute_get_id_list(sysarg_t **rid_list, size_t *rcount)
 		id_list[i++] = sroute->id;
 	}
 
-	fibril_mutex_unlock(&sroute_list_lock);
+	fibril_rwlock_read_unlock(&sroute_lock);
 
 	*rid_list = id_list;
 	*rcount = count;
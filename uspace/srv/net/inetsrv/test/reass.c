@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <errno.h>
+#include <fibril.h>
+#include <inet/addr.h>
+#include <io/log.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+
+#include "../inetsrv.h"
+#include "../reass.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(reass);
+
+enum {
+	test_dgram_max = 4096
+};
+
+static errno_t test_dgram_reassembled(inet_dgram_t *, uint8_t);
+
+static inet_reass_cb_t test_reass_cb = {
+	.dgram_reassembled = test_dgram_reassembled
+};
+
+static size_t dgram_cnt;
+static uint8_t dgram_proto;
+static size_t dgram_size;
+static uint8_t dgram_data[test_dgram_max];
+static uint8_t src_data[test_dgram_max];
+
+static errno_t test_dgram_reassembled(inet_dgram_t *dgram, uint8_t proto)
+{
+	++dgram_cnt;
+	dgram_proto = proto;
+	dgram_size = dgram->size;
+	if (dgram->size <= test_dgram_max)
+		memcpy(dgram_data, dgram->data, dgram->size);
+	return EOK;
+}
+
+/** Queue fragment of @c src_data */
+static errno_t test_queue_frag(uint32_t ident, size_t offs, size_t size,
+    bool mf)
+{
+	inet_packet_t packet;
+
+	memset(&packet, 0, sizeof(packet));
+	inet_addr_set(0x0a000001, &packet.src);
+	inet_addr_set(0x0a000002, &packet.dest);
+	packet.proto = 17;
+	packet.ident = ident;
+	packet.offs = offs;
+	packet.size = size;
+	packet.mf = mf;
+	packet.data = src_data + offs;
+
+	return inet_reass_queue_packet(&packet);
+}
+
+PCUT_TEST_BEFORE
+{
+	errno_t rc;
+	size_t i;
+
+	/* We will be calling functions that perform logging */
+	rc = log_init("test-inetsrv");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = inet_reass_init(&test_reass_cb);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	for (i = 0; i < test_dgram_max; i++)
+		src_data[i] = (uint8_t) (i * 7 + 3);
+
+	dgram_cnt = 0;
+	dgram_size = 0;
+	memset(dgram_data, 0, sizeof(dgram_data));
+}
+
+PCUT_TEST_AFTER
+{
+	inet_reass_fini();
+}
+
+/** Fragments received in order are reassembled */
+PCUT_TEST(in_order)
+{
+	inet_reass_stats_t stats;
+	errno_t rc;
+
+	rc = test_queue_frag(1, 0, 1000, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = test_queue_frag(1, 1000, 1000, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, dgram_cnt);
+
+	rc = test_queue_frag(1, 2000, 500, false);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_INT_EQUALS(1, dgram_cnt);
+	PCUT_ASSERT_INT_EQUALS(17, dgram_proto);
+	PCUT_ASSERT_INT_EQUALS(2500, dgram_size);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(dgram_data, src_data, 2500));
+
+	inet_reass_get_stats(&stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.reassembled);
+	PCUT_ASSERT_INT_EQUALS(0, stats.pending);
+	PCUT_ASSERT_INT_EQUALS(0, stats.mem);
+}
+
+/** Out of order, overlapping and duplicate fragments are reassembled */
+PCUT_TEST(overlap)
+{
+	errno_t rc;
+
+	/* Last fragment first */
+	rc = test_queue_frag(2, 2000, 400, false);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = test_queue_frag(2, 1000, 200, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	/* Covers both previously received fragments entirely */
+	rc = test_queue_frag(2, 800, 1600, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	/* Duplicate */
+	rc = test_queue_frag(2, 800, 1600, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	/* Overlaps the beginning of a received fragment */
+	rc = test_queue_frag(2, 400, 1200, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, dgram_cnt);
+
+	rc = test_queue_frag(2, 0, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_INT_EQUALS(1, dgram_cnt);
+	PCUT_ASSERT_INT_EQUALS(2400, dgram_size);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(dgram_data, src_data, 2400));
+}
+
+/** Interleaved datagrams are reassembled separately */
+PCUT_TEST(interleaved)
+{
+	inet_reass_stats_t stats;
+	errno_t rc;
+
+	rc = test_queue_frag(3, 0, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = test_queue_frag(4, 0, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_reass_get_stats(&stats);
+	PCUT_ASSERT_INT_EQUALS(2, stats.pending);
+
+	rc = test_queue_frag(4, 800, 200, false);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(1, dgram_cnt);
+	PCUT_ASSERT_INT_EQUALS(1000, dgram_size);
+
+	rc = test_queue_frag(3, 800, 100, false);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(2, dgram_cnt);
+	PCUT_ASSERT_INT_EQUALS(900, dgram_size);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(dgram_data, src_data, 900));
+}
+
+/** Datagram with inconsistent last fragment is dropped */
+PCUT_TEST(inconsistent)
+{
+	inet_reass_stats_t stats;
+	errno_t rc;
+
+	rc = test_queue_frag(5, 0, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = test_queue_frag(5, 1600, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Last fragment ends before data already received */
+	rc = test_queue_frag(5, 800, 400, false);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	inet_reass_get_stats(&stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.dropped);
+	PCUT_ASSERT_INT_EQUALS(0, stats.pending);
+	PCUT_ASSERT_INT_EQUALS(0, stats.mem);
+	PCUT_ASSERT_INT_EQUALS(0, dgram_cnt);
+}
+
+/** Fragment beyond maximum datagram size is rejected */
+PCUT_TEST(too_large)
+{
+	inet_packet_t packet;
+	errno_t rc;
+
+	memset(&packet, 0, sizeof(packet));
+	inet_addr_set(0x0a000001, &packet.src);
+	inet_addr_set(0x0a000002, &packet.dest);
+	packet.proto = 17;
+	packet.ident = 6;
+	packet.offs = 65528;
+	packet.size = 16;
+	packet.mf = false;
+	packet.data = src_data;
+
+	rc = inet_reass_queue_packet(&packet);
+	PCUT_ASSERT_ERRNO_VAL(ELIMIT, rc);
+}
+
+/** Least recently updated datagrams are evicted to stay within budget */
+PCUT_TEST(mem_limit)
+{
+	inet_reass_stats_t stats;
+	uint32_t ident;
+	errno_t rc;
+
+	inet_reass_set_limits(16 * 1024, SEC2USEC(30));
+
+	/* First datagram is kept up to date */
+	rc = test_queue_frag(100, 0, 1000, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	for (ident = 0; ident < 64; ident++) {
+		rc = test_queue_frag(ident, 0, 1000, true);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		rc = test_queue_frag(100, 1000 + ident * 8, 8, true);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	}
+
+	inet_reass_get_stats(&stats);
+	PCUT_ASSERT_TRUE(stats.evicted > 0);
+	PCUT_ASSERT_TRUE(stats.mem <= 16 * 1024);
+	PCUT_ASSERT_INT_EQUALS(64 + 1 - stats.evicted, stats.pending);
+
+	/* Recently updated datagram survived and can be completed */
+	rc = test_queue_frag(100, 1000 + 64 * 8, 8, false);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(1, dgram_cnt);
+	PCUT_ASSERT_INT_EQUALS(1000 + 65 * 8, dgram_size);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(dgram_data, src_data, dgram_size));
+}
+
+/** Datagram is dropped when reassembly times out */
+PCUT_TEST(timeout)
+{
+	inet_reass_stats_t stats;
+	errno_t rc;
+
+	inet_reass_set_limits(1024 * 1024, 1000);
+
+	rc = test_queue_frag(7, 0, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	fibril_usleep(10000);
+
+	rc = test_queue_frag(8, 0, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_reass_get_stats(&stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.timeouts);
+	PCUT_ASSERT_INT_EQUALS(1, stats.pending);
+
+	fibril_usleep(10000);
+
+	/* Late fragment starts a new datagram */
+	rc = test_queue_frag(8, 800, 100, false);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, dgram_cnt);
+
+	inet_reass_get_stats(&stats);
+	PCUT_ASSERT_INT_EQUALS(2, stats.timeouts);
+	PCUT_ASSERT_INT_EQUALS(1, stats.pending);
+}
+
+/** Timeout runs from the first fragment, not the most recent one */
+PCUT_TEST(timeout_first_frag)
+{
+	inet_reass_stats_t stats;
+	errno_t rc;
+
+	inet_reass_set_limits(1024 * 1024, 100000);
+
+	rc = test_queue_frag(9, 0, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	fibril_usleep(60000);
+
+	rc = test_queue_frag(9, 800, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	fibril_usleep(60000);
+
+	/* Unrelated fragment discards the first datagram */
+	rc = test_queue_frag(10, 0, 800, true);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_reass_get_stats(&stats);
+	PCUT_ASSERT_INT_EQUALS(1, stats.timeouts);
+	PCUT_ASSERT_INT_EQUALS(1, stats.pending);
+}
+
+PCUT_EXPORT(reass);
@@ -42,6 +42,7 @@
 #include <nettl/amap.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <time.h>
 #include "conn.h"
 #include "inet.h"
 #include "iqueue.h"
@@ -59,21 +60,39 @@
 #define MAX_SEGMENT_LIFETIME	(15*1000*1000) //(2*60*1000*1000)
 #define TIME_WAIT_TIMEOUT	(2*MAX_SEGMENT_LIFETIME)
 
-/** List of all allocated connections */
-static LIST_INITIALIZE(conn_list);
+/** Number of allocated connections */
+static size_t conn_cnt;
 /** Taken after tcp_conn_t lock */
-static FIBRIL_MUTEX_INITIALIZE(conn_list_lock);
+static FIBRIL_MUTEX_INITIALIZE(conn_cnt_lock);
+/** Connections in Time-Wait, ordered by expiration time */
+static LIST_INITIALIZE(tw_list);
+/** Protects tw_list, taken after tcp_conn_t lock */
+static FIBRIL_MUTEX_INITIALIZE(tw_list_lock);
+/** Single Time-Wait timer shared by all connections */
+static fibril_timer_t *tw_timer;
+/** @c tw_timer is set */
+static bool tw_timer_armed;
 /** Connection association map */
 static amap_t *amap;
 /** Taken after tcp_conn_t lock */
 static FIBRIL_MUTEX_INITIALIZE(amap_lock);
 
+/*
+ * Two tcp_conn_t locks may be held at the same time only by a listener
+ * state change callback: tcp_conn_state_set() runs it with the lock of
+ * the connection in Syn-Received held, and the service then locks the
+ * listener's sentinel connection (in Listen) to update its backlog.
+ * The lock of a connection in Listen must therefore never be held while
+ * locking another connection.
+ */
+
 /** Internal loopback configuration */
 tcp_lb_t tcp_conn_lb = tcp_lb_none;
 
 static void tcp_conn_seg_process(tcp_conn_t *, tcp_segment_t *);
 static void tcp_conn_tw_timer_set(tcp_conn_t *);
 static void tcp_conn_tw_timer_clear(tcp_conn_t *);
+static void tw_timeout_func(void *);
 static void tcp_transmit_segment(inet_ep2_t *, tcp_segment_t *);
 static void tcp_conn_trim_seg_to_wnd(tcp_conn_t *, tcp_segment_t *);
 static void tcp_reply_rst(inet_ep2_t *, tcp_segment_t *);
@@ -93,13 +112,27 @@ errno_t tcp_conns_init(void)
 		return ENOMEM;
 	}
 
+	tw_timer = fibril_timer_create(&tw_list_lock);
+	if (tw_timer == NULL) {
+		amap_destroy(amap);
+		amap = NULL;
+		return ENOMEM;
+	}
+
+	tw_timer_armed = false;
 	return EOK;
 }
 
 /** Finalize connections. */
 void tcp_conns_fini(void)
 {
-	assert(list_empty(&conn_list));
+	assert(conn_cnt == 0);
+	assert(list_empty(&tw_list));
+
+	fibril_timer_clear(tw_timer);
+	fibril_timer_destroy(tw_timer);
+	tw_timer = NULL;
+	tw_timer_armed = false;
 
 	amap_destroy(amap);
 	amap = NULL;
@@ -115,16 +148,16 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	tcp_conn_t *conn = NULL;
 	bool tqueue_inited = false;
 
-	/* Allocate connection structure */
-	conn = calloc(1, sizeof(tcp_conn_t));
+	/*
+	 * Allocate connection structure together with its receive
+	 * and send buffers.
+	 */
+	conn = calloc(1, sizeof(tcp_conn_t) + RCV_BUF_SIZE + SND_BUF_SIZE);
 	if (conn == NULL)
 		goto error;
 
 	fibril_mutex_initialize(&conn->lock);
-
-	conn->tw_timer = fibril_timer_create(&conn->lock);
-	if (conn->tw_timer == NULL)
-		goto error;
+	link_initialize(&conn->tw_link);
 
 	/* One for the user, one for not being in closed state */
 	refcount_init(&conn->refcnt);
@@ -135,19 +168,14 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	conn->rcv_buf_size = RCV_BUF_SIZE;
 	conn->rcv_buf_used = 0;
 	conn->rcv_buf_fin = false;
+	conn->rcv_buf = (uint8_t *) (conn + 1);
 
-	conn->rcv_buf = calloc(1, conn->rcv_buf_size);
-	if (conn->rcv_buf == NULL)
-		goto error;
-
-	/** Allocate send buffer */
+	/** Set up send buffer */
 	fibril_condvar_initialize(&conn->snd_buf_cv);
 	conn->snd_buf_size = SND_BUF_SIZE;
 	conn->snd_buf_used = 0;
 	conn->snd_buf_fin = false;
-	conn->snd_buf = calloc(1, conn->snd_buf_size);
-	if (conn->snd_buf == NULL)
-		goto error;
+	conn->snd_buf = conn->rcv_buf + RCV_BUF_SIZE;
 
 	/* Set up receive window. */
 	conn->rcv_wnd = conn->rcv_buf_size;
@@ -176,21 +204,15 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	if (epp != NULL)
 		conn->ident = *epp;
 
-	fibril_mutex_lock(&conn_list_lock);
-	list_append(&conn->link, &conn_list);
-	fibril_mutex_unlock(&conn_list_lock);
+	fibril_mutex_lock(&conn_cnt_lock);
+	++conn_cnt;
+	fibril_mutex_unlock(&conn_cnt_lock);
 
 	return conn;
 
 error:
 	if (tqueue_inited)
 		tcp_tqueue_fini(&conn->retransmit);
-	if (conn != NULL && conn->rcv_buf != NULL)
-		free(conn->rcv_buf);
-	if (conn != NULL && conn->snd_buf != NULL)
-		free(conn->snd_buf);
-	if (conn != NULL && conn->tw_timer != NULL)
-		fibril_timer_destroy(conn->tw_timer);
 	if (conn != NULL)
 		free(conn);
 
@@ -214,19 +236,21 @@ static void tcp_conn_free(tcp_conn_t *conn)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_conn_free(%p)", conn->name, conn);
 
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: %zu segments received "
+	    "(%zu coalesced), %zu ACKs sent (%zu delayed), %zu ACKs "
+	    "piggybacked", conn->name, conn->stats.segs_recv,
+	    conn->stats.segs_coalesced, conn->stats.acks_sent,
+	    conn->stats.acks_delayed, conn->stats.acks_piggybacked);
+
 	assert(conn->mapped == false);
+	assert(conn->tw_active == false);
 	tcp_tqueue_fini(&conn->retransmit);
 
-	fibril_mutex_lock(&conn_list_lock);
-	list_remove(&conn->link);
-	fibril_mutex_unlock(&conn_list_lock);
+	fibril_mutex_lock(&conn_cnt_lock);
+	assert(conn_cnt > 0);
+	--conn_cnt;
+	fibril_mutex_unlock(&conn_cnt_lock);
 
-	if (conn->rcv_buf != NULL)
-		free(conn->rcv_buf);
-	if (conn->snd_buf != NULL)
-		free(conn->snd_buf);
-	if (conn->tw_timer != NULL)
-		fibril_timer_destroy(conn->tw_timer);
 	free(conn);
 }
 
@@ -264,7 +288,8 @@ void tcp_conn_delref(tcp_conn_t *conn)
  * Must be called before any other connection-manipulating function,
  * except tcp_conn_{add|del}ref(). Locks the connection including
  * its timers. Must not be called inside any of the connection
- * timer handlers.
+ * timer handlers. See the lock order notes at the top of this file
+ * for locking two connections.
  *
  * @param conn		Connection
  */
@@ -662,6 +687,8 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	tcp_segment_t *pseg;
+	uint32_t seg_len;
+	bool had_hole;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_sa_seq(%p, %p)", conn, seg);
 
@@ -673,6 +700,10 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 		return;
 	}
 
+	/* Segments waiting in the queue mean there is a hole before them */
+	had_hole = !list_empty(&conn->incoming.list);
+	seg_len = seg->len;
+
 	/* Queue for processing */
 	tcp_iqueue_insert_seg(&conn->incoming, seg);
 
@@ -684,6 +715,27 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 	 */
 	while (tcp_iqueue_get_ready_seg(&conn->incoming, &pseg) == EOK)
 		tcp_conn_seg_process(conn, pseg);
+
+	if (conn->cstate != st_closed && tcp_conn_got_syn(conn)) {
+		/*
+		 * Segment arriving out of order or filling a hole should be
+		 * acknowledged immediately (RFC 5681 section 4.2).
+		 */
+		if (seg_len > 0 && (had_hole ||
+		    !list_empty(&conn->incoming.list)))
+			conn->rcv_ack_now = true;
+
+		/* Acknowledge the whole batch of segments at once */
+		tcp_tqueue_ack(conn);
+	}
+
+	/* Notify the user once about all the data we received */
+	if (conn->rcv_buf_notify) {
+		conn->rcv_buf_notify = false;
+		fibril_condvar_broadcast(&conn->rcv_buf_cv);
+		if (conn->cb != NULL && conn->cb->recv_data != NULL)
+			conn->cb->recv_data(conn, conn->cb_arg);
+	}
 }
 
 /** Process segment RST field.
@@ -1064,12 +1116,13 @@ static cproc_t tcp_conn_seg_proc_text(tcp_conn_t *conn, tcp_segment_t *seg)
 	    xfer_size);
 	conn->rcv_buf_used += xfer_size;
 
-	/* Signal to the receive function that new data has arrived */
-	if (xfer_size > 0) {
-		fibril_condvar_broadcast(&conn->rcv_buf_cv);
-		if (conn->cb != NULL && conn->cb->recv_data != NULL)
-			conn->cb->recv_data(conn, conn->cb_arg);
-	}
+	/*
+	 * Signal to the receive function that new data has arrived. This
+	 * is done by tcp_conn_sa_queue() once all ready segments have been
+	 * processed.
+	 */
+	if (xfer_size > 0)
+		conn->rcv_buf_notify = true;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Received %zu bytes of data.", xfer_size);
 
@@ -1079,9 +1132,14 @@ static cproc_t tcp_conn_seg_proc_text(tcp_conn_t *conn, tcp_segment_t *seg)
 	/* Update receive window. XXX Not an efficient strategy. */
 	conn->rcv_wnd -= xfer_size;
 
-	/* Send ACK */
-	if (xfer_size > 0)
-		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+	/* Acknowledge (possibly with delay) once the batch is processed */
+	if (xfer_size > 0) {
+		conn->rcv_unacked += 1 + seg->coalesced;
+
+		/* Let the sender know immediately that our window is closed */
+		if (conn->rcv_wnd == 0)
+			conn->rcv_ack_now = true;
+	}
 
 	if (xfer_size < seg->len) {
 		/* Trim part of segment which we just received */
@@ -1161,9 +1219,7 @@ static cproc_t tcp_conn_seg_proc_fin(tcp_conn_t *conn, tcp_segment_t *seg)
 
 		/* Add FIN to the receive buffer */
 		conn->rcv_buf_fin = true;
-		fibril_condvar_broadcast(&conn->rcv_buf_cv);
-		if (conn->cb != NULL && conn->cb->recv_data != NULL)
-			conn->cb->recv_data(conn, conn->cb_arg);
+		conn->rcv_buf_notify = true;
 
 		tcp_segment_delete(seg);
 		return cp_done;
@@ -1245,6 +1301,21 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 		return;
 	}
 
+	if (conn->cstate == st_listen && conn->syn_ignore) {
+		/*
+		 * Accept backlog is full. Drop the segment so that
+		 * the peer retransmits the SYN later.
+		 */
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Backlog full, dropping "
+		    "segment.", conn->name);
+		tcp_segment_delete(seg);
+		tcp_conn_unlock(conn);
+		return;
+	}
+
+	conn->stats.segs_recv += 1 + seg->coalesced;
+	conn->stats.segs_coalesced += seg->coalesced;
+
 	if (inet_addr_is_any(&conn->ident.remote.addr) ||
 	    conn->ident.remote.port == inet_port_any ||
 	    inet_addr_is_any(&conn->ident.local.addr)) {
@@ -1307,44 +1378,128 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 	tcp_conn_unlock(conn);
 }
 
+/** Get current time for Time-Wait purposes.
+ *
+ * @return Uptime in microseconds
+ */
+static usec_t tcp_conn_tw_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+/** Arm the Time-Wait timer for the first connection on the list.
+ *
+ * Must be called with @c tw_list_lock held.
+ *
+ * @param now Current time
+ */
+static void tcp_conn_tw_timer_arm(usec_t now)
+{
+	tcp_conn_t *conn;
+	usec_t delay;
+
+	assert(fibril_mutex_is_locked(&tw_list_lock));
+
+	if (tw_timer_armed || list_empty(&tw_list))
+		return;
+
+	conn = list_get_instance(list_first(&tw_list), tcp_conn_t, tw_link);
+	delay = conn->tw_expires > now ? conn->tw_expires - now : 1;
+
+	fibril_timer_set_locked(tw_timer, delay, tw_timeout_func, NULL);
+	tw_timer_armed = true;
+}
+
 /** Time-Wait timeout handler.
  *
- * @param arg	Connection
+ * Closes all connections whose Time-Wait period has expired.
+ *
+ * @param arg	Not used
  */
 static void tw_timeout_func(void *arg)
 {
-	tcp_conn_t *conn = (tcp_conn_t *) arg;
+	tcp_conn_t *conn;
+	link_t *link;
+	bool expired;
+	usec_t now;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "tw_timeout_func(%p)", conn);
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tw_timeout_func()");
 
-	tcp_conn_lock(conn);
+	fibril_mutex_lock(&tw_list_lock);
+	tw_timer_armed = false;
+
+	while (true) {
+		now = tcp_conn_tw_now();
+		link = list_first(&tw_list);
+		if (link == NULL)
+			break;
+
+		conn = list_get_instance(link, tcp_conn_t, tw_link);
+		if (conn->tw_expires > now)
+			break;
+
+		/* The list reference is passed to us */
+		list_remove(&conn->tw_link);
+		conn->tw_active = false;
+		fibril_mutex_unlock(&tw_list_lock);
+
+		tcp_conn_lock(conn);
+
+		/* Timer could have been restarted in the meantime */
+		fibril_mutex_lock(&tw_list_lock);
+		expired = !conn->tw_active;
+		fibril_mutex_unlock(&tw_list_lock);
+
+		if (expired && conn->cstate != st_closed) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: TW Timeout -> Closed",
+			    conn->name);
+			tcp_conn_state_set(conn, st_closed);
+		}
 
-	if (conn->cstate == st_closed) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "Connection already closed.");
 		tcp_conn_unlock(conn);
 		tcp_conn_delref(conn);
-		return;
-	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: TW Timeout -> Closed", conn->name);
-	tcp_conn_state_set(conn, st_closed);
+		fibril_mutex_lock(&tw_list_lock);
+	}
 
-	tcp_conn_unlock(conn);
-	tcp_conn_delref(conn);
+	tcp_conn_tw_timer_arm(now);
+	fibril_mutex_unlock(&tw_list_lock);
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "tw_timeout_func(%p) end", conn);
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tw_timeout_func() end");
 }
 
 /** Start or restart the Time-Wait timeout.
+ *
+ * All connections share a single timer. Since the timeout is the same
+ * for all of them, the list is kept ordered simply by appending.
  *
  * @param conn		Connection
  */
 void tcp_conn_tw_timer_set(tcp_conn_t *conn)
 {
+	usec_t now;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_conn_tw_timer_set() begin");
-	tcp_conn_addref(conn);
-	fibril_timer_set_locked(conn->tw_timer, TIME_WAIT_TIMEOUT,
-	    tw_timeout_func, (void *)conn);
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	now = tcp_conn_tw_now();
+
+	fibril_mutex_lock(&tw_list_lock);
+	if (conn->tw_active) {
+		list_remove(&conn->tw_link);
+	} else {
+		tcp_conn_addref(conn);
+		conn->tw_active = true;
+	}
+
+	conn->tw_expires = now + TIME_WAIT_TIMEOUT;
+	list_append(&conn->tw_link, &tw_list);
+	tcp_conn_tw_timer_arm(now);
+	fibril_mutex_unlock(&tw_list_lock);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_conn_tw_timer_set() end");
 }
 
@@ -1354,9 +1509,22 @@ void tcp_conn_tw_timer_set(tcp_conn_t *conn)
  */
 void tcp_conn_tw_timer_clear(tcp_conn_t *conn)
 {
+	bool active;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_conn_tw_timer_clear() begin");
-	if (fibril_timer_clear_locked(conn->tw_timer) == fts_active)
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	fibril_mutex_lock(&tw_list_lock);
+	active = conn->tw_active;
+	if (active) {
+		list_remove(&conn->tw_link);
+		conn->tw_active = false;
+	}
+	fibril_mutex_unlock(&tw_list_lock);
+
+	if (active)
 		tcp_conn_delref(conn);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_conn_tw_timer_clear() end");
 }
 
@@ -37,6 +37,7 @@
 #include <bitops.h>
 #include <byteorder.h>
 #include <errno.h>
+#include <inet/checksum.h>
 #include <inet/endpoint.h>
 #include <mem.h>
 #include <stdlib.h>
@@ -46,44 +47,6 @@
 #include "std.h"
 #include "tcp_type.h"
 
-#define TCP_CHECKSUM_INIT 0xffff
-
-/** One's complement addition.
- *
- * Result is a + b + carry.
- */
-static uint16_t tcp_ocadd16(uint16_t a, uint16_t b)
-{
-	uint32_t s;
-
-	s = (uint32_t)a + (uint32_t)b;
-	return (s & 0xffff) + (s >> 16);
-}
-
-static uint16_t tcp_checksum_calc(uint16_t ivalue, void *data, size_t size)
-{
-	uint16_t sum;
-	uint16_t w;
-	size_t words, i;
-	uint8_t *bdata;
-
-	sum = ~ivalue;
-	words = size / 2;
-	bdata = (uint8_t *)data;
-
-	for (i = 0; i < words; i++) {
-		w = ((uint16_t)bdata[2 * i] << 8) | bdata[2 * i + 1];
-		sum = tcp_ocadd16(sum, w);
-	}
-
-	if (size % 2 != 0) {
-		w = ((uint16_t)bdata[2 * words] << 8);
-		sum = tcp_ocadd16(sum, w);
-	}
-
-	return ~sum;
-}
-
 static void tcp_header_decode_flags(uint16_t doff_flags, tcp_control_t *rctl)
 {
 	tcp_control_t ctl;
@@ -260,29 +223,32 @@ void tcp_pdu_delete(tcp_pdu_t *pdu)
 	free(pdu);
 }
 
-static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
+/** Compute checksum of the pseudo header and TCP header.
+ *
+ * @param pdu PDU with header filled in
+ * @return Partial checksum to be continued over the segment text
+ */
+static uint16_t tcp_pdu_checksum_headers(tcp_pdu_t *pdu)
 {
 	uint16_t cs_phdr;
-	uint16_t cs_headers;
 	tcp_phdr_t phdr;
 	tcp_phdr6_t phdr6;
 
 	ip_ver_t ver = tcp_phdr_setup(pdu, &phdr, &phdr6);
 	switch (ver) {
 	case ip_v4:
-		cs_phdr = tcp_checksum_calc(TCP_CHECKSUM_INIT, (void *) &phdr,
+		cs_phdr = inet_checksum_calc(INET_CHECKSUM_INIT, &phdr,
 		    sizeof(tcp_phdr_t));
 		break;
 	case ip_v6:
-		cs_phdr = tcp_checksum_calc(TCP_CHECKSUM_INIT, (void *) &phdr6,
+		cs_phdr = inet_checksum_calc(INET_CHECKSUM_INIT, &phdr6,
 		    sizeof(tcp_phdr6_t));
 		break;
 	default:
 		assert(false);
 	}
 
-	cs_headers = tcp_checksum_calc(cs_phdr, pdu->header, pdu->header_size);
-	return tcp_checksum_calc(cs_headers, pdu->text, pdu->text_size);
+	return inet_checksum_calc(cs_phdr, pdu->header, pdu->header_size);
 }
 
 static void tcp_pdu_set_checksum(tcp_pdu_t *pdu, uint16_t checksum)
@@ -338,7 +304,7 @@ errno_t tcp_pdu_encode(inet_ep2_t *epp, tcp_segment_t *seg, tcp_pdu_t **pdu)
 	}
 
 	text_size = tcp_segment_text_size(seg);
-	npdu->text = calloc(1, text_size);
+	npdu->text = malloc(text_size);
 	if (npdu->text == NULL) {
 		free(npdu->header);
 		free(npdu);
@@ -346,10 +312,10 @@ errno_t tcp_pdu_encode(inet_ep2_t *epp, tcp_segment_t *seg, tcp_pdu_t **pdu)
 	}
 
 	npdu->text_size = text_size;
-	memcpy(npdu->text, seg->data, text_size);
 
-	/* Checksum calculation */
-	checksum = tcp_pdu_checksum_calc(npdu);
+	/* Copy the text and compute checksum in one pass */
+	checksum = inet_checksum_copy(tcp_pdu_checksum_headers(npdu),
+	    npdu->text, seg->data, text_size);
 	tcp_pdu_set_checksum(npdu, checksum);
 
 	*pdu = npdu;
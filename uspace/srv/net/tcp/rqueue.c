@@ -41,12 +41,16 @@
 #include <stdlib.h>
 #include <fibril.h>
 #include <fibril_synch.h>
+#include <inet/addr.h>
 #include "conn.h"
 #include "rqueue.h"
 #include "segment.h"
 #include "tcp_type.h"
 #include "ucall.h"
 
+/** Maximum text size of a segment produced by coalescing */
+#define RQ_COALESCE_MAX	(64 * 1024)
+
 static prodcons_t rqueue;
 static bool fibril_active;
 static fibril_mutex_t lock;
@@ -103,23 +107,87 @@ void tcp_rqueue_insert_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 	prodcons_produce(&rqueue, &rqe->link);
 }
 
-/** Receive queue handler fibril. */
+/** Determine if received segment can be coalesced into preceding segment.
+ *
+ * Only plain data segments (with no control bits other than ACK) that
+ * were received on the same endpoint pair, immediately follow each other
+ * in sequence space and carry the same acknowledgement and window
+ * are coalesced.
+ *
+ * @param rqe	Receive queue entry with the preceding segment
+ * @param next	Receive queue entry with the following segment
+ * @return	@c true if @a next can be appended to @a rqe
+ */
+static bool tcp_rqueue_can_coalesce(tcp_rqueue_entry_t *rqe,
+    tcp_rqueue_entry_t *next)
+{
+	tcp_segment_t *seg = rqe->seg;
+	tcp_segment_t *nseg = next->seg;
+	size_t t_size;
+	size_t n_size;
+
+	if (nseg == NULL)
+		return false;
+
+	if ((seg->ctrl & ~CTL_ACK) != 0 || nseg->ctrl != seg->ctrl)
+		return false;
+
+	if (nseg->seq != seg->seq + seg->len || nseg->ack != seg->ack ||
+	    nseg->wnd != seg->wnd)
+		return false;
+
+	t_size = tcp_segment_text_size(seg);
+	n_size = tcp_segment_text_size(nseg);
+	if (t_size == 0 || n_size == 0 || t_size + n_size > RQ_COALESCE_MAX)
+		return false;
+
+	return rqe->epp.local.port == next->epp.local.port &&
+	    rqe->epp.remote.port == next->epp.remote.port &&
+	    inet_addr_compare(&rqe->epp.local.addr, &next->epp.local.addr) &&
+	    inet_addr_compare(&rqe->epp.remote.addr, &next->epp.remote.addr);
+}
+
+/** Receive queue handler fibril.
+ *
+ * Consecutive data segments of the same connection that are waiting
+ * in the queue are coalesced into one segment before delivery so that
+ * the connection processes (and acknowledges) them in one go.
+ */
 static errno_t tcp_rqueue_fibril(void *arg)
 {
 	link_t *link;
 	tcp_rqueue_entry_t *rqe;
+	tcp_rqueue_entry_t *next = NULL;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_rqueue_fibril()");
 
 	while (true) {
-		link = prodcons_consume(&rqueue);
-		rqe = list_get_instance(link, tcp_rqueue_entry_t, link);
+		if (next != NULL) {
+			rqe = next;
+			next = NULL;
+		} else {
+			link = prodcons_consume(&rqueue);
+			rqe = list_get_instance(link, tcp_rqueue_entry_t, link);
+		}
 
 		if (rqe->seg == NULL) {
 			free(rqe);
 			break;
 		}
 
+		while ((link = prodcons_try_consume(&rqueue)) != NULL) {
+			next = list_get_instance(link, tcp_rqueue_entry_t, link);
+			if (!tcp_rqueue_can_coalesce(rqe, next))
+				break;
+
+			if (tcp_segment_append(rqe->seg, next->seg) != EOK)
+				break;
+
+			tcp_segment_delete(next->seg);
+			free(next);
+			next = NULL;
+		}
+
 		rqueue_cb->seg_received(&rqe->epp, rqe->seg);
 		free(rqe);
 	}
@@ -34,6 +34,7 @@
  * @file Segment processing
  */
 
+#include <errno.h>
 #include <io/log.h>
 #include <mem.h>
 #include <stdlib.h>
@@ -74,6 +75,7 @@ tcp_segment_t *tcp_segment_dup(tcp_segment_t *seg)
 	scopy->len = seg->len;
 	scopy->wnd = seg->wnd;
 	scopy->up = seg->up;
+	scopy->coalesced = seg->coalesced;
 
 	tsize = tcp_segment_text_size(seg);
 	scopy->data = calloc(tsize, 1);
@@ -215,6 +217,54 @@ void tcp_segment_trim(tcp_segment_t *seg, uint32_t left, uint32_t right)
 	}
 }
 
+/** Append text of the following segment to a segment.
+ *
+ * Used to coalesce consecutive received data segments. @a next must
+ * immediately follow @a seg in sequence space and neither segment may
+ * carry any control bits other than ACK.
+ *
+ * @param seg		Segment, will be modified in place
+ * @param next		Segment following @a seg, not modified
+ * @return		EOK on success, ENOMEM if out of memory
+ */
+errno_t tcp_segment_append(tcp_segment_t *seg, tcp_segment_t *next)
+{
+	size_t t_size;
+	size_t n_size;
+	uint8_t *data;
+
+	assert((seg->ctrl & ~CTL_ACK) == 0);
+	assert((next->ctrl & ~CTL_ACK) == 0);
+	assert(next->seq == seg->seq + seg->len);
+
+	t_size = tcp_segment_text_size(seg);
+	n_size = tcp_segment_text_size(next);
+
+	if (seg->data == seg->dfptr) {
+		/* Text starts at the beginning of the buffer, extend it */
+		data = realloc(seg->dfptr, t_size + n_size);
+		if (data == NULL)
+			return ENOMEM;
+	} else {
+		data = malloc(t_size + n_size);
+		if (data == NULL)
+			return ENOMEM;
+
+		memcpy(data, seg->data, t_size);
+		free(seg->dfptr);
+	}
+
+	memcpy(data + t_size, next->data, n_size);
+	seg->dfptr = seg->data = data;
+
+	seg->len += next->len;
+	seg->ack = next->ack;
+	seg->wnd = next->wnd;
+	seg->coalesced += 1 + next->coalesced;
+
+	return EOK;
+}
+
 /** Copy out text data from segment.
  *
  * Data is copied from the beginning of the segment text up to @a size bytes.
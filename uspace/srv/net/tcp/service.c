@@ -34,8 +34,11 @@
  * @file HelenOS service implementation
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <async.h>
 #include <errno.h>
+#include <fibril.h>
 #include <str_error.h>
 #include <inet/endpoint.h>
 #include <inet/inet.h>
@@ -57,6 +60,9 @@
 /** Maximum amount of data transferred in one send call */
 #define MAX_MSG_SIZE DATA_XFER_LIMIT
 
+/** Default maximum number of listener connections in Syn-Received */
+#define LISTENER_BACKLOG_DEFAULT 128
+
 static void tcp_ev_data(tcp_cconn_t *);
 static void tcp_ev_connected(tcp_cconn_t *);
 static void tcp_ev_conn_failed(tcp_cconn_t *);
@@ -68,6 +74,8 @@ static void tcp_service_recv_data(tcp_conn_t *, void *);
 static void tcp_service_lst_cstate_change(tcp_conn_t *, void *, tcp_cstate_t);
 
 static errno_t tcp_cconn_create(tcp_client_t *, tcp_conn_t *, tcp_cconn_t **);
+static void tcp_clistener_replenish(tcp_clst_t *);
+static void tcp_clistener_update_backlog(tcp_clst_t *);
 
 /** Connection callbacks to tie us to lower layer */
 static tcp_cb_t tcp_service_cb = {
@@ -119,7 +127,51 @@ static void tcp_service_cstate_change(tcp_conn_t *conn, void *arg,
 		tcp_ev_conn_failed(cconn);
 }
 
+/** Connection release fibril.
+ *
+ * @param arg Connection
+ * @return EOK
+ */
+static errno_t tcp_service_conn_release_fibril(void *arg)
+{
+	tcp_conn_t *conn = (tcp_conn_t *) arg;
+
+	/* This waits until the connection is unlocked */
+	(void) tcp_uc_close(conn);
+	tcp_uc_delete(conn);
+	return EOK;
+}
+
+/** Release embryonic connection that nobody will claim.
+ *
+ * The connection is closed and our reference to it dropped. Since we
+ * are called from the state change callback with the connection locked,
+ * this is done in a separate fibril once the connection is unlocked.
+ *
+ * @param conn Connection
+ */
+static void tcp_service_conn_release(tcp_conn_t *conn)
+{
+	fid_t fid;
+
+	tcp_uc_set_cb(conn, NULL, NULL);
+
+	fid = fibril_create(tcp_service_conn_release_fibril, conn);
+	if (fid == 0) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Out of memory releasing "
+		    "connection.");
+		return;
+	}
+
+	fibril_add_ready(fid);
+}
+
 /** Sentinel connection state has changed.
+ *
+ * The sentinel is the passive connection waiting for a SYN. Once it
+ * receives one it becomes an embryonic connection (in Syn-Received)
+ * and a new sentinel is opened in its place, unless the listener
+ * backlog is full.
  *
  * @param conn      Connection
  * @param arg       Argument (not used)
@@ -131,59 +183,57 @@ static void tcp_service_lst_cstate_change(tcp_conn_t *conn, void *arg,
 	tcp_cstate_t nstate;
 	tcp_clst_t *clst;
 	tcp_cconn_t *cconn;
-	inet_ep2_t epp;
 	errno_t rc;
-	tcp_error_t trc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_service_lst_cstate_change()");
 	nstate = conn->cstate;
 	clst = tcp_uc_get_userptr(conn);
 
-	if ((old_state == st_syn_sent || old_state == st_syn_received) &&
-	    (nstate == st_established)) {
-		/* Connection established */
-		clst->conn = NULL;
-
-		rc = tcp_cconn_create(clst->client, conn, &cconn);
-		if (rc != EOK) {
-			/* XXX Could not create client connection */
-			return;
-		}
-
-		/* XXX Is there a race here (i.e. the connection is already active)? */
-		tcp_uc_set_cb(conn, &tcp_service_cb, cconn);
-
-		/* New incoming connection */
-		tcp_ev_new_conn(clst, cconn);
-	}
+	if (old_state == st_listen && nstate == st_syn_received) {
+		/* New connection attempt */
+		assert(conn == clst->conn);
+		++clst->syn_cnt;
 
-	if (old_state != st_closed && nstate == st_closed && conn->reset) {
-		/* Connection reset */
-		/* XXX */
+		/* Replenish sentinel connection */
+		clst->conn = NULL;
+		tcp_clistener_replenish(clst);
+		return;
 	}
 
-	/* XXX Failed to establish connection */
-	if (0) {
-		/* XXX */
-	}
+	if (old_state != st_syn_received)
+		return;
 
-	/* Replenish sentinel connection */
+	assert(clst->syn_cnt > 0);
+	--clst->syn_cnt;
 
-	inet_ep2_init(&epp);
-	epp.local = clst->elocal;
+	if (nstate == st_established && !clst->destroyed) {
+		/* Connection established */
+		rc = tcp_cconn_create(clst->client, conn, &cconn);
+		if (rc == EOK) {
+			/* XXX Is there a race here (i.e. the connection is already active)? */
+			tcp_uc_set_cb(conn, &tcp_service_cb, cconn);
+
+			/* New incoming connection */
+			tcp_ev_new_conn(clst, cconn);
+		} else {
+			/* Could not create client connection */
+			tcp_service_conn_release(conn);
+		}
+	} else {
+		/*
+		 * Connection reset, failed to establish, reverted to Listen
+		 * or listener is gone. Nobody will claim it.
+		 */
+		tcp_service_conn_release(conn);
+	}
 
-	trc = tcp_uc_open(&epp, ap_passive, tcp_open_nonblock,
-	    &conn);
-	if (trc != TCP_EOK) {
-		/* XXX Could not replenish connection */
+	if (clst->destroyed) {
+		if (clst->syn_cnt == 0)
+			free(clst);
 		return;
 	}
 
-	conn->name = (char *) "s";
-	clst->conn = conn;
-
-	/* XXX Is there a race here (i.e. the connection is already active)? */
-	tcp_uc_set_cb(conn, &tcp_service_lst_cb, clst);
+	tcp_clistener_update_backlog(clst);
 }
 
 /** Received data became available on connection.
@@ -309,17 +359,14 @@ static errno_t tcp_cconn_create(tcp_client_t *client, tcp_conn_t *conn,
 		return ENOMEM;
 
 	/* Allocate new ID */
-	id = 0;
-	list_foreach (client->cconn, lclient, tcp_cconn_t, cconn) {
-		if (cconn->id >= id)
-			id = cconn->id + 1;
-	}
+	id = client->cconn_next_id++;
 
 	cconn->id = id;
 	cconn->client = client;
 	cconn->conn = conn;
 
 	list_append(&cconn->lclient, &client->cconn);
+	hash_table_insert(&client->cconn_map, &cconn->lmap);
 	*rcconn = cconn;
 	return EOK;
 }
@@ -331,6 +378,7 @@ static errno_t tcp_cconn_create(tcp_client_t *client, tcp_conn_t *conn,
 static void tcp_cconn_destroy(tcp_cconn_t *cconn)
 {
 	list_remove(&cconn->lclient);
+	hash_table_remove_item(&cconn->client->cconn_map, &cconn->lmap);
 	free(cconn);
 }
 
@@ -356,15 +404,12 @@ static errno_t tcp_clistener_create(tcp_client_t *client, tcp_conn_t *conn,
 		return ENOMEM;
 
 	/* Allocate new ID */
-	id = 0;
-	list_foreach (client->clst, lclient, tcp_clst_t, clst) {
-		if (clst->id >= id)
-			id = clst->id + 1;
-	}
+	id = client->clst_next_id++;
 
 	clst->id = id;
 	clst->client = client;
 	clst->conn = conn;
+	clst->backlog = LISTENER_BACKLOG_DEFAULT;
 
 	list_append(&clst->lclient, &client->clst);
 	*rclst = clst;
@@ -372,13 +417,81 @@ static errno_t tcp_clistener_create(tcp_client_t *client, tcp_conn_t *conn,
 }
 
 /** Destroy client listener.
+ *
+ * The sentinel connection is closed. If there are connections in
+ * Syn-Received referencing the listener, freeing it is deferred until
+ * they leave that state.
  *
  * @param clst Client listener
  */
 static void tcp_clistener_destroy(tcp_clst_t *clst)
 {
+	tcp_conn_t *conn;
+
 	list_remove(&clst->lclient);
-	free(clst);
+
+	conn = clst->conn;
+	clst->conn = NULL;
+	if (conn != NULL) {
+		tcp_uc_set_cb(conn, NULL, NULL);
+		tcp_uc_close(conn);
+		tcp_uc_delete(conn);
+	}
+
+	clst->destroyed = true;
+	clst->client = NULL;
+
+	if (clst->syn_cnt == 0)
+		free(clst);
+}
+
+/** Open new sentinel connection for client listener.
+ *
+ * @param clst Client listener
+ */
+static void tcp_clistener_replenish(tcp_clst_t *clst)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	tcp_error_t trc;
+
+	assert(clst->conn == NULL);
+
+	inet_ep2_init(&epp);
+	epp.local = clst->elocal;
+
+	trc = tcp_uc_open(&epp, ap_passive, tcp_open_nonblock, &conn);
+	if (trc != TCP_EOK) {
+		/* XXX Could not replenish connection */
+		return;
+	}
+
+	conn->name = (char *) "s";
+	clst->conn = conn;
+
+	/* XXX Is there a race here (i.e. the connection is already active)? */
+	tcp_uc_set_cb(conn, &tcp_service_lst_cb, clst);
+	tcp_clistener_update_backlog(clst);
+}
+
+/** Update sentinel connection according to listener backlog.
+ *
+ * While the number of connections in Syn-Received is at the backlog
+ * limit, the sentinel drops incoming SYNs.
+ *
+ * May be called with the lock of a connection in Syn-Received held,
+ * which is then taken before the sentinel's lock (see conn.c).
+ *
+ * @param clst Client listener
+ */
+static void tcp_clistener_update_backlog(tcp_clst_t *clst)
+{
+	if (clst->conn == NULL)
+		return;
+
+	tcp_conn_lock(clst->conn);
+	clst->conn->syn_ignore = clst->syn_cnt >= clst->backlog;
+	tcp_conn_unlock(clst->conn);
 }
 
 /** Get client connection by ID.
@@ -393,14 +506,14 @@ static void tcp_clistener_destroy(tcp_clst_t *clst)
 static errno_t tcp_cconn_get(tcp_client_t *client, sysarg_t id,
     tcp_cconn_t **rcconn)
 {
-	list_foreach (client->cconn, lclient, tcp_cconn_t, cconn) {
-		if (cconn->id == id) {
-			*rcconn = cconn;
-			return EOK;
-		}
-	}
+	ht_link_t *link;
 
-	return ENOENT;
+	link = hash_table_find(&client->cconn_map, &id);
+	if (link == NULL)
+		return ENOENT;
+
+	*rcconn = hash_table_get_inst(link, tcp_cconn_t, lmap);
+	return EOK;
 }
 
 /** Get client listener by ID.
@@ -566,13 +679,42 @@ static errno_t tcp_listener_destroy_impl(tcp_client_t *client, sysarg_t lst_id)
 		return ENOENT;
 	}
 
-#if 0
-	tcp_uc_close(cconn->conn);
-#endif
 	tcp_clistener_destroy(clst);
 	return EOK;
 }
 
+/** Set listener backlog.
+ *
+ * Handle client request to set listener backlog (with parameters
+ * unmarshalled).
+ *
+ * @param client  TCP client
+ * @param lst_id  Listener ID
+ * @param backlog Maximum number of connections in Syn-Received
+ *
+ * @return EOK on success, ENOENT if no such listener is found,
+ *         EINVAL if @a backlog is zero
+ */
+static errno_t tcp_listener_set_backlog_impl(tcp_client_t *client,
+    sysarg_t lst_id, size_t backlog)
+{
+	tcp_clst_t *clst;
+	errno_t rc;
+
+	if (backlog == 0)
+		return EINVAL;
+
+	rc = tcp_clistener_get(client, lst_id, &clst);
+	if (rc != EOK) {
+		assert(rc == ENOENT);
+		return ENOENT;
+	}
+
+	clst->backlog = backlog;
+	tcp_clistener_update_backlog(clst);
+	return EOK;
+}
+
 /** Send FIN.
  *
  * Handle client request to send FIN (with parameters unmarshalled).
@@ -876,6 +1018,29 @@ static void tcp_listener_destroy_srv(tcp_client_t *client, ipc_call_t *icall)
 	async_answer_0(icall, rc);
 }
 
+/** Set listener backlog.
+ *
+ * Handle client request to set listener backlog.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_listener_set_backlog_srv(tcp_client_t *client,
+    ipc_call_t *icall)
+{
+	sysarg_t lst_id;
+	size_t backlog;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_listener_set_backlog_srv()");
+
+	lst_id = ipc_get_arg1(icall);
+	backlog = ipc_get_arg2(icall);
+	rc = tcp_listener_set_backlog_impl(client, lst_id, backlog);
+	async_answer_0(icall, rc);
+}
+
 /** Send FIN.
  *
  * Handle client request to send FIN.
@@ -1111,16 +1276,50 @@ static void tcp_conn_recv_wait_srv(tcp_client_t *client, ipc_call_t *icall)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_recv_wait_srv(): OK");
 }
 
+static size_t tcp_cconn_hash(const ht_link_t *item)
+{
+	tcp_cconn_t *cconn = hash_table_get_inst(item, tcp_cconn_t, lmap);
+
+	return hash_mix(cconn->id);
+}
+
+static size_t tcp_cconn_key_hash(const void *key)
+{
+	return hash_mix(*(const sysarg_t *) key);
+}
+
+static bool tcp_cconn_key_equal(const void *key, const ht_link_t *item)
+{
+	tcp_cconn_t *cconn = hash_table_get_inst(item, tcp_cconn_t, lmap);
+
+	return cconn->id == *(const sysarg_t *) key;
+}
+
+/** Client connection map operations */
+static hash_table_ops_t tcp_cconn_map_ops = {
+	.hash = tcp_cconn_hash,
+	.key_hash = tcp_cconn_key_hash,
+	.key_equal = tcp_cconn_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
 /** Initialize TCP client structure.
  *
  * @param client TCP client
+ * @return EOK on success or ENOMEM if out of memory
  */
-static void tcp_client_init(tcp_client_t *client)
+static errno_t tcp_client_init(tcp_client_t *client)
 {
 	memset(client, 0, sizeof(tcp_client_t));
 	client->sess = NULL;
 	list_initialize(&client->cconn);
 	list_initialize(&client->clst);
+
+	if (!hash_table_create(&client->cconn_map, 0, 0, &tcp_cconn_map_ops))
+		return ENOMEM;
+
+	return EOK;
 }
 
 /** Finalize TCP client structure.
@@ -1150,9 +1349,15 @@ static void tcp_client_fini(tcp_client_t *client)
 	if (n != 0) {
 		log_msg(LOG_DEFAULT, LVL_WARN, "Client with %lu active "
 		    "listeners closed session", n);
-		/* XXX Destroy listeners */
+
+		while (!list_empty(&client->clst)) {
+			tcp_clistener_destroy(list_get_instance(
+			    list_first(&client->clst), tcp_clst_t, lclient));
+		}
 	}
 
+	hash_table_destroy(&client->cconn_map);
+
 	if (client->sess != NULL)
 		async_hangup(client->sess);
 }
@@ -1166,6 +1371,13 @@ static void tcp_client_fini(tcp_client_t *client)
 static void tcp_client_conn(ipc_call_t *icall, void *arg)
 {
 	tcp_client_t client;
+	errno_t rc;
+
+	rc = tcp_client_init(&client);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
 
 	/* Accept the connection */
 	async_accept_0(icall);
@@ -1173,8 +1385,6 @@ static void tcp_client_conn(ipc_call_t *icall, void *arg)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_client_conn() - client=%p",
 	    &client);
 
-	tcp_client_init(&client);
-
 	while (true) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_client_conn: wait req");
 		ipc_call_t call;
@@ -1223,6 +1433,9 @@ static void tcp_client_conn(ipc_call_t *icall, void *arg)
 		case TCP_CONN_RECV_WAIT:
 			tcp_conn_recv_wait_srv(&client, &call);
 			break;
+		case TCP_LISTENER_SET_BACKLOG:
+			tcp_listener_set_backlog_srv(&client, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
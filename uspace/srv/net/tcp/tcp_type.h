@@ -35,6 +35,7 @@
 #ifndef TCP_TYPE_H
 #define TCP_TYPE_H
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <async.h>
 #include <stdbool.h>
@@ -148,10 +149,26 @@ typedef struct {
 	void (*recv_data)(tcp_conn_t *, void *);
 } tcp_cb_t;
 
+/** Connection receive and acknowledgement statistics */
+typedef struct {
+	/** Segments received */
+	size_t segs_recv;
+	/** Received segments coalesced into a preceding segment */
+	size_t segs_coalesced;
+	/** ACK-only segments sent */
+	size_t acks_sent;
+	/** ACK-only segments sent on delayed ACK timeout */
+	size_t acks_delayed;
+	/** Pending acknowledgements carried by outgoing data segments */
+	size_t acks_piggybacked;
+} tcp_conn_stats_t;
+
 /** Data returned by Status user call */
 typedef struct {
 	/** Connection state */
 	tcp_cstate_t cstate;
+	/** Connection statistics */
+	tcp_conn_stats_t stats;
 } tcp_conn_status_t;
 
 typedef struct {
@@ -173,6 +190,9 @@ typedef struct {
 	void *data;
 	/** Segment data, original pointer used to free data */
 	void *dfptr;
+
+	/** Number of received segments coalesced into this one */
+	unsigned coalesced;
 } tcp_segment_t;
 
 /** Receive queue entry */
@@ -222,6 +242,10 @@ typedef struct {
 
 	/** Retransmission timer */
 	fibril_timer_t *timer;
+	/** Delayed ACK timer */
+	fibril_timer_t *ack_timer;
+	/** Delayed ACK timer is set */
+	bool ack_timer_set;
 
 	/** Callbacks */
 	tcp_tqueue_cb_t *cb;
@@ -230,7 +254,6 @@ typedef struct {
 /** Connection */
 struct tcp_conn {
 	char *name;
-	link_t link;
 
 	/** Connection callbacks function */
 	tcp_cb_t *cb;
@@ -268,10 +291,17 @@ struct tcp_conn {
 	/** Retransmission queue */
 	tcp_tqueue_t retransmit;
 
-	/** Time-Wait timeout timer */
-	fibril_timer_t *tw_timer;
+	/** Link to list of connections in Time-Wait */
+	link_t tw_link;
+	/** Time-Wait expiration time (uptime in usec) */
+	usec_t tw_expires;
+	/** Connection is on Time-Wait list */
+	bool tw_active;
 
-	/** Receive buffer */
+	/** Listening connection ignores incoming SYNs (backlog full) */
+	bool syn_ignore;
+
+	/** Receive buffer (allocated together with the connection) */
 	uint8_t *rcv_buf;
 	/** Receive buffer size */
 	size_t rcv_buf_size;
@@ -281,8 +311,18 @@ struct tcp_conn {
 	bool rcv_buf_fin;
 	/** Receive buffer CV. Broadcast when new data is inserted */
 	fibril_condvar_t rcv_buf_cv;
+	/** New data inserted into receive buffer, user not notified yet */
+	bool rcv_buf_notify;
+
+	/** Number of received segments not acknowledged yet */
+	unsigned rcv_unacked;
+	/** Acknowledgement should be sent without delay */
+	bool rcv_ack_now;
+
+	/** Connection statistics */
+	tcp_conn_stats_t stats;
 
-	/** Send buffer */
+	/** Send buffer (allocated together with the connection) */
 	uint8_t *snd_buf;
 	/** Send buffer size */
 	size_t snd_buf_size;
@@ -352,7 +392,10 @@ typedef struct tcp_cconn {
 	sysarg_t id;
 	/** Client */
 	struct tcp_client *client;
+	/** Link to tcp_client_t.cconn */
 	link_t lclient;
+	/** Link to tcp_client_t.cconn_map */
+	ht_link_t lmap;
 } tcp_cconn_t;
 
 /** TCP client listener */
@@ -367,6 +410,12 @@ typedef struct tcp_clst {
 	struct tcp_client *client;
 	/** Link to tcp_client_t.clst */
 	link_t lclient;
+	/** Maximum number of connections in Syn-Received */
+	size_t backlog;
+	/** Number of connections in Syn-Received */
+	size_t syn_cnt;
+	/** Listener was destroyed, free it once @c syn_cnt drops to zero */
+	bool destroyed;
 } tcp_clst_t;
 
 /** TCP client */
@@ -375,8 +424,14 @@ typedef struct tcp_client {
 	async_sess_t *sess;
 	/** Client's connections */
 	list_t cconn; /* of tcp_cconn_t */
+	/** Client's connections indexed by ID */
+	hash_table_t cconn_map; /* of tcp_cconn_t */
+	/** Next client connection ID */
+	sysarg_t cconn_next_id;
 	/** Client's listeners */
 	list_t clst;
+	/** Next client listener ID */
+	sysarg_t clst_next_id;
 } tcp_client_t;
 
 /** Internal loopback type */
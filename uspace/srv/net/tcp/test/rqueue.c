@@ -29,6 +29,7 @@
 #include <adt/prodcons.h>
 #include <inet/endpoint.h>
 #include <io/log.h>
+#include <mem.h>
 #include <pcut/pcut.h>
 
 #include "../rqueue.h"
@@ -126,4 +127,49 @@ PCUT_TEST(multiple_segments)
 
 }
 
+/** Test coalescing consecutive data segments */
+PCUT_TEST(coalesce_segments)
+{
+	tcp_segment_t *seg[3];
+	tcp_segment_t *fseg;
+	inet_ep2_t epp;
+	uint8_t data[10];
+	int i;
+
+	tcp_rqueue_init(&rcb);
+	seg_cnt = 0;
+
+	inet_ep2_init(&epp);
+	memset(data, 0, sizeof(data));
+
+	/* Two consecutive data segments followed by a FIN */
+	for (i = 0; i < 2; i++) {
+		seg[i] = tcp_segment_make_data(CTL_ACK, data, sizeof(data));
+		PCUT_ASSERT_NOT_NULL(seg[i]);
+		seg[i]->seq = 100 + i * sizeof(data);
+		tcp_rqueue_insert_seg(&epp, seg[i]);
+	}
+
+	seg[2] = tcp_segment_make_ctrl(CTL_FIN | CTL_ACK);
+	PCUT_ASSERT_NOT_NULL(seg[2]);
+	seg[2]->seq = 100 + 2 * sizeof(data);
+	tcp_rqueue_insert_seg(&epp, seg[2]);
+
+	tcp_rqueue_fibril_start();
+	tcp_rqueue_fini();
+
+	PCUT_ASSERT_INT_EQUALS(2, seg_cnt);
+
+	fseg = recv_seg[0];
+	PCUT_ASSERT_EQUALS(seg[0], fseg);
+	PCUT_ASSERT_INT_EQUALS(100, fseg->seq);
+	PCUT_ASSERT_INT_EQUALS(2 * sizeof(data), fseg->len);
+	PCUT_ASSERT_INT_EQUALS(1, fseg->coalesced);
+
+	PCUT_ASSERT_EQUALS(seg[2], recv_seg[1]);
+
+	tcp_segment_delete(seg[0]);
+	tcp_segment_delete(seg[2]);
+}
+
 PCUT_EXPORT(rqueue);
@@ -244,4 +244,66 @@ PCUT_TEST(data_seg_trim)
 	free(cdata);
 }
 
+/** Test appending text of the following segment */
+PCUT_TEST(data_seg_append)
+{
+	tcp_segment_t *seg, *nseg;
+	uint8_t *data;
+	uint8_t *cdata;
+	size_t i, dsize;
+	errno_t rc;
+
+	dsize = 15;
+	data = malloc(dsize);
+	PCUT_ASSERT_NOT_NULL(data);
+	cdata = malloc(2 * dsize);
+	PCUT_ASSERT_NOT_NULL(cdata);
+
+	for (i = 0; i < dsize; i++)
+		data[i] = (uint8_t) i;
+
+	seg = tcp_segment_make_data(CTL_ACK, data, dsize);
+	PCUT_ASSERT_NOT_NULL(seg);
+	seg->seq = 10;
+	seg->ack = 20;
+
+	nseg = tcp_segment_make_data(CTL_ACK, data, dsize);
+	PCUT_ASSERT_NOT_NULL(nseg);
+	nseg->seq = 10 + dsize;
+	nseg->ack = 30;
+	nseg->wnd = 40;
+
+	/* Trim the first segment so that its text is not at buffer start */
+	tcp_segment_trim(seg, 1, 0);
+	PCUT_ASSERT_INT_EQUALS(dsize - 1, tcp_segment_text_size(seg));
+
+	rc = tcp_segment_append(seg, nseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_INT_EQUALS(CTL_ACK, seg->ctrl);
+	PCUT_ASSERT_INT_EQUALS(11, seg->seq);
+	PCUT_ASSERT_INT_EQUALS(30, seg->ack);
+	PCUT_ASSERT_INT_EQUALS(40, seg->wnd);
+	PCUT_ASSERT_INT_EQUALS(1, seg->coalesced);
+	PCUT_ASSERT_INT_EQUALS(2 * dsize - 1, tcp_segment_text_size(seg));
+
+	tcp_segment_text_copy(seg, cdata, 2 * dsize - 1);
+	for (i = 0; i < dsize - 1; i++)
+		PCUT_ASSERT_INT_EQUALS(data[i + 1], cdata[i]);
+	for (i = 0; i < dsize; i++)
+		PCUT_ASSERT_INT_EQUALS(data[i], cdata[dsize - 1 + i]);
+
+	/* Append once more, now extending the buffer in place */
+	nseg->seq = seg->seq + seg->len;
+	rc = tcp_segment_append(seg, nseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(2, seg->coalesced);
+	PCUT_ASSERT_INT_EQUALS(3 * dsize - 1, tcp_segment_text_size(seg));
+
+	tcp_segment_delete(seg);
+	tcp_segment_delete(nseg);
+	free(data);
+	free(cdata);
+}
+
 PCUT_EXPORT(segment);
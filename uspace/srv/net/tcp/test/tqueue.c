@@ -257,6 +257,104 @@ PCUT_TEST(ack_received)
 	tcp_conn_delete(conn);
 }
 
+/** Test acknowledging received segments */
+PCUT_TEST(ack_segs)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_nxt = 10;
+	conn->rcv_nxt = 50;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+
+	/* Single segment, ACK should be delayed */
+	conn->rcv_unacked = 1;
+	tcp_tqueue_ack(conn);
+	PCUT_ASSERT_EQUALS(0, seg_cnt);
+	PCUT_ASSERT_TRUE(conn->retransmit.ack_timer_set);
+
+	/* Second segment, ACK should be sent immediately */
+	conn->rcv_unacked = 2;
+	tcp_tqueue_ack(conn);
+	PCUT_ASSERT_EQUALS(1, seg_cnt);
+	PCUT_ASSERT_EQUALS(0, conn->rcv_unacked);
+	PCUT_ASSERT_INT_EQUALS(1, conn->stats.acks_sent);
+
+	/* Nothing to acknowledge */
+	tcp_tqueue_ack(conn);
+	PCUT_ASSERT_EQUALS(1, seg_cnt);
+
+	/* Immediate ACK requested */
+	conn->rcv_unacked = 1;
+	conn->rcv_ack_now = true;
+	tcp_tqueue_ack(conn);
+	PCUT_ASSERT_EQUALS(2, seg_cnt);
+	PCUT_ASSERT_FALSE(conn->rcv_ack_now);
+
+	tcp_conn_reset(conn);
+	PCUT_ASSERT_FALSE(conn->retransmit.ack_timer_set);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+
+	PCUT_ASSERT_INT_EQUALS(CTL_ACK, trans_seg[0]->ctrl);
+	PCUT_ASSERT_INT_EQUALS(50, trans_seg[0]->ack);
+	tcp_segment_delete(trans_seg[0]);
+	tcp_segment_delete(trans_seg[1]);
+}
+
+/** Test sending ACK when delayed ACK timer expires */
+PCUT_TEST(ack_delayed)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_nxt = 10;
+	conn->rcv_nxt = 50;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+	conn->rcv_unacked = 1;
+	tcp_tqueue_ack(conn);
+	PCUT_ASSERT_EQUALS(0, seg_cnt);
+	tcp_conn_unlock(conn);
+
+	/* Wait for the delayed ACK timer to fire */
+	fibril_usleep(500 * 1000);
+
+	tcp_conn_lock(conn);
+	PCUT_ASSERT_EQUALS(1, seg_cnt);
+	PCUT_ASSERT_FALSE(conn->retransmit.ack_timer_set);
+	PCUT_ASSERT_EQUALS(0, conn->rcv_unacked);
+	PCUT_ASSERT_INT_EQUALS(1, conn->stats.acks_delayed);
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+
+	PCUT_ASSERT_INT_EQUALS(CTL_ACK, trans_seg[0]->ctrl);
+	PCUT_ASSERT_INT_EQUALS(50, trans_seg[0]->ack);
+	tcp_segment_delete(trans_seg[0]);
+}
+
 static void tqueue_test_transmit_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 {
 	trans_seg[seg_cnt++] = tcp_segment_dup(seg);
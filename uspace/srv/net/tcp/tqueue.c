@@ -54,7 +54,13 @@
 
 #define RETRANSMIT_TIMEOUT	(2*1000*1000)
 
+/** Maximum delay of acknowledgement (RFC 1122 requires < 0.5 s) */
+#define ACK_DELAY		(200*1000)
+/** Acknowledge at least every this many received segments */
+#define ACK_SEGS_MAX		2
+
 static void retransmit_timeout_func(void *);
+static void ack_timeout_func(void *);
 static void tcp_tqueue_timer_set(tcp_conn_t *);
 static void tcp_tqueue_timer_clear(tcp_conn_t *);
 static void tcp_tqueue_seg(tcp_conn_t *, tcp_segment_t *);
@@ -71,6 +77,15 @@ errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
 	if (tqueue->timer == NULL)
 		return ENOMEM;
 
+	tqueue->ack_timer = fibril_timer_create(&conn->lock);
+	if (tqueue->ack_timer == NULL) {
+		fibril_timer_destroy(tqueue->timer);
+		tqueue->timer = NULL;
+		return ENOMEM;
+	}
+
+	tqueue->ack_timer_set = false;
+
 	list_initialize(&tqueue->list);
 
 	return EOK;
@@ -78,7 +93,18 @@ errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
 
 void tcp_tqueue_clear(tcp_tqueue_t *tqueue)
 {
-	tcp_tqueue_timer_clear(tqueue->conn);
+	tcp_conn_t *conn = tqueue->conn;
+
+	tcp_tqueue_timer_clear(conn);
+
+	/* Clear delayed ACK timer */
+	conn->rcv_unacked = 0;
+	conn->rcv_ack_now = false;
+	if (tqueue->ack_timer_set) {
+		if (fibril_timer_clear_locked(tqueue->ack_timer) == fts_active)
+			tcp_conn_delref(conn);
+		tqueue->ack_timer_set = false;
+	}
 }
 
 void tcp_tqueue_fini(tcp_tqueue_t *tqueue)
@@ -91,6 +117,11 @@ void tcp_tqueue_fini(tcp_tqueue_t *tqueue)
 		tqueue->timer = NULL;
 	}
 
+	if (tqueue->ack_timer != NULL) {
+		fibril_timer_destroy(tqueue->ack_timer);
+		tqueue->ack_timer = NULL;
+	}
+
 	while (!list_empty(&tqueue->list)) {
 		link = list_first(&tqueue->list);
 		tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
@@ -288,6 +319,59 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 	tcp_tqueue_new_data(conn);
 }
 
+/** Acknowledge received segments.
+ *
+ * Should be called after a batch of incoming segments has been processed.
+ * Per RFC 1122 the ACK is sent immediately if at least two segments
+ * are waiting to be acknowledged (or if requested via @c rcv_ack_now),
+ * otherwise it is delayed in hope that it can be carried by outgoing
+ * data or combined with the ACK for the next segment.
+ *
+ * @param conn	Connection
+ */
+void tcp_tqueue_ack(tcp_conn_t *conn)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (conn->rcv_unacked == 0 && !conn->rcv_ack_now)
+		return;
+
+	if (conn->rcv_ack_now || conn->rcv_unacked >= ACK_SEGS_MAX) {
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+		return;
+	}
+
+	if (conn->retransmit.ack_timer_set)
+		return;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Delaying ACK", conn->name);
+
+	tcp_conn_addref(conn);
+	conn->retransmit.ack_timer_set = true;
+	fibril_timer_set_locked(conn->retransmit.ack_timer, ACK_DELAY,
+	    ack_timeout_func, (void *) conn);
+}
+
+/** Note that acknowledgement is being sent in outgoing segment.
+ *
+ * @param conn	Connection
+ * @param seg	Outgoing segment with ACK bit set
+ */
+static void tcp_tqueue_ack_sent(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	if (seg->ctrl == CTL_ACK && seg->len == 0)
+		++conn->stats.acks_sent;
+	else if (conn->rcv_unacked > 0)
+		++conn->stats.acks_piggybacked;
+
+	/*
+	 * We leave the delayed ACK timer running (if it is set). It will
+	 * find there is nothing to acknowledge.
+	 */
+	conn->rcv_unacked = 0;
+	conn->rcv_ack_now = false;
+}
+
 static void tcp_conn_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_conn_transmit_segment(%p, %p)",
@@ -295,10 +379,12 @@ static void tcp_conn_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	seg->wnd = conn->rcv_wnd;
 
-	if ((seg->ctrl & CTL_ACK) != 0)
+	if ((seg->ctrl & CTL_ACK) != 0) {
 		seg->ack = conn->rcv_nxt;
-	else
+		tcp_tqueue_ack_sent(conn, seg);
+	} else {
 		seg->ack = 0;
+	}
 
 	tcp_tqueue_send_immed(conn, seg);
 }
@@ -366,6 +452,30 @@ static void retransmit_timeout_func(void *arg)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmit_timeout_func(%p) end", conn->name, conn);
 }
 
+/** Delayed ACK timeout handler.
+ *
+ * @param arg	Connection
+ */
+static void ack_timeout_func(void *arg)
+{
+	tcp_conn_t *conn = (tcp_conn_t *) arg;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: ack_timeout_func(%p)", conn->name,
+	    conn);
+
+	tcp_conn_lock(conn);
+
+	conn->retransmit.ack_timer_set = false;
+
+	if (conn->cstate != st_closed && conn->rcv_unacked > 0) {
+		++conn->stats.acks_delayed;
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+	}
+
+	tcp_conn_unlock(conn);
+	tcp_conn_delref(conn);
+}
+
 /** Set or re-set retransmission timer */
 static void tcp_tqueue_timer_set(tcp_conn_t *conn)
 {
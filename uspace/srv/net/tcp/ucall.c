@@ -75,6 +75,9 @@ tcp_error_t tcp_uc_open(inet_ep2_t *epp, acpass_t acpass,
 	    oflags == tcp_open_nonblock ? "nonblock" : "none", conn);
 
 	nconn = tcp_conn_new(epp);
+	if (nconn == NULL)
+		return TCP_ENORES;
+
 	rc = tcp_conn_add(nconn);
 	if (rc != EOK) {
 		tcp_conn_delete(nconn);
@@ -290,6 +293,7 @@ void tcp_uc_status(tcp_conn_t *conn, tcp_conn_status_t *cstatus)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_uc_status()");
 	cstatus->cstate = conn->cstate;
+	cstatus->stats = conn->stats;
 }
 
 /** Delete connection user call.
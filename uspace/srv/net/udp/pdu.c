@@ -40,49 +40,12 @@
 #include <mem.h>
 #include <stdlib.h>
 #include <inet/addr.h>
+#include <inet/checksum.h>
 #include "msg.h"
 #include "pdu.h"
 #include "std.h"
 #include "udp_type.h"
 
-#define UDP_CHECKSUM_INIT 0xffff
-
-/** One's complement addition.
- *
- * Result is a + b + carry.
- */
-static uint16_t udp_ocadd16(uint16_t a, uint16_t b)
-{
-	uint32_t s;
-
-	s = (uint32_t)a + (uint32_t)b;
-	return (s & 0xffff) + (s >> 16);
-}
-
-static uint16_t udp_checksum_calc(uint16_t ivalue, void *data, size_t size)
-{
-	uint16_t sum;
-	uint16_t w;
-	size_t words, i;
-	uint8_t *bdata;
-
-	sum = ~ivalue;
-	words = size / 2;
-	bdata = (uint8_t *)data;
-
-	for (i = 0; i < words; i++) {
-		w = ((uint16_t)bdata[2 * i] << 8) | bdata[2 * i + 1];
-		sum = udp_ocadd16(sum, w);
-	}
-
-	if (size % 2 != 0) {
-		w = ((uint16_t)bdata[2 * words] << 8);
-		sum = udp_ocadd16(sum, w);
-	}
-
-	return ~sum;
-}
-
 static ip_ver_t udp_phdr_setup(udp_pdu_t *pdu, udp_phdr_t *phdr,
     udp_phdr6_t *phdr6)
 {
@@ -129,7 +92,12 @@ void udp_pdu_delete(udp_pdu_t *pdu)
 	free(pdu);
 }
 
-static uint16_t udp_pdu_checksum_calc(udp_pdu_t *pdu)
+/** Compute checksum of the pseudo header and UDP header.
+ *
+ * @param pdu PDU with header filled in
+ * @return Partial checksum to be continued over the payload
+ */
+static uint16_t udp_pdu_checksum_headers(udp_pdu_t *pdu)
 {
 	uint16_t cs_phdr;
 	udp_phdr_t phdr;
@@ -138,18 +106,18 @@ static uint16_t udp_pdu_checksum_calc(udp_pdu_t *pdu)
 	ip_ver_t ver = udp_phdr_setup(pdu, &phdr, &phdr6);
 	switch (ver) {
 	case ip_v4:
-		cs_phdr = udp_checksum_calc(UDP_CHECKSUM_INIT, (void *) &phdr,
+		cs_phdr = inet_checksum_calc(INET_CHECKSUM_INIT, &phdr,
 		    sizeof(udp_phdr_t));
 		break;
 	case ip_v6:
-		cs_phdr = udp_checksum_calc(UDP_CHECKSUM_INIT, (void *) &phdr6,
+		cs_phdr = inet_checksum_calc(INET_CHECKSUM_INIT, &phdr6,
 		    sizeof(udp_phdr6_t));
 		break;
 	default:
 		assert(false);
 	}
 
-	return udp_checksum_calc(cs_phdr, pdu->data, pdu->data_size);
+	return inet_checksum_calc(cs_phdr, pdu->data, sizeof(udp_header_t));
 }
 
 static void udp_pdu_set_checksum(udp_pdu_t *pdu, uint16_t checksum)
@@ -223,7 +191,7 @@ errno_t udp_pdu_encode(inet_ep2_t *epp, udp_msg_t *msg, udp_pdu_t **pdu)
 	npdu->dest = epp->remote.addr;
 
 	npdu->data_size = sizeof(udp_header_t) + msg->data_size;
-	npdu->data = calloc(1, npdu->data_size);
+	npdu->data = malloc(npdu->data_size);
 	if (npdu->data == NULL) {
 		udp_pdu_delete(npdu);
 		return ENOMEM;
@@ -235,11 +203,10 @@ errno_t udp_pdu_encode(inet_ep2_t *epp, udp_msg_t *msg, udp_pdu_t **pdu)
 	hdr->length = host2uint16_t_be(npdu->data_size);
 	hdr->checksum = 0;
 
-	memcpy((uint8_t *)npdu->data + sizeof(udp_header_t), msg->data,
+	/* Copy the payload and compute checksum in one pass */
+	checksum = inet_checksum_copy(udp_pdu_checksum_headers(npdu),
+	    (uint8_t *)npdu->data + sizeof(udp_header_t), msg->data,
 	    msg->data_size);
-
-	/* Checksum calculation */
-	checksum = udp_pdu_checksum_calc(npdu);
 	udp_pdu_set_checksum(npdu, checksum);
 
 	*pdu = npdu;
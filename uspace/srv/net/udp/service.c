@@ -42,6 +42,7 @@
 #include <ipc/udp.h>
 #include <loc.h>
 #include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 #include "assoc.h"
@@ -90,9 +91,17 @@ static void udp_ev_data(udp_client_t *client)
 static void udp_recv_msg_cassoc(void *arg, inet_ep2_t *epp, udp_msg_t *msg)
 {
 	udp_cassoc_t *cassoc = (udp_cassoc_t *) arg;
+	bool notify;
+
+	/*
+	 * The client drains the whole receive queue on each 'data' event,
+	 * it only needs to be notified when the queue becomes non-empty.
+	 */
+	notify = list_empty(&cassoc->client->crcv_queue);
 
 	udp_cassoc_queue_msg(cassoc, epp, msg);
-	udp_ev_data(cassoc->client);
+	if (notify)
+		udp_ev_data(cassoc->client);
 }
 
 /** Create association.
@@ -414,6 +423,93 @@ static void udp_assoc_send_msg_srv(udp_client_t *client, ipc_call_t *icall)
 	free(data);
 }
 
+/** Send multiple messages via association.
+ *
+ * Handle client request to send messages packed in a multi-message
+ * buffer. Sending stops at the first message that fails. The number
+ * of messages sent is returned in the answer.
+ *
+ * @param client UDP client
+ * @param icall  Async request data
+ *
+ */
+static void udp_assoc_send_mmsg_srv(udp_client_t *client, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	udp_cassoc_t *cassoc;
+	udp_mmsg_hdr_t *hdr;
+	inet_ep_t *dest;
+	udp_msg_t msg;
+	uint8_t *buf;
+	size_t off;
+	size_t sent;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_assoc_send_mmsg_srv()");
+
+	if (!async_data_write_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	if (size > DATA_XFER_LIMIT) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	buf = malloc(size);
+	if (buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	rc = async_data_write_finalize(&call, buf, size);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		free(buf);
+		return;
+	}
+
+	rc = udp_cassoc_get(client, ipc_get_arg1(icall), &cassoc);
+	if (rc != EOK) {
+		async_answer_1(icall, rc, 0);
+		free(buf);
+		return;
+	}
+
+	sent = 0;
+	off = 0;
+	while (size - off >= sizeof(udp_mmsg_hdr_t)) {
+		hdr = (udp_mmsg_hdr_t *) (buf + off);
+		if (hdr->size > size - off - sizeof(udp_mmsg_hdr_t)) {
+			rc = EINVAL;
+			break;
+		}
+
+		/* Unspecified endpoint selects association's remote ep. */
+		dest = &hdr->remote_ep;
+		if (inet_addr_is_any(&dest->addr) &&
+		    dest->port == inet_port_any)
+			dest = NULL;
+
+		msg.data = buf + off + sizeof(udp_mmsg_hdr_t);
+		msg.data_size = hdr->size;
+		rc = udp_assoc_send(cassoc->assoc, dest, &msg);
+		if (rc != EOK)
+			break;
+
+		++sent;
+		off += min(UDP_MMSG_SPACE(hdr->size), size - off);
+	}
+
+	async_answer_1(icall, rc, sent);
+	free(buf);
+}
+
 /** Get next received message.
  *
  * @param client UDP Client
@@ -530,6 +626,112 @@ static void udp_rmsg_read_srv(udp_client_t *client, ipc_call_t *icall)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_read_srv(): OK");
 }
 
+/** Read multiple received messages.
+ *
+ * Handle client request to read as many received messages as fit in
+ * the client's buffer, packed in a multi-message buffer. Messages read
+ * are discarded. The number of messages and the number of bytes used
+ * are returned in the answer.
+ *
+ * @param client UDP client
+ * @param icall  Async request data
+ *
+ */
+static void udp_rmsg_read_mmsg_srv(udp_client_t *client, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	udp_crcv_queue_entry_t *enext;
+	udp_mmsg_hdr_t *hdr;
+	link_t *link;
+	uint8_t *buf;
+	size_t size;
+	size_t space;
+	size_t off;
+	size_t cnt;
+	size_t i;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_read_mmsg_srv()");
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	size = min(size, (size_t) DATA_XFER_LIMIT);
+
+	enext = udp_rmsg_get_next(client);
+	if (enext == NULL) {
+		async_answer_0(&call, ENOENT);
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	if (UDP_MMSG_SPACE(enext->msg->data_size) > size) {
+		/* Client needs to read this message piece-wise */
+		async_answer_0(&call, ELIMIT);
+		async_answer_0(icall, ELIMIT);
+		return;
+	}
+
+	/* Determine how many messages fit */
+	off = 0;
+	cnt = 0;
+	link = &enext->link;
+	while (link != NULL) {
+		enext = list_get_instance(link, udp_crcv_queue_entry_t, link);
+		space = UDP_MMSG_SPACE(enext->msg->data_size);
+		if (space > size - off)
+			break;
+
+		off += space;
+		++cnt;
+		link = list_next(link, &client->crcv_queue);
+	}
+
+	buf = calloc(1, off);
+	if (buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	off = 0;
+	link = list_first(&client->crcv_queue);
+	for (i = 0; i < cnt; i++) {
+		enext = list_get_instance(link, udp_crcv_queue_entry_t, link);
+		hdr = (udp_mmsg_hdr_t *) (buf + off);
+		hdr->remote_ep = enext->epp.remote;
+		hdr->assoc_id = enext->cassoc->id;
+		hdr->size = enext->msg->data_size;
+		memcpy(buf + off + sizeof(udp_mmsg_hdr_t), enext->msg->data,
+		    enext->msg->data_size);
+
+		off += UDP_MMSG_SPACE(enext->msg->data_size);
+		link = list_next(link, &client->crcv_queue);
+	}
+
+	rc = async_data_read_finalize(&call, buf, off);
+	free(buf);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	/* Discard messages transferred to the client */
+	for (i = 0; i < cnt; i++) {
+		enext = udp_rmsg_get_next(client);
+		list_remove(&enext->link);
+		udp_msg_delete(enext->msg);
+		free(enext);
+	}
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_read_mmsg_srv(): cnt=%zu, "
+	    "size=%zu", cnt, off);
+	async_answer_2(icall, EOK, cnt, off);
+}
+
 /** Discard first received message.
  *
  * Handle client request to discard first received message, advancing
@@ -608,12 +810,18 @@ static void udp_client_conn(ipc_call_t *icall, void *arg)
 		case UDP_ASSOC_SEND_MSG:
 			udp_assoc_send_msg_srv(&client, &call);
 			break;
+		case UDP_ASSOC_SEND_MMSG:
+			udp_assoc_send_mmsg_srv(&client, &call);
+			break;
 		case UDP_RMSG_INFO:
 			udp_rmsg_info_srv(&client, &call);
 			break;
 		case UDP_RMSG_READ:
 			udp_rmsg_read_srv(&client, &call);
 			break;
+		case UDP_RMSG_READ_MMSG:
+			udp_rmsg_read_mmsg_srv(&client, &call);
+			break;
 		case UDP_RMSG_DISCARD:
 			udp_rmsg_discard_srv(&client, &call);
 			break;
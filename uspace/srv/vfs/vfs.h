@@ -227,6 +227,9 @@ extern errno_t vfs_op_write(int fd, aoff64_t, size_t *out_bytes);
 
 extern void vfs_register(ipc_call_t *);
 
+extern bool vfs_page_cache_init(void);
+extern void vfs_page_cache_invalidate(vfs_triplet_t *);
+extern void vfs_page_cache_invalidate_fs(fs_handle_t, service_id_t);
 extern void vfs_page_in(ipc_call_t *);
 
 typedef struct {
@@ -483,6 +483,17 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 	if (file->node->type == VFS_NODE_DIRECTORY)
 		fibril_rwlock_read_unlock(&namespace_rwlock);
 
+	if (!read) {
+		/* Pages cached by the pager are now stale. */
+		vfs_triplet_t triplet = {
+			.fs_handle = file->node->fs_handle,
+			.service_id = file->node->service_id,
+			.index = file->node->index
+		};
+
+		vfs_page_cache_invalidate(&triplet);
+	}
+
 	/* Unlock the VFS node. */
 	if (rlock) {
 		fibril_rwlock_read_unlock(&file->node->contents_rwlock);
@@ -599,6 +610,8 @@ errno_t vfs_op_rename(int basefd, char *old, char *new)
 
 	/* If the node is not held by anyone, try to destroy it. */
 	if (orig_unlinked) {
+		vfs_page_cache_invalidate(&new_lr_orig.triplet);
+
 		vfs_node_t *node = vfs_node_peek(&new_lr_orig);
 		if (!node)
 			out_destroy(&new_lr_orig.triplet);
@@ -629,6 +642,14 @@ errno_t vfs_op_resize(int fd, int64_t size)
 	if (rc == EOK)
 		file->node->size = size;
 
+	vfs_triplet_t triplet = {
+		.fs_handle = file->node->fs_handle,
+		.service_id = file->node->service_id,
+		.index = file->node->index
+	};
+
+	vfs_page_cache_invalidate(&triplet);
+
 	fibril_rwlock_write_unlock(&file->node->contents_rwlock);
 	vfs_file_put(file);
 	return rc;
@@ -766,6 +787,12 @@ errno_t vfs_op_unlink(int parentfd, int expectfd, char *path)
 	if (rc != EOK)
 		goto exit;
 
+	/*
+	 * Drop cached pages now, the file may be destroyed once the last
+	 * reference to its node goes away.
+	 */
+	vfs_page_cache_invalidate(&lr.triplet);
+
 	/* If the node is not held by anyone, try to destroy it. */
 	vfs_node_t *node = vfs_node_peek(&lr);
 	if (!node)
@@ -822,6 +849,9 @@ errno_t vfs_op_unmount(int mpfd)
 		return rc;
 	}
 
+	vfs_page_cache_invalidate_fs(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
+
 	vfs_node_forget(mp->node->mount);
 	vfs_node_put(mp->node);
 	mp->node->mount = NULL;
@@ -32,7 +32,7 @@
 
 /**
  * @file vfs_pager.c
- * @brief VFS pager operations.
+ * @brief VFS pager operations and page cache.
  */
 
 #include "vfs.h"
@@ -40,12 +40,372 @@
 #include <fibril_synch.h>
 #include <errno.h>
 #include <as.h>
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <mem.h>
+#include <smc.h>
+#include <stdlib.h>
 
-void vfs_page_in(ipc_call_t *req)
+/** Maximum number of pages kept in the VFS page cache. */
+#define VFS_PAGE_CACHE_MAX  1024
+
+/** File with at least one page in the page cache or being read into it. */
+typedef struct {
+	/** Link in pcache_files. */
+	ht_link_t fh_link;
+	/** Identity of the file. */
+	vfs_triplet_t triplet;
+	/** Cached pages of this file (vfs_page_t). */
+	list_t pages;
+	/** Invalidation generation, incremented on each invalidation. */
+	unsigned gen;
+	/** Number of page-ins reading the file outside pcache_mutex. */
+	unsigned readers;
+} vfs_page_file_t;
+
+/** Page of file data kept in the VFS page cache.
+ *
+ * The page is backed by a single-page anonymous area in the VFS address
+ * space. Clients map the underlying frame directly, so the frame is shared
+ * between all tasks that fault in the same page of the same file and it
+ * outlives the cache entry for as long as any client mapping exists.
+ */
+typedef struct {
+	/** Link in pcache_pages. */
+	ht_link_t ph_link;
+	/** Link in vfs_page_file_t.pages. */
+	link_t file_link;
+	/** Link in pcache_lru. */
+	link_t lru_link;
+	/** File the page belongs to. */
+	vfs_page_file_t *file;
+	/** Offset of the page in the file. */
+	aoff64_t offset;
+	/** Page data. */
+	void *data;
+} vfs_page_t;
+
+/** Page cache lookup key. */
+typedef struct {
+	vfs_triplet_t triplet;
+	aoff64_t offset;
+} vfs_page_key_t;
+
+/** Mutex protecting the page cache. */
+static FIBRIL_MUTEX_INITIALIZE(pcache_mutex);
+
+/** Cached pages hashed by file and offset. */
+static hash_table_t pcache_pages;
+/** Files with cached pages hashed by triplet. */
+static hash_table_t pcache_files;
+/** Cached pages, least recently used at the tail. */
+static LIST_INITIALIZE(pcache_lru);
+/** Number of pages in the cache. */
+static size_t pcache_count;
+
+static size_t triplet_hash(const vfs_triplet_t *tri)
+{
+	size_t hash = hash_combine(tri->fs_handle, tri->index);
+	return hash_combine(hash, tri->service_id);
+}
+
+static bool triplet_equal(const vfs_triplet_t *a, const vfs_triplet_t *b)
+{
+	return a->fs_handle == b->fs_handle &&
+	    a->service_id == b->service_id && a->index == b->index;
+}
+
+static size_t pages_key_hash(const void *key)
+{
+	const vfs_page_key_t *pkey = key;
+	return hash_combine(triplet_hash(&pkey->triplet),
+	    hash_mix64(pkey->offset));
+}
+
+static size_t pages_hash(const ht_link_t *item)
+{
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, ph_link);
+	vfs_page_key_t pkey = {
+		.triplet = page->file->triplet,
+		.offset = page->offset
+	};
+
+	return pages_key_hash(&pkey);
+}
+
+static bool pages_key_equal(const void *key, const ht_link_t *item)
+{
+	const vfs_page_key_t *pkey = key;
+	vfs_page_t *page = hash_table_get_inst(item, vfs_page_t, ph_link);
+	return page->offset == pkey->offset &&
+	    triplet_equal(&page->file->triplet, &pkey->triplet);
+}
+
+static size_t files_key_hash(const void *key)
+{
+	return triplet_hash(key);
+}
+
+static size_t files_hash(const ht_link_t *item)
+{
+	vfs_page_file_t *file = hash_table_get_inst(item, vfs_page_file_t,
+	    fh_link);
+	return triplet_hash(&file->triplet);
+}
+
+static bool files_key_equal(const void *key, const ht_link_t *item)
+{
+	vfs_page_file_t *file = hash_table_get_inst(item, vfs_page_file_t,
+	    fh_link);
+	return triplet_equal(&file->triplet, key);
+}
+
+static hash_table_ops_t pages_ops = {
+	.hash = pages_hash,
+	.key_hash = pages_key_hash,
+	.key_equal = pages_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static hash_table_ops_t files_ops = {
+	.hash = files_hash,
+	.key_hash = files_key_hash,
+	.key_equal = files_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize the VFS page cache.
+ *
+ * @return True on success, false on failure.
+ */
+bool vfs_page_cache_init(void)
+{
+	if (!hash_table_create(&pcache_pages, 0, 0, &pages_ops))
+		return false;
+
+	if (!hash_table_create(&pcache_files, 0, 0, &files_ops)) {
+		hash_table_destroy(&pcache_pages);
+		return false;
+	}
+
+	return true;
+}
+
+/** Find or create the page cache structure of a file.
+ *
+ * @param triplet File identity.
+ * @return File structure or @c NULL if out of memory.
+ */
+static vfs_page_file_t *vfs_page_file_get(vfs_triplet_t *triplet)
+{
+	assert(fibril_mutex_is_locked(&pcache_mutex));
+
+	ht_link_t *link = hash_table_find(&pcache_files, triplet);
+	if (link != NULL)
+		return hash_table_get_inst(link, vfs_page_file_t, fh_link);
+
+	vfs_page_file_t *file = malloc(sizeof(vfs_page_file_t));
+	if (file == NULL)
+		return NULL;
+
+	file->triplet = *triplet;
+	list_initialize(&file->pages);
+	file->gen = 0;
+	file->readers = 0;
+	hash_table_insert(&pcache_files, &file->fh_link);
+	return file;
+}
+
+/** Free the page cache structure of a file if it is no longer used.
+ *
+ * @param file File structure.
+ */
+static void vfs_page_file_release(vfs_page_file_t *file)
+{
+	assert(fibril_mutex_is_locked(&pcache_mutex));
+
+	if (list_empty(&file->pages) && file->readers == 0) {
+		hash_table_remove_item(&pcache_files, &file->fh_link);
+		free(file);
+	}
+}
+
+/** Remove page from the cache and release its memory.
+ *
+ * Frames already mapped by clients stay referenced by them.
+ *
+ * @param page Page to remove.
+ */
+static void vfs_page_remove(vfs_page_t *page)
+{
+	vfs_page_file_t *file = page->file;
+
+	assert(fibril_mutex_is_locked(&pcache_mutex));
+
+	hash_table_remove_item(&pcache_pages, &page->ph_link);
+	list_remove(&page->file_link);
+	list_remove(&page->lru_link);
+	pcache_count--;
+
+	as_area_destroy(page->data);
+	free(page);
+
+	vfs_page_file_release(file);
+}
+
+/** Invalidate all pages of a file.
+ *
+ * Page-ins of the file that are in progress will not insert their
+ * (possibly stale) pages into the cache.
+ *
+ * @param file File structure, may be freed by this function.
+ */
+static void vfs_page_file_invalidate(vfs_page_file_t *file)
+{
+	assert(fibril_mutex_is_locked(&pcache_mutex));
+
+	file->gen++;
+
+	if (list_empty(&file->pages)) {
+		/* Page-ins are in progress, keep the structure. */
+		return;
+	}
+
+	/* Removing the last page frees the file structure if unused. */
+	unsigned long count = list_count(&file->pages);
+	while (count-- > 0) {
+		vfs_page_remove(list_get_instance(list_first(&file->pages),
+		    vfs_page_t, file_link));
+	}
+}
+
+/** Remove all pages of a file from the page cache.
+ *
+ * Must be called whenever the contents of the file change or the file is
+ * destroyed, so that new mappings do not see stale data.
+ *
+ * @param triplet File identity.
+ */
+void vfs_page_cache_invalidate(vfs_triplet_t *triplet)
+{
+	fibril_mutex_lock(&pcache_mutex);
+
+	ht_link_t *link = hash_table_find(&pcache_files, triplet);
+	if (link != NULL) {
+		vfs_page_file_invalidate(hash_table_get_inst(link,
+		    vfs_page_file_t, fh_link));
+	}
+
+	fibril_mutex_unlock(&pcache_mutex);
+}
+
+/** File system instance whose pages are being invalidated. */
+typedef struct {
+	fs_handle_t fs_handle;
+	service_id_t service_id;
+} vfs_page_fs_t;
+
+static bool vfs_page_invalidate_fs_file(ht_link_t *item, void *arg)
+{
+	vfs_page_file_t *file = hash_table_get_inst(item, vfs_page_file_t,
+	    fh_link);
+	vfs_page_fs_t *fs = (vfs_page_fs_t *) arg;
+
+	if (file->triplet.fs_handle == fs->fs_handle &&
+	    file->triplet.service_id == fs->service_id)
+		vfs_page_file_invalidate(file);
+
+	return true;
+}
+
+/** Remove all pages belonging to one file system instance.
+ *
+ * @param fs_handle  File system handle.
+ * @param service_id Service ID of the file system instance.
+ */
+void vfs_page_cache_invalidate_fs(fs_handle_t fs_handle,
+    service_id_t service_id)
+{
+	vfs_page_fs_t fs = {
+		.fs_handle = fs_handle,
+		.service_id = service_id
+	};
+
+	fibril_mutex_lock(&pcache_mutex);
+	hash_table_apply(&pcache_files, vfs_page_invalidate_fs_file, &fs);
+	fibril_mutex_unlock(&pcache_mutex);
+}
+
+/** Find a page in the cache and mark it as most recently used.
+ *
+ * @param key Page key.
+ * @return Cached page or @c NULL if not found.
+ */
+static vfs_page_t *vfs_page_find(vfs_page_key_t *key)
+{
+	assert(fibril_mutex_is_locked(&pcache_mutex));
+
+	ht_link_t *link = hash_table_find(&pcache_pages, key);
+	if (link == NULL)
+		return NULL;
+
+	vfs_page_t *page = hash_table_get_inst(link, vfs_page_t, ph_link);
+	list_remove(&page->lru_link);
+	list_prepend(&page->lru_link, &pcache_lru);
+	return page;
+}
+
+/** Insert a freshly read page into the cache.
+ *
+ * @param file   File the page belongs to.
+ * @param offset Offset of the page in the file.
+ * @param data   Page data.
+ * @return Cached page or @c NULL if out of memory.
+ */
+static vfs_page_t *vfs_page_insert(vfs_page_file_t *file, aoff64_t offset,
+    void *data)
+{
+	assert(fibril_mutex_is_locked(&pcache_mutex));
+
+	vfs_page_t *page = malloc(sizeof(vfs_page_t));
+	if (page == NULL)
+		return NULL;
+
+	page->file = file;
+	page->offset = offset;
+	page->data = data;
+	list_append(&page->file_link, &file->pages);
+	list_prepend(&page->lru_link, &pcache_lru);
+	hash_table_insert(&pcache_pages, &page->ph_link);
+	pcache_count++;
+
+	/* Evict least recently used pages. */
+	while (pcache_count > VFS_PAGE_CACHE_MAX) {
+		vfs_page_t *victim = list_get_instance(list_last(&pcache_lru),
+		    vfs_page_t, lru_link);
+		assert(victim != page);
+		vfs_page_remove(victim);
+	}
+
+	return page;
+}
+
+/** Read one page of a file into a newly allocated page.
+ *
+ * The tail of the page past the end of the file is zeroed.
+ *
+ * @param fd        File descriptor.
+ * @param pos       File offset.
+ * @param page_size Page size.
+ * @param rpage     Place to store the page address.
+ * @return EOK on success or an error code.
+ */
+static errno_t vfs_page_read(int fd, aoff64_t pos, size_t page_size,
+    void **rpage)
 {
-	aoff64_t offset = ipc_get_arg1(req);
-	size_t page_size = ipc_get_arg2(req);
-	int fd = ipc_get_arg3(req);
 	void *page;
 	errno_t rc;
 
@@ -53,10 +413,8 @@ void vfs_page_in(ipc_call_t *req)
 	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
 	    AS_AREA_UNPAGED);
 
-	if (page == AS_MAP_FAILED) {
-		async_answer_0(req, ENOMEM);
-		return;
-	}
+	if (page == AS_MAP_FAILED)
+		return ENOMEM;
 
 	rdwr_io_chunk_t chunk = {
 		.buffer = page,
@@ -64,7 +422,6 @@ void vfs_page_in(ipc_call_t *req)
 	};
 
 	size_t total = 0;
-	aoff64_t pos = offset;
 	do {
 		rc = vfs_rdwr_internal(fd, pos, true, &chunk);
 		if (rc != EOK)
@@ -77,15 +434,144 @@ void vfs_page_in(ipc_call_t *req)
 		chunk.size = page_size - total;
 	} while (total < page_size);
 
-	async_answer_1(req, rc, (sysarg_t) page);
+	if (rc != EOK) {
+		as_area_destroy(page);
+		return rc;
+	}
+
+	/*
+	 * Zero the rest of the page. This also makes sure the whole page is
+	 * present so that the kernel can find its frame when we answer.
+	 */
+	memset(page + total, 0, page_size - total);
+
+	/* The page may be mapped executable by the clients. */
+	smc_coherence(page, page_size);
+
+	*rpage = page;
+	return EOK;
+}
+
+/** Handle a page-in request.
+ *
+ * The request arguments are the offset of the faulting page within the
+ * address space area, the page size, the file descriptor of the backing file
+ * in the client's file table and the file offset corresponding to the start
+ * of the area.
+ *
+ * Pages are served from the page cache so that read-only mappings of the
+ * same file (typically executable code) share frames across tasks.
+ *
+ * @param req Page-in request.
+ */
+void vfs_page_in(ipc_call_t *req)
+{
+	aoff64_t offset = ipc_get_arg1(req);
+	size_t page_size = ipc_get_arg2(req);
+	int fd = ipc_get_arg3(req);
+	aoff64_t base = ipc_get_arg4(req);
+	void *data;
+	errno_t rc;
+
+	vfs_file_t *file = vfs_file_get(fd);
+	if (file == NULL) {
+		async_answer_0(req, EBADF);
+		return;
+	}
+
+	if (!file->open_read || file->node->type != VFS_NODE_FILE) {
+		vfs_file_put(file);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	vfs_page_key_t key = {
+		.triplet = {
+			.fs_handle = file->node->fs_handle,
+			.service_id = file->node->service_id,
+			.index = file->node->index
+		},
+		.offset = base + offset
+	};
+
+	vfs_file_put(file);
+
+	if (page_size != PAGE_SIZE) {
+		/* Only cache pages of the native size. */
+		rc = vfs_page_read(fd, key.offset, page_size, &data);
+		if (rc != EOK) {
+			async_answer_0(req, rc);
+			return;
+		}
+
+		async_answer_1(req, EOK, (sysarg_t) data);
+		as_area_destroy(data);
+		return;
+	}
+
+	fibril_mutex_lock(&pcache_mutex);
+	vfs_page_t *page = vfs_page_find(&key);
+	if (page != NULL) {
+		/* The kernel takes a reference to the frame when answering. */
+		async_answer_1(req, EOK, (sysarg_t) page->data);
+		fibril_mutex_unlock(&pcache_mutex);
+		return;
+	}
 
 	/*
-	 * FIXME:
-	 * This is just for now until we implement proper page cache
-	 * management.  Not keeping the pages around in a cache results in
-	 * inherently non-coherent private mappings.
+	 * Keep the file structure while reading so that we can tell if
+	 * the file was invalidated (e.g. written to) in the meantime.
 	 */
-	as_area_destroy(page);
+	vfs_page_file_t *pfile = vfs_page_file_get(&key.triplet);
+	unsigned gen = 0;
+	if (pfile != NULL) {
+		pfile->readers++;
+		gen = pfile->gen;
+	}
+	fibril_mutex_unlock(&pcache_mutex);
+
+	rc = vfs_page_read(fd, key.offset, page_size, &data);
+
+	fibril_mutex_lock(&pcache_mutex);
+
+	if (pfile != NULL)
+		pfile->readers--;
+
+	if (rc != EOK) {
+		if (pfile != NULL)
+			vfs_page_file_release(pfile);
+		fibril_mutex_unlock(&pcache_mutex);
+		async_answer_0(req, rc);
+		return;
+	}
+
+	if (pfile == NULL || pfile->gen != gen) {
+		/*
+		 * Out of memory or the file changed while we were reading.
+		 * The page may be stale, so do not cache it.
+		 */
+		page = NULL;
+	} else {
+		/* Somebody might have read the same page in the meantime. */
+		page = vfs_page_find(&key);
+		if (page == NULL)
+			page = vfs_page_insert(pfile, key.offset, data);
+		else
+			as_area_destroy(data);
+	}
+
+	if (pfile != NULL)
+		vfs_page_file_release(pfile);
+
+	if (page != NULL) {
+		async_answer_1(req, EOK, (sysarg_t) page->data);
+	} else {
+		/* Hand out an uncached page. */
+		async_answer_1(req, EOK, (sysarg_t) data);
+		as_area_destroy(data);
+	}
+
+	fibril_mutex_unlock(&pcache_mutex);
 }
 
 /**